@@ -20,11 +20,11 @@
 
 #include <graphics.h>
 #include <ege/camera_capture.h>
+#include <ege/triangles.h>
 
 #include <memory>
 #include <vector>
 #include <string>
-#include <cassert>
 #include <cmath>
 #include <algorithm>
 
@@ -152,10 +152,7 @@ public:
 
     void setTextureImage(PIMAGE texture)
     {
-        m_texture     = texture;
-        m_texWidth    = getwidth(texture);
-        m_texHeight   = getheight(texture);
-        m_textureData = (color_t*)getbuffer(m_texture);
+        m_texture = texture;
     }
 
     void setOutputTarget(PIMAGE target)
@@ -199,6 +196,16 @@ public:
                 ++index;
             }
         }
+
+        // 每个网格单元拆成两个三角形
+        m_indices.clear();
+        for (int i = 1; i != h; ++i) {
+            for (int j = 1; j != w; ++j) {
+                const uint32_t p1 = (i - 1) * w + j - 1, p2 = p1 + 1, p3 = i * w + j - 1, p4 = p3 + 1;
+                const uint32_t quad[6] = {p1, p2, p3, p3, p2, p4};
+                m_indices.insert(m_indices.end(), quad, quad + 6);
+            }
+        }
         return true;
     }
 
@@ -274,156 +281,6 @@ public:
 
     void releasePoint() { m_lastIndex = -1; }
 
-    template <class Type> inline void fillTriangle(const Type& v0, const Type& v1, const Type& v2)
-    {
-        if (v0.y == v2.y) {
-            _fillSimpleTriangle(v0, v1, v2);
-        } else if (v1.y == v2.y) {
-            _fillSimpleTriangle(v1, v0, v2);
-        } else if (v0.y == v1.y) {
-            _fillSimpleTriangle(v0, v2, v1);
-        } else {
-            _fillNormalTriangle(v0, v1, v2);
-        }
-    }
-
-    template <class Type> inline void _fillSimpleTriangle(const Type& vv0, const Type& v1, const Type& vv2)
-    {
-        assert(vv0.y == vv2.y);
-        bool        isOK = (vv0.x < vv2.x);
-        const Type& v0   = isOK ? vv0 : vv2;
-        const Type& v2   = isOK ? vv2 : vv0;
-
-        float h = v1.y - v0.y;
-
-        // 修复：添加除零检查
-        if (fabs(h) < 1e-6f) {
-            return; // 三角形退化为线段，跳过
-        }
-
-        float dL = (v1.x - v0.x) / h;
-        float dR = (v1.x - v2.x) / h;
-
-        float dUL = (v1.u - v0.u) / h;
-        float dUR = (v1.u - v2.u) / h;
-
-        float dVL = (v1.v - v0.v) / h;
-        float dVR = (v1.v - v2.v) / h;
-
-        float xL = v0.x, xR = v2.x;
-        float uL = v0.u, uR = v2.u;
-        float vL = v0.v, vR = v2.v;
-
-        const color_t* data         = m_textureData;
-        color_t*       outputBuffer = (color_t*)getbuffer(m_outputTarget);
-
-        if (v0.y < v1.y) {
-            for (int i = v0.y; i < v1.y; ++i) {
-                float len  = xR - xL;
-                float uLen = uR - uL;
-                float vLen = vR - vL;
-
-                // 修复：添加除零检查
-                if (fabs(len) > 1e-6f) {
-                    for (int j = xL; j < xR; ++j) {
-                        float percent = (j - xL) / len;
-                        float u       = uL + uLen * percent;
-                        float v       = vL + vLen * percent;
-                        if (u < 0 || v < 0 || u > 1 || v > 1 || i < 0 || j < 0 || i >= m_outputHeight ||
-                            j >= m_outputWidth)
-                        {
-                            continue;
-                        }
-
-                        // 修复：添加纹理边界检查
-                        int ww = u * (m_texWidth - 1);
-                        int hh = v * (m_texHeight - 1);
-
-                        int index                 = ww + hh * m_texWidth;
-                        int outputIndex           = j + i * m_outputWidth;
-                        outputBuffer[outputIndex] = data[index];
-                    }
-                }
-                xL += dL;
-                xR += dR;
-                uL += dUL;
-                uR += dUR;
-                vL += dVL;
-                vR += dVR;
-            }
-        } else {
-            for (int i = v0.y; i > v1.y; --i) {
-                float len  = xR - xL;
-                float uLen = uR - uL;
-                float vLen = vR - vL;
-
-                // 修复：添加除零检查
-                if (fabs(len) > 1e-6f) {
-                    for (int j = xL; j < xR; ++j) {
-                        float percent = (j - xL) / len;
-                        float u       = uL + uLen * percent;
-                        float v       = vL + vLen * percent;
-                        if (u < 0 || v < 0 || u > 1 || v > 1 || i < 0 || j < 0 || i >= m_outputHeight ||
-                            j >= m_outputWidth)
-                        {
-                            continue;
-                        }
-
-                        int ww = u * (m_texWidth - 1);
-                        int hh = v * (m_texHeight - 1);
-
-                        int index                           = ww + hh * m_texWidth;
-                        outputBuffer[j + i * m_outputWidth] = data[index];
-                    }
-                }
-
-                xL -= dL;
-                xR -= dR;
-                uL -= dUL;
-                uR -= dUR;
-                vL -= dVL;
-                vR -= dVR;
-            }
-        }
-    }
-
-    template <class Type> inline void _fillNormalTriangle(const Type& v0, const Type& v1, const Type& v2)
-    {
-        const Type* pnts[] = {&v0, &v1, &v2};
-
-        if ((*pnts[0]).y > (*pnts[1]).y) {
-            std::swap(pnts[0], pnts[1]);
-        }
-
-        if ((*pnts[0]).y > (*pnts[2]).y) {
-            std::swap(pnts[0], pnts[2]);
-        }
-
-        if ((*pnts[1]).y > (*pnts[2]).y) {
-            std::swap(pnts[1], pnts[2]);
-        }
-
-        const Type &vv0 = *pnts[0], &vv1 = *pnts[1], &vv2 = *pnts[2];
-
-        // 修复：添加除零检查
-        float heightDiff = vv2.y - vv0.y;
-        if (fabs(heightDiff) < 1e-6f) {
-            return; // 三角形退化，跳过
-        }
-
-        Type newPoint;
-
-        float percent = (vv1.y - vv0.y) / heightDiff;
-
-        newPoint.x = floorf(vv0.x + (vv2.x - vv0.x) * percent);
-        newPoint.y = vv1.y;
-        newPoint.u = vv0.u + (vv2.u - vv0.u) * percent;
-        newPoint.v = vv0.v + (vv2.v - vv0.v) * percent;
-
-        _fillSimpleTriangle(newPoint, vv0, vv1);
-        _fillSimpleTriangle(newPoint, vv2, vv1);
-    }
-
     void drawNet()
     {
         std::vector<Point>& vec = m_vec[m_index];
@@ -443,20 +300,12 @@ public:
             v[i].y = floorf(v[i].y * m_outputHeight);
         }
 
-        for (i = 1; i != m_height; ++i) {
-            const int k1 = (i - 1) * m_width;
-            const int k2 = i * m_width;
-
-            for (int j = 1; j != m_width; ++j) {
-                const int p1 = k1 + j - 1;
-                const int p2 = k1 + j;
-                const int p3 = k2 + j - 1;
-                const int p4 = k2 + j;
-
-                fillTriangle(v[p1], v[p2], v[p3]);
-                fillTriangle(v[p3], v[p2], v[p4]);
-            }
+        m_vertices.resize(sz);
+        for (i = 0; i != sz; ++i) {
+            ege_vertex vertex = {v[i].x, v[i].y, v[i].u, v[i].v};
+            m_vertices[i]     = vertex;
         }
+        ege_drawtriangles(m_texture, &m_vertices[0], &m_indices[0], (int)m_indices.size() / 3, m_outputTarget);
 
         color_t* outputBuffer = (color_t*)getbuffer(m_outputTarget);
 
@@ -504,14 +353,14 @@ public:
 private:
     std::vector<Point> m_vec[2];
     std::vector<Point> m_pointCache;
+    std::vector<ege_vertex> m_vertices;
+    std::vector<uint32_t>   m_indices;
     int                m_index;
     int                m_width, m_height;
     float              m_intensity;
     int                m_lastIndex;
 
-    PIMAGE   m_texture;
-    int      m_texWidth, m_texHeight;
-    color_t* m_textureData;
+    PIMAGE m_texture;
 
     PIMAGE m_outputTarget;
     int    m_outputWidth, m_outputHeight;
@@ -672,6 +521,7 @@ int main()
 {
     /// 在相机的高吞吐场景下, 不设置 RENDERMANUAL 会出现闪屏.
     initgraph(WINDOW_WIDTH, WINDOW_HEIGHT, INIT_RENDERMANUAL);
+    ege_set_worker_threads(0);
     setcaption(TEXT_WINDOW_TITLE);
 
     Net                net;
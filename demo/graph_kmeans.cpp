@@ -18,6 +18,7 @@
 #endif
 
 #include <graphics.h>
+#include <ege/shapes.h>
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
@@ -372,6 +373,9 @@ public:
     // 绘制数据点
     void drawPoints()
     {
+        // 所有数据点一次批量绘制
+        m_pointCircles.clear();
+        m_pointColors.clear();
         for (const auto& point : m_points) {
             color_t color;
             if (point.clusterId >= 0 && point.clusterId < m_k) {
@@ -380,9 +384,13 @@ public:
                 color = EGERGB(128, 128, 128); // 未分配的点为灰色
             }
 
-            setfillcolor(color);
-            setcolor(EGEACOLOR(200, color));
-            ege_fillellipse(point.x - POINT_RADIUS, point.y - POINT_RADIUS, POINT_RADIUS * 2, POINT_RADIUS * 2);
+            m_pointCircles.push_back(point.x);
+            m_pointCircles.push_back(point.y);
+            m_pointCircles.push_back(static_cast<float>(POINT_RADIUS));
+            m_pointColors.push_back(color);
+        }
+        if (!m_pointColors.empty()) {
+            ege_fillcircles(static_cast<int>(m_pointColors.size()), &m_pointCircles[0], &m_pointColors[0]);
         }
     }
 
@@ -672,6 +680,8 @@ public:
 
 private:
     std::vector<Point2D>  m_points;              // 数据点
+    std::vector<float>    m_pointCircles;        // 数据点绘制参数 (x, y, r)
+    std::vector<color_t>  m_pointColors;         // 数据点颜色
     std::vector<Centroid> m_centroids;           // 聚类中心
     int                   m_k;                   // 簇数量
     int                   m_numPoints;           // 数据点数量
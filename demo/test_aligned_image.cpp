@@ -0,0 +1,55 @@
+/**
+ * @file test_aligned_image.cpp
+ * @brief A SIMD filter on a newimage_aligned buffer
+ *
+ * Every frame a fading filter darkens the canvas and new circles are drawn on it. The width is
+ * not a multiple of 4 pixels, yet the filter uses aligned SSE2 loads over whole padded rows
+ * (getstride() pixels each) without a scalar tail.
+ */
+
+#include <graphics.h>
+#include <ege/image_view.h>
+
+#include <emmintrin.h>
+#include <stdlib.h>
+
+// Scale every channel by 15/16, rounding down.
+static void fade_aligned(const ege_image_view& view)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    for (int y = 0; y < getheight(view); ++y) {
+        __m128i* row = (__m128i*)(getbuffer(view) + y * getstride(view));
+        for (int x = 0; x < getstride(view) / 4; ++x) {
+            __m128i p = _mm_load_si128(row + x);
+            _mm_store_si128(row + x, _mm_sub_epi8(p, _mm_and_si128(_mm_srli_epi16(p, 4), mask)));
+        }
+    }
+}
+
+int main()
+{
+    const int width = 1270, height = 720;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Aligned image buffer");
+
+    ege_image_view aligned = newimage_aligned(width, height);
+
+    for (; is_run(); delay_fps(60)) {
+        float   xyr[3 * 32];
+        color_t colors[32];
+        for (int i = 0; i < 32; ++i) {
+            xyr[i * 3]     = (float)(rand() % width);
+            xyr[i * 3 + 1] = (float)(rand() % height);
+            xyr[i * 3 + 2] = (float)(4 + rand() % 30);
+            colors[i]      = EGEACOLOR(255, HSVtoRGB((float)(rand() % 360), 0.7f, 1.0f));
+        }
+
+        fade_aligned(aligned);
+        ege_fillcircles(32, xyr, colors, aligned);
+        putimage_f(newimage_view(NULL), 0, 0, aligned);
+    }
+
+    delimage_aligned(aligned);
+    closegraph();
+    return 0;
+}
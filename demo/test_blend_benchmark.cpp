@@ -0,0 +1,121 @@
+/**
+ * @file test_blend_benchmark.cpp
+ * @brief Throughput of the SIMD span kernels in ege/blend.h
+ *
+ * Runs every blend kernel on every instruction set supported by this CPU, prints the
+ * throughput in megapixels per second and checks that SIMD output matches the scalar
+ * kernels byte for byte. A second table compares every putimage_*_f function with the
+ * library function it replaces, for every color type, and shows how many pixels differ.
+ * Below the tables, a sprite is composited with putimage_withalpha_f.
+ *
+ * The program exits with the number of kernels and functions that do not match. Run it with
+ * --check to write the tables to blend_check.txt and exit without opening the interactive view.
+ *
+ * Keys:
+ *   R     run the benchmark again
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/blend.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static int runReport(FILE* out)
+{
+    ege_span_kernel_report  kernels[32];
+    ege_span_library_report library[8];
+    int kernelCount  = ege_span_kernel_benchmark(kernels, 32);
+    int libraryCount = ege_span_library_check(library, 8);
+    int failed       = 0;
+
+    cleardevice();
+    setfont(16, 0, "Consolas");
+    setbkmode(TRANSPARENT);
+
+    char line[160];
+    snprintf(line, sizeof(line), "Selected kernels: %s", ege_span_kernel_isa());
+    settextcolor(WHITE);
+    outtextxy(10, 10, line);
+
+    for (int i = 0; i < kernelCount; ++i) {
+        const ege_span_kernel_report& r = kernels[i];
+        snprintf(line, sizeof(line), "%-20s %-7s %9.1f MP/s  %s", r.kernel, r.isa, r.megapixelsPerSec,
+            r.exact ? "exact" : "MISMATCH");
+        failed += !r.exact;
+        settextcolor(r.exact ? WHITE : LIGHTRED);
+        outtextxy(10, 40 + i * 20, line);
+        if (out != NULL) {
+            fprintf(out, "%s\n", line);
+        }
+    }
+
+    int y = 40 + kernelCount * 20 + 10;
+    for (int i = 0; i < libraryCount; ++i, y += 20) {
+        const ege_span_library_report& r = library[i];
+        if (r.mismatches == 0) {
+            snprintf(line, sizeof(line), "%-28s matches the library", r.function);
+        } else {
+            snprintf(line, sizeof(line), "%-28s %d of %d pixels differ, max %d (library %08X, _f %08X)", r.function,
+                r.mismatches, r.pixels, r.maxDiff, (unsigned int)r.library, (unsigned int)r.simd);
+        }
+        failed += r.mismatches != 0;
+        settextcolor(r.mismatches == 0 ? WHITE : LIGHTRED);
+        outtextxy(10, y, line);
+        if (out != NULL) {
+            fprintf(out, "%s\n", line);
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    initgraph(800, 720, INIT_RENDERMANUAL);
+    setcaption("SIMD blend kernels");
+    setbkcolor(EGERGB(0x20, 0x20, 0x20));
+
+    PIMAGE sprite = newimage(96, 96);
+    setbkcolor(EGEARGB(0, 0, 0, 0), sprite);
+    cleardevice(sprite);
+    setfillcolor(EGEARGB(0xC0, 0x34, 0x98, 0xDB), sprite);
+    ege_fillellipse(0, 0, 96, 96, sprite);
+
+    FILE* report = fopen("blend_check.txt", "w");
+    int   failed = runReport(report);
+    if (report != NULL) {
+        fclose(report);
+    }
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        delimage(sprite);
+        closegraph();
+        return failed;
+    }
+
+    for (int frame = 0; is_run(); delay_fps(60), ++frame) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                delimage(sprite);
+                closegraph();
+                return failed;
+            } else if (msg.key == key_R) {
+                failed = runReport(NULL);
+            }
+        }
+
+        setfillcolor(EGERGB(0x20, 0x20, 0x20));
+        bar(0, 600, 800, 720);
+        for (int i = 0; i < 8; ++i) {
+            putimage_withalpha_f(NULL, sprite, (frame * 3 + i * 100) % 800 - 48, 612);
+        }
+    }
+
+    delimage(sprite);
+    closegraph();
+    return failed;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file test_compress_parallel.cpp
+ * @brief Compressing a 64 MiB simulation state with ege_compress and ege_compress_parallel
+ *
+ * A particle state is generated, then compressed and decompressed once with ege_compress() /
+ * ege_uncompress() and once with the block-parallel frame of ege/compress.h. The HUD shows the
+ * timings, the sizes and whether the data came back intact.
+ *
+ * Keys:
+ *   Space run again
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/compress.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+struct Particle
+{
+    float x, y, vx, vy;
+    int   id, flags;
+};
+
+int main()
+{
+    const int width = 1000, height = 200, count = 64 * 1024 * 1024 / (int)sizeof(Particle);
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Parallel compression");
+
+    std::vector<Particle> state(count);
+    for (int i = 0; i < count; ++i) {
+        Particle& p = state[i];
+        p.x         = (float)(i % 4096);
+        p.y         = (float)(i / 4096);
+        p.vx        = sinf(i * 0.001f);
+        p.vy        = 0.0f;
+        p.id        = i;
+        p.flags     = i % 97 == 0;
+    }
+    const uint32_t       size = (uint32_t)(state.size() * sizeof(Particle));
+    std::vector<uint8_t> packed, unpacked(size);
+    char                 lines[2][160] = {"", ""};
+
+    for (bool run = true; is_run(); delay_fps(30)) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                closegraph();
+                return 0;
+            }
+            run = run || msg.key == key_space;
+        }
+
+        if (run) {
+            run = false;
+            for (int parallel = 0; parallel < 2; ++parallel) {
+                packed.resize(parallel ? ege_compress_parallel_bound(size) : ege_compress_bound(size));
+                uint32_t packedSize = (uint32_t)packed.size(), unpackedSize = size;
+                memset(&unpacked[0], 0, size);
+
+                double start = fclock();
+                if (parallel) {
+                    ege_compress_parallel(&packed[0], &packedSize, &state[0], size, 5);
+                } else {
+                    ege_compress(&packed[0], &packedSize, &state[0], size);
+                }
+                double compressTime = fclock() - start;
+                start               = fclock();
+                if (parallel) {
+                    ege_uncompress_parallel(&unpacked[0], &unpackedSize, &packed[0], packedSize);
+                } else {
+                    ege_uncompress(&unpacked[0], &unpackedSize, &packed[0], packedSize);
+                }
+                double uncompressTime = fclock() - start;
+
+                snprintf(lines[parallel], sizeof(lines[parallel]),
+                    "%-22s %6.1f MiB -> %5.1f MiB, compress %5.0f ms, uncompress %4.0f ms, %s",
+                    parallel ? "ege_compress_parallel:" : "ege_compress:", size / 1048576.0, packedSize / 1048576.0,
+                    compressTime * 1000.0, uncompressTime * 1000.0,
+                    unpackedSize == size && memcmp(&unpacked[0], &state[0], size) == 0 ? "intact" : "DAMAGED");
+            }
+        }
+
+        cleardevice();
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, lines[0]);
+        outtextxy(6, 24, lines[1]);
+        outtextxy(6, 60, "Space: run again");
+    }
+
+    closegraph();
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_compress_stream.cpp
+ * @brief Recording frames into a compressed file with ege_deflate_stream and playing it back
+ *
+ * While recording, every frame of a small animation is pushed into an ege_deflate_stream and
+ * the compressed bytes are written to "frames.z" as they come, so memory use stays the same
+ * however long the recording runs. Playback reads the file in small chunks into an
+ * ege_inflate_stream and pulls one frame at a time. The HUD shows the sizes and the state.
+ *
+ * Keys:
+ *   R     start / stop recording
+ *   P     play the recording
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/compress.h>
+
+#include <math.h>
+#include <stdio.h>
+
+int main()
+{
+    const int width = 640, height = 480, frameW = 320, frameH = 240;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Streaming compression");
+
+    PIMAGE                frame = newimage(frameW, frameH);
+    const size_t          frameBytes = (size_t)frameW * frameH * sizeof(color_t);
+    std::vector<uint8_t>  chunk(16 * 1024);
+    ege_deflate_stream*   recorder = NULL;
+    ege_inflate_stream*   player   = NULL;
+    FILE*                 file     = NULL;
+    long                  frames = 0, rawBytes = 0, fileBytes = 0;
+    char                  state[96] = "R: record, P: play";
+
+    for (int tick = 0; is_run(); delay_fps(30), ++tick) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                closegraph();
+                return 0;
+            } else if (msg.key == key_R && player == NULL) {
+                if (recorder == NULL) {
+                    file     = fopen("frames.z", "wb");
+                    recorder = file != NULL ? new ege_deflate_stream(3) : NULL;
+                    frames = rawBytes = fileBytes = 0;
+                } else {
+                    recorder->finish();
+                    for (size_t n; (n = recorder->pull(&chunk[0], chunk.size())) != 0; fileBytes += (long)n) {
+                        fwrite(&chunk[0], 1, n, file);
+                    }
+                    fclose(file);
+                    delete recorder;
+                    recorder = NULL;
+                    snprintf(state, sizeof(state), "recorded %ld frames", frames);
+                }
+            } else if (msg.key == key_P && recorder == NULL && player == NULL) {
+                file   = fopen("frames.z", "rb");
+                player = file != NULL ? new ege_inflate_stream() : NULL;
+                frames = 0;
+            }
+        }
+
+        if (recorder != NULL) {
+            // A moving pattern, so that consecutive frames differ a little.
+            setbkcolor(BLACK, frame);
+            cleardevice(frame);
+            for (int i = 0; i < 12; ++i) {
+                float a = tick * 0.05f + i * 0.52f;
+                setfillcolor(HSVtoRGB((float)(i * 30), 0.7f, 0.9f), frame);
+                ege_fillellipse(frameW / 2 + cosf(a) * 90.0f - 15.0f, frameH / 2 + sinf(a) * 90.0f - 15.0f, 30.0f, 30.0f,
+                    frame);
+            }
+            recorder->push(getbuffer(frame), frameBytes);
+            for (size_t n; (n = recorder->pull(&chunk[0], chunk.size())) != 0; fileBytes += (long)n) {
+                fwrite(&chunk[0], 1, n, file);
+            }
+            ++frames;
+            rawBytes += (long)frameBytes;
+            snprintf(state, sizeof(state), "recording frame %ld", frames);
+        } else if (player != NULL) {
+            // Feed the file until a whole frame comes out, straight into the image buffer.
+            uint8_t* dst = (uint8_t*)getbuffer(frame);
+            size_t   got = 0;
+            while (got < frameBytes) {
+                size_t n = player->pull(dst + got, frameBytes - got);
+                got += n;
+                if (n == 0) {
+                    if (feof(file) || player->error() != grOk) {
+                        break;
+                    }
+                    size_t read = fread(&chunk[0], 1, chunk.size(), file);
+                    player->push(&chunk[0], read);
+                    if (read < chunk.size()) {
+                        player->finish();
+                    }
+                }
+            }
+            if (got == frameBytes) {
+                snprintf(state, sizeof(state), "playing frame %ld", ++frames);
+            } else {
+                snprintf(state, sizeof(state), player->error() == grOk ? "played %ld frames" : "damaged after %ld frames",
+                    frames);
+                fclose(file);
+                delete player;
+                player = NULL;
+            }
+        }
+
+        cleardevice();
+        putimage(0, 40, frame);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, state);
+        char text[96];
+        snprintf(text, sizeof(text), "raw %ld KiB -> file %ld KiB", rawBytes / 1024, fileBytes / 1024);
+        outtextxy(6, 22, text);
+    }
+
+    delimage(frame);
+    closegraph();
+    return 0;
+}
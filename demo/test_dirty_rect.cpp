@@ -0,0 +1,92 @@
+/**
+ * @file test_dirty_rect.cpp
+ * @brief Partial window present with invalidaterect and delay_fps_dirty
+ *
+ * A static scene is drawn once; every frame only a status label and a small moving marker
+ * change. With the partial present only those areas are copied to the window.
+ *
+ * Keys:
+ *   Space switch between delay_fps_dirty and delay_fps
+ *   O     outline the presented rectangles
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/dirty_rect.h>
+
+#include <math.h>
+#include <stdio.h>
+
+int main()
+{
+    const int width = 1280, height = 720;
+    initgraph(width, height, INIT_ANIMATION);
+    setcaption("Dirty rectangles");
+
+    setbkcolor(EGERGB(0x18, 0x18, 0x28));
+    cleardevice();
+    for (int i = 0; i < 400; ++i) {
+        setfillcolor(HSVtoRGB((float)(i * 7 % 360), 0.5f, 0.6f));
+        ege_fillcircle((float)(i * 97 % width), (float)(i * 61 % height), (float)(8 + i % 24));
+    }
+    invalidatewindow();
+
+    bool partial = true, overlay = false;
+    int  markerX = 0, markerY = 0;
+
+    for (double t = 0.0; is_run(); t += 0.03) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                closegraph();
+                return 0;
+            } else if (msg.key == key_space) {
+                partial = !partial;
+                ege_dirty_reset_stats();
+                invalidatewindow();
+            } else if (msg.key == key_O) {
+                overlay = !overlay;
+                ege_dirty_overlay(overlay);
+                invalidatewindow();
+            }
+        }
+
+        // Moving marker: restore the old spot with the background color, draw the new one.
+        setfillcolor(EGERGB(0x18, 0x18, 0x28));
+        bar(markerX, markerY, markerX + 24, markerY + 24);
+        invalidaterect(markerX, markerY, 24, 24);
+        markerX = width / 2 + (int)(cos(t) * 400.0);
+        markerY = height / 2 + (int)(sin(t * 1.7) * 250.0);
+        setfillcolor(EGERGB(0xFF, 0xD0, 0x40));
+        bar(markerX, markerY, markerX + 24, markerY + 24);
+        invalidaterect(markerX, markerY, 24, 24);
+
+        ege_dirty_stats stats;
+        ege_dirty_get_stats(&stats);
+        double share = stats.windowPixels > 0.0 ? stats.presentedPixels * 100.0 / stats.windowPixels : 100.0;
+
+        char text[128];
+        snprintf(text, sizeof(text), "%s: %.1f%% of the window presented, %.1f rects per frame",
+            partial ? "delay_fps_dirty" : "delay_fps", partial ? share : 100.0,
+            stats.frames > 0 ? (double)stats.rects / stats.frames : 0.0);
+        setfillcolor(BLACK);
+        bar(0, 0, 640, 24);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, text);
+        invalidaterect(0, 0, 640, 24);
+
+        if (partial) {
+            delay_fps_dirty(60);
+        } else {
+            delay_fps(60);
+        }
+    }
+
+    closegraph();
+    return 0;
+}
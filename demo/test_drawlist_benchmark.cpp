@@ -0,0 +1,173 @@
+/**
+ * @file test_drawlist_benchmark.cpp
+ * @brief Benchmark of ege_drawlist against immediate-mode ege_ primitives
+ *
+ * Draws the same set of circles, triangles and lines every frame, alternating between
+ * the immediate-mode path (one ege_fillcircle / ege_fillpoly / ege_line call per object)
+ * and a recorded ege_drawlist submitted in one pass. The average time spent drawing is
+ * shown for both paths.
+ *
+ * Keys:
+ *   +/-   change the number of primitives
+ *   Space pause/resume switching, stay on the current mode
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/drawlist.h>
+
+#include <stdio.h>
+#include <vector>
+
+struct Item
+{
+    float   x, y, r;
+    float   vx, vy;
+    int     kind;   // 0 circle, 1 triangle, 2 line
+    color_t color;
+};
+
+static const color_t palette[] = {
+    EGERGB(0xE7, 0x4C, 0x3C), EGERGB(0x2E, 0xCC, 0x71), EGERGB(0x34, 0x98, 0xDB),
+    EGERGB(0xF1, 0xC4, 0x0F), EGERGB(0x9B, 0x59, 0xB6), EGERGB(0x1A, 0xBC, 0x9C),
+};
+
+static void resetItems(std::vector<Item>& items, int count, int w, int h)
+{
+    items.resize(count);
+    for (int i = 0; i < count; ++i) {
+        Item& it = items[i];
+        it.x     = (float)random(w);
+        it.y     = (float)random(h);
+        it.r     = 2.0f + (float)random(6);
+        it.vx    = (float)randomf() * 2.0f - 1.0f;
+        it.vy    = (float)randomf() * 2.0f - 1.0f;
+        it.kind  = random(3);
+        it.color = palette[random(sizeof(palette) / sizeof(palette[0]))];
+    }
+}
+
+static void updateItems(std::vector<Item>& items, int w, int h)
+{
+    for (size_t i = 0; i < items.size(); ++i) {
+        Item& it  = items[i];
+        it.x     += it.vx;
+        it.y     += it.vy;
+        if (it.x < 0 || it.x >= w) it.vx = -it.vx;
+        if (it.y < 0 || it.y >= h) it.vy = -it.vy;
+    }
+}
+
+static void drawImmediate(const std::vector<Item>& items)
+{
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Item& it = items[i];
+        if (it.kind == 0) {
+            setfillcolor(it.color);
+            ege_fillcircle(it.x, it.y, it.r);
+        } else if (it.kind == 1) {
+            ege_point tri[3] = {
+                {it.x, it.y - it.r}, {it.x + it.r, it.y + it.r}, {it.x - it.r, it.y + it.r}
+            };
+            setfillcolor(it.color);
+            ege_fillpoly(3, tri);
+        } else {
+            setlinecolor(it.color);
+            ege_line(it.x - it.r, it.y, it.x + it.r, it.y + it.r);
+        }
+    }
+}
+
+static void drawRecorded(ege_drawlist* list, const std::vector<Item>& items)
+{
+    ege_drawlist_begin(list);
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Item& it = items[i];
+        if (it.kind == 0) {
+            ege_drawlist_setfillcolor(list, it.color);
+            ege_drawlist_fillcircle(list, it.x, it.y, it.r);
+        } else if (it.kind == 1) {
+            ege_point tri[3] = {
+                {it.x, it.y - it.r}, {it.x + it.r, it.y + it.r}, {it.x - it.r, it.y + it.r}
+            };
+            ege_drawlist_setfillcolor(list, it.color);
+            ege_drawlist_fillpoly(list, 3, tri);
+        } else {
+            ege_drawlist_setlinecolor(list, it.color);
+            ege_drawlist_line(list, it.x - it.r, it.y, it.x + it.r, it.y + it.r);
+        }
+    }
+    ege_drawlist_submit(list);
+}
+
+int main()
+{
+    const int width = 1024, height = 720;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("ege_drawlist benchmark");
+    setbkcolor(EGERGB(0x20, 0x20, 0x20));
+    ege_enable_aa(true);
+    randomize();
+
+    int               count = 20000;
+    std::vector<Item> items;
+    resetItems(items, count, width, height);
+
+    ege_drawlist* list      = ege_drawlist_create();
+    double        avg[2]    = {0.0, 0.0};
+    int           mode      = 0;
+    int           frames    = 0;
+    bool          switching = true;
+
+    for (; is_run(); delay_fps(60)) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                closegraph();
+                ege_drawlist_destroy(list);
+                return 0;
+            } else if (msg.key == key_plus) {
+                count += 5000;
+                resetItems(items, count, width, height);
+            } else if (msg.key == key_minus && count > 5000) {
+                count -= 5000;
+                resetItems(items, count, width, height);
+            } else if (msg.key == key_space) {
+                switching = !switching;
+            }
+        }
+
+        updateItems(items, width, height);
+        cleardevice();
+
+        double start = fclock();
+        if (mode == 0) {
+            drawImmediate(items);
+        } else {
+            drawRecorded(list, items);
+        }
+        double elapsed = (fclock() - start) * 1000.0;
+        avg[mode]      = avg[mode] == 0.0 ? elapsed : avg[mode] * 0.9 + elapsed * 0.1;
+
+        if (switching && ++frames % 60 == 0) {
+            mode = 1 - mode;
+        }
+
+        char text[160];
+        snprintf(text, sizeof(text), "%d primitives | immediate: %.2f ms | drawlist: %.2f ms | now: %s", count, avg[0], avg[1],
+            mode == 0 ? "immediate" : "drawlist");
+        setfillcolor(EGEARGB(0xC0, 0, 0, 0));
+        ege_fillrect(0, 0, (float)width, 24);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, text);
+    }
+
+    ege_drawlist_destroy(list);
+    closegraph();
+    return 0;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file test_floodfill.cpp
+ * @brief floodfillsurface_f and floodfill_mask on a large offscreen image
+ *
+ * A 4096x4096 image of random circles is shown scaled down. Clicking fills the region under
+ * the mouse with floodfillsurface_f, or with floodfillsurface when Space toggled it, and shows
+ * the time taken. Right clicking selects the region with floodfill_mask and outlines it.
+ *
+ * Before the window opens its canvas, checkFloodfill() compares the fills with a plain
+ * breadth-first search on a random maze whose width is not a multiple of 32 and whose wall
+ * pixels have random alpha: floodfillsurface_f and floodfill_f must paint exactly the pixels the
+ * search reaches, floodfill_mask must select the same pixels without touching the image, and a
+ * start point outside the image must be rejected. The result is shown at the bottom, and the
+ * program exits with the number of failed checks. Run it with --check to exit right after the
+ * checks.
+ *
+ * Keys:
+ *   Space switch between floodfillsurface_f and floodfillsurface
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/floodfill.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/// Pixels 4-connected to (x, y) whose RGB equals (surface) or differs from (border) key.
+static std::vector<char> referenceFill(PCIMAGE img, int x, int y, color_t key, bool surface)
+{
+    const int         w = getwidth(img), h = getheight(img);
+    const color_t*    buf = getbuffer(img);
+    std::vector<char> reached(w * h, 0);
+    std::vector<int>  queue(1, y * w + x);
+    reached[y * w + x] = 1;
+    for (size_t head = 0; head < queue.size(); ++head) {
+        int       p = queue[head], px = p % w, py = p / w;
+        const int next[4][2] = {{px - 1, py}, {px + 1, py}, {px, py - 1}, {px, py + 1}};
+        for (int i = 0; i < 4; ++i) {
+            int nx = next[i][0], ny = next[i][1];
+            if (nx < 0 || ny < 0 || nx >= w || ny >= h || reached[ny * w + nx]) {
+                continue;
+            }
+            if (((buf[ny * w + nx] & 0xFFFFFF) == (key & 0xFFFFFF)) == surface) {
+                reached[ny * w + nx] = 1;
+                queue.push_back(ny * w + nx);
+            }
+        }
+    }
+    return reached;
+}
+
+/// Whether exactly the reached pixels of img hold fill and all others are unchanged from source.
+static bool filledExactly(PCIMAGE img, PCIMAGE source, const std::vector<char>& reached, color_t fill)
+{
+    for (int i = 0; i < getwidth(img) * getheight(img); ++i) {
+        if (getbuffer(img)[i] != (reached[i] ? fill : getbuffer(source)[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Check the fills against a breadth-first search; returns the number of failed checks.
+static int checkFloodfill()
+{
+    const int     w = 333, h = 211;
+    const color_t floor = EGERGB(0xF0, 0xF0, 0xF0), wall = EGERGB(0x20, 0x30, 0x40), fill = EGERGB(0xFF, 0x80, 0x00);
+    PIMAGE        maze = newimage(w, h), img = newimage(w, h);
+    int           failed = 0;
+
+    srand(11);
+    for (int i = 0; i < w * h; ++i) {
+        getbuffer(maze)[i] = rand() % 100 < 40 ? (wall & 0xFFFFFF) | (color_t)(rand() % 256) << 24 : floor;
+    }
+    int sx = w / 2, sy = h / 2;
+    getbuffer(maze)[sy * w + sx] = floor;
+    setfillcolor(fill, img);
+
+    // The surface fill paints exactly the floor pixels the search reaches.
+    std::vector<char> reached = referenceFill(maze, sx, sy, floor, true);
+    putimage(img, 0, 0, maze);
+    failed += floodfillsurface_f(sx, sy, floor, img) != grOk || !filledExactly(img, maze, reached, fill);
+
+    // The border fill spreads over every pixel that is not wall colored, whatever its alpha.
+    reached = referenceFill(maze, sx, sy, wall, false);
+    putimage(img, 0, 0, maze);
+    failed += floodfill_f(sx, sy, wall, img) != grOk || !filledExactly(img, maze, reached, fill);
+
+    // The mask selects the same pixels and leaves the image alone.
+    reached = referenceFill(maze, sx, sy, floor, true);
+    putimage(img, 0, 0, maze);
+    const int             stride = (w + 31) / 32 + 1;
+    std::vector<uint32_t> mask(stride * h, ~0u);
+    bool                  same = floodfill_mask(sx, sy, floor, FLOODFILL_SURFACE, &mask[0], stride, img) == grOk;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < stride * 32; ++x) {
+            bool bit = (mask[y * stride + (x >> 5)] >> (x & 31)) & 1;
+            same     = same && bit == (x < w && reached[y * w + x]);
+        }
+    }
+    failed += !same || memcmp(getbuffer(img), getbuffer(maze), sizeof(color_t) * w * h) != 0;
+
+    // Start points outside the image are rejected without painting.
+    failed += floodfillsurface_f(w, 0, floor, img) != grParamError || floodfill_f(0, -1, wall, img) != grParamError
+           || memcmp(getbuffer(img), getbuffer(maze), sizeof(color_t) * w * h) != 0;
+
+    delimage(maze);
+    delimage(img);
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    const int width = 1024, height = 1024, size = 4096, scale = size / width;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Flood fill");
+
+    int failed = checkFloodfill();
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        closegraph();
+        return failed;
+    }
+
+    PIMAGE canvas = newimage(size, size);
+    setbkcolor(WHITE, canvas);
+    cleardevice(canvas);
+    setcolor(BLACK, canvas);
+    setlinewidth(3, canvas);
+    for (int i = 0; i < 600; ++i) {
+        circle(rand() % size, rand() % size, 20 + rand() % 400, canvas);
+    }
+
+    std::vector<uint32_t> mask((size_t)(size / 32) * size);
+    bool                  fast = true, selected = false;
+    double                elapsed = 0.0;
+
+    for (; is_run(); delay_fps(30)) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg == key_msg_down && msg.key == key_esc) {
+                delimage(canvas);
+                closegraph();
+                return failed;
+            } else if (msg.msg == key_msg_down && msg.key == key_space) {
+                fast = !fast;
+            }
+        }
+        while (mousemsg()) {
+            mouse_msg msg = getmouse();
+            if (!msg.is_down()) {
+                continue;
+            }
+            int    x = msg.x * scale, y = msg.y * scale;
+            double start = fclock();
+            if (msg.is_left()) {
+                setfillcolor(HSVtoRGB((float)(rand() % 360), 0.6f, 0.95f), canvas);
+                color_t area = getpixel_f(x, y, canvas);
+                if (fast) {
+                    floodfillsurface_f(x, y, area, canvas);
+                } else {
+                    floodfillsurface(x, y, area, canvas);
+                }
+                selected = false;
+            } else if (msg.is_right()) {
+                selected = floodfill_mask(x, y, getpixel_f(x, y, canvas), FLOODFILL_SURFACE, &mask[0], size / 32, canvas) == grOk;
+            }
+            elapsed = (fclock() - start) * 1000.0;
+        }
+
+        putimage(0, 0, width, height, canvas, 0, 0, size, size);
+        if (selected) {
+            // Mark selected pixels of the scaled-down view.
+            color_t* buffer = getbuffer((PIMAGE)NULL);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    int sx = x * scale, sy = y * scale;
+                    if (((mask[(size_t)sy * (size / 32) + (sx >> 5)] >> (sx & 31)) & 1) && ((x + y) & 4)) {
+                        buffer[y * width + x] = EGERGB(0xFF, 0x40, 0x40);
+                    }
+                }
+            }
+        }
+
+        char text[128];
+        snprintf(text, sizeof(text), "%s, last operation %.2f ms (right click: select)", fast ? "floodfillsurface_f" : "floodfillsurface", elapsed);
+        settextcolor(BLACK);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, text);
+        settextcolor(failed == 0 ? BLACK : LIGHTRED);
+        xyprintf(6, height - 20, "output checks: %d of 4 failed", failed);
+    }
+
+    delimage(canvas);
+    closegraph();
+    return failed;
+}
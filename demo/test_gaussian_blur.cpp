@@ -0,0 +1,67 @@
+/**
+ * @file test_gaussian_blur.cpp
+ * @brief Glow effect with imagefilter_gaussian
+ *
+ * Moving circles are drawn into an offscreen layer, blurred with imagefilter_gaussian and
+ * shown behind their sharp cores. The blur costs the same for every radius.
+ *
+ * Keys:
+ *   +/-   change the blur radius
+ */
+
+#include <graphics.h>
+#include <ege/blur.h>
+#include <ege/fps.h>
+
+#include <math.h>
+
+int main()
+{
+    const int width = 1280, height = 720;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("imagefilter_gaussian glow");
+    ege_set_worker_threads(0);
+
+    PIMAGE layer  = newimage(width, height);
+    float  radius = 20.0f;
+    fps    f;
+
+    for (double t = 0.0; is_run(); delay_fps(60), t += 0.02) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_plus) {
+                radius += 2.0f;
+            } else if (msg.key == key_minus && radius > 2.0f) {
+                radius -= 2.0f;
+            }
+        }
+
+        float xs[12], ys[12];
+        cleardevice(layer);
+        for (int i = 0; i < 12; ++i) {
+            xs[i] = width / 2 + (float)cos(t * (1.0 + i * 0.1) + i) * (200 + i * 20);
+            ys[i] = height / 2 + (float)sin(t * (1.3 + i * 0.07) + i * 2) * (120 + i * 15);
+            setfillcolor(HSVtoRGB((float)(i * 30), 0.8f, 1.0f), layer);
+            ege_fillcircle(xs[i], ys[i], 24, layer);
+        }
+
+        imagefilter_gaussian(layer, radius);
+
+        putimage(0, 0, layer);
+        for (int i = 0; i < 12; ++i) {
+            setfillcolor(WHITE);
+            ege_fillcircle(xs[i], ys[i], 10);
+        }
+
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, 16, "radius %.0f", radius);
+    }
+
+    delimage(layer);
+    closegraph();
+    return 0;
+}
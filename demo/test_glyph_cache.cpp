@@ -0,0 +1,45 @@
+/**
+ * @file test_glyph_cache.cpp
+ * @brief HUD labels drawn with outtextxy_cached
+ *
+ * Draws a grid of short numeric labels every frame through the glyph atlas and shows the
+ * glyph cache counters.
+ */
+
+#include <graphics.h>
+#include <ege/glyph_cache.h>
+
+#include <stdio.h>
+
+int main()
+{
+    const int width = 1280, height = 720;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Glyph atlas cache");
+    setbkcolor(EGERGB(0x20, 0x20, 0x20));
+
+    for (int frame = 0; is_run(); delay_fps(60), ++frame) {
+        cleardevice();
+        setbkmode(TRANSPARENT);
+        setfont(14, 0, "Consolas");
+        settextcolor(EGERGB(0x9F, 0xE2, 0xBF));
+
+        char label[32];
+        for (int row = 0; row < 34; ++row) {
+            for (int col = 0; col < 16; ++col) {
+                sprintf(label, "%04d:%05d", row * 16 + col, (frame * 7 + row * 131 + col * 17) % 100000);
+                outtextxy_cached(8 + col * 79, 32 + row * 20, label);
+            }
+        }
+        ege_glyph_cache_stats stats;
+        ege_glyph_cache_get_stats(&stats);
+
+        settextcolor(WHITE);
+        setfont(16, 0, "Consolas");
+        xyprintf(6, 6, "hits %lu misses %lu evictions %lu glyphs %d atlas %u KB", stats.hits, stats.misses,
+            stats.evictions, stats.glyphs, (unsigned)(stats.atlasBytes / 1024));
+    }
+
+    closegraph();
+    return 0;
+}
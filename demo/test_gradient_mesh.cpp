@@ -0,0 +1,154 @@
+/**
+ * @file test_gradient_mesh.cpp
+ * @brief Animated heat map drawn with fillmesh_gradient
+ *
+ * A grid of about 100k Gouraud shaded triangles whose vertex colors follow a moving field,
+ * drawn with one fillmesh_gradient call per frame. The frame rate is shown in the top-left corner.
+ *
+ * Before the animation starts, checkMesh() checks the output: a jittered one-color mesh must
+ * fill exactly the pixels centered inside its outline, a horizontal ramp must be within 1 of the
+ * exact linear value at every pixel center, and the mesh drawn with one thread must match the
+ * mesh drawn with one thread per processor. The result is shown at the bottom, and the program
+ * exits with the number of failed checks. Run it with --check to exit right after the checks.
+ */
+
+#include <graphics.h>
+#include <ege/fps.h>
+#include <ege/gradient_mesh.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+/// Grid of (cols + 1) x (rows + 1) vertices, two triangles per cell.
+static void gridIndices(int cols, int rows, std::vector<uint32_t>& indices)
+{
+    indices.clear();
+    for (int j = 0; j < rows; ++j) {
+        for (int i = 0; i < cols; ++i) {
+            uint32_t p1 = j * (cols + 1) + i, p2 = p1 + 1, p3 = p1 + cols + 1, p4 = p3 + 1;
+            uint32_t quad[6] = {p1, p2, p3, p3, p2, p4};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+/// Check the output of fillmesh_gradient; returns the number of failed checks.
+static int checkMesh()
+{
+    const int   w = 200, h = 160, cols = 7, rows = 5;
+    const float left = 10.25f, top = 12.75f, right = 181.5f, bottom = 141.0f;
+    PIMAGE      target = newimage(w, h), reference = newimage(w, h);
+    int         failed = 0;
+
+    // A one-color mesh with jittered inner vertices fills exactly the pixels centered inside.
+    std::vector<ege_colpoint> grid((cols + 1) * (rows + 1));
+    std::vector<uint32_t>     indices;
+    gridIndices(cols, rows, indices);
+    srand(3);
+    for (int j = 0; j <= rows; ++j) {
+        for (int i = 0; i <= cols; ++i) {
+            float         jx = (i > 0 && i < cols) ? (rand() % 100 - 50) / 16.0f : 0.0f;
+            float         jy = (j > 0 && j < rows) ? (rand() % 100 - 50) / 16.0f : 0.0f;
+            ege_colpoint& v  = grid[j * (cols + 1) + i];
+            v.x              = left + (right - left) * i / cols + jx;
+            v.y              = top + (bottom - top) * j / rows + jy;
+            v.color          = EGEACOLOR(0xC0, EGERGB(0x12, 0x80, 0xFE));
+        }
+    }
+    memset(getbuffer(target), 0, sizeof(color_t) * w * h);
+    fillmesh_gradient(&grid[0], &indices[0], (int)indices.size() / 3, target);
+    bool exact = true;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            bool inside = x + 0.5f >= left && x + 0.5f < right && y + 0.5f >= top && y + 0.5f < bottom;
+            exact       = exact && getbuffer(target)[y * w + x] == (inside ? grid[0].color : 0);
+        }
+    }
+    failed += !exact;
+
+    // A horizontal ramp is within 1 of the exact value at every pixel center.
+    const color_t from = EGEACOLOR(0xFF, EGERGB(0x00, 0x40, 0xFF)), to = EGEACOLOR(0x20, EGERGB(0xFF, 0xC0, 0x00));
+    for (size_t i = 0; i < grid.size(); ++i) {
+        float k       = (grid[i].x - left) / (right - left);
+        grid[i].color = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            float a = (float)((from >> shift) & 0xFF), b = (float)((to >> shift) & 0xFF);
+            grid[i].color |= (color_t)floor(a + (b - a) * k + 0.5f) << shift;
+        }
+    }
+    fillmesh_gradient(&grid[0], &indices[0], (int)indices.size() / 3, target);
+    bool ramp = true;
+    for (int y = (int)top + 1; y < (int)bottom; ++y) {
+        for (int x = (int)left + 1; x < (int)right; ++x) {
+            float   k = (x + 0.5f - left) / (right - left);
+            color_t c = getbuffer(target)[y * w + x];
+            // The vertex colors are rounded already, so allow 1.
+            for (int shift = 0; shift < 32; shift += 8) {
+                float a = (float)((from >> shift) & 0xFF), b = (float)((to >> shift) & 0xFF);
+                ramp    = ramp && fabs(((c >> shift) & 0xFF) - (a + (b - a) * k)) <= 1.0f;
+            }
+        }
+    }
+    failed += !ramp;
+
+    // The tile split does not change the output.
+    for (size_t i = 0; i < grid.size(); ++i) {
+        grid[i].color = 0xFF000000 | ((unsigned int)i * 2654435761u >> 8);
+    }
+    int threads = ege_get_worker_threads();
+    memset(getbuffer(target), 0, sizeof(color_t) * w * h);
+    memset(getbuffer(reference), 0, sizeof(color_t) * w * h);
+    ege_set_worker_threads(1);
+    fillmesh_gradient(&grid[0], &indices[0], (int)indices.size() / 3, reference);
+    ege_set_worker_threads(0);
+    fillmesh_gradient(&grid[0], &indices[0], (int)indices.size() / 3, target);
+    ege_set_worker_threads(threads);
+    failed += memcmp(getbuffer(target), getbuffer(reference), sizeof(color_t) * w * h) != 0;
+
+    delimage(target);
+    delimage(reference);
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    const int width = 1280, height = 720, cols = 280, rows = 180;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Gradient mesh");
+    ege_set_worker_threads(0);
+
+    int failed = checkMesh();
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        closegraph();
+        return failed;
+    }
+
+    std::vector<ege_colpoint> vertices((cols + 1) * (rows + 1));
+    std::vector<uint32_t>     indices;
+    gridIndices(cols, rows, indices);
+    const int triangles = (int)indices.size() / 3;
+
+    fps f;
+    for (double t = 0.0; is_run(); delay_fps(60), t += 0.03) {
+        for (int j = 0; j <= rows; ++j) {
+            for (int i = 0; i <= cols; ++i) {
+                ege_colpoint& v     = vertices[j * (cols + 1) + i];
+                double        field = sin(i * 0.05 + t) * cos(j * 0.07 - t * 0.7) + sin((i + j) * 0.02 + t * 1.3);
+                v.x                 = (float)i * width / cols;
+                v.y                 = (float)j * height / rows;
+                v.color             = HSVtoRGB((float)(240.0 - (field + 2.0) * 60.0), 0.9f, 0.95f);
+            }
+        }
+
+        fillmesh_gradient(&vertices[0], &indices[0], triangles);
+
+        settextcolor(failed == 0 ? WHITE : LIGHTRED);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, height - 20, "output checks: %d of 3 failed", failed);
+    }
+
+    closegraph();
+    return failed;
+}
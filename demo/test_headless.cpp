@@ -0,0 +1,61 @@
+/**
+ * @file test_headless.cpp
+ * @brief Batch chart rendering with initgraph_headless, no window is created
+ *
+ * Renders a series of bar charts into the offscreen image, saves each one as PNG and writes
+ * the timings to headless_report.txt.
+ */
+
+#include <graphics.h>
+#include <ege/headless.h>
+
+#include <math.h>
+#include <stdio.h>
+
+int main()
+{
+    const int width = 480, height = 320, charts = 20;
+
+    double start = fclock();
+    if (initgraph_headless(width, height) != grOk) {
+        return 1;
+    }
+    double startup = fclock() - start;
+
+    start = fclock();
+    for (int n = 0; n < charts; ++n) {
+        setbkcolor(WHITE);
+        cleardevice();
+        setcolor(EGERGB(0x40, 0x40, 0x40));
+        line(40, height - 40, width - 20, height - 40);
+        line(40, 20, 40, height - 40);
+
+        for (int i = 0; i < 12; ++i) {
+            int value = (int)((sin(n * 0.7 + i * 0.5) * 0.5 + 0.5) * (height - 80));
+            setfillcolor(HSVtoRGB((float)(i * 30), 0.6f, 0.85f));
+            bar(50 + i * 35, height - 40 - value, 75 + i * 35, height - 40);
+        }
+
+        char title[64];
+        snprintf(title, sizeof(title), "chart %d", n);
+        setbkmode(TRANSPARENT);
+        settextcolor(BLACK);
+        setfont(18, 0, "Arial");
+        outtextxy(50, 4, title);
+
+        char file[64];
+        snprintf(file, sizeof(file), "chart_%03d.png", n);
+        savepng(getheadlessimage(), file);
+    }
+    double render = fclock() - start;
+
+    closegraph_headless();
+
+    FILE* report = fopen("headless_report.txt", "w");
+    if (report != NULL) {
+        fprintf(report, "startup %.2f ms, %d charts in %.2f ms (%.2f ms each)\n", startup * 1000.0, charts,
+            render * 1000.0, render * 1000.0 / charts);
+        fclose(report);
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file test_image_async.cpp
+ * @brief Loading 300 textures with getimage_async while the UI keeps animating
+ *
+ * Press Space to load getimage.png and getimage.jpg 150 times each. The loads run on the loader
+ * threads and arrive through ege_load_dispatch(), so the spinning bar keeps moving; press S to
+ * load the same set with getimage() on the drawing thread and watch it freeze instead.
+ *
+ * Keys:
+ *   Space load asynchronously
+ *   S     load synchronously
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/image_async.h>
+
+#include <math.h>
+#include <stdio.h>
+
+static int loaded = 0, failed = 0;
+
+static void onLoaded(PIMAGE, int result, void*)
+{
+    if (result == grOk) {
+        ++loaded;
+    } else {
+        ++failed;
+    }
+}
+
+int main()
+{
+    const int width = 1280, height = 720, count = 300;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Asynchronous image loading");
+
+    PIMAGE textures[count];
+    for (int i = 0; i < count; ++i) {
+        textures[i] = newimage();
+    }
+    const wchar_t* files[2] = {L"getimage.png", L"getimage.jpg"};
+    double         start = 0.0, elapsed = 0.0;
+
+    for (double t = 0.0; is_run(); delay_fps(60), t += 0.05) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                for (int i = 0; i < count; ++i) {
+                    delimage(textures[i]);
+                }
+                closegraph();
+                return 0;
+            } else if (msg.key == key_space) {
+                loaded = failed = 0;
+                start  = fclock();
+                for (int i = 0; i < count; ++i) {
+                    ege_load_close(getimage_async(textures[i], files[i % 2], onLoaded));
+                }
+            } else if (msg.key == key_S) {
+                loaded = failed = 0;
+                start  = fclock();
+                for (int i = 0; i < count; ++i) {
+                    onLoaded(textures[i], getimage(textures[i], files[i % 2]), NULL);
+                }
+                elapsed = fclock() - start;
+            }
+        }
+        if (ege_load_dispatch() > 0 && loaded + failed == count) {
+            elapsed = fclock() - start;
+        }
+
+        cleardevice();
+        for (int i = 0; i < loaded && i < 60; ++i) {
+            putimage(20 + (i % 12) * 100, 60 + (i / 12) * 100, 90, 90, textures[i], 0, 0, getwidth(textures[i]),
+                getheight(textures[i]));
+        }
+        setfillcolor(EGERGB(0x40, 0xA0, 0xFF));
+        ege_fillrect((float)(width / 2 + cos(t) * 400 - 20), (float)(height - 80), 40.0f, 40.0f);
+
+        char text[128];
+        snprintf(text, sizeof(text), "%d/%d loaded, %d failed, %d loader threads, last set %.2f s", loaded, count, failed,
+            ege_get_load_threads(), elapsed);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, text);
+    }
+
+    for (int i = 0; i < count; ++i) {
+        delimage(textures[i]);
+    }
+    closegraph();
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file test_image_memory.cpp
+ * @brief Decoding and encoding images in memory with getimage_frommemory/saveimage_tomemory
+ *
+ * getimage.png is read into a byte buffer once, as if it came out of a pack file, and decoded
+ * from there. Space encodes the decoded image into the next format in memory and decodes the
+ * result again, showing both images side by side with the encoded size and timings.
+ *
+ * Keys:
+ *   Space encode into the next format
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/image_codec.h>
+
+#include <stdio.h>
+
+static bool readFile(const char* name, std::vector<uint8_t>& data)
+{
+    FILE* fp = fopen(name, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    data.resize((size_t)ftell(fp));
+    fseek(fp, 0, SEEK_SET);
+    bool ok = !data.empty() && fread(&data[0], 1, data.size(), fp) == data.size();
+    fclose(fp);
+    return ok;
+}
+
+int main()
+{
+    const int width = 1280, height = 720;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Images in memory");
+
+    const char* names[] = {"PNG", "BMP", "JPEG", "GIF", "TIFF"};
+
+    std::vector<uint8_t> packed, encoded;
+    PIMAGE               source = newimage(), decoded = newimage();
+    char                 text[192];
+    if (!readFile("getimage.png", packed)) {
+        snprintf(text, sizeof(text), "getimage.png not found");
+    } else {
+        double start = fclock();
+        int    ret   = getimage_frommemory(source, &packed[0], packed.size());
+        snprintf(text, sizeof(text), "getimage_frommemory: %d, %d bytes -> %dx%d in %.2f ms", ret, (int)packed.size(),
+            getwidth(source), getheight(source), (fclock() - start) * 1000.0);
+    }
+    char status[192] = "Space: encode into the next format";
+    int  format      = 0;
+
+    for (; is_run(); delay_fps(60)) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                delimage(source);
+                delimage(decoded);
+                closegraph();
+                return 0;
+            } else if (msg.key == key_space) {
+                double start   = fclock();
+                int    ret     = saveimage_tomemory(source, (image_format)format, encoded, true);
+                double encTime = fclock() - start;
+                start          = fclock();
+                if (ret == grOk) {
+                    ret = getimage_frommemory(decoded, &encoded[0], encoded.size());
+                }
+                snprintf(status, sizeof(status), "%s: result %d, %d bytes, encode %.2f ms, decode %.2f ms", names[format],
+                    ret, ret == grOk ? (int)encoded.size() : 0, encTime * 1000.0, (fclock() - start) * 1000.0);
+                format = (format + 1) % 5;
+            }
+        }
+
+        cleardevice();
+        putimage(20, 60, source);
+        putimage(width / 2 + 20, 60, decoded);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, text);
+        outtextxy(6, 24, status);
+    }
+
+    delimage(source);
+    delimage(decoded);
+    closegraph();
+    return 0;
+}
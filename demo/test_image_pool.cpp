@@ -0,0 +1,56 @@
+/**
+ * @file test_image_pool.cpp
+ * @brief Per-frame scratch layers with newimage_pooled/delimage_pooled
+ *
+ * Every frame a few scratch layers of varying sizes are taken from the image pool, drawn on,
+ * composited onto the window and returned to the pool. A backdrop follows a window-like size
+ * that changes every second through resize_pooled. The pool counters are shown at the top.
+ */
+
+#include <graphics.h>
+#include <ege/image_pool.h>
+
+int main()
+{
+    const int width = 1280, height = 720, layers = 8;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Image pool");
+
+    const int sizes[4][2] = {{256, 256}, {512, 128}, {320, 240}, {128, 512}};
+    PIMAGE    backdrop    = newimage_pooled(width / 2, height / 2);
+
+    for (int frame = 0; is_run(); delay_fps(60), ++frame) {
+        // A backdrop following a window that switches between two sizes.
+        if (frame % 60 == 0) {
+            int w = (frame / 60) % 2 ? width / 2 : width / 3, h = (frame / 60) % 2 ? height / 2 : height / 3;
+            resize_pooled(backdrop, w, h);
+            setbkcolor(EGERGB(0x30, 0x38, 0x48), backdrop);
+            cleardevice(backdrop);
+        }
+
+        cleardevice();
+        putimage(0, 0, backdrop);
+        for (int i = 0; i < layers; ++i) {
+            const int* size  = sizes[(frame + i) % 4];
+            PIMAGE     layer = newimage_pooled(size[0], size[1]);
+            setbkcolor(HSVtoRGB((float)(i * 45), 0.5f, 0.6f), layer);
+            cleardevice(layer);
+            setcolor(WHITE, layer);
+            circle(size[0] / 2, size[1] / 2, size[1] / 3, layer);
+            putimage((i % 4) * 300 + 20, (i / 4) * 330 + 40, layer);
+            delimage_pooled(layer);
+        }
+
+        ege_image_pool_stats stats;
+        ege_image_pool_get_stats(&stats);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, 4, "hit rate %.0f%%, live %lu KiB, pooled %lu KiB in %d images", stats.hitRate * 100.0f,
+            stats.liveBytes / 1024, stats.pooledBytes / 1024, stats.pooledImages);
+    }
+
+    delimage_pooled(backdrop);
+    ege_image_pool_clear();
+    closegraph();
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file test_image_view.cpp
+ * @brief Editing the tiles of an atlas in place through newimage_view
+ *
+ * A 4x4 atlas of 256x256 tiles is drawn through one view per tile: every frame each tile gets
+ * new circles, and the tile under the mouse is blurred. Blurs never read across tile borders,
+ * so neighbouring tiles do not bleed into each other. Clicking flood fills inside a tile.
+ */
+
+#include <graphics.h>
+#include <ege/image_view.h>
+
+#include <stdlib.h>
+
+int main()
+{
+    const int tile = 256, tiles = 4, size = tile * tiles;
+    initgraph(size, size, INIT_RENDERMANUAL);
+    setcaption("Image views");
+    ege_set_worker_threads(0);
+
+    PIMAGE atlas = newimage(size, size);
+    setbkcolor(EGERGB(0x20, 0x20, 0x28), atlas);
+    cleardevice(atlas);
+
+    ege_image_view views[tiles * tiles];
+    for (int i = 0; i < tiles * tiles; ++i) {
+        views[i] = newimage_view(atlas, (i % tiles) * tile, (i / tiles) * tile, tile, tile);
+    }
+
+    int mouseX = 0, mouseY = 0;
+    for (; is_run(); delay_fps(60)) {
+        while (mousemsg()) {
+            mouse_msg msg = getmouse();
+            mouseX        = msg.x;
+            mouseY        = msg.y;
+            if (msg.is_left() && msg.is_down()) {
+                const ege_image_view& v = views[(mouseY / tile) * tiles + mouseX / tile];
+                int                   x = mouseX % tile, y = mouseY % tile;
+                setfillcolor(HSVtoRGB((float)(rand() % 360), 0.8f, 0.9f), atlas);
+                floodfillsurface_f(x, y, getbuffer(v)[y * getstride(v) + x], v);
+            }
+        }
+
+        for (int i = 0; i < tiles * tiles; ++i) {
+            float   xyr[3 * 4];
+            color_t colors[4];
+            for (int k = 0; k < 4; ++k) {
+                xyr[k * 3]     = (float)(rand() % tile);
+                xyr[k * 3 + 1] = (float)(rand() % tile);
+                xyr[k * 3 + 2] = (float)(2 + rand() % 12);
+                colors[k]      = EGEACOLOR(160, HSVtoRGB((float)(i * 22 + rand() % 20), 0.7f, 0.95f));
+            }
+            ege_fillcircles(4, xyr, colors, views[i]);
+        }
+        if (mouseX >= 0 && mouseX < size && mouseY >= 0 && mouseY < size) {
+            imagefilter_gaussian(views[(mouseY / tile) * tiles + mouseX / tile], 3.0f);
+        }
+
+        putimage(0, 0, atlas);
+    }
+
+    delimage(atlas);
+    closegraph();
+    return 0;
+}
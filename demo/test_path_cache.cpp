@@ -0,0 +1,107 @@
+/**
+ * @file test_path_cache.cpp
+ * @brief ege_fillpath_cached/ege_drawpath_cached with glyph outline paths
+ *
+ * A few text outlines built once with ege_path_addtext() are drawn many times per frame at
+ * moving positions and angles, which reuses their cached geometry. A check scene strokes each
+ * path off-screen with ege_drawpath_cached() and ege_render_drawpath() on the native backend and
+ * shows the largest pixel difference between them, which should be 0.
+ */
+
+#include <graphics.h>
+#include <ege/path_cache.h>
+
+#include <math.h>
+#include <stdlib.h>
+
+/// Largest channel difference between cached and uncached native strokes of the paths.
+int compareStrokes(ege_path* const* paths, int count)
+{
+    const int      w = 360, h = 120;
+    PIMAGE         cachedImg = newimage(w, h), uncachedImg = newimage(w, h);
+    render_backend backend   = ege_get_render_backend();
+    ege_set_render_backend(RENDER_BACKEND_NATIVE);
+
+    int worst = 0;
+    for (int i = 0; i < count; ++i) {
+        ege_transform_matrix m = {1.5f, 0.4f, -0.4f, 1.5f, w / 2.0f, h / 2.0f};
+        PIMAGE               images[2] = {cachedImg, uncachedImg};
+        for (int k = 0; k < 2; ++k) {
+            setbkcolor(BLACK, images[k]);
+            cleardevice(images[k]);
+            ege_set_transform(&m, images[k]);
+            setlinecolor(WHITE, images[k]);
+            setlinewidth(3.0f, images[k]);
+        }
+        ege_drawpath_cached(paths[i], cachedImg);     // fills the cache
+        cleardevice(cachedImg);
+        ege_drawpath_cached(paths[i], cachedImg);     // draws from the cache
+        ege_render_drawpath(paths[i], uncachedImg);
+
+        const color_t* a = getbuffer(cachedImg);
+        const color_t* b = getbuffer(uncachedImg);
+        for (int p = 0; p < w * h; ++p) {
+            for (int shift = 0; shift < 24; shift += 8) {
+                int delta = abs((int)((a[p] >> shift) & 0xFF) - (int)((b[p] >> shift) & 0xFF));
+                worst     = delta > worst ? delta : worst;
+            }
+        }
+    }
+
+    ege_set_render_backend(backend);
+    delimage(cachedImg);
+    delimage(uncachedImg);
+    return worst;
+}
+
+int main()
+{
+    const int width = 1280, height = 720, copies = 60;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Path cache");
+    setbkcolor(EGERGB(0x10, 0x18, 0x20));
+    ege_set_worker_threads(0);
+    ege_enable_aa(true);
+
+    const char* words[4] = {"EGE", "Path", "Cache", "Glyph"};
+    ege_path*   paths[4];
+    for (int i = 0; i < 4; ++i) {
+        paths[i] = ege_path_create();
+        ege_path_addtext(paths[i], -60, -24, words[i], 48, -1, "Arial");
+    }
+
+    int strokeDiff = compareStrokes(paths, 4);
+
+    for (double t = 0.0; is_run(); delay_fps(60), t += 0.01) {
+        cleardevice();
+        setlinewidth(2.0f);
+        for (int i = 0; i < copies; ++i) {
+            float a = (float)(t + i * 0.4), c = cosf(a), s = sinf(a);
+            ege_transform_matrix m = {c, s, -s, c, (float)(width / 2 + cos(t * 0.7 + i) * (width / 2 - 120)),
+                (float)(height / 2 + sin(t * 1.1 + i * 1.7) * (height / 2 - 80))};
+            ege_set_transform(&m);
+            setfillcolor(EGEACOLOR(200, HSVtoRGB((float)(i * 6), 0.7f, 0.95f)));
+            setlinecolor(WHITE);
+            const ege_path* path = paths[i % 4];
+            ege_fillpath_cached(path);
+            ege_drawpath_cached(path);
+        }
+        ege_transform_matrix identity = {1, 0, 0, 1, 0, 0};
+        ege_set_transform(&identity);
+
+        ege_path_cache_stats stats;
+        ege_path_cache_get_stats(&stats);
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, 4, "hits %lu, misses %lu, entries %d", stats.hits, stats.misses, stats.entries);
+        xyprintf(6, 22, "cached vs uncached native stroke: max difference %d %s", strokeDiff,
+            strokeDiff == 0 ? "(match)" : "(MISMATCH)");
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        ege_path_cache_invalidate(paths[i]);
+        ege_path_destroy(paths[i]);
+    }
+    closegraph();
+    return 0;
+}
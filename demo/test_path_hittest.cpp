@@ -0,0 +1,82 @@
+/**
+ * @file test_path_hittest.cpp
+ * @brief Lasso selection over a million scatter points with ege_path_inpath_batch
+ *
+ * Drag with the left mouse button to draw a lasso; the points inside it are highlighted each
+ * frame while dragging.
+ */
+
+#include <graphics.h>
+#include <ege/path_hittest.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+int main()
+{
+    const int width = 1280, height = 720, count = 1000000;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Lasso hit test");
+    ege_set_worker_threads(0);
+
+    // Gaussian-ish clusters of points.
+    std::vector<ege_point> points(count);
+    for (int i = 0; i < count; ++i) {
+        float cx = (float)(200 + (i % 5) * 220), cy = (float)(200 + (i % 3) * 160);
+        float a = (float)(rand() % 6283) / 1000.0f, r = (float)((rand() % 1000) * (rand() % 1000)) / 6000.0f;
+        points[i].x = cx + r * cosf(a);
+        points[i].y = cy + r * sinf(a);
+    }
+    std::vector<uint8_t>   selected(count, 0);
+    std::vector<ege_point> lasso;
+    bool                   dragging = false;
+    int                    inside   = 0;
+
+    for (; is_run(); delay_fps(60)) {
+        while (mousemsg()) {
+            mouse_msg msg = getmouse();
+            if (msg.is_left() && msg.is_down()) {
+                dragging = true;
+                lasso.clear();
+            } else if (msg.is_left() && msg.is_up()) {
+                dragging = false;
+            }
+            if (dragging) {
+                ege_point p = {(float)msg.x, (float)msg.y};
+                lasso.push_back(p);
+            }
+        }
+
+        if (dragging && lasso.size() > 2) {
+            ege_path* path = ege_path_create();
+            ege_path_addpolygon(path, (int)lasso.size(), &lasso[0]);
+            ege_path_inpath_batch(path, &points[0], count, &selected[0]);
+            ege_path_destroy(path);
+            inside = 0;
+            for (int i = 0; i < count; ++i) {
+                inside += selected[i];
+            }
+        }
+
+        cleardevice();
+        color_t* buffer = getbuffer((PIMAGE)NULL);
+        for (int i = 0; i < count; ++i) {
+            int x = (int)points[i].x, y = (int)points[i].y;
+            if (x >= 0 && x < width && y >= 0 && y < height) {
+                buffer[y * width + x] = selected[i] ? EGERGB(0xFF, 0xD0, 0x40) : EGERGB(0x50, 0x70, 0x90);
+            }
+        }
+        if (lasso.size() > 1) {
+            setlinecolor(WHITE);
+            ege_drawpoly((int)lasso.size(), &lasso[0]);
+        }
+
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, 4, "%d points, %d selected", count, inside);
+    }
+
+    closegraph();
+    return 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file test_png_encoder.cpp
+ * @brief Saving a 3840x2160 frame with savepng and with savepng_ex on several threads
+ *
+ * A 4K scene is drawn into an off-screen image and saved as PNG, either with the library's
+ * savepng() or with savepng_ex() at the selected level and filter. The HUD shows the time and
+ * the file size of the last save of each kind.
+ *
+ * Keys:
+ *   Space save with savepng
+ *   E     save with savepng_ex
+ *   +/-   compression level of savepng_ex
+ *   F     next filter
+ *   T     toggle between 1 thread and one per processor
+ *   Esc   quit
+ */
+
+#include <graphics.h>
+#include <ege/image_png.h>
+
+#include <stdio.h>
+
+static long fileSize(const char* name)
+{
+    FILE* fp = fopen(name, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+int main()
+{
+    const int width = 1280, height = 720, frameW = 3840, frameH = 2160;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Multithreaded PNG encoder");
+
+    PIMAGE frame = newimage(frameW, frameH);
+    for (int i = 0; i < 400; ++i) {
+        setfillcolor(HSVtoRGB((float)(i * 37 % 360), 0.6f, 0.9f), frame);
+        ege_fillellipse((float)(i * 977 % frameW), (float)(i * 571 % frameH), 300.0f, 200.0f, frame);
+    }
+    settextcolor(WHITE, frame);
+    setfont(120, 0, "Consolas", frame);
+    outtextxy(200, frameH / 2, "savepng_ex", frame);
+
+    const char*     filters[] = {"none", "sub", "up", "average", "paeth", "adaptive"};
+    ege_png_options options   = ege_png_default_options();
+    double          baseTime = 0.0, exTime = 0.0;
+    long            baseSize = 0, exSize = 0;
+
+    for (; is_run(); delay_fps(60)) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                delimage(frame);
+                closegraph();
+                return 0;
+            } else if (msg.key == key_space) {
+                double start = fclock();
+                savepng(frame, "frame_savepng.png");
+                baseTime = fclock() - start;
+                baseSize = fileSize("frame_savepng.png");
+            } else if (msg.key == key_E) {
+                double start = fclock();
+                savepng_ex(frame, "frame_savepng_ex.png", &options);
+                exTime = fclock() - start;
+                exSize = fileSize("frame_savepng_ex.png");
+            } else if (msg.key == key_plus && options.level < 8) {
+                ++options.level;
+            } else if (msg.key == key_minus && options.level > 0) {
+                --options.level;
+            } else if (msg.key == key_F) {
+                options.filter = (png_filter_type)((options.filter + 1) % 6);
+            } else if (msg.key == key_T) {
+                ege_set_worker_threads(ege_get_worker_threads() == 1 ? 0 : 1);
+            }
+        }
+
+        cleardevice();
+        putimage(0, 0, width, height, frame, 0, 0, frameW, frameH);
+
+        char text[192];
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        snprintf(text, sizeof(text), "savepng:    %.0f ms, %ld KiB", baseTime * 1000.0, baseSize / 1024);
+        outtextxy(6, 4, text);
+        snprintf(text, sizeof(text), "savepng_ex: %.0f ms, %ld KiB (level %d, filter %s, %d threads)", exTime * 1000.0,
+            exSize / 1024, options.level, filters[options.filter], ege_get_worker_threads());
+        outtextxy(6, 24, text);
+    }
+
+    delimage(frame);
+    closegraph();
+    return 0;
+}
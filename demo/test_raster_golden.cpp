@@ -0,0 +1,255 @@
+/**
+ * @file test_raster_golden.cpp
+ * @brief Compare the native rasterizer of ege/raster.h with GDI+
+ *
+ * Every scene is drawn once with RENDER_BACKEND_GDIPLUS as the golden image and once with
+ * RENDER_BACKEND_NATIVE. The window shows both with an amplified difference image, and the
+ * per-scene results (largest channel difference, mean difference, share of pixels off by more
+ * than 32, time of each backend) are written to raster_golden.txt, each measure next to its limit.
+ *
+ * Each scene has limits for the three measures; a scene that exceeds one is marked FAIL and the
+ * program exits with the number of failed scenes. Run it with --check to write the report and
+ * exit without opening the interactive view.
+ *
+ * Keys:
+ *   Left/Right previous/next scene
+ *   Esc        quit
+ */
+
+#include <graphics.h>
+#include <ege/raster.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const int SCENE_W = 400, SCENE_H = 300, SCENES = 6;
+
+struct scene_limit
+{
+    int    maxDiff;     ///< Largest channel difference
+    double meanDiff;    ///< Mean of the largest channel difference per pixel
+    double badShare;    ///< Percentage of pixels off by more than 32
+};
+
+/**
+ * Anti-aliasing differs slightly between the renderers, strokes more than fills. A quarter-pixel
+ * shift of a solid edge costs at most 64; a missing or misplaced cap, join or winding region
+ * differs by about 200 over 90 pixels or more, so maxDiff is what catches those.
+ */
+const scene_limit SCENE_LIMITS[SCENES] = {
+    {64, 0.3, 0.1},     // star, alternate
+    {64, 0.3, 0.1},     // star, winding
+    {96, 0.6, 0.3},     // bezier outline
+    {96, 0.8, 0.3},     // polyline caps and joins
+    {96, 0.8, 0.3},     // transformed stroke
+    {112, 1.5, 1.0},    // many lines
+};
+
+const char* sceneName(int scene)
+{
+    static const char* names[SCENES] = {"star, alternate", "star, winding", "bezier outline", "polyline caps and joins",
+        "transformed stroke", "many lines"};
+    return names[scene];
+}
+
+void drawScene(int scene, PIMAGE img)
+{
+    setbkcolor(BLACK, img);
+    cleardevice(img);
+    ege_enable_aa(true, img);
+    setfillcolor(EGEACOLOR(220, EGERGB(0x40, 0xA0, 0xFF)), img);
+    setlinecolor(EGEACOLOR(230, EGERGB(0xFF, 0xC0, 0x40)), img);
+    setlinestyle(PS_SOLID, 0, 1, img);
+    ege_transform_matrix identity = {1, 0, 0, 1, 0, 0};
+    ege_set_transform(&identity, img);
+
+    if (scene <= 1) {
+        ege_point star[5];
+        for (int i = 0; i < 5; ++i) {
+            float a = (float)(-PI / 2 + i * 4 * PI / 5);
+            star[i].x = SCENE_W / 2 + 130 * cosf(a);
+            star[i].y = SCENE_H / 2 + 10 + 130 * sinf(a);
+        }
+        ege_path* path = ege_path_create();
+        ege_path_addpolygon(path, 5, star);
+        ege_path_addcircle(path, SCENE_W / 2.0f, SCENE_H / 2.0f + 10, 40);
+        ege_render_fillpath(path, scene == 0 ? FILLMODE_ALTERNATE : FILLMODE_WINDING, img);
+        ege_path_destroy(path);
+    } else if (scene == 2) {
+        ege_path* path = ege_path_create();
+        ege_path_addellipse(path, 40, 40, 200, 140);
+        ege_path_addbezier(path, 60, 260, 160, 120, 260, 320, 360, 180);
+        ege_path_addarc(path, 220, 60, 150, 150, 30, 240);
+        ege_render_fillpath(path, FILLMODE_DEFAULT, img);
+        setlinewidth(3.0f, img);
+        ege_render_drawpath(path, img);
+        ege_path_destroy(path);
+    } else if (scene == 3) {
+        const line_cap_type  caps[3]  = {LINECAP_FLAT, LINECAP_SQUARE, LINECAP_ROUND};
+        const line_join_type joins[3] = {LINEJOIN_MITER, LINEJOIN_BEVEL, LINEJOIN_ROUND};
+        setlinewidth(14.0f, img);
+        for (int i = 0; i < 3; ++i) {
+            ege_point pts[4] = {{30.0f + i * 125, 260}, {60.0f + i * 125, 50}, {100.0f + i * 125, 200}, {140.0f + i * 125, 80}};
+            setlinecap(caps[i], img);
+            setlinejoin(joins[i], img);
+            ege_path* path = ege_path_create();
+            ege_path_addpolyline(path, 4, pts);
+            ege_render_drawpath(path, img);
+            ege_path_destroy(path);
+        }
+        setlinecap(LINECAP_FLAT, img);
+        setlinejoin(LINEJOIN_MITER, img);
+    } else if (scene == 4) {
+        ege_transform_matrix m = {0.9f, 0.35f, -0.5f, 1.1f, 170, 20};
+        ege_set_transform(&m, img);
+        setlinewidth(6.0f, img);
+        setlinejoin(LINEJOIN_ROUND, img);
+        ege_path* path = ege_path_create();
+        ege_path_addrect(path, 20, 20, 160, 120);
+        ege_path_addcircle(path, 100, 80, 40);
+        ege_render_drawpath(path, img);
+        ege_path_destroy(path);
+        setlinejoin(LINEJOIN_MITER, img);
+    } else {
+        srand(7);
+        setlinewidth(2.0f, img);
+        for (int i = 0; i < 300; ++i) {
+            setlinecolor(EGEACOLOR(160, HSVtoRGB((float)(i % 360), 0.8f, 1.0f)), img);
+            ege_render_line((float)(rand() % SCENE_W), (float)(rand() % SCENE_H), (float)(rand() % SCENE_W),
+                (float)(rand() % SCENE_H), img);
+        }
+    }
+}
+
+struct compare_result
+{
+    int    maxDiff;
+    double meanDiff, badShare, gdiplusMs, nativeMs;
+    bool   pass;
+};
+
+compare_result runScene(int scene, PIMAGE golden, PIMAGE native, PIMAGE diff)
+{
+    compare_result r;
+    ege_set_render_backend(RENDER_BACKEND_GDIPLUS);
+    double start = fclock();
+    drawScene(scene, golden);
+    r.gdiplusMs = (fclock() - start) * 1000.0;
+
+    ege_set_render_backend(RENDER_BACKEND_NATIVE);
+    start = fclock();
+    drawScene(scene, native);
+    r.nativeMs = (fclock() - start) * 1000.0;
+
+    const color_t* a = getbuffer(golden);
+    const color_t* b = getbuffer(native);
+    color_t*       d = getbuffer(diff);
+    long long      total = 0;
+    int            bad   = 0;
+    r.maxDiff            = 0;
+    for (int i = 0; i < SCENE_W * SCENE_H; ++i) {
+        int worst = 0;
+        for (int shift = 0; shift < 24; shift += 8) {
+            int delta = abs((int)((a[i] >> shift) & 0xFF) - (int)((b[i] >> shift) & 0xFF));
+            worst     = delta > worst ? delta : worst;
+        }
+        total += worst;
+        bad += worst > 32;
+        r.maxDiff = worst > r.maxDiff ? worst : r.maxDiff;
+        int v     = worst * 4 > 255 ? 255 : worst * 4;
+        d[i]      = EGERGB(v, v, v);
+    }
+    r.meanDiff = (double)total / (SCENE_W * SCENE_H);
+    r.badShare = 100.0 * bad / (SCENE_W * SCENE_H);
+    r.pass     = r.maxDiff <= SCENE_LIMITS[scene].maxDiff && r.meanDiff <= SCENE_LIMITS[scene].meanDiff
+             && r.badShare <= SCENE_LIMITS[scene].badShare;
+    ege_set_render_backend(RENDER_BACKEND_GDIPLUS);
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    initgraph(SCENE_W * 3, SCENE_H + 40, INIT_RENDERMANUAL);
+    setcaption("Native rasterizer vs GDI+");
+    ege_set_worker_threads(0);
+
+    PIMAGE golden = newimage(SCENE_W, SCENE_H);
+    PIMAGE native = newimage(SCENE_W, SCENE_H);
+    PIMAGE diff   = newimage(SCENE_W, SCENE_H);
+
+    int   failed = 0;
+    FILE* report = fopen("raster_golden.txt", "w");
+    for (int scene = 0; scene < SCENES; ++scene) {
+        compare_result r = runScene(scene, golden, native, diff);
+        failed += !r.pass;
+        if (report != NULL) {
+            const scene_limit& l = SCENE_LIMITS[scene];
+            fprintf(report,
+                "%-24s max %3d/%3d  mean %5.2f/%4.2f  >32: %5.2f%%/%4.2f%%  gdi+ %7.2f ms  native %7.2f ms  %s\n",
+                sceneName(scene), r.maxDiff, l.maxDiff, r.meanDiff, l.meanDiff, r.badShare, l.badShare, r.gdiplusMs,
+                r.nativeMs, r.pass ? "ok" : "FAIL");
+        }
+    }
+    if (report != NULL) {
+        fprintf(report, "%d of %d scenes failed\n", failed, SCENES);
+        fclose(report);
+    }
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        delimage(golden);
+        delimage(native);
+        delimage(diff);
+        closegraph();
+        return failed;
+    }
+
+    int scene = 0;
+    for (bool redraw = true; is_run(); delay_fps(30)) {
+        while (kbmsg()) {
+            key_msg msg = getkey();
+            if (msg.msg != key_msg_down) {
+                continue;
+            }
+            if (msg.key == key_esc) {
+                delimage(golden);
+                delimage(native);
+                delimage(diff);
+                closegraph();
+                return failed;
+            } else if (msg.key == key_left) {
+                scene  = (scene + SCENES - 1) % SCENES;
+                redraw = true;
+            } else if (msg.key == key_right) {
+                scene  = (scene + 1) % SCENES;
+                redraw = true;
+            }
+        }
+        if (!redraw) {
+            continue;
+        }
+        redraw = false;
+
+        compare_result r = runScene(scene, golden, native, diff);
+        cleardevice();
+        putimage(0, 40, golden);
+        putimage(SCENE_W, 40, native);
+        putimage(SCENE_W * 2, 40, diff);
+
+        char text[160];
+        snprintf(text, sizeof(text), "%d/%d %s: max %d, mean %.2f, >32: %.2f%%, GDI+ %.2f ms, native %.2f ms  %s",
+            scene + 1, SCENES, sceneName(scene), r.maxDiff, r.meanDiff, r.badShare, r.gdiplusMs, r.nativeMs,
+            r.pass ? "ok" : "FAIL");
+        settextcolor(WHITE);
+        setbkmode(TRANSPARENT);
+        setfont(16, 0, "Consolas");
+        outtextxy(6, 4, text);
+        outtextxy(6, 20, "GDI+ (golden) | native | difference x4");
+    }
+
+    delimage(golden);
+    delimage(native);
+    delimage(diff);
+    closegraph();
+    return failed;
+}
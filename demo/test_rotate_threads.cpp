@@ -0,0 +1,43 @@
+/**
+ * @file test_rotate_threads.cpp
+ * @brief Tiled, multithreaded putimage_rotatezoom_f
+ *
+ * Rotates a large texture with bilinear sampling every frame, split into tiles that the
+ * worker threads render in parallel. The frame rate is shown in the top-left corner.
+ */
+
+#include <graphics.h>
+#include <ege/fps.h>
+#include <ege/rotate.h>
+
+int main()
+{
+    const int width = 1280, height = 720;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Tiled putimage_rotatezoom");
+    setbkcolor(EGERGB(0x20, 0x20, 0x20));
+    ege_set_worker_threads(0);
+
+    PIMAGE img = newimage();
+    getimage(img, "JPG", "EGE_LOGO_JPG");
+
+    PIMAGE texture = newimage(1024, 1024);
+    for (int y = 0; y < 1024; y += getheight(img)) {
+        for (int x = 0; x < 1024; x += getwidth(img)) {
+            putimage(texture, x, y, img);
+        }
+    }
+
+    fps    f;
+    double radian = 0.0;
+    for (; is_run(); delay_fps(60)) {
+        radian += 0.01;
+        cleardevice();
+        putimage_rotatezoom_f(NULL, texture, width / 2, height / 2, 0.5f, 0.5f, (float)radian, 1.2f, false, -1, true);
+    }
+
+    delimage(texture);
+    delimage(img);
+    closegraph();
+    return 0;
+}
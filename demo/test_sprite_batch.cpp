@@ -0,0 +1,170 @@
+/**
+ * @file test_sprite_batch.cpp
+ * @brief Drawing thousands of atlas tiles with one ege_drawsprites call
+ *
+ * Tiles from one atlas bounce around the window; every few tiles are rotated, scaled or
+ * tinted. The frame rate is shown in the top-left corner.
+ *
+ * Before the animation starts, checkSprites() compares the batch with reference output:
+ * unscaled sprites against one putimage_alphablend_f call each, a sprite scaled by 2 against
+ * the tile enlarged by hand, and a mixed batch drawn with one thread against the same batch
+ * drawn with one thread per processor. The result is shown at the bottom, and the program exits
+ * with the number of failed checks. Run it with --check to exit right after the checks.
+ */
+
+#include <graphics.h>
+#include <ege/fps.h>
+#include <ege/sprites.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static void fillBackground(PIMAGE img)
+{
+    color_t* p = getbuffer(img);
+    for (int i = 0; i < getwidth(img) * getheight(img); ++i) {
+        p[i] = 0xFF000000 | (i * 2654435761u >> 8);
+    }
+}
+
+static bool sameImage(PCIMAGE a, PCIMAGE b)
+{
+    return memcmp(getbuffer(a), getbuffer(b), sizeof(color_t) * getwidth(a) * getheight(a)) == 0;
+}
+
+/// Compare ege_drawsprites with reference output; returns the number of failed checks.
+static int checkSprites(PCIMAGE atlas, int tile)
+{
+    const int w = 320, h = 200;
+    PIMAGE    batch = newimage(w, h), reference = newimage(w, h);
+    int       failed = 0;
+
+    // Unscaled sprites, partly outside the target, some translucent.
+    std::vector<ege_sprite> sprites;
+    srand(1);
+    for (int i = 0; i < 200; ++i) {
+        ege_sprite s = ege_make_sprite((i % 8) * tile, (i / 8 % 8) * tile, tile, tile,
+            (float)(rand() % (w + tile) - tile), (float)(rand() % (h + tile) - tile));
+        s.alpha = (unsigned char)(i % 3 == 0 ? 64 + rand() % 192 : 255);
+        sprites.push_back(s);
+    }
+    fillBackground(batch);
+    fillBackground(reference);
+    ege_drawsprites(atlas, &sprites[0], (int)sprites.size(), batch);
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        const ege_sprite& s = sprites[i];
+        putimage_alphablend_f(reference, atlas, (int)s.x, (int)s.y, s.alpha, s.srcX, s.srcY, s.srcW, s.srcH);
+    }
+    failed += !sameImage(batch, reference);
+
+    // A sprite scaled by 2 samples every texel into a 2x2 block.
+    PIMAGE big = newimage(tile * 2, tile * 2);
+    for (int y = 0; y < tile * 2; ++y) {
+        for (int x = 0; x < tile * 2; ++x) {
+            getbuffer(big)[y * tile * 2 + x] = getbuffer(atlas)[(3 * tile + y / 2) * getwidth(atlas) + 5 * tile + x / 2];
+        }
+    }
+    ege_sprite scaled = ege_make_sprite(5 * tile, 3 * tile, tile, tile, 37, 23);
+    scaled.scaleX = scaled.scaleY = 2.0f;
+    fillBackground(batch);
+    fillBackground(reference);
+    ege_drawsprites(atlas, &scaled, 1, batch);
+    putimage_alphablend_f(reference, big, 37, 23, 255, 0, 0, tile * 2, tile * 2);
+    failed += !sameImage(batch, reference);
+    delimage(big);
+
+    // Rotated, scaled and tinted sprites come out the same however the bands are split.
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        sprites[i].angle  = i % 4 == 0 ? (float)i : 0.0f;
+        sprites[i].scaleX = i % 5 == 0 ? 0.6f : 1.0f;
+        sprites[i].scaleY = i % 5 == 0 ? 1.7f : 1.0f;
+        sprites[i].tint   = i % 6 == 0 ? 0xFFFFC080 : 0xFFFFFFFF;
+    }
+    int threads = ege_get_worker_threads();
+    fillBackground(batch);
+    fillBackground(reference);
+    ege_set_worker_threads(1);
+    ege_drawsprites(atlas, &sprites[0], (int)sprites.size(), reference);
+    ege_set_worker_threads(0);
+    ege_drawsprites(atlas, &sprites[0], (int)sprites.size(), batch);
+    ege_set_worker_threads(threads);
+    failed += !sameImage(batch, reference);
+
+    delimage(batch);
+    delimage(reference);
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    const int width = 1280, height = 720, tile = 32;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Sprite batch");
+    setbkcolor(EGERGB(0x10, 0x18, 0x20));
+    ege_set_worker_threads(0);
+
+    // 8x8 atlas of round tiles with premultiplied alpha.
+    PIMAGE atlas = newimage(tile * 8, tile * 8);
+    for (int i = 0; i < 64; ++i) {
+        color_t c = HSVtoRGB((float)(i * 360 / 64), 0.7f, 0.95f);
+        for (int y = 0; y < tile; ++y) {
+            for (int x = 0; x < tile; ++x) {
+                float dx = x + 0.5f - tile / 2, dy = y + 0.5f - tile / 2;
+                float a  = tile / 2 - sqrtf(dx * dx + dy * dy);
+                unsigned int alpha = a <= 0.0f ? 0 : (a >= 1.0f ? 255 : (unsigned int)(a * 255));
+                putpixel_f((i % 8) * tile + x, (i / 8) * tile + y,
+                    EGEARGB(alpha, EGEGET_R(c) * alpha / 255, EGEGET_G(c) * alpha / 255, EGEGET_B(c) * alpha / 255), atlas);
+            }
+        }
+    }
+
+    int failed = checkSprites(atlas, tile);
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        delimage(atlas);
+        closegraph();
+        return failed;
+    }
+
+    struct body { float x, y, vx, vy; };
+    const int               count = 5000;
+    std::vector<body>       bodies(count);
+    std::vector<ege_sprite> sprites(count);
+    for (int i = 0; i < count; ++i) {
+        body b = {(float)(rand() % (width - tile)), (float)(rand() % (height - tile)), (rand() % 200 - 100) / 40.0f,
+            (rand() % 200 - 100) / 40.0f};
+        bodies[i] = b;
+    }
+
+    fps f;
+    for (double t = 0.0; is_run(); delay_fps(60), t += 0.02) {
+        for (int i = 0; i < count; ++i) {
+            body& b = bodies[i];
+            b.x += b.vx;
+            b.y += b.vy;
+            if (b.x < 0 || b.x > width - tile)  b.vx = -b.vx;
+            if (b.y < 0 || b.y > height - tile) b.vy = -b.vy;
+
+            sprites[i] = ege_make_sprite((i % 64 % 8) * tile, (i % 64 / 8) * tile, tile, tile, b.x, b.y);
+            if (i % 7 == 0) {
+                sprites[i].angle  = (float)(t + i);
+                sprites[i].scaleX = sprites[i].scaleY = 0.75f + 0.25f * (float)sin(t * 3 + i);
+            } else if (i % 7 == 1) {
+                sprites[i].tint  = 0xFFFFC080;
+                sprites[i].alpha = 160;
+            }
+        }
+
+        cleardevice();
+        ege_drawsprites(atlas, &sprites[0], count, NULL);
+
+        settextcolor(failed == 0 ? WHITE : LIGHTRED);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, height - 20, "output checks: %d of 3 failed", failed);
+    }
+
+    delimage(atlas);
+    closegraph();
+    return failed;
+}
@@ -0,0 +1,182 @@
+/**
+ * @file test_triangles.cpp
+ * @brief A waving textured flag drawn with ege_drawtriangles
+ *
+ * A grid of textured triangles is displaced by a travelling wave every frame and drawn with
+ * bilinear filtering. The frame rate is shown in the top-left corner.
+ *
+ * Before the animation starts, checkTriangles() checks the rasterizer: a texture mapped 1:1
+ * onto two triangles must come out unchanged, a jittered triangulation of a rectangle must cover
+ * exactly the pixels whose centers lie inside it, texture coordinates beyond the edge must
+ * repeat the edge texels, even thousands of texture widths away, and a mesh drawn with one thread must match the same mesh drawn with
+ * one thread per processor. The result is shown at the bottom, and the program exits with the
+ * number of failed checks. Run it with --check to exit right after the checks.
+ */
+
+#include <graphics.h>
+#include <ege/fps.h>
+#include <ege/triangles.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static bool sameImage(PCIMAGE a, PCIMAGE b)
+{
+    return memcmp(getbuffer(a), getbuffer(b), sizeof(color_t) * getwidth(a) * getheight(a)) == 0;
+}
+
+/// Grid of (cols + 1) x (rows + 1) vertices, two triangles per cell.
+static void gridIndices(int cols, int rows, std::vector<uint32_t>& indices)
+{
+    indices.clear();
+    for (int j = 0; j < rows; ++j) {
+        for (int i = 0; i < cols; ++i) {
+            uint32_t p1 = j * (cols + 1) + i, p2 = p1 + 1, p3 = p1 + cols + 1, p4 = p3 + 1;
+            uint32_t quad[6] = {p1, p2, p3, p3, p2, p4};
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+/// Check the output of ege_drawtriangles; returns the number of failed checks.
+static int checkTriangles()
+{
+    const int w = 200, h = 160, tw = 64, th = 48;
+    PIMAGE    texture = newimage(tw, th), target = newimage(w, h), reference = newimage(w, h);
+    int       failed  = 0;
+
+    for (int i = 0; i < tw * th; ++i) {
+        getbuffer(texture)[i] = 0xFF000000 | (i * 2654435761u >> 8);
+    }
+
+    // A texture mapped 1:1 onto two triangles comes out unchanged.
+    ege_vertex quad[4] = {{30, 20, 0, 0}, {30 + tw, 20, 1, 0}, {30, 20 + th, 0, 1}, {30 + tw, 20 + th, 1, 1}};
+    uint32_t   quadIndices[6] = {0, 1, 2, 2, 1, 3};
+    memset(getbuffer(target), 0, sizeof(color_t) * w * h);
+    memset(getbuffer(reference), 0, sizeof(color_t) * w * h);
+    ege_drawtriangles(texture, quad, quadIndices, 2, target);
+    for (int y = 0; y < th; ++y) {
+        memcpy(getbuffer(reference) + (20 + y) * w + 30, getbuffer(texture) + y * tw, sizeof(color_t) * tw);
+    }
+    failed += !sameImage(target, reference);
+
+    // Coordinates beyond the texture repeat its edge texels, also far beyond the 16.16 range.
+    ege_vertex outside[4] = {{0, 0, 2, -1}, {w, 0, 3, -1}, {0, h, 2, 0}, {w, h, 3, 0}};
+    ege_vertex far[4]     = {{0, 0, 900, -5000}, {w, 0, 3000, -5000}, {0, h, 900, -4000}, {w, h, 3000, -4000}};
+    bool       edge       = true;
+    ege_drawtriangles(texture, outside, quadIndices, 2, target);
+    for (int i = 0; i < w * h; ++i) {
+        edge = edge && getbuffer(target)[i] == getbuffer(texture)[tw - 1];
+    }
+    ege_drawtriangles(texture, far, quadIndices, 2, target, true);
+    for (int i = 0; i < w * h; ++i) {
+        edge = edge && getbuffer(target)[i] == getbuffer(texture)[tw - 1];
+    }
+    failed += !edge;
+
+    // A jittered triangulation of a rectangle covers exactly the pixels centered inside it.
+    const int           cols = 7, rows = 5;
+    const float         left = 10.25f, top = 12.75f, right = 181.5f, bottom = 141.0f;
+    std::vector<ege_vertex> grid((cols + 1) * (rows + 1));
+    std::vector<uint32_t>   indices;
+    srand(3);
+    for (int j = 0; j <= rows; ++j) {
+        for (int i = 0; i <= cols; ++i) {
+            float jx = (i > 0 && i < cols) ? (rand() % 100 - 50) / 16.0f : 0.0f;
+            float jy = (j > 0 && j < rows) ? (rand() % 100 - 50) / 16.0f : 0.0f;
+            ege_vertex& v = grid[j * (cols + 1) + i];
+            v.x = left + (right - left) * i / cols + jx;
+            v.y = top + (bottom - top) * j / rows + jy;
+            v.u = v.v = 0.5f;
+        }
+    }
+    gridIndices(cols, rows, indices);
+    PIMAGE white = newimage(1, 1);
+    getbuffer(white)[0] = 0xFFFFFFFF;
+    memset(getbuffer(target), 0, sizeof(color_t) * w * h);
+    ege_drawtriangles(white, &grid[0], &indices[0], (int)indices.size() / 3, target);
+    bool exact = true;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            bool inside = x + 0.5f >= left && x + 0.5f < right && y + 0.5f >= top && y + 0.5f < bottom;
+            exact       = exact && getbuffer(target)[y * w + x] == (inside ? 0xFFFFFFFF : 0);
+        }
+    }
+    failed += !exact;
+    delimage(white);
+
+    // The tile split does not change the output.
+    for (size_t i = 0; i < grid.size(); ++i) {
+        grid[i].u = (grid[i].x - left) / (right - left) * 1.3f - 0.1f;
+        grid[i].v = (grid[i].y - top) / (bottom - top);
+    }
+    int threads = ege_get_worker_threads();
+    memset(getbuffer(target), 0, sizeof(color_t) * w * h);
+    memset(getbuffer(reference), 0, sizeof(color_t) * w * h);
+    ege_set_worker_threads(1);
+    ege_drawtriangles(texture, &grid[0], &indices[0], (int)indices.size() / 3, reference, true);
+    ege_set_worker_threads(0);
+    ege_drawtriangles(texture, &grid[0], &indices[0], (int)indices.size() / 3, target, true);
+    ege_set_worker_threads(threads);
+    failed += !sameImage(target, reference);
+
+    delimage(texture);
+    delimage(target);
+    delimage(reference);
+    return failed;
+}
+
+int main(int argc, char* argv[])
+{
+    const int width = 1280, height = 720, cols = 48, rows = 32;
+    initgraph(width, height, INIT_RENDERMANUAL);
+    setcaption("Textured triangles");
+    setbkcolor(EGERGB(0x10, 0x18, 0x20));
+    ege_set_worker_threads(0);
+
+    int failed = checkTriangles();
+    if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+        closegraph();
+        return failed;
+    }
+
+    // Checkerboard texture with a color ramp.
+    PIMAGE texture = newimage(256, 256);
+    for (int y = 0; y < 256; ++y) {
+        for (int x = 0; x < 256; ++x) {
+            color_t c = HSVtoRGB((float)(x + y) * 0.7f, 0.6f, ((x / 32 + y / 32) % 2) ? 0.95f : 0.55f);
+            putpixel_f(x, y, c, texture);
+        }
+    }
+
+    std::vector<ege_vertex> vertices((cols + 1) * (rows + 1));
+    std::vector<uint32_t>   indices;
+    gridIndices(cols, rows, indices);
+
+    fps f;
+    for (double t = 0.0; is_run(); delay_fps(60), t += 0.05) {
+        for (int j = 0; j <= rows; ++j) {
+            for (int i = 0; i <= cols; ++i) {
+                ege_vertex& v    = vertices[j * (cols + 1) + i];
+                float       wave = (float)sin(i * 0.25 - t) * i * 0.8f;
+                v.x              = 240.0f + i * 16.0f;
+                v.y              = 120.0f + j * 14.0f + wave;
+                v.u              = (float)i / cols;
+                v.v              = (float)j / rows;
+            }
+        }
+
+        cleardevice();
+        ege_drawtriangles(texture, &vertices[0], &indices[0], (int)indices.size() / 3, NULL, true);
+
+        settextcolor(failed == 0 ? WHITE : LIGHTRED);
+        setbkmode(TRANSPARENT);
+        xyprintf(6, height - 20, "output checks: %d of 4 failed", failed);
+    }
+
+    delimage(texture);
+    closegraph();
+    return failed;
+}
@@ -0,0 +1,933 @@
+/**
+ * @file blend.h
+ * @brief SIMD span kernels for alpha blending and color-key compositing
+ *
+ * Provides span kernels for the compositing done by putimage_alphablend,
+ * putimage_withalpha, putimage_transparent and putimage_alphatransparent, in scalar,
+ * SSE2, SSSE3 and AVX2 versions. The best version is selected once at runtime by CPUID
+ * (see ege/cpu.h), and every SIMD version produces exactly the same bytes as the scalar one.
+ *
+ * The putimage_*_f functions apply the kernels to whole images. Like the other _f
+ * functions of EGE they work in image coordinates and ignore the viewport; they only
+ * clip against the image bounds. Source and destination must not be the same image.
+ *
+ * Blending is done on premultiplied pixels (COLORTYPE_PRGB32, the default pixel format
+ * of EGE images). With mul(x, y) = x * y / 255 rounded to nearest, a source pixel s is
+ * first converted to premultiplied form p with alpha pa:
+ *   - COLORTYPE_PRGB32: every channel of s, alpha included, is mul(channel, alpha)
+ *   - COLORTYPE_ARGB32: pa = mul(alpha(s), alpha), every color channel is mul(channel, pa)
+ *   - COLORTYPE_RGB32:  pa = alpha, every color channel is mul(channel, pa)
+ * and every channel of the destination pixel d, alpha included, becomes
+ * min(255, p + mul(d, 255 - pa)). putimage_withalpha_f is the PRGB32 case with alpha 255,
+ * so its source must be premultiplied.
+ *
+ * The library's putimage_* functions are compiled separately and do not document their
+ * arithmetic, so these functions are not assumed to match them bit for bit. The output
+ * can differ from the library in exactly three places: the rounding of mul() (the library
+ * may truncate), source pixels whose color channel exceeds their alpha (here added with
+ * saturation), and the destination alpha channel (here blended like a color channel).
+ * ege_span_library_check() runs each library function and its _f counterpart on the same
+ * pixels and reports how many pixels differ and by how much.
+ */
+#ifndef EGE_BLEND_H
+#define EGE_BLEND_H
+
+#include "cpu.h"
+#include "dirty_rect.h"
+
+#include <string.h>
+#include <vector>
+
+namespace ege
+{
+
+namespace detail
+{
+
+//------------------------------------------------------------------------------
+//                                   Scalar
+//------------------------------------------------------------------------------
+
+/// x * y / 255 rounded to nearest, exact for x, y in [0, 255]
+inline unsigned int blend_mul255(unsigned int x, unsigned int y)
+{
+    unsigned int t = x * y + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+inline unsigned int blend_clamp255(unsigned int x)
+{
+    return x > 255 ? 255 : x;
+}
+
+/// mode: 0 = COLORTYPE_PRGB32, 1 = COLORTYPE_ARGB32, 2 = COLORTYPE_RGB32
+inline color_t blend_pixel(color_t d, color_t s, unsigned int alpha, int mode)
+{
+    unsigned int sb = s & 0xFF, sg = (s >> 8) & 0xFF, sr = (s >> 16) & 0xFF, sa = s >> 24;
+
+    if (mode == 0) {
+        sb = blend_mul255(sb, alpha);
+        sg = blend_mul255(sg, alpha);
+        sr = blend_mul255(sr, alpha);
+        sa = blend_mul255(sa, alpha);
+    } else {
+        sa = (mode == 1) ? blend_mul255(sa, alpha) : alpha;
+        sb = blend_mul255(sb, sa);
+        sg = blend_mul255(sg, sa);
+        sr = blend_mul255(sr, sa);
+    }
+
+    unsigned int inv = 255 - sa;
+    unsigned int b = blend_clamp255(sb + blend_mul255(d & 0xFF, inv));
+    unsigned int g = blend_clamp255(sg + blend_mul255((d >> 8) & 0xFF, inv));
+    unsigned int r = blend_clamp255(sr + blend_mul255((d >> 16) & 0xFF, inv));
+    unsigned int a = blend_clamp255(sa + blend_mul255(d >> 24, inv));
+    return (a << 24) | (r << 16) | (g << 8) | b;
+}
+
+/// Pseudo-random premultiplied pixel for the benchmark and the library check
+inline color_t blend_sample_pixel(unsigned int& seed)
+{
+    seed = seed * 1664525u + 1013904223u;
+    unsigned int a = seed >> 24;
+    unsigned int c = seed * 2654435761u;
+    return (a << 24) | (blend_mul255((c >> 16) & 0xFF, a) << 16) | (blend_mul255((c >> 8) & 0xFF, a) << 8) |
+           blend_mul255(c & 0xFF, a);
+}
+
+template <int Mode>
+inline void span_blend_scalar(color_t* dst, const color_t* src, int count, unsigned int alpha)
+{
+    for (int i = 0; i < count; ++i) {
+        dst[i] = blend_pixel(dst[i], src[i], alpha, Mode);
+    }
+}
+
+inline void span_transparent_scalar(color_t* dst, const color_t* src, int count, color_t key, unsigned int)
+{
+    key &= 0x00FFFFFF;
+    for (int i = 0; i < count; ++i) {
+        if ((src[i] & 0x00FFFFFF) != key) {
+            dst[i] = src[i];
+        }
+    }
+}
+
+inline void span_alphatransparent_scalar(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    key &= 0x00FFFFFF;
+    for (int i = 0; i < count; ++i) {
+        if ((src[i] & 0x00FFFFFF) != key) {
+            dst[i] = blend_pixel(dst[i], src[i], alpha, 2);
+        }
+    }
+}
+
+#ifdef EGE_SIMD_X86
+
+//------------------------------------------------------------------------------
+//                                SSE2 / SSSE3
+//------------------------------------------------------------------------------
+
+EGE_SIMD_TARGET("sse2") inline __m128i blend_mul255_sse2(__m128i x, __m128i y)
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/// Broadcast the alpha lane of two unpacked pixels to all of their lanes.
+EGE_SIMD_TARGET("sse2") inline __m128i blend_alpha_sse2(__m128i x)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+EGE_SIMD_TARGET("ssse3") inline __m128i blend_alpha_ssse3(__m128i x)
+{
+    return _mm_shuffle_epi8(x, _mm_set_epi8(15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6));
+}
+
+/// Scale two unpacked (16 bits per channel) source pixels to premultiplied form.
+template <int Mode>
+EGE_SIMD_TARGET("sse2") inline __m128i blend_source_sse2(__m128i s, __m128i alpha, __m128i sa)
+{
+    if (Mode == 0) {
+        return blend_mul255_sse2(s, alpha);
+    }
+    // Force the alpha lane to 255 so that it becomes the scaled alpha itself.
+    const __m128i alphaLane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i rgbMask   = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    return blend_mul255_sse2(_mm_or_si128(_mm_and_si128(s, rgbMask), alphaLane), Mode == 1 ? sa : alpha);
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("sse2") inline __m128i blend_4px_sse2(__m128i s, __m128i d, __m128i alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    __m128i r[2];
+    for (int half = 0; half < 2; ++half) {
+        __m128i s16 = half ? _mm_unpackhi_epi8(s, zero) : _mm_unpacklo_epi8(s, zero);
+        __m128i d16 = half ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+        __m128i sa  = Mode == 1 ? blend_alpha_sse2(blend_mul255_sse2(s16, alpha)) : alpha;
+        __m128i sp  = blend_source_sse2<Mode>(s16, alpha, sa);
+        __m128i inv = _mm_sub_epi16(c255, blend_alpha_sse2(sp));
+        r[half]     = _mm_add_epi16(sp, blend_mul255_sse2(d16, inv));
+    }
+    return _mm_packus_epi16(r[0], r[1]);
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("ssse3") inline __m128i blend_4px_ssse3(__m128i s, __m128i d, __m128i alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    __m128i r[2];
+    for (int half = 0; half < 2; ++half) {
+        __m128i s16 = half ? _mm_unpackhi_epi8(s, zero) : _mm_unpacklo_epi8(s, zero);
+        __m128i d16 = half ? _mm_unpackhi_epi8(d, zero) : _mm_unpacklo_epi8(d, zero);
+        __m128i sa  = Mode == 1 ? blend_alpha_ssse3(blend_mul255_sse2(s16, alpha)) : alpha;
+        __m128i sp  = blend_source_sse2<Mode>(s16, alpha, sa);
+        __m128i inv = _mm_sub_epi16(c255, blend_alpha_ssse3(sp));
+        r[half]     = _mm_add_epi16(sp, blend_mul255_sse2(d16, inv));
+    }
+    return _mm_packus_epi16(r[0], r[1]);
+}
+
+/// Lanes of 4 source pixels that can skip blending: 1 = keep destination, 2 = copy source, 0 = blend.
+template <int Mode>
+EGE_SIMD_TARGET("sse2") inline int blend_skip_sse2(__m128i s, bool copyOpaque)
+{
+    // Fully transparent premultiplied pixels leave the destination untouched and opaque
+    // pixels at full alpha replace it; both give the same bytes as blending.
+    if (Mode == 0 && _mm_movemask_epi8(_mm_cmpeq_epi32(s, _mm_setzero_si128())) == 0xFFFF) {
+        return 1;
+    }
+    const __m128i alphaMask = _mm_set1_epi32((int)0xFF000000);
+    if (copyOpaque && _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask)) == 0xFFFF) {
+        return 2;
+    }
+    return 0;
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("sse2") inline void span_blend_sse2(color_t* dst, const color_t* src, int count, unsigned int alpha)
+{
+    const __m128i alpha16    = _mm_set1_epi16((short)alpha);
+    const bool    copyOpaque = Mode != 2 && alpha == 255;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s    = _mm_loadu_si128((const __m128i*)(src + i));
+        int     skip = blend_skip_sse2<Mode>(s, copyOpaque);
+        if (skip == 0) {
+            s = blend_4px_sse2<Mode>(s, _mm_loadu_si128((const __m128i*)(dst + i)), alpha16);
+        }
+        if (skip != 1) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+        }
+    }
+    span_blend_scalar<Mode>(dst + i, src + i, count - i, alpha);
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("ssse3") inline void span_blend_ssse3(color_t* dst, const color_t* src, int count, unsigned int alpha)
+{
+    const __m128i alpha16    = _mm_set1_epi16((short)alpha);
+    const bool    copyOpaque = Mode != 2 && alpha == 255;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s    = _mm_loadu_si128((const __m128i*)(src + i));
+        int     skip = blend_skip_sse2<Mode>(s, copyOpaque);
+        if (skip == 0) {
+            s = blend_4px_ssse3<Mode>(s, _mm_loadu_si128((const __m128i*)(dst + i)), alpha16);
+        }
+        if (skip != 1) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+        }
+    }
+    span_blend_scalar<Mode>(dst + i, src + i, count - i, alpha);
+}
+
+/// Color-key kernels; Blend selects putimage_alphatransparent over putimage_transparent.
+template <bool Blend>
+EGE_SIMD_TARGET("sse2") inline void span_key_sse2(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i key4    = _mm_set1_epi32((int)(key & 0x00FFFFFF));
+    const __m128i alpha16 = _mm_set1_epi16((short)alpha);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s    = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, rgbMask), key4);
+        if (_mm_movemask_epi8(keep) == 0xFFFF) {
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i r = Blend ? blend_4px_sse2<2>(s, d, alpha16) : s;
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, r)));
+    }
+
+    if (Blend) {
+        span_alphatransparent_scalar(dst + i, src + i, count - i, key, alpha);
+    } else {
+        span_transparent_scalar(dst + i, src + i, count - i, key, alpha);
+    }
+}
+
+EGE_SIMD_TARGET("ssse3") inline void span_alphatransparent_ssse3(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+    const __m128i key4    = _mm_set1_epi32((int)(key & 0x00FFFFFF));
+    const __m128i alpha16 = _mm_set1_epi16((short)alpha);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s    = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i keep = _mm_cmpeq_epi32(_mm_and_si128(s, rgbMask), key4);
+        if (_mm_movemask_epi8(keep) == 0xFFFF) {
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i r = blend_4px_ssse3<2>(s, d, alpha16);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, r)));
+    }
+    span_alphatransparent_scalar(dst + i, src + i, count - i, key, alpha);
+}
+
+EGE_SIMD_TARGET("sse2") inline void span_transparent_sse2(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    span_key_sse2<false>(dst, src, count, key, alpha);
+}
+
+EGE_SIMD_TARGET("sse2") inline void span_alphatransparent_sse2(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    span_key_sse2<true>(dst, src, count, key, alpha);
+}
+
+//------------------------------------------------------------------------------
+//                                    AVX2
+//------------------------------------------------------------------------------
+
+EGE_SIMD_TARGET("avx2") inline __m256i blend_mul255_avx2(__m256i x, __m256i y)
+{
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+EGE_SIMD_TARGET("avx2") inline __m256i blend_alpha_avx2(__m256i x)
+{
+    const __m256i shuffle = _mm256_set_epi8(
+        15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6,
+        15, 14, 15, 14, 15, 14, 15, 14, 7, 6, 7, 6, 7, 6, 7, 6);
+    return _mm256_shuffle_epi8(x, shuffle);
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("avx2") inline __m256i blend_unpacked_avx2(__m256i s, __m256i d, __m256i alpha)
+{
+    const __m256i alphaLane = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i rgbMask   = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+
+    __m256i sp;
+    if (Mode == 0) {
+        sp = blend_mul255_avx2(s, alpha);
+    } else {
+        __m256i opaque = _mm256_or_si256(_mm256_and_si256(s, rgbMask), alphaLane);
+        __m256i sa     = (Mode == 1) ? blend_alpha_avx2(blend_mul255_avx2(s, alpha)) : alpha;
+        sp             = blend_mul255_avx2(opaque, sa);
+    }
+
+    __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), blend_alpha_avx2(sp));
+    return _mm256_add_epi16(sp, blend_mul255_avx2(d, inv));
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("avx2") inline __m256i blend_8px_avx2(__m256i s, __m256i d, __m256i alpha)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = blend_unpacked_avx2<Mode>(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), alpha);
+    __m256i hi = blend_unpacked_avx2<Mode>(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), alpha);
+    return _mm256_packus_epi16(lo, hi);
+}
+
+template <int Mode>
+EGE_SIMD_TARGET("avx2") inline void span_blend_avx2(color_t* dst, const color_t* src, int count, unsigned int alpha)
+{
+    const __m256i alpha16    = _mm256_set1_epi16((short)alpha);
+    const __m256i alphaMask  = _mm256_set1_epi32((int)0xFF000000);
+    const bool    copyOpaque = (Mode != 2) && alpha == 255;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (Mode == 0 && _mm256_testz_si256(s, s)) {
+            continue;
+        }
+        if (copyOpaque && _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alphaMask), alphaMask)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), blend_8px_avx2<Mode>(s, d, alpha16));
+    }
+    span_blend_ssse3<Mode>(dst + i, src + i, count - i, alpha);
+}
+
+template <bool Blend>
+EGE_SIMD_TARGET("avx2") inline void span_key_avx2(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    const __m256i rgbMask = _mm256_set1_epi32(0x00FFFFFF);
+    const __m256i key8    = _mm256_set1_epi32((int)(key & 0x00FFFFFF));
+    const __m256i alpha16 = _mm256_set1_epi16((short)alpha);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i s    = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i keep = _mm256_cmpeq_epi32(_mm256_and_si256(s, rgbMask), key8);
+        if (_mm256_movemask_epi8(keep) == -1) {
+            continue;
+        }
+
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i r = Blend ? blend_8px_avx2<2>(s, d, alpha16) : s;
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_blendv_epi8(r, d, keep));
+    }
+
+    if (Blend) {
+        span_alphatransparent_ssse3(dst + i, src + i, count - i, key, alpha);
+    } else {
+        span_transparent_sse2(dst + i, src + i, count - i, key, alpha);
+    }
+}
+
+EGE_SIMD_TARGET("avx2") inline void span_transparent_avx2(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    span_key_avx2<false>(dst, src, count, key, alpha);
+}
+
+EGE_SIMD_TARGET("avx2") inline void span_alphatransparent_avx2(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha)
+{
+    span_key_avx2<true>(dst, src, count, key, alpha);
+}
+
+#endif // EGE_SIMD_X86
+
+//------------------------------------------------------------------------------
+//                                  Dispatch
+//------------------------------------------------------------------------------
+
+typedef void (*span_blend_fn)(color_t* dst, const color_t* src, int count, unsigned int alpha);
+typedef void (*span_key_fn)(color_t* dst, const color_t* src, int count, color_t key, unsigned int alpha);
+
+struct span_kernels
+{
+    const char*   isa;
+    span_blend_fn blend[3];  ///< Indexed by color_type
+    span_key_fn   transparent;
+    span_key_fn   alphatransparent;
+};
+
+/// Index of the kernel table of each instruction set.
+enum span_kernels_level
+{
+    SPAN_KERNELS_SCALAR,
+    SPAN_KERNELS_SSE2,
+    SPAN_KERNELS_SSSE3,
+    SPAN_KERNELS_AVX2,
+    SPAN_KERNELS_LEVELS
+};
+
+/// Kernel tables, one per instruction set. They are constant-initialized and never written.
+inline const span_kernels* span_kernels_tables()
+{
+    static const span_kernels tables[SPAN_KERNELS_LEVELS] = {
+        {"scalar", {span_blend_scalar<0>, span_blend_scalar<1>, span_blend_scalar<2>}, span_transparent_scalar,
+         span_alphatransparent_scalar},
+#ifdef EGE_SIMD_X86
+        {"sse2", {span_blend_sse2<0>, span_blend_sse2<1>, span_blend_sse2<2>}, span_transparent_sse2,
+         span_alphatransparent_sse2},
+        {"ssse3", {span_blend_ssse3<0>, span_blend_ssse3<1>, span_blend_ssse3<2>}, span_transparent_sse2,
+         span_alphatransparent_ssse3},
+        {"avx2", {span_blend_avx2<0>, span_blend_avx2<1>, span_blend_avx2<2>}, span_transparent_avx2,
+         span_alphatransparent_avx2},
+#endif
+    };
+    return tables;
+}
+
+/// Kernel table for the best instruction set in features.
+inline const span_kernels& span_kernels_select(unsigned int features)
+{
+    int level = SPAN_KERNELS_SCALAR;
+#ifdef EGE_SIMD_X86
+    if ((features & CPU_FEATURE_AVX2) && (features & CPU_FEATURE_SSSE3)) {
+        level = SPAN_KERNELS_AVX2;
+    } else if (features & CPU_FEATURE_SSSE3) {
+        level = SPAN_KERNELS_SSSE3;
+    } else if (features & CPU_FEATURE_SSE2) {
+        level = SPAN_KERNELS_SSE2;
+    }
+#else
+    (void)features;
+#endif
+    return span_kernels_tables()[level];
+}
+
+/**
+ * Kernel table for the current CPU features. Worker threads call this concurrently: the tables
+ * are immutable and the choice is derived from ege_cpu_features(), which cpu.h publishes with
+ * InterlockedExchange, so no shared state is written here. A change of
+ * ege_cpu_set_features_mask() takes effect on the next call.
+ */
+inline const span_kernels& span_kernels_current()
+{
+    return span_kernels_select(ege_cpu_features());
+}
+
+inline int blend_mode(color_type colorType)
+{
+    return (colorType == COLORTYPE_ARGB32) ? 1 : (colorType == COLORTYPE_RGB32 ? 2 : 0);
+}
+
+/// Clip a source rectangle placed at (xDest, yDest) against both images.
+inline bool blit_clip(int dstW, int dstH, int srcW, int srcH, int& xDest, int& yDest, int& xSrc, int& ySrc, int& width,
+    int& height)
+{
+    if (width <= 0)  width  = srcW - xSrc;
+    if (height <= 0) height = srcH - ySrc;
+
+    if (xSrc < 0) { width  += xSrc; xDest -= xSrc; xSrc = 0; }
+    if (ySrc < 0) { height += ySrc; yDest -= ySrc; ySrc = 0; }
+    if (xDest < 0) { width  += xDest; xSrc -= xDest; xDest = 0; }
+    if (yDest < 0) { height += yDest; ySrc -= yDest; yDest = 0; }
+    if (xSrc + width  > srcW)  width  = srcW - xSrc;
+    if (ySrc + height > srcH)  height = srcH - ySrc;
+    if (xDest + width  > dstW) width  = dstW - xDest;
+    if (yDest + height > dstH) height = dstH - yDest;
+
+    return width > 0 && height > 0;
+}
+
+inline bool blit_clip(PIMAGE imgDest, PCIMAGE imgSrc, int& xDest, int& yDest, int& xSrc, int& ySrc, int& width, int& height)
+{
+    return blit_clip(getwidth(imgDest), getheight(imgDest), getwidth(imgSrc), getheight(imgSrc), xDest, yDest, xSrc, ySrc,
+        width, height);
+}
+
+} // namespace detail
+
+/**
+ * @brief Get the instruction set used by the span kernels
+ * @return "avx2", "ssse3", "sse2" or "scalar"
+ */
+inline const char* ege_span_kernel_isa()
+{
+    return detail::span_kernels_current().isa;
+}
+
+/**
+ * @brief Alpha blend a span of source pixels over destination pixels
+ * @param dst Destination pixels (premultiplied)
+ * @param src Source pixels
+ * @param count Number of pixels
+ * @param alpha Overall source transparency (0-255)
+ * @param colorType Color type of source pixels, default is COLORTYPE_PRGB32
+ */
+inline void ege_span_alphablend(color_t* dst, const color_t* src, int count, unsigned char alpha,
+    color_type colorType = COLORTYPE_PRGB32)
+{
+    detail::span_kernels_current().blend[detail::blend_mode(colorType)](dst, src, count, alpha);
+}
+
+/**
+ * @brief Blend a span of premultiplied source pixels using their own alpha channel
+ * @param dst Destination pixels (premultiplied)
+ * @param src Source pixels (premultiplied)
+ * @param count Number of pixels
+ */
+inline void ege_span_withalpha(color_t* dst, const color_t* src, int count)
+{
+    detail::span_kernels_current().blend[0](dst, src, count, 255);
+}
+
+/**
+ * @brief Copy a span of source pixels, skipping pixels of the transparent color
+ * @param dst Destination pixels
+ * @param src Source pixels
+ * @param count Number of pixels
+ * @param transparentColor Color to skip (alpha channel is ignored)
+ */
+inline void ege_span_transparent(color_t* dst, const color_t* src, int count, color_t transparentColor)
+{
+    detail::span_kernels_current().transparent(dst, src, count, transparentColor, 255);
+}
+
+/**
+ * @brief Blend a span of opaque source pixels with an overall alpha, skipping the transparent color
+ * @param dst Destination pixels (premultiplied)
+ * @param src Source pixels (alpha channel is ignored)
+ * @param count Number of pixels
+ * @param transparentColor Color to skip (alpha channel is ignored)
+ * @param alpha Overall source transparency (0-255)
+ */
+inline void ege_span_alphatransparent(color_t* dst, const color_t* src, int count, color_t transparentColor,
+    unsigned char alpha)
+{
+    detail::span_kernels_current().alphatransparent(dst, src, count, transparentColor, alpha);
+}
+
+/**
+ * @brief Alpha blending drawing function using the SIMD span kernels
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgSrc Source IMAGE object pointer
+ * @param xDest X coordinate of drawing position
+ * @param yDest Y coordinate of drawing position
+ * @param alpha Overall image transparency (0-255)
+ * @param xSrc X coordinate of top-left corner of drawing content in source IMAGE object
+ * @param ySrc Y coordinate of top-left corner of drawing content in source IMAGE object
+ * @param widthSrc Width of drawing content in source IMAGE object, 0 means to the right edge
+ * @param heightSrc Height of drawing content in source IMAGE object, 0 means to the bottom edge
+ * @param colorType Color type of source image pixels, default is COLORTYPE_PRGB32
+ * @return grOk on success, grInvalidRegion if nothing is visible, grNullPointer if imgSrc is NULL
+ */
+inline int putimage_alphablend_f(PIMAGE imgDest, PCIMAGE imgSrc, int xDest, int yDest, unsigned char alpha,
+    int xSrc, int ySrc, int widthSrc, int heightSrc, color_type colorType = COLORTYPE_PRGB32)
+{
+    if (imgSrc == NULL) {
+        return grNullPointer;
+    }
+    if (!detail::blit_clip(imgDest, imgSrc, xDest, yDest, xSrc, ySrc, widthSrc, heightSrc)) {
+        return grInvalidRegion;
+    }
+
+    int            dstW = getwidth(imgDest), srcW = getwidth(imgSrc);
+    color_t*       dst  = getbuffer(imgDest) + (size_t)yDest * dstW + xDest;
+    const color_t* src  = getbuffer(imgSrc) + (size_t)ySrc * srcW + xSrc;
+
+    detail::span_blend_fn kernel = detail::span_kernels_current().blend[detail::blend_mode(colorType)];
+    for (int y = 0; y < heightSrc; ++y, dst += dstW, src += srcW) {
+        kernel(dst, src, widthSrc, alpha);
+    }
+    detail::dirty_note(imgDest, xDest, yDest, widthSrc, heightSrc);
+    return grOk;
+}
+
+/// @brief Alpha blending drawing function using the SIMD span kernels, whole source image
+inline int putimage_alphablend_f(PIMAGE imgDest, PCIMAGE imgSrc, int xDest, int yDest, unsigned char alpha,
+    color_type colorType = COLORTYPE_PRGB32)
+{
+    return putimage_alphablend_f(imgDest, imgSrc, xDest, yDest, alpha, 0, 0, 0, 0, colorType);
+}
+
+/// @brief Alpha blending drawing function using the SIMD span kernels, from (xSrc, ySrc) to the source edges
+inline int putimage_alphablend_f(PIMAGE imgDest, PCIMAGE imgSrc, int xDest, int yDest, unsigned char alpha,
+    int xSrc, int ySrc, color_type colorType = COLORTYPE_PRGB32)
+{
+    return putimage_alphablend_f(imgDest, imgSrc, xDest, yDest, alpha, xSrc, ySrc, 0, 0, colorType);
+}
+
+/**
+ * @brief Alpha channel drawing function using the SIMD span kernels
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgSrc Source IMAGE object pointer (premultiplied alpha)
+ * @param xDest X coordinate of drawing position
+ * @param yDest Y coordinate of drawing position
+ * @param xSrc X coordinate of top-left corner of drawing content in source IMAGE object, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in source IMAGE object, default is 0
+ * @param widthSrc Width of drawing content in source IMAGE object, default is 0 (use entire image width)
+ * @param heightSrc Height of drawing content in source IMAGE object, default is 0 (use entire image height)
+ * @return grOk on success, corresponding error code on failure
+ */
+inline int putimage_withalpha_f(PIMAGE imgDest, PCIMAGE imgSrc, int xDest, int yDest, int xSrc = 0, int ySrc = 0,
+    int widthSrc = 0, int heightSrc = 0)
+{
+    return putimage_alphablend_f(imgDest, imgSrc, xDest, yDest, 255, xSrc, ySrc, widthSrc, heightSrc, COLORTYPE_PRGB32);
+}
+
+/**
+ * @brief Transparent color drawing function using the SIMD span kernels
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgSrc Source IMAGE object pointer
+ * @param xDest X coordinate of drawing position
+ * @param yDest Y coordinate of drawing position
+ * @param transparentColor Pixel color to become transparent
+ * @param xSrc X coordinate of top-left corner of drawing content in source IMAGE object, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in source IMAGE object, default is 0
+ * @param widthSrc Width of drawing content in source IMAGE object, default is 0 (use entire image width)
+ * @param heightSrc Height of drawing content in source IMAGE object, default is 0 (use entire image height)
+ * @return grOk on success, corresponding error code on failure
+ */
+inline int putimage_transparent_f(PIMAGE imgDest, PCIMAGE imgSrc, int xDest, int yDest, color_t transparentColor,
+    int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    if (imgSrc == NULL) {
+        return grNullPointer;
+    }
+    if (!detail::blit_clip(imgDest, imgSrc, xDest, yDest, xSrc, ySrc, widthSrc, heightSrc)) {
+        return grInvalidRegion;
+    }
+
+    int            dstW = getwidth(imgDest), srcW = getwidth(imgSrc);
+    color_t*       dst  = getbuffer(imgDest) + (size_t)yDest * dstW + xDest;
+    const color_t* src  = getbuffer(imgSrc) + (size_t)ySrc * srcW + xSrc;
+
+    detail::span_key_fn kernel = detail::span_kernels_current().transparent;
+    for (int y = 0; y < heightSrc; ++y, dst += dstW, src += srcW) {
+        kernel(dst, src, widthSrc, transparentColor, 255);
+    }
+    detail::dirty_note(imgDest, xDest, yDest, widthSrc, heightSrc);
+    return grOk;
+}
+
+/**
+ * @brief Alpha transparent color blending drawing function using the SIMD span kernels
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgSrc Source IMAGE object pointer
+ * @param xDest X coordinate of drawing position
+ * @param yDest Y coordinate of drawing position
+ * @param transparentColor Pixel color to become transparent
+ * @param alpha Overall image transparency (0-255)
+ * @param xSrc X coordinate of top-left corner of drawing content in source IMAGE object, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in source IMAGE object, default is 0
+ * @param widthSrc Width of drawing content in source IMAGE object, default is 0 (use entire image width)
+ * @param heightSrc Height of drawing content in source IMAGE object, default is 0 (use entire image height)
+ * @return grOk on success, corresponding error code on failure
+ */
+inline int putimage_alphatransparent_f(PIMAGE imgDest, PCIMAGE imgSrc, int xDest, int yDest, color_t transparentColor,
+    unsigned char alpha, int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    if (imgSrc == NULL) {
+        return grNullPointer;
+    }
+    if (!detail::blit_clip(imgDest, imgSrc, xDest, yDest, xSrc, ySrc, widthSrc, heightSrc)) {
+        return grInvalidRegion;
+    }
+
+    int            dstW = getwidth(imgDest), srcW = getwidth(imgSrc);
+    color_t*       dst  = getbuffer(imgDest) + (size_t)yDest * dstW + xDest;
+    const color_t* src  = getbuffer(imgSrc) + (size_t)ySrc * srcW + xSrc;
+
+    detail::span_key_fn kernel = detail::span_kernels_current().alphatransparent;
+    for (int y = 0; y < heightSrc; ++y, dst += dstW, src += srcW) {
+        kernel(dst, src, widthSrc, transparentColor, alpha);
+    }
+    detail::dirty_note(imgDest, xDest, yDest, widthSrc, heightSrc);
+    return grOk;
+}
+
+/**
+ * @struct ege_span_kernel_report
+ * @brief Throughput of one span kernel on one instruction set
+ */
+struct ege_span_kernel_report
+{
+    const char* kernel;             ///< Kernel name, e.g. "alphablend_prgb32"
+    const char* isa;                ///< "scalar", "sse2", "ssse3" or "avx2"
+    double      megapixelsPerSec;   ///< Measured throughput
+    bool        exact;              ///< Output is identical to the scalar kernel
+};
+
+/**
+ * @brief Measure the throughput of every span kernel on every supported instruction set
+ * @param reports Array receiving the results
+ * @param maxReports Capacity of reports
+ * @param pixels Number of pixels per kernel call, default is one 1920x1080 frame
+ * @param iterations Number of timed calls per kernel, default is 20
+ * @return Number of entries written to reports
+ *
+ * Every kernel is run on the same pseudo-random premultiplied data, and its output is
+ * compared against the scalar kernel to fill ege_span_kernel_report::exact.
+ */
+inline int ege_span_kernel_benchmark(ege_span_kernel_report* reports, int maxReports, int pixels = 1920 * 1080,
+    int iterations = 20)
+{
+    static const char* const names[] = {
+        "alphablend_prgb32", "alphablend_argb32", "alphablend_rgb32", "transparent", "alphatransparent"
+    };
+    const unsigned int levels[] = {
+        0, CPU_FEATURE_SSE2, CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3,
+        CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3 | CPU_FEATURE_AVX2
+    };
+    const color_t key   = EGERGB(0x40, 0x80, 0xC0);
+    const unsigned char alpha = 0xA0;
+
+    if (reports == NULL || maxReports <= 0 || pixels <= 0 || iterations <= 0) {
+        return 0;
+    }
+
+    std::vector<color_t> src(pixels), base(pixels), dst(pixels), expect(pixels);
+    unsigned int seed = 0x12345678u;
+    for (int i = 0; i < pixels; ++i) {
+        color_t p = detail::blend_sample_pixel(seed);
+        src[i]  = (i & 31) == 0 ? (key | 0xFF000000) : p;
+        base[i] = 0xFF000000 | (seed * 22695477u >> 8);
+    }
+
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+
+    unsigned int available = detail::cpu_detect_features();
+    int          count     = 0;
+    for (int kernel = 0; kernel < 5; ++kernel) {
+        const detail::span_kernels& scalar = detail::span_kernels_select(0);
+        expect = base;
+        if (kernel < 3) {
+            scalar.blend[kernel](&expect[0], &src[0], pixels, alpha);
+        } else if (kernel == 3) {
+            scalar.transparent(&expect[0], &src[0], pixels, key, 255);
+        } else {
+            scalar.alphatransparent(&expect[0], &src[0], pixels, key, alpha);
+        }
+
+        for (int level = 0; level < 4 && count < maxReports; ++level) {
+            if ((available & levels[level]) != levels[level]) {
+                continue;
+            }
+            const detail::span_kernels& k = detail::span_kernels_select(levels[level]);
+
+            LARGE_INTEGER start, stop;
+            bool          exact = true;
+            QueryPerformanceCounter(&start);
+            for (int it = 0; it <= iterations; ++it) {
+                if (it == 1) {
+                    exact = memcmp(&dst[0], &expect[0], sizeof(color_t) * pixels) == 0;
+                    QueryPerformanceCounter(&start);
+                }
+                memcpy(&dst[0], &base[0], sizeof(color_t) * pixels);
+                if (kernel < 3) {
+                    k.blend[kernel](&dst[0], &src[0], pixels, alpha);
+                } else if (kernel == 3) {
+                    k.transparent(&dst[0], &src[0], pixels, key, 255);
+                } else {
+                    k.alphatransparent(&dst[0], &src[0], pixels, key, alpha);
+                }
+            }
+            QueryPerformanceCounter(&stop);
+
+            double seconds = (double)(stop.QuadPart - start.QuadPart) / (double)freq.QuadPart;
+            ege_span_kernel_report& r = reports[count++];
+            r.kernel           = names[kernel];
+            r.isa              = k.isa;
+            r.megapixelsPerSec = seconds > 0.0 ? (double)pixels * iterations / seconds / 1e6 : 0.0;
+            r.exact            = exact;
+        }
+    }
+    return count;
+}
+
+/**
+ * @struct ege_span_library_report
+ * @brief Comparison of one _f function with the library function it replaces
+ */
+struct ege_span_library_report
+{
+    const char* function;   ///< Library function and color type, e.g. "putimage_alphablend ARGB32"
+    int         pixels;     ///< Number of pixels compared
+    int         mismatches; ///< Number of pixels whose bytes differ
+    int         maxDiff;    ///< Largest difference of a single channel
+    color_t     library;    ///< First differing pixel as written by the library, 0 if none
+    color_t     simd;       ///< The same pixel as written by the _f function, 0 if none
+};
+
+/**
+ * @brief Compare the putimage_*_f functions with the library's putimage_* functions
+ * @param reports Array receiving the results, one per function and color type (6 in total)
+ * @param maxReports Capacity of reports
+ * @param width Width of the test images, default is 256
+ * @param height Height of the test images, default is 256
+ * @return Number of entries written to reports, or 0 if the test images could not be created
+ *
+ * putimage_alphablend (PRGB32, ARGB32 and RGB32), putimage_withalpha, putimage_transparent
+ * and putimage_alphatransparent are each run on a copy of the same pseudo-random
+ * destination, from the same pseudo-random premultiplied source, as their _f counterparts.
+ * The upper half of the destination is opaque, the lower half has random alpha.
+ */
+inline int ege_span_library_check(ege_span_library_report* reports, int maxReports, int width = 256, int height = 256)
+{
+    static const char* const names[] = {
+        "putimage_alphablend PRGB32", "putimage_alphablend ARGB32", "putimage_alphablend RGB32",
+        "putimage_withalpha", "putimage_transparent", "putimage_alphatransparent"
+    };
+    const color_t       key   = EGERGB(0x40, 0x80, 0xC0);
+    const unsigned char alpha = 0xA0;
+
+    if (reports == NULL || maxReports <= 0 || width <= 0 || height <= 0) {
+        return 0;
+    }
+
+    PIMAGE src = newimage(width, height), base = newimage(width, height);
+    PIMAGE lib = newimage(width, height), simd = newimage(width, height);
+    if (src == NULL || base == NULL || lib == NULL || simd == NULL) {
+        delimage(src);
+        delimage(base);
+        delimage(lib);
+        delimage(simd);
+        return 0;
+    }
+
+    int          pixels = width * height;
+    unsigned int seed   = 0x9E3779B9u;
+    for (int i = 0; i < pixels; ++i) {
+        color_t p = detail::blend_sample_pixel(seed);
+        color_t d = detail::blend_sample_pixel(seed);
+        getbuffer(src)[i]  = (i & 31) == 0 ? (key | 0xFF000000) : p;
+        getbuffer(base)[i] = i < pixels / 2 ? (0xFF000000 | (seed * 22695477u >> 8)) : d;
+    }
+
+    int count = 0;
+    for (int f = 0; f < 6 && count < maxReports; ++f) {
+        memcpy(getbuffer(lib), getbuffer(base), sizeof(color_t) * pixels);
+        memcpy(getbuffer(simd), getbuffer(base), sizeof(color_t) * pixels);
+        if (f < 3) {
+            color_type colorType = f == 0 ? COLORTYPE_PRGB32 : (f == 1 ? COLORTYPE_ARGB32 : COLORTYPE_RGB32);
+            putimage_alphablend(lib, src, 0, 0, alpha, 0, 0, width, height, colorType);
+            putimage_alphablend_f(simd, src, 0, 0, alpha, 0, 0, width, height, colorType);
+        } else if (f == 3) {
+            putimage_withalpha(lib, src, 0, 0);
+            putimage_withalpha_f(simd, src, 0, 0);
+        } else if (f == 4) {
+            putimage_transparent(lib, src, 0, 0, key);
+            putimage_transparent_f(simd, src, 0, 0, key);
+        } else {
+            putimage_alphatransparent(lib, src, 0, 0, key, alpha);
+            putimage_alphatransparent_f(simd, src, 0, 0, key, alpha);
+        }
+
+        ege_span_library_report& r = reports[count++];
+        r.function   = names[f];
+        r.pixels     = pixels;
+        r.mismatches = 0;
+        r.maxDiff    = 0;
+        r.library    = 0;
+        r.simd       = 0;
+        const color_t* a = getbuffer(lib);
+        const color_t* b = getbuffer(simd);
+        for (int i = 0; i < pixels; ++i) {
+            if (a[i] == b[i]) {
+                continue;
+            }
+            if (r.mismatches++ == 0) {
+                r.library = a[i];
+                r.simd    = b[i];
+            }
+            for (int shift = 0; shift < 32; shift += 8) {
+                int diff = (int)((a[i] >> shift) & 0xFF) - (int)((b[i] >> shift) & 0xFF);
+                diff     = diff < 0 ? -diff : diff;
+                r.maxDiff = diff > r.maxDiff ? diff : r.maxDiff;
+            }
+        }
+    }
+
+    delimage(src);
+    delimage(base);
+    delimage(lib);
+    delimage(simd);
+    return count;
+}
+
+} // namespace ege
+
+#endif /* EGE_BLEND_H */
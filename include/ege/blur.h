@@ -0,0 +1,321 @@
+/**
+ * @file blur.h
+ * @brief Box and gaussian blur filters with a constant cost per pixel
+ *
+ * Each box pass is separable: a horizontal pass over rows followed by a vertical pass over
+ * columns, both keeping a running sum of the window so the cost does not depend on the
+ * radius. The four channels of a pixel are summed together in one SSE2 register. Rows and
+ * column strips are distributed over the worker pool (see ege_set_worker_threads()).
+ *
+ * imagefilter_gaussian() approximates a gaussian with three box passes whose widths are
+ * chosen to match its standard deviation.
+ */
+#ifndef EGE_BLUR_H
+#define EGE_BLUR_H
+
+#include "cpu.h"
+#include "dirty_rect.h"
+#include "parallel.h"
+
+#include <math.h>
+#include <vector>
+
+namespace ege
+{
+
+namespace detail
+{
+
+struct blur_job
+{
+    color_t* buf;
+    int      stride;
+    int      x, y, w, h;    ///< Region being blurred
+    int      radius;
+    bool     sse2;
+};
+
+const int BLUR_ROWS_PER_TASK = 16;
+const int BLUR_STRIP_WIDTH   = 32;
+
+inline color_t blur_pack(const int* sum, float inv)
+{
+    color_t r = 0;
+    for (int c = 0; c < 4; ++c) {
+        r |= (color_t)(int)((float)sum[c] * inv + 0.5f) << (c * 8);
+    }
+    return r;
+}
+
+inline void blur_add(int* sum, color_t p, int sign)
+{
+    for (int c = 0; c < 4; ++c) {
+        sum[c] += sign * (int)((p >> (c * 8)) & 0xFF);
+    }
+}
+
+/**
+ * Running-sum box filter of n outputs spaced outStep apart. in[k * inStep] holds the
+ * source value at position k - radius (edges already clamped), k in [0, n + 2 * radius].
+ */
+inline void blur_run_scalar(color_t* out, int outStep, const color_t* in, int inStep, int n, int radius)
+{
+    const int   size = 2 * radius + 1;
+    const float inv  = 1.0f / (float)size;
+
+    int sum[4] = {0, 0, 0, 0};
+    for (int k = 0; k < size; ++k) {
+        blur_add(sum, in[k * inStep], 1);
+    }
+    for (int i = 0; i < n; ++i) {
+        out[i * outStep] = blur_pack(sum, inv);
+        blur_add(sum, in[(i + size) * inStep], 1);
+        blur_add(sum, in[i * inStep], -1);
+    }
+}
+
+#ifdef EGE_SIMD_X86
+EGE_SIMD_TARGET("sse2") inline __m128i blur_unpack_sse2(color_t p)
+{
+    const __m128i zero = _mm_setzero_si128();
+    return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p), zero), zero);
+}
+
+EGE_SIMD_TARGET("sse2") inline color_t blur_pack_sse2(__m128i sum, __m128 inv)
+{
+    // Same float operations as blur_pack(), so both paths give identical results.
+    __m128i r = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(sum), inv), _mm_set1_ps(0.5f)));
+    r         = _mm_packs_epi32(r, r);
+    return (color_t)_mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+}
+
+EGE_SIMD_TARGET("sse2")
+inline void blur_run_sse2(color_t* out, int outStep, const color_t* in, int inStep, int n, int radius)
+{
+    const int    size = 2 * radius + 1;
+    const __m128 inv  = _mm_set1_ps(1.0f / (float)size);
+
+    __m128i sum = _mm_setzero_si128();
+    for (int k = 0; k < size; ++k) {
+        sum = _mm_add_epi32(sum, blur_unpack_sse2(in[k * inStep]));
+    }
+    for (int i = 0; i < n; ++i) {
+        out[i * outStep] = blur_pack_sse2(sum, inv);
+        sum = _mm_add_epi32(sum, _mm_sub_epi32(blur_unpack_sse2(in[(i + size) * inStep]), blur_unpack_sse2(in[i * inStep])));
+    }
+}
+
+/// Vertical running sums of a strip of columns, one SSE2 accumulator per column.
+EGE_SIMD_TARGET("sse2")
+inline void blur_columns_sse2(color_t* out, int outStride, const color_t* in, int width, int n, int radius)
+{
+    const int    size = 2 * radius + 1;
+    const __m128 inv  = _mm_set1_ps(1.0f / (float)size);
+
+    __m128i sums[BLUR_STRIP_WIDTH];
+    for (int c = 0; c < width; ++c) {
+        sums[c] = _mm_setzero_si128();
+    }
+    for (int k = 0; k < size; ++k) {
+        for (int c = 0; c < width; ++c) {
+            sums[c] = _mm_add_epi32(sums[c], blur_unpack_sse2(in[k * width + c]));
+        }
+    }
+    for (int i = 0; i < n; ++i) {
+        const color_t* add = in + (i + size) * width;
+        const color_t* sub = in + i * width;
+        color_t*       dst = out + (size_t)i * outStride;
+        for (int c = 0; c < width; ++c) {
+            dst[c]  = blur_pack_sse2(sums[c], inv);
+            sums[c] = _mm_add_epi32(sums[c], _mm_sub_epi32(blur_unpack_sse2(add[c]), blur_unpack_sse2(sub[c])));
+        }
+    }
+}
+#endif
+
+inline void blur_columns_scalar(color_t* out, int outStride, const color_t* in, int width, int n, int radius)
+{
+    for (int c = 0; c < width; ++c) {
+        blur_run_scalar(out + c, outStride, in + c, width, n, radius);
+    }
+}
+
+inline void blur_rows_task(void* context, int index)
+{
+    const blur_job& job = *(const blur_job*)context;
+
+    const int r  = job.radius;
+    int       ya = job.y + index * BLUR_ROWS_PER_TASK;
+    int       yb = ya + BLUR_ROWS_PER_TASK < job.y + job.h ? ya + BLUR_ROWS_PER_TASK : job.y + job.h;
+
+    std::vector<color_t> line((size_t)job.w + 2 * (size_t)r + 1);
+    for (int y = ya; y < yb; ++y) {
+        color_t* row = job.buf + (size_t)y * job.stride + job.x;
+        for (int k = 0; k < (int)line.size(); ++k) {
+            int x   = k - r;
+            line[k] = row[x < 0 ? 0 : (x >= job.w ? job.w - 1 : x)];
+        }
+#ifdef EGE_SIMD_X86
+        if (job.sse2) {
+            blur_run_sse2(row, 1, &line[0], 1, job.w, r);
+            continue;
+        }
+#endif
+        blur_run_scalar(row, 1, &line[0], 1, job.w, r);
+    }
+}
+
+inline void blur_columns_task(void* context, int index)
+{
+    const blur_job& job = *(const blur_job*)context;
+
+    const int r     = job.radius;
+    int       xa    = job.x + index * BLUR_STRIP_WIDTH;
+    int       width = xa + BLUR_STRIP_WIDTH < job.x + job.w ? BLUR_STRIP_WIDTH : job.x + job.w - xa;
+    size_t    rows  = (size_t)job.h + 2 * (size_t)r + 1;
+
+    // Copy of the strip with clamped rows above and below, so the sums read unmodified input.
+    std::vector<color_t> strip(rows * width);
+    for (int k = 0; k < (int)rows; ++k) {
+        int            y   = k - r;
+        const color_t* src = job.buf + (size_t)(job.y + (y < 0 ? 0 : (y >= job.h ? job.h - 1 : y))) * job.stride + xa;
+        for (int c = 0; c < width; ++c) {
+            strip[(size_t)k * width + c] = src[c];
+        }
+    }
+
+    color_t* out = job.buf + (size_t)job.y * job.stride + xa;
+#ifdef EGE_SIMD_X86
+    if (job.sse2) {
+        blur_columns_sse2(out, job.stride, &strip[0], width, job.h, r);
+        return;
+    }
+#endif
+    blur_columns_scalar(out, job.stride, &strip[0], width, job.h, r);
+}
+
+/// Largest useful radius for the region; wider windows only add more copies of the edge pixels.
+inline int blur_max_radius(const blur_job& job)
+{
+    return job.w > job.h ? job.w : job.h;
+}
+
+inline void blur_box_pass(blur_job& job, int radius)
+{
+    if (radius <= 0) {
+        return;
+    }
+    // Keeps the padded line and strip buffers within three times the region size.
+    job.radius = radius < blur_max_radius(job) ? radius : blur_max_radius(job);
+    parallel_for((job.h + BLUR_ROWS_PER_TASK - 1) / BLUR_ROWS_PER_TASK, blur_rows_task, &job);
+    parallel_for((job.w + BLUR_STRIP_WIDTH - 1) / BLUR_STRIP_WIDTH, blur_columns_task, &job);
+}
+
+/// Clip the region to a w x h buffer with the given row stride and prepare the job.
+inline bool blur_setup(blur_job& job, color_t* buf, int w, int h, int stride, int xDest, int yDest, int widthDest,
+    int heightDest)
+{
+    if (widthDest <= 0)  widthDest  = w - xDest;
+    if (heightDest <= 0) heightDest = h - yDest;
+    if (xDest < 0) { widthDest  += xDest; xDest = 0; }
+    if (yDest < 0) { heightDest += yDest; yDest = 0; }
+    if (xDest + widthDest > w)  widthDest  = w - xDest;
+    if (yDest + heightDest > h) heightDest = h - yDest;
+    if (widthDest <= 0 || heightDest <= 0) {
+        return false;
+    }
+
+    job.buf    = buf;
+    job.stride = stride;
+    job.x      = xDest;
+    job.y      = yDest;
+    job.w      = widthDest;
+    job.h      = heightDest;
+    job.radius = 0;
+    job.sse2   = (ege_cpu_features() & CPU_FEATURE_SSE2) != 0;
+    return job.buf != NULL;
+}
+
+inline bool blur_setup(blur_job& job, PIMAGE imgDest, int xDest, int yDest, int widthDest, int heightDest)
+{
+    int w = getwidth(imgDest);
+    return blur_setup(job, getbuffer(imgDest), w, getheight(imgDest), w, xDest, yDest, widthDest, heightDest);
+}
+
+/// Three box passes whose combined variance matches radius^2.
+inline void blur_gaussian(blur_job& job, float radius)
+{
+    // m passes of width wl, the rest wl + 2.
+    const int passes   = 3;
+    double    sigma    = radius < (float)blur_max_radius(job) ? radius : (double)blur_max_radius(job);
+    double    variance = sigma * sigma;
+    int       wl       = (int)floor(sqrt(12.0 * variance / passes + 1.0));
+    if (wl % 2 == 0) {
+        --wl;
+    }
+    int m = (int)floor((12.0 * variance - passes * wl * wl - 4.0 * passes * wl - 3.0 * passes) / (-4.0 * wl - 4.0) + 0.5);
+
+    for (int i = 0; i < passes; ++i) {
+        blur_box_pass(job, ((i < m ? wl : wl + 2) - 1) / 2);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Box blur filter with a constant cost per pixel regardless of radius
+ * @param imgDest Target IMAGE object pointer, image to be blurred, if NULL then the screen
+ * @param radius Blur radius in pixels, each output pixel averages a (2 * radius + 1) square
+ * @param passes Number of box passes, default is 1 (three passes look close to a gaussian)
+ * @param xDest X coordinate of top-left corner of processing region, default is 0
+ * @param yDest Y coordinate of top-left corner of processing region, default is 0
+ * @param widthDest Width of processing region, default is 0 (use entire image width)
+ * @param heightDest Height of processing region, default is 0 (use entire image height)
+ * @return Returns grOk on success, corresponding error code on failure
+ * @note Pixels outside the region are treated as copies of the nearest edge pixel. The radius is
+ *       clamped to the larger side of the region.
+ */
+inline int imagefilter_boxblur(PIMAGE imgDest, int radius, int passes = 1, int xDest = 0, int yDest = 0,
+    int widthDest = 0, int heightDest = 0)
+{
+    detail::blur_job job;
+    if (!detail::blur_setup(job, imgDest, xDest, yDest, widthDest, heightDest)) {
+        return grInvalidRegion;
+    }
+    for (int i = 0; i < passes; ++i) {
+        detail::blur_box_pass(job, radius);
+    }
+    detail::dirty_note(imgDest, job.x, job.y, job.w, job.h);
+    return grOk;
+}
+
+/**
+ * @brief Gaussian blur filter with a constant cost per pixel regardless of radius
+ * @param imgDest Target IMAGE object pointer, image to be blurred, if NULL then the screen
+ * @param radius Standard deviation of the gaussian in pixels
+ * @param xDest X coordinate of top-left corner of processing region, default is 0
+ * @param yDest Y coordinate of top-left corner of processing region, default is 0
+ * @param widthDest Width of processing region, default is 0 (use entire image width)
+ * @param heightDest Height of processing region, default is 0 (use entire image height)
+ * @return Returns grOk on success, corresponding error code on failure
+ * @note Implemented as three box passes, which stays within a few percent of a true gaussian.
+ *       The radius is clamped to the larger side of the region.
+ */
+inline int imagefilter_gaussian(PIMAGE imgDest, float radius, int xDest = 0, int yDest = 0, int widthDest = 0,
+    int heightDest = 0)
+{
+    detail::blur_job job;
+    if (!detail::blur_setup(job, imgDest, xDest, yDest, widthDest, heightDest)) {
+        return grInvalidRegion;
+    }
+    if (!(radius > 0.0f)) {
+        return grOk;
+    }
+    detail::blur_gaussian(job, radius);
+    detail::dirty_note(imgDest, job.x, job.y, job.w, job.h);
+    return grOk;
+}
+
+} // namespace ege
+
+#endif /* EGE_BLUR_H */
@@ -8,6 +8,7 @@
 #define EGE_BUTTON_H
 
 #include "egecontrolbase.h"
+#include "text_measure.h"
 
 #include <algorithm>
 
@@ -148,14 +149,14 @@ public:
         setbkmode(TRANSPARENT);
         setfillstyle(SOLID_FILL, _bg_color);
         bar(0, 0, getw() - 1, geth() - 1);
-        setfont(_font_height, 0, _face);
+        setfont_cached(_font_height, 0, _face);
         setcolor(_text_color);
 
         // settextjustify(LEFT_TEXT,CENTER_TEXT);
         // outtextrect(_side_width, _side_width, getw()-_side_width, geth()-_side_width, _caption);
         // outtextrect(0, 0, getw(), geth(), _caption);
-        int x = (getw() - textwidth(_caption)) / 2;
-        int y = (geth() - textheight(_caption)) / 2;
+        int x = (getw() - textwidth_cached(_caption)) / 2;
+        int y = (geth() - textheight_cached(_caption)) / 2;
 
         outtextxy(x, y, _caption);
         setbkcolor(_line_color);
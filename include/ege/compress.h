@@ -0,0 +1,496 @@
+/**
+ * @file compress.h
+ * @brief Block-parallel compression built on ege_compress2() and ege_uncompress()
+ *
+ * ege_compress() turns a buffer into one stream that is compressed and decompressed on one
+ * thread. ege_compress_parallel() cuts the buffer into blocks of a fixed size instead and
+ * compresses each block with ege_compress2() on its own thread; ege_uncompress_parallel()
+ * decompresses the blocks concurrently again. The result is a frame:
+ *
+ *     uint32 size                 uncompressed size, where ege_compress() stores it as well
+ *     uint32 magic                "EGPF"
+ *     uint32 blockSize
+ *     uint32 blockCount
+ *     blockCount x { uint32 compressedSize; uint32 crc32; }
+ *     blockCount x ege_compress2() output
+ *
+ * All fields are little-endian; the CRC-32 covers the uncompressed block. Because the frame
+ * starts with the uncompressed size, ege_uncompress_size() works on frames unchanged, and
+ * ege_uncompress_parallel() accepts plain ege_compress() output too.
+ *
+ * ege_deflate_stream and ege_inflate_stream compress and decompress data that is produced or
+ * consumed a little at a time, such as logs or recorded frames, with a fixed amount of memory:
+ * push() hands data in, pull() takes the result out. They use the zlib stream format (RFC 1950)
+ * and the encoder and decoder of ege/deflate.h, with the same levels as ege_compress2().
+ */
+#ifndef EGE_COMPRESS_H
+#define EGE_COMPRESS_H
+
+#include "deflate.h"
+#include "parallel.h"
+
+namespace ege
+{
+
+namespace detail
+{
+
+const uint32_t FRAME_MAGIC        = 0x46504745;  ///< "EGPF" in little-endian byte order
+const uint32_t FRAME_HEADER_SIZE  = 16;
+const uint32_t FRAME_ENTRY_SIZE   = 8;
+const uint32_t FRAME_BLOCK_MIN    = 64 * 1024;
+const uint32_t FRAME_BLOCK_DEFAULT = 1024 * 1024;
+const size_t   STREAM_PIECE        = 128 * 1024;   ///< Input compressed at once by ege_deflate_stream
+
+inline void frame_put32(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+inline uint32_t frame_get32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+inline uint32_t frame_block_size(int blockSize)
+{
+    return blockSize <= 0 ? FRAME_BLOCK_DEFAULT : ((uint32_t)blockSize < FRAME_BLOCK_MIN ? FRAME_BLOCK_MIN : (uint32_t)blockSize);
+}
+
+inline bool frame_is_parallel(const void* compressData, uint32_t compressSize)
+{
+    return compressData != NULL && compressSize >= FRAME_HEADER_SIZE
+           && frame_get32((const uint8_t*)compressData + 4) == FRAME_MAGIC;
+}
+
+struct frame_job
+{
+    const uint8_t*        src;
+    uint8_t*              dst;
+    uint32_t              size, blockSize, blocks;
+    int                   level;
+    std::vector<uint32_t> offset;   ///< Position of each compressed block in the frame
+    std::vector<uint32_t> packed;   ///< Compressed size of each block
+    std::vector<uint32_t> crc;
+    volatile LONG         failed;
+
+    uint32_t blockLength(uint32_t i) const { return i + 1 < blocks ? blockSize : size - i * blockSize; }
+};
+
+inline void frame_compress_block(void* context, int index)
+{
+    frame_job& job = *(frame_job*)context;
+    uint32_t   i = (uint32_t)index, length = job.blockLength(i);
+    const uint8_t* src = job.src + (size_t)i * job.blockSize;
+    job.crc[i]         = deflate_crc32(0, src, length);
+    job.packed[i]      = ege_compress_bound(length);
+    if (ege_compress2(job.dst + job.offset[i], &job.packed[i], src, length, job.level) != 0) {
+        InterlockedExchange(&job.failed, 1);
+    }
+}
+
+inline void frame_uncompress_block(void* context, int index)
+{
+    frame_job& job = *(frame_job*)context;
+    uint32_t   i = (uint32_t)index, length = job.blockLength(i), unpacked = length;
+    uint8_t*   dst = job.dst + (size_t)i * job.blockSize;
+    if (ege_uncompress(dst, &unpacked, job.src + job.offset[i], job.packed[i]) != 0 || unpacked != length
+        || deflate_crc32(0, dst, length) != job.crc[i]) {
+        InterlockedExchange(&job.failed, 1);
+    }
+}
+
+struct frame_runner
+{
+    parallel_task task;
+    void*         context;
+    LONG          count;
+    volatile LONG next;
+
+    void work()
+    {
+        for (LONG i; (i = InterlockedIncrement(&next) - 1) < count;) {
+            task(context, (int)i);
+        }
+    }
+
+    static DWORD WINAPI threadProc(LPVOID param)
+    {
+        ((frame_runner*)param)->work();
+        return 0;
+    }
+};
+
+/**
+ * Run task(context, i) for i in [0, count) on the given number of threads, including the calling
+ * one. Unlike parallel_for() the thread count is chosen per call, as the callers ask for it.
+ */
+inline void frame_run(int count, parallel_task task, void* context, int threads)
+{
+    if (threads <= 0) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        threads = (int)info.dwNumberOfProcessors;
+    }
+    threads = threads > count ? count : (threads > 64 ? 64 : threads);
+
+    frame_runner        runner = {task, context, count, 0};
+    std::vector<HANDLE> workers;
+    for (int i = 1; i < threads; ++i) {
+        HANDLE thread = CreateThread(NULL, 0, frame_runner::threadProc, &runner, 0, NULL);
+        if (thread == NULL) {
+            break;
+        }
+        workers.push_back(thread);
+    }
+    runner.work();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        WaitForSingleObject(workers[i], INFINITE);
+        CloseHandle(workers[i]);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Get the maximum size of the output of ege_compress_parallel()
+ * @param dataSize Size of the data to compress
+ * @param blockSize Block size that will be passed to ege_compress_parallel()
+ * @return Required size of the compressData buffer
+ */
+inline uint32_t ege_compress_parallel_bound(uint32_t dataSize, int blockSize = 0)
+{
+    uint32_t block  = detail::frame_block_size(blockSize);
+    uint32_t blocks = dataSize / block, rest = dataSize % block;
+    return detail::FRAME_HEADER_SIZE + (blocks + (rest != 0)) * detail::FRAME_ENTRY_SIZE + blocks * ege_compress_bound(block)
+           + (rest != 0 ? ege_compress_bound(rest) : 0);
+}
+
+/**
+ * @brief Compress data as independent blocks on several threads
+ * @param compressData Receives the frame, at least ege_compress_parallel_bound() bytes
+ * @param compressSize In: size of compressData; out: size of the frame
+ * @param data Data to compress
+ * @param size Size of data
+ * @param level Compression level of each block, as for ege_compress2()
+ * @param blockSize Uncompressed size of each block, at least 64 KiB; 0 or a negative value uses 1 MiB
+ * @param threads Thread count including the calling thread; 0 or a negative value uses one per processor
+ * @return grOk on success, grNullPointer if a pointer is NULL, grParamError if compressData is too
+ *         small, grError if a block cannot be compressed
+ * @note Smaller blocks spread better over threads, larger ones compress slightly better.
+ *       ege_uncompress_size() returns the uncompressed size of the frame; decompress it with
+ *       ege_uncompress_parallel().
+ */
+inline int ege_compress_parallel(void* compressData, uint32_t* compressSize, const void* data, uint32_t size,
+    int level, int blockSize = 0, int threads = 0)
+{
+    if (compressData == NULL || compressSize == NULL || (data == NULL && size != 0)) {
+        return grNullPointer;
+    }
+    detail::frame_job job;
+    job.src       = (const uint8_t*)data;
+    job.dst       = (uint8_t*)compressData;
+    job.size      = size;
+    job.blockSize = detail::frame_block_size(blockSize);
+    job.blocks    = (size + job.blockSize - 1) / job.blockSize;
+    job.level     = level;
+    job.failed    = 0;
+    if (*compressSize < ege_compress_parallel_bound(size, (int)job.blockSize)) {
+        return grParamError;
+    }
+    job.offset.resize(job.blocks);
+    job.packed.resize(job.blocks);
+    job.crc.resize(job.blocks);
+
+    // Every block is compressed into a slot of its worst-case size, then the slots are packed.
+    uint32_t pos = detail::FRAME_HEADER_SIZE + job.blocks * detail::FRAME_ENTRY_SIZE;
+    for (uint32_t i = 0; i < job.blocks; ++i) {
+        job.offset[i] = pos;
+        pos          += ege_compress_bound(job.blockLength(i));
+    }
+    detail::frame_run((int)job.blocks, detail::frame_compress_block, &job, threads);
+    if (job.failed) {
+        return grError;
+    }
+
+    uint8_t* frame = job.dst;
+    pos            = detail::FRAME_HEADER_SIZE + job.blocks * detail::FRAME_ENTRY_SIZE;
+    for (uint32_t i = 0; i < job.blocks; ++i) {
+        memmove(frame + pos, frame + job.offset[i], job.packed[i]);
+        detail::frame_put32(frame + detail::FRAME_HEADER_SIZE + i * detail::FRAME_ENTRY_SIZE, job.packed[i]);
+        detail::frame_put32(frame + detail::FRAME_HEADER_SIZE + i * detail::FRAME_ENTRY_SIZE + 4, job.crc[i]);
+        pos += job.packed[i];
+    }
+    detail::frame_put32(frame, size);
+    detail::frame_put32(frame + 4, detail::FRAME_MAGIC);
+    detail::frame_put32(frame + 8, job.blockSize);
+    detail::frame_put32(frame + 12, job.blocks);
+    *compressSize = pos;
+    return grOk;
+}
+
+/**
+ * @brief Decompress a frame of ege_compress_parallel(), decompressing its blocks on several threads
+ * @param buffer Receives the data, at least ege_uncompress_size() bytes
+ * @param bufferSize In: size of buffer; out: size of the data
+ * @param compressData Frame from ege_compress_parallel(), or output of ege_compress()
+ * @param compressSize Size of compressData
+ * @param threads Thread count including the calling thread; 0 or a negative value uses one per processor
+ * @return grOk on success, grNullPointer if a pointer is NULL, grParamError if buffer is too small,
+ *         grInvalidFileFormat if the frame is damaged or a block fails its checksum
+ * @note Output of ege_compress() is passed on to ege_uncompress() and returns its result.
+ */
+inline int ege_uncompress_parallel(void* buffer, uint32_t* bufferSize, const void* compressData, uint32_t compressSize,
+    int threads = 0)
+{
+    if (buffer == NULL || bufferSize == NULL || compressData == NULL) {
+        return grNullPointer;
+    }
+    if (!detail::frame_is_parallel(compressData, compressSize)) {
+        return ege_uncompress(buffer, bufferSize, compressData, compressSize);
+    }
+
+    const uint8_t*    frame = (const uint8_t*)compressData;
+    detail::frame_job job;
+    job.src       = frame;
+    job.dst       = (uint8_t*)buffer;
+    job.size      = detail::frame_get32(frame);
+    job.blockSize = detail::frame_get32(frame + 8);
+    job.blocks    = detail::frame_get32(frame + 12);
+    job.failed    = 0;
+    if (job.blockSize == 0 || job.blocks != (job.size + (unsigned long long)job.blockSize - 1) / job.blockSize
+        || job.blocks > (compressSize - detail::FRAME_HEADER_SIZE) / detail::FRAME_ENTRY_SIZE) {
+        return grInvalidFileFormat;
+    }
+    if (*bufferSize < job.size) {
+        return grParamError;
+    }
+    job.offset.resize(job.blocks);
+    job.packed.resize(job.blocks);
+    job.crc.resize(job.blocks);
+    unsigned long long pos = detail::FRAME_HEADER_SIZE + job.blocks * detail::FRAME_ENTRY_SIZE;
+    for (uint32_t i = 0; i < job.blocks; ++i) {
+        const uint8_t* entry = frame + detail::FRAME_HEADER_SIZE + i * detail::FRAME_ENTRY_SIZE;
+        job.offset[i]        = (uint32_t)pos;
+        job.packed[i]        = detail::frame_get32(entry);
+        job.crc[i]           = detail::frame_get32(entry + 4);
+        pos                 += job.packed[i];
+    }
+    if (pos > compressSize) {
+        return grInvalidFileFormat;
+    }
+    detail::frame_run((int)job.blocks, detail::frame_uncompress_block, &job, threads);
+    if (job.failed) {
+        return grInvalidFileFormat;
+    }
+    *bufferSize = job.size;
+    return grOk;
+}
+
+/**
+ * @class ege_deflate_stream
+ * @brief Incremental compressor producing a zlib stream
+ *
+ * Input is collected in pieces of 128 KiB, each compressed as soon as it is complete with
+ * matches reaching back into the previous 32 KiB, so memory use does not depend on the amount
+ * of data as long as the output is pulled as it comes.
+ */
+class ege_deflate_stream
+{
+public:
+    /// @param level Compression level from 0 (fastest) to 8 (smallest), as for ege_compress2()
+    explicit ege_deflate_stream(int level = detail::DEFLATE_LEVEL_DEFAULT)
+        : m_encoder(level), m_history(0), m_read(0), m_adler(1), m_started(false), m_finished(false)
+    {}
+
+    /**
+     * @brief Add data to compress
+     * @return false if data is NULL or finish() has been called
+     */
+    bool push(const void* data, size_t size)
+    {
+        if (m_finished || (data == NULL && size != 0)) {
+            return false;
+        }
+        const uint8_t* p = (const uint8_t*)data;
+        m_adler          = detail::deflate_adler32(m_adler, p, size);
+        while (size > 0) {
+            size_t n = std::min(size, m_history + detail::STREAM_PIECE - m_buf.size());
+            m_buf.insert(m_buf.end(), p, p + n);
+            p    += n;
+            size -= n;
+            if (m_buf.size() - m_history >= detail::STREAM_PIECE) {
+                compress(false);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Compress the data pushed so far without waiting for a full piece
+     * @note Everything pulled afterwards decodes up to the last pushed byte, at the cost of a
+     *       few bytes of output. Flushing after every small push hurts compression.
+     */
+    void flush()
+    {
+        if (!m_finished && m_buf.size() > m_history) {
+            compress(false);
+        }
+    }
+
+    /// @brief End the stream: compress the rest and append the checksum
+    void finish()
+    {
+        if (!m_finished) {
+            compress(true);
+            m_finished = true;
+        }
+    }
+
+    /**
+     * @brief Take compressed bytes
+     * @param buffer Receives up to size bytes
+     * @return Number of bytes copied, 0 when nothing is ready
+     */
+    size_t pull(void* buffer, size_t size)
+    {
+        size_t n = std::min(size, available());
+        if (n > 0) {
+            memcpy(buffer, &m_out[m_read], n);
+            m_read += n;
+        }
+        if (m_read == m_out.size()) {
+            m_out.clear();
+            m_read = 0;
+        }
+        return n;
+    }
+
+    /// @brief Number of compressed bytes ready to pull
+    size_t available() const { return m_out.size() - m_read; }
+
+    /// @brief Whether the stream is finished and everything has been pulled
+    bool done() const { return m_finished && available() == 0; }
+
+private:
+    void compress(bool last)
+    {
+        if (m_read > 0) {
+            m_out.erase(m_out.begin(), m_out.begin() + m_read);
+            m_read = 0;
+        }
+        if (!m_started) {
+            m_out.push_back(0x78);
+            m_out.push_back(0x9C);
+            m_started = true;
+        }
+        detail::deflate_bits bits(m_out);
+        m_encoder.compress(bits, m_buf.empty() ? NULL : &m_buf[0], m_history, m_buf.size(), last);
+        if (last) {
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                m_out.push_back((uint8_t)(m_adler >> shift));
+            }
+        }
+        // Only the last 32 KiB are kept, as the history of the next piece.
+        if (m_buf.size() > (size_t)detail::DEFLATE_WINDOW) {
+            m_buf.erase(m_buf.begin(), m_buf.end() - detail::DEFLATE_WINDOW);
+        }
+        m_history = m_buf.size();
+    }
+
+    detail::deflate_encoder m_encoder;
+    std::vector<uint8_t>    m_buf;      ///< History followed by input not compressed yet
+    size_t                  m_history;
+    std::vector<uint8_t>    m_out;
+    size_t                  m_read;
+    uint32_t                m_adler;
+    bool                    m_started, m_finished;
+};
+
+/**
+ * @class ege_inflate_stream
+ * @brief Incremental decompressor for zlib streams, such as the output of ege_deflate_stream
+ *
+ * Decoding happens in pull(), as far as the pushed input goes; it keeps 32 KiB of history plus
+ * at most 64 KiB of output that has not been pulled yet.
+ */
+class ege_inflate_stream
+{
+public:
+    ege_inflate_stream() : m_read(0), m_status(detail::inflate_decoder::INFLATE_MORE), m_ended(false) {}
+
+    /**
+     * @brief Add compressed data
+     * @return false if data is NULL, finish() has been called or the stream has ended or failed
+     */
+    bool push(const void* data, size_t size)
+    {
+        if (m_ended || m_status != detail::inflate_decoder::INFLATE_MORE || (data == NULL && size != 0)) {
+            return false;
+        }
+        m_decoder.feed(data, size);
+        return true;
+    }
+
+    /// @brief Declare that no more input follows, so that a truncated stream becomes an error
+    void finish()
+    {
+        m_ended = true;
+        m_decoder.end();
+    }
+
+    /**
+     * @brief Take decompressed bytes
+     * @param buffer Receives up to size bytes
+     * @return Number of bytes copied; 0 when more input is needed, the stream is done or failed
+     */
+    size_t pull(void* buffer, size_t size)
+    {
+        uint8_t* dst   = (uint8_t*)buffer;
+        size_t   total = 0;
+        while (total < size) {
+            if (m_read == m_out.size()) {
+                if (m_status != detail::inflate_decoder::INFLATE_MORE) {
+                    break;
+                }
+                if (m_out.size() >= 2 * (size_t)detail::DEFLATE_WINDOW) {
+                    m_out.erase(m_out.begin(), m_out.end() - detail::DEFLATE_WINDOW);
+                    m_read = m_out.size();
+                }
+                m_status = m_decoder.decode(m_out, m_out.size() + std::min(size - total, (size_t)2 * detail::DEFLATE_WINDOW));
+                if (m_read == m_out.size()) {
+                    break;
+                }
+            }
+            size_t n = std::min(size - total, m_out.size() - m_read);
+            memcpy(dst + total, &m_out[m_read], n);
+            m_read += n;
+            total  += n;
+        }
+        return total;
+    }
+
+    /// @brief Whether the whole stream has been decoded, verified and pulled
+    bool done() const { return m_status == detail::inflate_decoder::INFLATE_END && m_read == m_out.size(); }
+
+    /**
+     * @brief Get the state of the stream
+     * @return grOk, or grInvalidFileFormat if the stream is damaged, fails its checksum or was
+     *         truncated before finish()
+     */
+    int error() const { return m_status == detail::inflate_decoder::INFLATE_ERROR ? grInvalidFileFormat : grOk; }
+
+private:
+    detail::inflate_decoder         m_decoder;
+    std::vector<uint8_t>            m_out;  ///< History followed by output not pulled yet
+    size_t                          m_read;
+    detail::inflate_decoder::status m_status;
+    bool                            m_ended;
+};
+
+} // namespace ege
+
+#endif /* EGE_COMPRESS_H */
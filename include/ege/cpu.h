@@ -0,0 +1,139 @@
+/**
+ * @file cpu.h
+ * @brief Runtime CPU feature detection for the SIMD code paths of the EGE helpers
+ *
+ * SIMD kernels are compiled for every instruction set the compiler can target and the
+ * best one is selected at runtime from CPUID, so the same binary runs on any x86 CPU.
+ * On compilers that cannot target SSE2/AVX2 from a header (or on non-x86 targets)
+ * EGE_SIMD_X86 is left undefined and only the scalar paths are built.
+ */
+#ifndef EGE_CPU_H
+#define EGE_CPU_H
+
+#include "../ege.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#   if defined(_MSC_VER) && (_MSC_VER >= 1800)
+#       define EGE_SIMD_X86 1
+#       define EGE_SIMD_TARGET(isa)
+#       include <intrin.h>
+#       include <immintrin.h>
+#   elif defined(__clang__) || (defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9))))
+#       define EGE_SIMD_X86 1
+#       define EGE_SIMD_TARGET(isa) __attribute__((target(isa)))
+#       include <cpuid.h>
+#       include <immintrin.h>
+#   endif
+#endif
+
+namespace ege
+{
+
+/**
+ * @enum cpu_feature_flag
+ * @brief Instruction set extensions used by the SIMD kernels
+ */
+enum cpu_feature_flag
+{
+    CPU_FEATURE_SSE2  = 0x01,   ///< SSE2
+    CPU_FEATURE_SSSE3 = 0x02,   ///< SSSE3
+    CPU_FEATURE_SSE41 = 0x04,   ///< SSE4.1
+    CPU_FEATURE_AVX2  = 0x08    ///< AVX2 (only reported when the OS saves the YMM registers)
+};
+
+namespace detail
+{
+
+inline unsigned int cpu_detect_features()
+{
+    unsigned int features = 0;
+#ifdef EGE_SIMD_X86
+    unsigned int regs[4] = {0, 0, 0, 0};  // eax, ebx, ecx, edx
+    unsigned int maxLeaf;
+#   ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    maxLeaf = (unsigned int)info[0];
+    if (maxLeaf >= 1) {
+        __cpuid(info, 1);
+        for (int i = 0; i < 4; ++i) regs[i] = (unsigned int)info[i];
+    }
+#   else
+    maxLeaf = __get_cpuid_max(0, NULL);
+    if (maxLeaf >= 1) {
+        __cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+    }
+#   endif
+
+    if (regs[3] & (1u << 26)) features |= CPU_FEATURE_SSE2;
+    if (regs[2] & (1u << 9))  features |= CPU_FEATURE_SSSE3;
+    if (regs[2] & (1u << 19)) features |= CPU_FEATURE_SSE41;
+
+    // AVX2 needs OSXSAVE + AVX and an OS that preserves the YMM state (XCR0 bits 1 and 2).
+    bool osAvx = false;
+    if ((regs[2] & (1u << 27)) && (regs[2] & (1u << 28))) {
+#   ifdef _MSC_VER
+        osAvx = (_xgetbv(0) & 0x6) == 0x6;
+#   else
+        unsigned int xcr0Lo, xcr0Hi;
+        __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+        osAvx = (xcr0Lo & 0x6) == 0x6;
+#   endif
+    }
+
+    if (osAvx && maxLeaf >= 7) {
+#   ifdef _MSC_VER
+        __cpuidex(info, 7, 0);
+        unsigned int ebx7 = (unsigned int)info[1];
+#   else
+        unsigned int eax7, ebx7, ecx7, edx7;
+        __cpuid_count(7, 0, eax7, ebx7, ecx7, edx7);
+#   endif
+        if (ebx7 & (1u << 5)) features |= CPU_FEATURE_AVX2;
+    }
+#endif
+    return features;
+}
+
+inline volatile LONG& cpu_features_cache()
+{
+    static volatile LONG features = -1;
+    return features;
+}
+
+inline volatile LONG& cpu_features_mask()
+{
+    static volatile LONG mask = -1;
+    return mask;
+}
+
+} // namespace detail
+
+/**
+ * @brief Get the instruction set extensions usable by the SIMD kernels
+ * @return Combination of cpu_feature_flag values, filtered by ege_cpu_set_features_mask()
+ * @note Detection runs once; the result is cached for the lifetime of the process
+ */
+inline unsigned int ege_cpu_features()
+{
+    volatile LONG& cache = detail::cpu_features_cache();
+    if (cache == -1) {
+        InterlockedExchange(&cache, (LONG)detail::cpu_detect_features());
+    }
+    return (unsigned int)cache & (unsigned int)detail::cpu_features_mask();
+}
+
+/**
+ * @brief Restrict the instruction sets the SIMD kernels may use
+ * @param mask Combination of cpu_feature_flag values, 0 forces the scalar paths, ~0u restores detection
+ * @note Intended for benchmarking and for verifying SIMD output against the scalar paths.
+ *       Kernel tables that were already selected are re-selected on their next use.
+ */
+inline void ege_cpu_set_features_mask(unsigned int mask)
+{
+    InterlockedExchange(&detail::cpu_features_mask(), (LONG)mask);
+}
+
+} // namespace ege
+
+#endif /* EGE_CPU_H */
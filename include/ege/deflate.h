@@ -0,0 +1,1038 @@
+/**
+ * @file deflate.h
+ * @brief Deflate encoder that can stitch independently compressed pieces into one stream
+ *
+ * ege_compress() hands a whole buffer to the library's sdefl encoder and always produces one
+ * complete stream. The encoder here produces deflate (RFC 1951) data piece by piece instead:
+ * a piece that is not the last one ends with an empty stored block, so it stops on a byte
+ * boundary and the next piece can simply be appended. Pieces may look back into the 32 KiB of
+ * input before them, so splitting costs almost nothing in compression ratio, and pieces of
+ * one buffer can be compressed on different threads at the same time.
+ *
+ * The levels follow sdefl and ege_compress2(): 0 is the fastest, 8 the smallest output.
+ * Adler-32 (with combination of partial sums) and CRC-32 are included for zlib and PNG framing.
+ *
+ * inflate_decoder is the matching zlib stream decoder for input that arrives in pieces: it
+ * decodes as far as the input goes and picks up at the last complete symbol once more arrives.
+ */
+#ifndef EGE_DEFLATE_H
+#define EGE_DEFLATE_H
+
+#include "../ege.h"
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+namespace ege
+{
+
+namespace detail
+{
+
+const int DEFLATE_WINDOW       = 32768;
+const int DEFLATE_HASH_BITS    = 15;
+const int DEFLATE_BLOCK_TOKENS = 16384;    ///< Symbols per block before new Huffman codes are built
+const int DEFLATE_MIN_MATCH    = 3;
+const int DEFLATE_MAX_MATCH    = 258;
+const int DEFLATE_LEVEL_MIN    = 0;
+const int DEFLATE_LEVEL_DEFAULT = 5;
+const int DEFLATE_LEVEL_MAX    = 8;
+
+const uint16_t deflate_len_base[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83,
+    99, 115, 131, 163, 195, 227, 258};
+const uint8_t  deflate_len_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5,
+    0};
+const uint16_t deflate_dist_base[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t  deflate_dist_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11,
+    12, 12, 13, 13};
+/// Order in which the code length code lengths are stored
+const uint8_t  deflate_clen_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+inline uint32_t deflate_adler32(uint32_t adler, const void* data, size_t size)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t       a = adler & 0xFFFF, b = adler >> 16;
+    while (size > 0) {
+        // 5552 is the largest run before b can overflow 32 bits.
+        size_t n = size < 5552 ? size : 5552;
+        size -= n;
+        while (n-- > 0) {
+            a += *p++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+/// Adler-32 of two concatenated pieces, from the sums of each piece and the size of the second.
+inline uint32_t deflate_adler32_combine(uint32_t adler1, uint32_t adler2, size_t size2)
+{
+    const uint32_t base = 65521;
+    uint32_t       rem  = (uint32_t)(size2 % base);
+    uint32_t       sum1 = adler1 & 0xFFFF;
+    uint32_t       sum2 = (rem * sum1) % base;
+    sum1 += (adler2 & 0xFFFF) + base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + base - rem;
+    sum1 = sum1 >= base ? sum1 - base : sum1;
+    sum1 = sum1 >= base ? sum1 - base : sum1;
+    sum2 = sum2 >= 2 * base ? sum2 - 2 * base : sum2;
+    sum2 = sum2 >= base ? sum2 - base : sum2;
+    return (sum2 << 16) | sum1;
+}
+
+struct deflate_crc_table
+{
+    uint32_t entries[256];
+
+    deflate_crc_table()
+    {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+    }
+};
+
+inline uint32_t deflate_crc32(uint32_t crc, const void* data, size_t size)
+{
+    static const deflate_crc_table table;
+    const uint8_t* p = (const uint8_t*)data;
+    crc              = ~crc;
+    while (size-- > 0) {
+        crc = table.entries[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/// LSB-first bit writer appending to a byte vector.
+class deflate_bits
+{
+public:
+    deflate_bits() : m_out(NULL), m_bits(0), m_count(0) {}
+
+    explicit deflate_bits(std::vector<uint8_t>& out) : m_out(&out), m_bits(0), m_count(0) {}
+
+    void target(std::vector<uint8_t>& out) { m_out = &out; }
+
+    /// Append count (at most 16) bits of value.
+    void put(uint32_t value, int count)
+    {
+        m_bits  |= value << m_count;
+        m_count += count;
+        while (m_count >= 8) {
+            m_out->push_back((uint8_t)m_bits);
+            m_bits  >>= 8;
+            m_count -= 8;
+        }
+    }
+
+    void align()
+    {
+        if (m_count > 0) {
+            put(0, 8 - m_count);
+        }
+    }
+
+    /// Append whole bytes; the writer must be aligned.
+    void bytes(const uint8_t* data, size_t size) { m_out->insert(m_out->end(), data, data + size); }
+
+private:
+    std::vector<uint8_t>* m_out;
+    uint32_t              m_bits;
+    int                   m_count;
+};
+
+/// Code lengths and bit-reversed canonical codes of one alphabet.
+struct deflate_huffman
+{
+    uint8_t  lengths[288];
+    uint16_t codes[288];
+};
+
+/// Build code lengths of at most maxBits for freq[0, n); unused symbols get 0.
+inline void deflate_build_lengths(const uint32_t* freq, int n, int maxBits, uint8_t* lengths)
+{
+    int sorted[288], weights[288], used = 0;
+    memset(lengths, 0, n);
+    for (int i = 0; i < n; ++i) {
+        if (freq[i] != 0) {
+            sorted[used++] = i;
+        }
+    }
+    if (used == 0) {
+        return;
+    }
+    if (used == 1) {
+        // A complete code needs two symbols; the second one is never emitted.
+        lengths[sorted[0]]              = 1;
+        lengths[sorted[0] == 0 ? 1 : 0] = 1;
+        return;
+    }
+    for (int i = 1; i < used; ++i) {
+        int s = sorted[i], j = i;
+        for (; j > 0 && freq[sorted[j - 1]] > freq[s]; --j) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = s;
+    }
+
+    // Moffat and Katajainen's in-place minimum redundancy code on ascending weights.
+    int* a = weights;
+    for (int i = 0; i < used; ++i) {
+        a[i] = (int)freq[sorted[i]];
+    }
+    a[0] += a[1];
+    int root = 0, leaf = 2;
+    for (int next = 1; next < used - 1; ++next) {
+        if (leaf >= used || a[root] < a[leaf]) {
+            a[next]   = a[root];
+            a[root++] = next;
+        } else {
+            a[next] = a[leaf++];
+        }
+        if (leaf >= used || (root < next && a[root] < a[leaf])) {
+            a[next]   += a[root];
+            a[root++] = next;
+        } else {
+            a[next] += a[leaf++];
+        }
+    }
+    a[used - 2] = 0;
+    for (int next = used - 3; next >= 0; --next) {
+        a[next] = a[a[next]] + 1;
+    }
+    int avail = 1, taken = 0, depth = 0, next = used - 1;
+    root      = used - 2;
+    while (avail > 0) {
+        while (root >= 0 && a[root] == depth) {
+            ++taken;
+            --root;
+        }
+        while (avail > taken) {
+            a[next--] = depth;
+            --avail;
+        }
+        avail = 2 * taken;
+        ++depth;
+        taken = 0;
+    }
+
+    // Clamp to maxBits, then lengthen codes until the Kraft sum is exact again.
+    int count[16] = {0};
+    for (int i = 0; i < used; ++i) {
+        ++count[a[i] > maxBits ? maxBits : a[i]];
+    }
+    uint32_t total = 0;
+    for (int i = maxBits; i > 0; --i) {
+        total += (uint32_t)count[i] << (maxBits - i);
+    }
+    while (total != (1u << maxBits)) {
+        --count[maxBits];
+        for (int i = maxBits - 1; i > 0; --i) {
+            if (count[i] != 0) {
+                --count[i];
+                count[i + 1] += 2;
+                break;
+            }
+        }
+        --total;
+    }
+    for (int bits = maxBits, i = 0; bits > 0; --bits) {
+        for (int k = count[bits]; k > 0; --k) {
+            lengths[sorted[i++]] = (uint8_t)bits;
+        }
+    }
+}
+
+/// Assign canonical codes to lengths[0, n), bit-reversed for deflate_bits.
+inline void deflate_build_codes(deflate_huffman& h, int n)
+{
+    int count[16] = {0}, next[16];
+    for (int i = 0; i < n; ++i) {
+        ++count[h.lengths[i]];
+    }
+    count[0] = 0;
+    for (int bits = 1, code = 0; bits < 16; ++bits) {
+        code       = (code + count[bits - 1]) << 1;
+        next[bits] = code;
+    }
+    for (int i = 0; i < n; ++i) {
+        int len = h.lengths[i], code = len ? next[len]++ : 0, rev = 0;
+        for (int k = 0; k < len; ++k) {
+            rev  = (rev << 1) | (code & 1);
+            code >>= 1;
+        }
+        h.codes[i] = (uint16_t)rev;
+    }
+}
+
+struct deflate_tables
+{
+    uint8_t         lenCode[259];   ///< Match length to length code 0-28
+    uint8_t         distCode[512];  ///< distance - 1 below 256, else 256 + ((distance - 1) >> 7)
+    deflate_huffman fixedLit, fixedDist;
+
+    deflate_tables()
+    {
+        for (int c = 0; c < 29; ++c) {
+            for (int len = deflate_len_base[c]; len < deflate_len_base[c] + (1 << deflate_len_extra[c]) && len <= 258; ++len) {
+                lenCode[len] = (uint8_t)c;
+            }
+        }
+        for (int c = 0; c < 30; ++c) {
+            for (int d = deflate_dist_base[c]; d < deflate_dist_base[c] + (1 << deflate_dist_extra[c]); ++d) {
+                distCode[d <= 256 ? d - 1 : 256 + ((d - 1) >> 7)] = (uint8_t)c;
+            }
+        }
+        for (int i = 0; i < 288; ++i) {
+            fixedLit.lengths[i] = (uint8_t)(i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8)));
+        }
+        memset(fixedDist.lengths, 5, 30);
+        deflate_build_codes(fixedLit, 288);
+        deflate_build_codes(fixedDist, 30);
+    }
+
+    int distanceCode(int dist) const { return distCode[dist <= 256 ? dist - 1 : 256 + ((dist - 1) >> 7)]; }
+};
+
+inline const deflate_tables& deflate_tables_instance()
+{
+    static const deflate_tables tables;
+    return tables;
+}
+
+/// Literal (dist == 0) or match
+struct deflate_token
+{
+    uint16_t value;     ///< Literal byte or match length
+    uint16_t dist;
+};
+
+class deflate_encoder
+{
+public:
+    explicit deflate_encoder(int level = DEFLATE_LEVEL_DEFAULT)
+        : m_head(1 << DEFLATE_HASH_BITS), m_prev(DEFLATE_WINDOW), m_data(NULL), m_end(0), m_inserted(0)
+    {
+        setLevel(level);
+        m_tokens.reserve(DEFLATE_BLOCK_TOKENS + DEFLATE_MAX_MATCH);
+    }
+
+    void setLevel(int level)
+    {
+        level   = level < DEFLATE_LEVEL_MIN ? DEFLATE_LEVEL_MIN : (level > DEFLATE_LEVEL_MAX ? DEFLATE_LEVEL_MAX : level);
+        m_chain = level < DEFLATE_LEVEL_MAX ? 1 << (level + 1) : 1 << 12;
+        m_nice  = level < 4 ? 16 << level : DEFLATE_MAX_MATCH;
+        m_good  = level < 4 ? 8 : 32;
+        m_lazy  = level >= 4;
+    }
+
+    /**
+     * Compress data[begin, end), with matches reaching back up to 32 KiB before begin. The
+     * output ends with a final block if last is set, and with an empty stored block otherwise,
+     * so it stops on a byte boundary either way.
+     */
+    void compress(deflate_bits& bits, const uint8_t* data, size_t begin, size_t end, bool last)
+    {
+        std::fill(m_head.begin(), m_head.end(), -1);
+        m_data     = data;
+        m_end      = end;
+        m_inserted = begin > (size_t)DEFLATE_WINDOW ? begin - DEFLATE_WINDOW : 0;
+        m_tokens.clear();
+
+        size_t blockStart = begin, i = begin;
+        bool   finished   = false;
+        while (i < end) {
+            insertUntil(i);
+            int len = 0, dist = 0;
+            findMatch(i, len, dist);
+            // Lazy matching: emit a literal instead when the next position has a longer match.
+            while (m_lazy && len > 0 && len < m_nice && i + 1 < end) {
+                insertUntil(i + 1);
+                int len2 = 0, dist2 = 0;
+                findMatch(i + 1, len2, dist2);
+                if (len2 <= len) {
+                    break;
+                }
+                pushLiteral(data[i++]);
+                len  = len2;
+                dist = dist2;
+            }
+            if (len > 0) {
+                deflate_token t = {(uint16_t)len, (uint16_t)dist};
+                m_tokens.push_back(t);
+                // The fast levels do not index the inside of long matches.
+                if (!m_lazy && len > m_good) {
+                    insertUntil(i + 1);
+                    m_inserted = i + len;
+                }
+                i += len;
+            } else {
+                pushLiteral(data[i++]);
+            }
+            if ((int)m_tokens.size() >= DEFLATE_BLOCK_TOKENS) {
+                finished = last && i == end;
+                writeBlock(bits, blockStart, i, finished);
+                blockStart = i;
+            }
+        }
+        if (!m_tokens.empty() || (last && !finished)) {
+            writeBlock(bits, blockStart, end, last);
+        }
+        if (!last) {
+            // Sync flush: empty stored block.
+            bits.put(0, 3);
+            bits.align();
+            const uint8_t marker[4] = {0, 0, 0xFF, 0xFF};
+            bits.bytes(marker, 4);
+        } else {
+            bits.align();
+        }
+        m_data = NULL;
+    }
+
+private:
+    static uint32_t hash(const uint8_t* p)
+    {
+        return (((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2]) * 2654435761u) >> (32 - DEFLATE_HASH_BITS);
+    }
+
+    void insertUntil(size_t pos)
+    {
+        for (; m_inserted < pos; ++m_inserted) {
+            if (m_inserted + DEFLATE_MIN_MATCH <= m_end) {
+                uint32_t h                                = hash(m_data + m_inserted);
+                m_prev[m_inserted & (DEFLATE_WINDOW - 1)] = m_head[h];
+                m_head[h]                                 = (int)m_inserted;
+            }
+        }
+    }
+
+    void findMatch(size_t pos, int& bestLen, int& bestDist)
+    {
+        int maxLen = m_end - pos < (size_t)DEFLATE_MAX_MATCH ? (int)(m_end - pos) : DEFLATE_MAX_MATCH;
+        bestLen    = 0;
+        if (maxLen < DEFLATE_MIN_MATCH) {
+            return;
+        }
+        const uint8_t* cur   = m_data + pos;
+        long long      limit = (long long)pos - DEFLATE_WINDOW;
+        int            cand  = m_head[hash(cur)];
+        int            best  = DEFLATE_MIN_MATCH - 1;
+        for (int chain = m_chain; cand >= 0 && cand > limit && (size_t)cand < pos && chain > 0; --chain) {
+            const uint8_t* m = m_data + cand;
+            if (m[best] == cur[best] && m[0] == cur[0] && m[1] == cur[1]) {
+                int n = 2;
+                while (n < maxLen && m[n] == cur[n]) {
+                    ++n;
+                }
+                if (n > best) {
+                    best     = n;
+                    bestDist = (int)(pos - cand);
+                    if (n >= m_nice || n == maxLen) {
+                        break;
+                    }
+                    // A good match is rarely beaten further down the chain.
+                    if (n >= m_good && chain > m_chain >> 2) {
+                        chain = m_chain >> 2;
+                    }
+                }
+            }
+            int next = m_prev[cand & (DEFLATE_WINDOW - 1)];
+            if (next >= cand) {
+                break;
+            }
+            cand = next;
+        }
+        bestLen = best >= DEFLATE_MIN_MATCH ? best : 0;
+    }
+
+    void pushLiteral(uint8_t c)
+    {
+        deflate_token t = {c, 0};
+        m_tokens.push_back(t);
+    }
+
+    static void pushLength(std::vector<uint8_t>& rle, uint32_t* freq, int symbol, int extra)
+    {
+        rle.push_back((uint8_t)symbol);
+        rle.push_back((uint8_t)extra);
+        ++freq[symbol];
+    }
+
+    static void writeTokens(deflate_bits& bits, const std::vector<deflate_token>& tokens, const deflate_huffman& lit,
+        const deflate_huffman& dist)
+    {
+        const deflate_tables& t = deflate_tables_instance();
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            int v = tokens[i].value, d = tokens[i].dist;
+            if (d == 0) {
+                bits.put(lit.codes[v], lit.lengths[v]);
+                continue;
+            }
+            int lc = t.lenCode[v], dc = t.distanceCode(d);
+            bits.put(lit.codes[257 + lc], lit.lengths[257 + lc]);
+            if (deflate_len_extra[lc] != 0) {
+                bits.put(v - deflate_len_base[lc], deflate_len_extra[lc]);
+            }
+            bits.put(dist.codes[dc], dist.lengths[dc]);
+            if (deflate_dist_extra[dc] != 0) {
+                bits.put(d - deflate_dist_base[dc], deflate_dist_extra[dc]);
+            }
+        }
+        bits.put(lit.codes[256], lit.lengths[256]);
+    }
+
+    /// Write the pending tokens, covering data[start, end), as the cheapest block type.
+    void writeBlock(deflate_bits& bits, size_t start, size_t end, bool final)
+    {
+        const deflate_tables& t           = deflate_tables_instance();
+        uint32_t              litFreq[286] = {0}, distFreq[30] = {0};
+        for (size_t i = 0; i < m_tokens.size(); ++i) {
+            if (m_tokens[i].dist == 0) {
+                ++litFreq[m_tokens[i].value];
+            } else {
+                ++litFreq[257 + t.lenCode[m_tokens[i].value]];
+                ++distFreq[t.distanceCode(m_tokens[i].dist)];
+            }
+        }
+        litFreq[256] = 1;
+
+        deflate_huffman lit, dist;
+        deflate_build_lengths(litFreq, 286, 15, lit.lengths);
+        deflate_build_lengths(distFreq, 30, 15, dist.lengths);
+        deflate_build_codes(lit, 286);
+        deflate_build_codes(dist, 30);
+
+        // Run-length code the two code length tables as one sequence.
+        int nlit = 286, ndist = 30;
+        while (nlit > 257 && lit.lengths[nlit - 1] == 0) {
+            --nlit;
+        }
+        while (ndist > 1 && dist.lengths[ndist - 1] == 0) {
+            --ndist;
+        }
+        uint8_t all[286 + 30];
+        memcpy(all, lit.lengths, nlit);
+        memcpy(all + nlit, dist.lengths, ndist);
+        std::vector<uint8_t> rle;   // symbol, extra bits value
+        uint32_t             clenFreq[19] = {0};
+        for (int i = 0, n = nlit + ndist; i < n;) {
+            int v = all[i], run = 1;
+            while (i + run < n && all[i + run] == v) {
+                ++run;
+            }
+            i += run;
+            if (v != 0) {
+                pushLength(rle, clenFreq, v, 0);
+                for (--run; run >= 3; run -= std::min(run, 6)) {
+                    pushLength(rle, clenFreq, 16, std::min(run, 6) - 3);
+                }
+            } else {
+                for (; run >= 11; run -= std::min(run, 138)) {
+                    pushLength(rle, clenFreq, 18, std::min(run, 138) - 11);
+                }
+                if (run >= 3) {
+                    pushLength(rle, clenFreq, 17, run - 3);
+                    run = 0;
+                }
+            }
+            for (; run > 0; --run) {
+                pushLength(rle, clenFreq, v, 0);
+            }
+        }
+        deflate_huffman clen;
+        deflate_build_lengths(clenFreq, 19, 7, clen.lengths);
+        deflate_build_codes(clen, 19);
+        int nclen = 19;
+        while (nclen > 4 && clen.lengths[deflate_clen_order[nclen - 1]] == 0) {
+            --nclen;
+        }
+
+        // Pick the cheapest of dynamic, fixed and stored.
+        unsigned long long extra = 0, dynBits = 17 + 3 * nclen, fixedBits = 3;
+        for (int i = 0; i < 286; ++i) {
+            dynBits   += (unsigned long long)litFreq[i] * lit.lengths[i];
+            fixedBits += (unsigned long long)litFreq[i] * t.fixedLit.lengths[i];
+            extra     += i >= 257 ? (unsigned long long)litFreq[i] * deflate_len_extra[i - 257] : 0;
+        }
+        for (int i = 0; i < 30; ++i) {
+            dynBits   += (unsigned long long)distFreq[i] * dist.lengths[i];
+            fixedBits += (unsigned long long)distFreq[i] * 5;
+            extra     += (unsigned long long)distFreq[i] * deflate_dist_extra[i];
+        }
+        for (size_t i = 0; i < rle.size(); i += 2) {
+            dynBits += clen.lengths[rle[i]] + (rle[i] == 16 ? 2 : (rle[i] == 17 ? 3 : (rle[i] == 18 ? 7 : 0)));
+        }
+        dynBits   += extra;
+        fixedBits += extra;
+        size_t             size       = end - start;
+        unsigned long long storedBits = ((size + 65534) / 65535 + (size == 0)) * 42ull + size * 8ull;
+
+        if (storedBits <= dynBits && storedBits <= fixedBits) {
+            do {
+                size_t n = size < 65535 ? size : 65535;
+                size -= n;
+                bits.put(final && size == 0 ? 1 : 0, 3);
+                bits.align();
+                const uint8_t header[4] = {(uint8_t)n, (uint8_t)(n >> 8), (uint8_t)~n, (uint8_t)(~n >> 8)};
+                bits.bytes(header, 4);
+                bits.bytes(m_data + start, n);
+                start += n;
+            } while (size > 0);
+        } else if (fixedBits <= dynBits) {
+            bits.put(final ? 3 : 2, 3);
+            writeTokens(bits, m_tokens, t.fixedLit, t.fixedDist);
+        } else {
+            bits.put(final ? 5 : 4, 3);
+            bits.put(nlit - 257, 5);
+            bits.put(ndist - 1, 5);
+            bits.put(nclen - 4, 4);
+            for (int i = 0; i < nclen; ++i) {
+                bits.put(clen.lengths[deflate_clen_order[i]], 3);
+            }
+            for (size_t i = 0; i < rle.size(); i += 2) {
+                bits.put(clen.codes[rle[i]], clen.lengths[rle[i]]);
+                if (rle[i] >= 16) {
+                    bits.put(rle[i + 1], rle[i] == 16 ? 2 : (rle[i] == 17 ? 3 : 7));
+                }
+            }
+            writeTokens(bits, m_tokens, lit, dist);
+        }
+        m_tokens.clear();
+    }
+
+    std::vector<int>           m_head;
+    std::vector<int>           m_prev;
+    std::vector<deflate_token> m_tokens;
+    const uint8_t*             m_data;
+    size_t                     m_end, m_inserted;
+    int                        m_chain, m_nice, m_good;
+    bool                       m_lazy;
+};
+
+const int INFLATE_FAST_BITS = 10;
+
+/// Canonical Huffman decoding table with a direct lookup for codes up to INFLATE_FAST_BITS long.
+struct inflate_huffman
+{
+    uint16_t count[16];     ///< Number of codes of each length
+    uint16_t symbol[288];   ///< Symbols in canonical order
+    int16_t  fast[1 << INFLATE_FAST_BITS];  ///< symbol << 4 | length, or -1 for a longer code
+
+    /// Build from code lengths; false if the lengths over-subscribe the code space.
+    bool build(const uint8_t* lengths, int n)
+    {
+        uint16_t offset[16];
+        memset(count, 0, sizeof(count));
+        for (int i = 0; i < n; ++i) {
+            ++count[lengths[i]];
+        }
+        count[0] = 0;
+        int left = 1;
+        for (int len = 1; len < 16; ++len) {
+            left = (left << 1) - count[len];
+            if (left < 0) {
+                return false;
+            }
+        }
+        offset[1] = 0;
+        for (int len = 1; len < 15; ++len) {
+            offset[len + 1] = (uint16_t)(offset[len] + count[len]);
+        }
+        for (int i = 0; i < n; ++i) {
+            if (lengths[i] != 0) {
+                symbol[offset[lengths[i]]++] = (uint16_t)i;
+            }
+        }
+
+        memset(fast, 0xFF, sizeof(fast));
+        for (int len = 1, code = 0, k = 0; len <= INFLATE_FAST_BITS; ++len, code <<= 1) {
+            for (int c = 0; c < count[len]; ++c, ++k, ++code) {
+                int rev = 0;
+                for (int b = 0; b < len; ++b) {
+                    rev |= ((code >> b) & 1) << (len - 1 - b);
+                }
+                for (int j = rev; j < (1 << INFLATE_FAST_BITS); j += 1 << len) {
+                    fast[j] = (int16_t)(symbol[k] << 4 | len);
+                }
+            }
+        }
+        return true;
+    }
+};
+
+/**
+ * zlib (RFC 1950) stream decoder fed piece by piece. Every step, from a block header to one
+ * literal or match, either completes or is rolled back when the input runs short, so decoding
+ * can stop anywhere and resume after feed().
+ */
+class inflate_decoder
+{
+public:
+    enum status
+    {
+        INFLATE_MORE,   ///< Output limit reached or more input needed
+        INFLATE_END,    ///< Stream complete and checksum verified
+        INFLATE_ERROR   ///< Damaged or truncated stream
+    };
+
+    inflate_decoder() { reset(); }
+
+    void reset()
+    {
+        m_in.clear();
+        m_inPos = 0;
+        m_bits  = 0;
+        m_count = 0;
+        m_short = false;
+        m_ended = false;
+        m_last  = false;
+        m_state = STATE_HEADER;
+        m_adler = 1;
+    }
+
+    void feed(const void* data, size_t size)
+    {
+        if (m_inPos > 0 && m_inPos * 2 >= m_in.size()) {
+            m_in.erase(m_in.begin(), m_in.begin() + m_inPos);
+            m_inPos = 0;
+        }
+        m_in.insert(m_in.end(), (const uint8_t*)data, (const uint8_t*)data + size);
+    }
+
+    /// No more input will come; a stream still incomplete is then an error.
+    void end() { m_ended = true; }
+
+    /**
+     * Append decoded bytes to out until it holds at least limit bytes (a match may go up to
+     * 257 bytes further) or the input runs out. The last 32 KiB of out must be the previous
+     * output, as matches refer back into it.
+     */
+    status decode(std::vector<uint8_t>& out, size_t limit)
+    {
+        size_t start = out.size();
+        status ret   = run(out, limit);
+        m_adler      = deflate_adler32(m_adler, out.empty() ? NULL : &out[start], out.size() - start);
+        if (ret == INFLATE_MORE && m_state == STATE_TRAILER) {
+            ret = trailer();
+        }
+        return ret;
+    }
+
+private:
+    enum state
+    {
+        STATE_HEADER,
+        STATE_BLOCK,
+        STATE_STORED,
+        STATE_CODES,
+        STATE_TRAILER,
+        STATE_END,
+        STATE_ERROR
+    };
+
+    struct mark
+    {
+        uint64_t bits;
+        int      count;
+        size_t   inPos;
+    };
+
+    mark save() const
+    {
+        mark m = {m_bits, m_count, m_inPos};
+        return m;
+    }
+
+    /// End a step that ran out of input: roll it back, or fail if no more input will come.
+    status suspend(const mark& m)
+    {
+        m_bits  = m.bits;
+        m_count = m.count;
+        m_inPos = m.inPos;
+        m_short = false;
+        return m_ended ? fail() : INFLATE_MORE;
+    }
+
+    status fail()
+    {
+        m_state = STATE_ERROR;
+        return INFLATE_ERROR;
+    }
+
+    void refill()
+    {
+        while (m_count <= 56 && m_inPos < m_in.size()) {
+            m_bits  |= (uint64_t)m_in[m_inPos++] << m_count;
+            m_count += 8;
+        }
+    }
+
+    uint32_t bits(int n)
+    {
+        refill();
+        if (m_count < n) {
+            m_short = true;
+            return 0;
+        }
+        uint32_t v = (uint32_t)(m_bits & ((1u << n) - 1));
+        m_bits   >>= n;
+        m_count   -= n;
+        return v;
+    }
+
+    /// Next symbol, or -1 for an invalid code; sets m_short when the input ends inside the code.
+    int symbol(const inflate_huffman& h)
+    {
+        refill();
+        int e = h.fast[m_bits & ((1 << INFLATE_FAST_BITS) - 1)];
+        if (e >= 0 && (e & 15) <= m_count) {
+            m_bits  >>= e & 15;
+            m_count  -= e & 15;
+            return e >> 4;
+        }
+        int code = 0, first = 0, index = 0;
+        for (int len = 1; len < 16; ++len) {
+            if (len > m_count) {
+                m_short = true;
+                return -1;
+            }
+            code  |= (int)((m_bits >> (len - 1)) & 1);
+            int n  = h.count[len];
+            if (code - n < first) {
+                m_bits  >>= len;
+                m_count  -= len;
+                return h.symbol[index + (code - first)];
+            }
+            index += n;
+            first  = (first + n) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    status run(std::vector<uint8_t>& out, size_t limit)
+    {
+        for (;;) {
+            switch (m_state) {
+            case STATE_HEADER: {
+                mark     m   = save();
+                uint32_t cmf = bits(8), flg = bits(8);
+                if (m_short) {
+                    return suspend(m);
+                }
+                if ((cmf & 15) != 8 || (cmf >> 4) > 7 || (cmf * 256 + flg) % 31 != 0 || (flg & 0x20) != 0) {
+                    return fail();
+                }
+                m_state = STATE_BLOCK;
+                break;
+            }
+            case STATE_BLOCK: {
+                mark     m    = save();
+                uint32_t last = bits(1), type = bits(2);
+                if (m_short) {
+                    return suspend(m);
+                }
+                m_last = last != 0;
+                if (type == 0) {
+                    bits(m_count & 7);
+                    uint32_t len = bits(16), nlen = bits(16);
+                    if (m_short) {
+                        return suspend(m);
+                    }
+                    if (len != (~nlen & 0xFFFF)) {
+                        return fail();
+                    }
+                    m_remaining = len;
+                    m_state     = STATE_STORED;
+                } else if (type == 1) {
+                    uint8_t lengths[288 + 30];
+                    for (int i = 0; i < 288; ++i) {
+                        lengths[i] = (uint8_t)(i < 144 ? 8 : (i < 256 ? 9 : (i < 280 ? 7 : 8)));
+                    }
+                    memset(lengths + 288, 5, 30);
+                    m_lit.build(lengths, 288);
+                    m_dist.build(lengths + 288, 30);
+                    m_state = STATE_CODES;
+                } else if (type == 2) {
+                    status ret = dynamic(m);
+                    if (ret != INFLATE_END) {
+                        return ret;
+                    }
+                    m_state = STATE_CODES;
+                } else {
+                    return fail();
+                }
+                break;
+            }
+            case STATE_STORED:
+                // Whole bytes left in the bit buffer come first, then the input is copied directly.
+                while (m_remaining > 0 && m_count >= 8 && out.size() < limit) {
+                    out.push_back((uint8_t)bits(8));
+                    --m_remaining;
+                }
+                if (m_remaining > 0 && m_count < 8 && out.size() < limit) {
+                    size_t n = std::min(std::min((size_t)m_remaining, m_in.size() - m_inPos), limit - out.size());
+                    out.insert(out.end(), m_in.begin() + m_inPos, m_in.begin() + m_inPos + n);
+                    m_inPos     += n;
+                    m_remaining -= (uint32_t)n;
+                    if (m_remaining > 0 && n == 0) {
+                        return m_ended ? fail() : INFLATE_MORE;
+                    }
+                }
+                if (m_remaining > 0) {
+                    if (out.size() >= limit) {
+                        return INFLATE_MORE;
+                    }
+                    break;
+                }
+                m_state = m_last ? STATE_TRAILER : STATE_BLOCK;
+                break;
+            case STATE_CODES: {
+                status ret = codes(out, limit);
+                if (ret != INFLATE_END) {
+                    return ret;
+                }
+                m_state = m_last ? STATE_TRAILER : STATE_BLOCK;
+                break;
+            }
+            case STATE_TRAILER:
+                return INFLATE_MORE;
+            case STATE_END:
+                return INFLATE_END;
+            default:
+                return INFLATE_ERROR;
+            }
+        }
+    }
+
+    /// Read the code tables of a dynamic block; INFLATE_END once they are built.
+    status dynamic(const mark& m)
+    {
+        int nlit = (int)bits(5) + 257, ndist = (int)bits(5) + 1, nclen = (int)bits(4) + 4;
+        uint8_t lengths[286 + 30] = {0}, clen[19] = {0};
+        for (int i = 0; i < nclen; ++i) {
+            clen[deflate_clen_order[i]] = (uint8_t)bits(3);
+        }
+        if (m_short) {
+            return suspend(m);
+        }
+        inflate_huffman clenCode;
+        if (nlit > 286 || ndist > 30 || !clenCode.build(clen, 19)) {
+            return fail();
+        }
+        for (int i = 0; i < nlit + ndist;) {
+            int sym = symbol(clenCode), repeat = 0, value = 0;
+            if (sym < 16) {
+                repeat = 1;
+                value  = sym;
+            } else if (sym == 16) {
+                if (i == 0) {
+                    return m_short ? suspend(m) : fail();
+                }
+                repeat = 3 + (int)bits(2);
+                value  = lengths[i - 1];
+            } else if (sym == 17) {
+                repeat = 3 + (int)bits(3);
+            } else {
+                repeat = 11 + (int)bits(7);
+            }
+            if (m_short) {
+                return suspend(m);
+            }
+            if (sym < 0 || i + repeat > nlit + ndist) {
+                return fail();
+            }
+            memset(lengths + i, value, repeat);
+            i += repeat;
+        }
+        if (lengths[256] == 0 || !m_lit.build(lengths, nlit) || !m_dist.build(lengths + nlit, ndist)) {
+            return fail();
+        }
+        return INFLATE_END;
+    }
+
+    /// Decode literals and matches; INFLATE_END at the end of the block.
+    status codes(std::vector<uint8_t>& out, size_t limit)
+    {
+        while (out.size() < limit) {
+            mark m   = save();
+            int  sym = symbol(m_lit);
+            if (sym < 256) {
+                if (m_short) {
+                    return suspend(m);
+                }
+                if (sym < 0) {
+                    return fail();
+                }
+                out.push_back((uint8_t)sym);
+                continue;
+            }
+            if (sym == 256) {
+                return INFLATE_END;
+            }
+            sym -= 257;
+            if (sym >= 29) {
+                return fail();
+            }
+            int len  = deflate_len_base[sym] + (int)bits(deflate_len_extra[sym]);
+            int dsym = symbol(m_dist);
+            int dist = dsym >= 0 && dsym < 30 ? deflate_dist_base[dsym] + (int)bits(deflate_dist_extra[dsym]) : 0;
+            if (m_short) {
+                return suspend(m);
+            }
+            if (dist == 0 || (size_t)dist > out.size()) {
+                return fail();
+            }
+            size_t from = out.size() - dist;
+            for (int i = 0; i < len; ++i) {
+                out.push_back(out[from + i]);
+            }
+        }
+        return INFLATE_MORE;
+    }
+
+    status trailer()
+    {
+        mark m = save();
+        bits(m_count & 7);
+        uint32_t adler = bits(8) << 24;
+        adler         |= bits(8) << 16;
+        adler         |= bits(8) << 8;
+        adler         |= bits(8);
+        if (m_short) {
+            return suspend(m);
+        }
+        if (adler != m_adler) {
+            return fail();
+        }
+        m_state = STATE_END;
+        return INFLATE_END;
+    }
+
+    std::vector<uint8_t> m_in;
+    size_t               m_inPos;
+    uint64_t             m_bits;
+    int                  m_count;
+    bool                 m_short;       ///< A read in the current step ran past the input
+    bool                 m_ended;
+    bool                 m_last;        ///< Current block is the final one
+    state                m_state;
+    uint32_t             m_remaining;   ///< Bytes left in a stored block
+    uint32_t             m_adler;
+    inflate_huffman      m_lit, m_dist;
+};
+
+} // namespace detail
+
+} // namespace ege
+
+#endif /* EGE_DEFLATE_H */
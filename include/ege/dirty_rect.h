@@ -0,0 +1,320 @@
+/**
+ * @file dirty_rect.h
+ * @brief Dirty rectangle tracking and partial window present
+ *
+ * In manual rendering mode (INIT_RENDERMANUAL / INIT_ANIMATION) delay_fps() copies the whole
+ * window buffer to the window every frame. delay_fps_dirty() and present_dirty() copy only the
+ * rectangles damaged since the previous present. They replace delay_fps() / delay_ms() in the
+ * frame loop: any of those still called per frame flushes the whole buffer again and the savings
+ * are lost.
+ *
+ * Only the frame loop's updates go through the dirty list. When part of the window is uncovered,
+ * restored or resized, the library's own WM_PAINT handler repaints the exposed area from the
+ * window buffer, which always holds the complete frame, so nothing has to be invalidated for it.
+ *
+ * Damage is recorded by invalidaterect(), which code writing through getbuffer() or drawing with
+ * the library primitives calls for the area it changed. After ege_dirty_tracking(true), the
+ * header-only drawing functions of this SDK (putimage_*_f, outtextxy_cached, imagefilter_boxblur,
+ * imagefilter_gaussian) record their own damage when they draw to the window.
+ *
+ * Rectangles are merged while merging wastes little area and the list is kept to a few entries;
+ * when the damage covers most of the window the whole buffer is presented instead.
+ * ege_dirty_overlay(true) outlines every presented rectangle on the window to check the savings.
+ */
+#ifndef EGE_DIRTY_RECT_H
+#define EGE_DIRTY_RECT_H
+
+#include "../ege.h"
+
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_dirty_stats
+ * @brief Counters of the partial present
+ */
+struct ege_dirty_stats
+{
+    unsigned long frames;           ///< present_dirty() calls
+    unsigned long rects;            ///< Rectangles copied to the window
+    double        presentedPixels;  ///< Pixels copied to the window
+    double        windowPixels;     ///< Pixels a full present would have copied
+};
+
+namespace detail
+{
+
+struct dirty_box
+{
+    int x0, y0, x1, y1;
+
+    long long area() const { return (long long)(x1 - x0) * (y1 - y0); }
+    bool      contains(const dirty_box& b) const { return b.x0 >= x0 && b.y0 >= y0 && b.x1 <= x1 && b.y1 <= y1; }
+
+    dirty_box united(const dirty_box& b) const
+    {
+        dirty_box u;
+        u.x0 = x0 < b.x0 ? x0 : b.x0;
+        u.y0 = y0 < b.y0 ? y0 : b.y0;
+        u.x1 = x1 > b.x1 ? x1 : b.x1;
+        u.y1 = y1 > b.y1 ? y1 : b.y1;
+        return u;
+    }
+};
+
+class dirty_region
+{
+public:
+    enum
+    {
+        MAX_RECTS   = 16,   ///< Beyond this the closest pair is merged
+        MERGE_SLACK = 4096  ///< Extra pixels a merge may add and still be taken
+    };
+
+    dirty_region() : m_tracking(false), m_overlay(false), m_nextFrame(0.0) { resetStats(); }
+
+    void add(int x, int y, int w, int h)
+    {
+        if (w <= 0 || h <= 0) {
+            return;
+        }
+        dirty_box b = {x < 0 ? 0 : x, y < 0 ? 0 : y, x + w, y + h};
+        if (b.x0 >= b.x1 || b.y0 >= b.y1) {
+            return;
+        }
+        insert(b);
+    }
+
+    /// Copy the damaged rectangles of the window buffer to the window and forget them.
+    int present()
+    {
+        PIMAGE saved = gettarget();
+        settarget(NULL);
+
+        const int W = getwidth(NULL), H = getheight(NULL);
+        dirty_box window = {0, 0, W, H};
+
+        // Erase last frame's outlines along with the new damage.
+        for (size_t i = 0; i < m_outlines.size(); ++i) {
+            insert(m_outlines[i]);
+        }
+        m_outlines.clear();
+
+        std::vector<dirty_box> boxes;
+        long long              covered = 0;
+        for (size_t i = 0; i < m_boxes.size(); ++i) {
+            dirty_box b = m_boxes[i];
+            if (b.x1 > W) b.x1 = W;
+            if (b.y1 > H) b.y1 = H;
+            if (b.x0 < b.x1 && b.y0 < b.y1) {
+                boxes.push_back(b);
+                covered += b.area();
+            }
+        }
+        m_boxes.clear();
+        if (covered * 4 >= (long long)W * H * 3) {
+            boxes.assign(1, window);
+            covered = (long long)W * H;
+        }
+
+        if (!boxes.empty()) {
+            HWND hwnd = getHWnd();
+            HDC  wdc  = GetDC(hwnd);
+            HDC  src  = getHDC(NULL);
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                const dirty_box& b = boxes[i];
+                BitBlt(wdc, b.x0, b.y0, b.x1 - b.x0, b.y1 - b.y0, src, b.x0, b.y0, SRCCOPY);
+            }
+            if (m_overlay) {
+                HBRUSH brush = CreateSolidBrush(RGB(0xFF, 0x00, 0xFF));
+                for (size_t i = 0; i < boxes.size(); ++i) {
+                    RECT rc = {boxes[i].x0, boxes[i].y0, boxes[i].x1, boxes[i].y1};
+                    FrameRect(wdc, &rc, brush);
+                }
+                DeleteObject(brush);
+                m_outlines = boxes;
+            }
+            ReleaseDC(hwnd, wdc);
+        }
+
+        settarget(saved);
+
+        ++m_stats.frames;
+        m_stats.rects           += (unsigned long)boxes.size();
+        m_stats.presentedPixels += (double)covered;
+        m_stats.windowPixels    += (double)W * H;
+        return (int)boxes.size();
+    }
+
+    /// Wait for the next frame of a fps-paced loop without presenting the whole buffer.
+    void waitFrame(double fps)
+    {
+        double now    = fclock();
+        double period = fps > 0.0 ? 1.0 / fps : 0.0;
+        if (m_nextFrame == 0.0 || now - m_nextFrame > period * 4) {
+            m_nextFrame = now;  // first frame, or far behind: do not try to catch up
+        }
+        m_nextFrame += period;
+        if (m_nextFrame > now) {
+            ege_sleep((long)((m_nextFrame - now) * 1000.0));
+        }
+    }
+
+    bool tracking() const { return m_tracking; }
+    void setTracking(bool enable) { m_tracking = enable; }
+    void setOverlay(bool enable) { m_overlay = enable; }
+
+    void stats(ege_dirty_stats* out) const { *out = m_stats; }
+
+    void resetStats()
+    {
+        m_stats.frames          = 0;
+        m_stats.rects           = 0;
+        m_stats.presentedPixels = 0.0;
+        m_stats.windowPixels    = 0.0;
+    }
+
+private:
+    void insert(dirty_box b)
+    {
+        // Absorb every rectangle that b overlaps or nearly touches, then grow b by them.
+        for (size_t i = 0; i < m_boxes.size();) {
+            const dirty_box& r = m_boxes[i];
+            if (r.contains(b)) {
+                return;
+            }
+            dirty_box u = r.united(b);
+            if (u.area() <= r.area() + b.area() + MERGE_SLACK) {
+                b = u;
+                m_boxes.erase(m_boxes.begin() + i);
+                i = 0;
+            } else {
+                ++i;
+            }
+        }
+        m_boxes.push_back(b);
+
+        while ((int)m_boxes.size() > MAX_RECTS) {
+            size_t    bi = 0, bj = 1;
+            long long best = 0;
+            for (size_t i = 0; i < m_boxes.size(); ++i) {
+                for (size_t j = i + 1; j < m_boxes.size(); ++j) {
+                    long long waste = m_boxes[i].united(m_boxes[j]).area() - m_boxes[i].area() - m_boxes[j].area();
+                    if ((i == 0 && j == 1) || waste < best) {
+                        best = waste;
+                        bi   = i;
+                        bj   = j;
+                    }
+                }
+            }
+            m_boxes[bi] = m_boxes[bi].united(m_boxes[bj]);
+            m_boxes.erase(m_boxes.begin() + bj);
+        }
+    }
+
+    std::vector<dirty_box> m_boxes;
+    std::vector<dirty_box> m_outlines;  ///< Overlay outlines drawn by the last present
+    bool                   m_tracking;
+    bool                   m_overlay;
+    double                 m_nextFrame;
+    ege_dirty_stats        m_stats;
+};
+
+inline dirty_region& dirty_instance()
+{
+    static dirty_region region;
+    return region;
+}
+
+/// Record damage from a header-only drawing function if it drew to the window.
+inline void dirty_note(PCIMAGE pimg, int x, int y, int w, int h)
+{
+    dirty_region& region = dirty_instance();
+    if (region.tracking() && pimg == NULL && gettarget() == NULL) {
+        region.add(x, y, w, h);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Mark a window area as changed so the next present_dirty() copies it
+ * @param x X coordinate of the top-left corner, in window buffer pixels
+ * @param y Y coordinate of the top-left corner
+ * @param w Width of the area
+ * @param h Height of the area
+ */
+inline void invalidaterect(int x, int y, int w, int h)
+{
+    detail::dirty_instance().add(x, y, w, h);
+}
+
+/// @brief Mark the whole window as changed
+inline void invalidatewindow()
+{
+    detail::dirty_instance().add(0, 0, 0x3FFFFFFF, 0x3FFFFFFF);
+}
+
+/**
+ * @brief Copy the changed areas of the window buffer to the window
+ * @return Number of rectangles copied
+ * @note Use in manual rendering mode instead of the full flush of delay_fps() / delay_ms(), not
+ *       next to it. Areas uncovered by other windows are repainted by WM_PAINT, not by this call.
+ */
+inline int present_dirty()
+{
+    return detail::dirty_instance().present();
+}
+
+/**
+ * @brief Present the changed areas, then delay by frame rate
+ * @param fps Target frame rate
+ * @note Replaces delay_fps() in the frame loop, e.g. for (; is_run(); delay_fps_dirty(60)).
+ */
+inline void delay_fps_dirty(double fps)
+{
+    detail::dirty_instance().present();
+    detail::dirty_instance().waitFrame(fps);
+}
+
+/**
+ * @brief Let the header-only drawing functions record their damage on the window
+ * @param enable true to record, false (default) to rely on invalidaterect() alone
+ */
+inline void ege_dirty_tracking(bool enable)
+{
+    detail::dirty_instance().setTracking(enable);
+}
+
+/**
+ * @brief Outline every presented rectangle on the window (debug aid)
+ * @param enable true to draw the outlines, false (default) to turn them off
+ * @note The outlines are drawn on the window only, never into the buffer.
+ */
+inline void ege_dirty_overlay(bool enable)
+{
+    detail::dirty_instance().setOverlay(enable);
+}
+
+/**
+ * @brief Get the counters of the partial present
+ * @param stats Receives frames, rectangles and presented / full-window pixel totals
+ */
+inline void ege_dirty_get_stats(ege_dirty_stats* stats)
+{
+    if (stats != NULL) {
+        detail::dirty_instance().stats(stats);
+    }
+}
+
+/// @brief Reset the counters of the partial present
+inline void ege_dirty_reset_stats()
+{
+    detail::dirty_instance().resetStats();
+}
+
+} // namespace ege
+
+#endif /* EGE_DIRTY_RECT_H */
@@ -0,0 +1,507 @@
+/**
+ * @file drawlist.h
+ * @brief Recorded draw lists for the ege_ anti-aliased primitives
+ *
+ * A draw list records ege_line / ege_fillcircle / ege_fillellipse / ege_fillpoly
+ * calls together with the pen and brush state they were recorded with, and replays
+ * them in a single pass. On submit, commands are grouped by state so that the pen
+ * and brush of the target image are switched as rarely as possible, and runs of
+ * opaque primitives sharing the same state are merged into a single path, which
+ * turns thousands of immediate-mode calls into a handful of GDI+ draw calls.
+ *
+ * Typical use:
+ * @code
+ *     ege_drawlist* list = ege_drawlist_create();
+ *     for (; is_run(); delay_fps(60)) {
+ *         ege_drawlist_begin(list);
+ *         for (int i = 0; i < n; ++i) {
+ *             ege_drawlist_setfillcolor(list, balls[i].color);
+ *             ege_drawlist_fillcircle(list, balls[i].x, balls[i].y, balls[i].r);
+ *         }
+ *         cleardevice();
+ *         ege_drawlist_submit(list);
+ *     }
+ *     ege_drawlist_destroy(list);
+ * @endcode
+ */
+#ifndef EGE_DRAWLIST_H
+#define EGE_DRAWLIST_H
+
+#include "../ege.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_drawlist
+ * @brief Recorded list of ege_ primitives with their pen/brush state
+ *
+ * Create with ege_drawlist_create() and destroy with ege_drawlist_destroy().
+ * The members are implementation details and should not be accessed directly.
+ */
+struct ege_drawlist
+{
+    enum command_type
+    {
+        CMD_LINE,
+        CMD_FILLCIRCLE,
+        CMD_FILLELLIPSE,
+        CMD_FILLPOLY
+    };
+
+    struct state
+    {
+        color_t linecolor;
+        color_t fillcolor;
+        float   linewidth;
+    };
+
+    struct command
+    {
+        int   type;
+        int   state;        ///< Index into states
+        float a, b, c, d;   ///< Geometry of lines, circles and ellipses
+        int   first, count; ///< Point range of CMD_FILLPOLY
+        int   order;        ///< Recording order, keeps sorting stable
+    };
+
+    std::vector<state>     states;
+    std::vector<command>   commands;
+    std::vector<ege_point> points;
+    std::vector<ege_point> scratch;
+    std::vector<command>   sorted;
+    state                  current;
+    bool                   dirty;   ///< current differs from states.back()
+    ege_path*              path;
+
+    ege_drawlist() : dirty(true), path(NULL)
+    {
+        current.linecolor = BLACK;
+        current.fillcolor = BLACK;
+        current.linewidth = 1.0f;
+    }
+
+    ~ege_drawlist()
+    {
+        if (path != NULL) {
+            ege_path_destroy(path);
+        }
+    }
+
+private:
+    ege_drawlist(const ege_drawlist&);
+    ege_drawlist& operator=(const ege_drawlist&);
+};
+
+namespace detail
+{
+
+/// Line width of an image; getlinestyle() is the only way to read it back.
+inline float drawlist_linewidth(PCIMAGE pimg)
+{
+    int thickness = 1;
+    getlinestyle(NULL, NULL, &thickness, pimg);
+    return (float)(thickness > 0 ? thickness : 1);
+}
+
+inline int drawlist_state(ege_drawlist* list)
+{
+    if (list->dirty) {
+        const ege_drawlist::state& s = list->current;
+        if (list->states.empty() || list->states.back().linecolor != s.linecolor ||
+            list->states.back().fillcolor != s.fillcolor || list->states.back().linewidth != s.linewidth) {
+            list->states.push_back(s);
+        }
+        list->dirty = false;
+    }
+    return (int)list->states.size() - 1;
+}
+
+inline void drawlist_push(ege_drawlist* list, int type, float a, float b, float c, float d, int first = 0, int count = 0)
+{
+    ege_drawlist::command cmd;
+    cmd.type  = type;
+    cmd.state = drawlist_state(list);
+    cmd.a     = a;
+    cmd.b     = b;
+    cmd.c     = c;
+    cmd.d     = d;
+    cmd.first = first;
+    cmd.count = count;
+    cmd.order = (int)list->commands.size();
+    list->commands.push_back(cmd);
+}
+
+inline bool drawlist_is_line(const ege_drawlist::command& cmd)
+{
+    return cmd.type == ege_drawlist::CMD_LINE;
+}
+
+/* Only the part of the state a command actually uses takes part in comparisons, so
+ * a fill recorded after a line color change still joins the previous fill run. */
+inline int drawlist_compare(const ege_drawlist* list, const ege_drawlist::command& x, const ege_drawlist::command& y)
+{
+    bool xl = drawlist_is_line(x), yl = drawlist_is_line(y);
+    if (xl != yl) {
+        return xl ? 1 : -1;
+    }
+
+    const ege_drawlist::state& a = list->states[x.state];
+    const ege_drawlist::state& b = list->states[y.state];
+    if (!xl) {
+        return a.fillcolor == b.fillcolor ? 0 : (a.fillcolor < b.fillcolor ? -1 : 1);
+    }
+    if (a.linecolor != b.linecolor) {
+        return a.linecolor < b.linecolor ? -1 : 1;
+    }
+    if (a.linewidth != b.linewidth) {
+        return a.linewidth < b.linewidth ? -1 : 1;
+    }
+    return 0;
+}
+
+struct drawlist_state_less
+{
+    const ege_drawlist* list;
+
+    explicit drawlist_state_less(const ege_drawlist* l) : list(l) {}
+
+    bool operator()(const ege_drawlist::command& x, const ege_drawlist::command& y) const
+    {
+        int c = drawlist_compare(list, x, y);
+        return c != 0 ? c < 0 : x.order < y.order;
+    }
+};
+
+/* Only convex polygons can be merged into a winding-filled path without changing
+ * the result of the alternate fill used by ege_fillpoly. */
+inline bool drawlist_convex(const ege_point* p, int n)
+{
+    if (n <= 3) {
+        return true;
+    }
+
+    int sign = 0;
+    for (int i = 0; i < n; ++i) {
+        const ege_point& p0 = p[i];
+        const ege_point& p1 = p[(i + 1) % n];
+        const ege_point& p2 = p[(i + 2) % n];
+        float cross = (p1.x - p0.x) * (p2.y - p1.y) - (p1.y - p0.y) * (p2.x - p1.x);
+        if (cross > 0.0f) {
+            if (sign < 0) {
+                return false;
+            }
+            sign = 1;
+        } else if (cross < 0.0f) {
+            if (sign > 0) {
+                return false;
+            }
+            sign = -1;
+        }
+    }
+    return true;
+}
+
+inline void drawlist_addpoly(ege_path* path, ege_drawlist* list, const ege_point* p, int n)
+{
+    float area = 0.0f;
+    for (int i = 0, j = n - 1; i < n; j = i++) {
+        area += p[j].x * p[i].y - p[i].x * p[j].y;
+    }
+
+    if (area >= 0.0f) {
+        ege_path_addpolygon(path, n, p);
+        return;
+    }
+
+    // Keep every figure in the merged path clockwise so overlaps do not cancel out.
+    std::vector<ege_point>& reversed = list->scratch;
+    reversed.assign(p, p + n);
+    std::reverse(reversed.begin(), reversed.end());
+    ege_path_addpolygon(path, n, &reversed[0]);
+}
+
+inline void drawlist_draw_single(ege_drawlist* list, const ege_drawlist::command& cmd, PIMAGE pimg)
+{
+    switch (cmd.type) {
+    case ege_drawlist::CMD_LINE:
+        ege_line(cmd.a, cmd.b, cmd.c, cmd.d, pimg);
+        break;
+    case ege_drawlist::CMD_FILLCIRCLE:
+        ege_fillcircle(cmd.a, cmd.b, cmd.c, pimg);
+        break;
+    case ege_drawlist::CMD_FILLELLIPSE:
+        ege_fillellipse(cmd.a, cmd.b, cmd.c, cmd.d, pimg);
+        break;
+    case ege_drawlist::CMD_FILLPOLY:
+        ege_fillpoly(cmd.count, &list->points[cmd.first], pimg);
+        break;
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Create an empty draw list
+ * @return New draw list, destroy it with ege_drawlist_destroy()
+ */
+inline ege_drawlist* ege_drawlist_create()
+{
+    return new ege_drawlist();
+}
+
+/**
+ * @brief Destroy a draw list created by ege_drawlist_create()
+ * @param list Draw list, ignored if NULL
+ */
+inline void ege_drawlist_destroy(ege_drawlist* list)
+{
+    delete list;
+}
+
+/**
+ * @brief Start recording, discarding previously recorded commands
+ * @param list Draw list
+ * @param pimg Image whose current line color, fill color and line width become the initial state,
+ *             default is NULL (window)
+ * @note Allocated memory is kept, so re-recording a list every frame does not allocate
+ */
+inline void ege_drawlist_begin(ege_drawlist* list, PCIMAGE pimg = NULL)
+{
+    list->states.clear();
+    list->commands.clear();
+    list->points.clear();
+    list->current.linecolor = getlinecolor(pimg);
+    list->current.fillcolor = getfillcolor(pimg);
+    list->current.linewidth = detail::drawlist_linewidth(pimg);
+    list->dirty             = true;
+}
+
+/**
+ * @brief Set the line color used by subsequently recorded ege_drawlist_line() calls
+ * @param list Draw list
+ * @param color Line color
+ */
+inline void ege_drawlist_setlinecolor(ege_drawlist* list, color_t color)
+{
+    list->current.linecolor = color;
+    list->dirty             = true;
+}
+
+/**
+ * @brief Set the fill color used by subsequently recorded fill calls
+ * @param list Draw list
+ * @param color Fill color
+ */
+inline void ege_drawlist_setfillcolor(ege_drawlist* list, color_t color)
+{
+    list->current.fillcolor = color;
+    list->dirty             = true;
+}
+
+/**
+ * @brief Set the line width used by subsequently recorded ege_drawlist_line() calls
+ * @param list Draw list
+ * @param width Line width
+ */
+inline void ege_drawlist_setlinewidth(ege_drawlist* list, float width)
+{
+    list->current.linewidth = width;
+    list->dirty             = true;
+}
+
+/**
+ * @brief Record an ege_line() call
+ * @param list Draw list
+ * @param x1 Start point x coordinate
+ * @param y1 Start point y coordinate
+ * @param x2 End point x coordinate
+ * @param y2 End point y coordinate
+ */
+inline void ege_drawlist_line(ege_drawlist* list, float x1, float y1, float x2, float y2)
+{
+    detail::drawlist_push(list, ege_drawlist::CMD_LINE, x1, y1, x2, y2);
+}
+
+/**
+ * @brief Record an ege_fillcircle() call
+ * @param list Draw list
+ * @param x Center x coordinate
+ * @param y Center y coordinate
+ * @param radius Radius
+ */
+inline void ege_drawlist_fillcircle(ege_drawlist* list, float x, float y, float radius)
+{
+    detail::drawlist_push(list, ege_drawlist::CMD_FILLCIRCLE, x, y, radius, 0.0f);
+}
+
+/**
+ * @brief Record an ege_fillellipse() call
+ * @param list Draw list
+ * @param x Bounding rectangle left x coordinate
+ * @param y Bounding rectangle top y coordinate
+ * @param w Bounding rectangle width
+ * @param h Bounding rectangle height
+ */
+inline void ege_drawlist_fillellipse(ege_drawlist* list, float x, float y, float w, float h)
+{
+    detail::drawlist_push(list, ege_drawlist::CMD_FILLELLIPSE, x, y, w, h);
+}
+
+/**
+ * @brief Record an ege_fillpoly() call
+ * @param list Draw list
+ * @param numOfPoints Number of polygon vertices
+ * @param points Polygon vertices, copied into the list
+ */
+inline void ege_drawlist_fillpoly(ege_drawlist* list, int numOfPoints, const ege_point* points)
+{
+    if (numOfPoints < 3 || points == NULL) {
+        return;
+    }
+    int first = (int)list->points.size();
+    list->points.insert(list->points.end(), points, points + numOfPoints);
+    detail::drawlist_push(list, ege_drawlist::CMD_FILLPOLY, 0.0f, 0.0f, 0.0f, 0.0f, first, numOfPoints);
+}
+
+/**
+ * @brief Get the number of recorded commands
+ * @param list Draw list
+ * @return Number of commands recorded since ege_drawlist_begin()
+ */
+inline int ege_drawlist_size(const ege_drawlist* list)
+{
+    return (int)list->commands.size();
+}
+
+/**
+ * @brief Draw all recorded commands onto an image
+ * @param list Draw list
+ * @param pimg Target image, default is NULL (window)
+ * @param sortByState Group commands by pen/brush state before drawing, default is true
+ *
+ * With sortByState, fills are drawn before lines and the painter's order is only kept between
+ * commands that share a state; pass false when overlapping primitives must keep their recording
+ * order (consecutive commands with the same state are still merged).
+ * Runs of opaque fills and opaque lines with identical state are merged into one path and
+ * drawn with a single ege_fillpath() / ege_drawpath() call. Translucent primitives are drawn
+ * one by one, because merging would change how their overlaps blend.
+ *
+ * The line color, fill color and line width of the target image are restored afterwards; the
+ * width is read with getlinestyle(), which reports it in whole pixels.
+ * The list is not cleared and can be submitted again.
+ */
+inline void ege_drawlist_submit(ege_drawlist* list, PIMAGE pimg = NULL, bool sortByState = true)
+{
+    if (list->commands.empty()) {
+        return;
+    }
+
+    std::vector<ege_drawlist::command>& cmds = list->sorted;
+    cmds.assign(list->commands.begin(), list->commands.end());
+    if (sortByState) {
+        std::sort(cmds.begin(), cmds.end(), detail::drawlist_state_less(list));
+    }
+
+    if (list->path == NULL) {
+        list->path = ege_path_create();
+    }
+    ege_path* path = list->path;
+
+    color_t oldLineColor = getlinecolor(pimg);
+    color_t oldFillColor = getfillcolor(pimg);
+    float   oldLineWidth = detail::drawlist_linewidth(pimg);
+    bool    hasLineColor = false, hasFillColor = false, hasLineWidth = false;
+    color_t lineColor = 0, fillColor = 0;
+    float   lineWidth = 0.0f;
+
+    size_t i = 0;
+    while (i < cmds.size()) {
+        size_t end = i + 1;
+        while (end < cmds.size() && detail::drawlist_compare(list, cmds[i], cmds[end]) == 0) {
+            ++end;
+        }
+
+        const ege_drawlist::state& s = list->states[cmds[i].state];
+        bool isLine = detail::drawlist_is_line(cmds[i]);
+        int  merged = 0;
+        ege_path_reset(path);
+
+        if (isLine) {
+            if (!hasLineColor || lineColor != s.linecolor) {
+                setlinecolor(s.linecolor, pimg);
+                lineColor    = s.linecolor;
+                hasLineColor = true;
+            }
+            if (!hasLineWidth || lineWidth != s.linewidth) {
+                setlinewidth(s.linewidth, pimg);
+                lineWidth    = s.linewidth;
+                hasLineWidth = true;
+            }
+
+            bool merge = EGEGET_A(s.linecolor) == 0xFF;
+            for (size_t k = i; k < end; ++k) {
+                const ege_drawlist::command& cmd = cmds[k];
+                if (merge) {
+                    ege_path_start(path);
+                    ege_path_addline(path, cmd.a, cmd.b, cmd.c, cmd.d);
+                    ++merged;
+                } else {
+                    detail::drawlist_draw_single(list, cmd, pimg);
+                }
+            }
+            if (merged > 0) {
+                ege_drawpath(path, pimg);
+            }
+        } else {
+            if (!hasFillColor || fillColor != s.fillcolor) {
+                setfillcolor(s.fillcolor, pimg);
+                fillColor    = s.fillcolor;
+                hasFillColor = true;
+            }
+
+            bool merge = EGEGET_A(s.fillcolor) == 0xFF;
+            ege_path_setfillmode(path, FILLMODE_WINDING);
+            for (size_t k = i; k < end; ++k) {
+                const ege_drawlist::command& cmd = cmds[k];
+                if (!merge) {
+                    detail::drawlist_draw_single(list, cmd, pimg);
+                } else if (cmd.type == ege_drawlist::CMD_FILLCIRCLE) {
+                    ege_path_addcircle(path, cmd.a, cmd.b, cmd.c);
+                    ++merged;
+                } else if (cmd.type == ege_drawlist::CMD_FILLELLIPSE) {
+                    ege_path_addellipse(path, cmd.a, cmd.b, cmd.c, cmd.d);
+                    ++merged;
+                } else {
+                    const ege_point* p = &list->points[cmd.first];
+                    int              n = cmd.count;
+                    if (detail::drawlist_convex(p, n)) {
+                        detail::drawlist_addpoly(path, list, p, n);
+                        ++merged;
+                    } else {
+                        detail::drawlist_draw_single(list, cmd, pimg);
+                    }
+                }
+            }
+            if (merged > 0) {
+                ege_fillpath(path, pimg);
+            }
+        }
+
+        i = end;
+    }
+
+    ege_path_reset(path);
+    setlinecolor(oldLineColor, pimg);
+    setfillcolor(oldFillColor, pimg);
+    if (hasLineWidth && lineWidth != oldLineWidth) {
+        setlinewidth(oldLineWidth, pimg);
+    }
+}
+
+} // namespace ege
+
+#endif /* EGE_DRAWLIST_H */
@@ -0,0 +1,291 @@
+/**
+ * @file floodfill.h
+ * @brief Scanline flood fill over the image buffer, with bounded memory
+ *
+ * floodfill_f() and floodfillsurface_f() are span based replacements for floodfill() and
+ * floodfillsurface(): every maximal run of matching pixels is found once, marked in a 1-bit
+ * visited mask and queued for its neighbouring rows on a heap allocated span stack, so memory
+ * stays at one bit per pixel plus the stack no matter the image size. Runs are found by
+ * comparing four pixels at a time with SSE2, one 32-bit pixel at a time otherwise.
+ *
+ * floodfill_mask() runs the same search but only returns the mask, for region selection tools.
+ *
+ * Colors are compared on their RGB part, like GDI does. As with the other _f functions the fill
+ * works in image coordinates, ignoring the viewport, and paints the solid fill color.
+ */
+#ifndef EGE_FLOODFILL_H
+#define EGE_FLOODFILL_H
+
+#include "blend.h"
+
+#include <string.h>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @enum floodfill_type
+ * @brief Which pixels a flood fill spreads over
+ */
+enum floodfill_type
+{
+    FLOODFILL_BORDER  = 0,  ///< All pixels up to the border color, like floodfill()
+    FLOODFILL_SURFACE = 1   ///< Pixels of the area color, like floodfillsurface()
+};
+
+namespace detail
+{
+
+struct flood_job
+{
+    const color_t* buf;
+    int            w, h;
+    int            stride;          ///< Pixels from one buffer row to the next
+    color_t        key;             ///< RGB of the border or area color
+    bool           inside;          ///< Whether pixels equal to key belong to the region
+    uint32_t*      mask;
+    int            maskStride;      ///< In 32-bit words
+    int            x0, y0, x1, y1;  ///< Bounds of the marked pixels
+    int            count;           ///< Number of marked pixels
+};
+
+inline bool flood_match(const flood_job& job, color_t c)
+{
+    return ((c & 0xFFFFFF) == job.key) == job.inside;
+}
+
+/// First x in [x, end) whose pixel matches (want) or does not match (!want) the region.
+inline int flood_scan_scalar(const flood_job& job, const color_t* row, int x, int end, bool want)
+{
+    while (x < end && flood_match(job, row[x]) != want) {
+        ++x;
+    }
+    return x;
+}
+
+#ifdef EGE_SIMD_X86
+EGE_SIMD_TARGET("sse2")
+inline int flood_scan_sse2(const flood_job& job, const color_t* row, int x, int end, bool want)
+{
+    const __m128i rgb = _mm_set1_epi32(0xFFFFFF), key = _mm_set1_epi32((int)job.key);
+    // movemask bits are set for lanes equal to key; lanes that stop the scan give the stop mask.
+    const bool stopOnEqual = job.inside == want;
+    for (; x + 4 <= end; x += 4) {
+        __m128i p    = _mm_and_si128(_mm_loadu_si128((const __m128i*)(row + x)), rgb);
+        int     eq   = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(p, key)));
+        int     stop = stopOnEqual ? eq : (~eq & 0xF);
+        if (stop != 0) {
+            return x + (stop & 1 ? 0 : (stop & 2 ? 1 : (stop & 4 ? 2 : 3)));
+        }
+    }
+    return flood_scan_scalar(job, row, x, end, want);
+}
+#endif
+
+inline int flood_scan(const flood_job& job, const color_t* row, int x, int end, bool want)
+{
+#ifdef EGE_SIMD_X86
+    if (ege_cpu_features() & CPU_FEATURE_SSE2) {
+        return flood_scan_sse2(job, row, x, end, want);
+    }
+#endif
+    return flood_scan_scalar(job, row, x, end, want);
+}
+
+inline bool flood_visited(const flood_job& job, int x, int y)
+{
+    return (job.mask[(size_t)y * job.maskStride + (x >> 5)] >> (x & 31)) & 1;
+}
+
+/// Set the mask bits of [xa, xb) in row y.
+inline void flood_mark(flood_job& job, int y, int xa, int xb)
+{
+    uint32_t* row = job.mask + (size_t)y * job.maskStride;
+    int       wa = xa >> 5, wb = (xb - 1) >> 5;
+    uint32_t  head = ~0u << (xa & 31), tail = ~0u >> (31 - ((xb - 1) & 31));
+    if (wa == wb) {
+        row[wa] |= head & tail;
+    } else {
+        row[wa] |= head;
+        for (int i = wa + 1; i < wb; ++i) {
+            row[i] = ~0u;
+        }
+        row[wb] |= tail;
+    }
+    job.x0 = xa < job.x0 ? xa : job.x0;
+    job.x1 = xb > job.x1 ? xb : job.x1;
+    job.y0 = y < job.y0 ? y : job.y0;
+    job.y1 = y + 1 > job.y1 ? y + 1 : job.y1;
+    job.count += xb - xa;
+}
+
+struct flood_seed
+{
+    int x, y;
+};
+
+/// Fill the visited mask with the region connected to (x, y); the mask must start cleared.
+inline void flood_run(flood_job& job, int x, int y)
+{
+    job.x0 = job.w, job.y0 = job.h, job.x1 = 0, job.y1 = 0, job.count = 0;
+
+    std::vector<flood_seed> stack;
+    flood_seed              seed = {x, y};
+    stack.push_back(seed);
+    while (!stack.empty()) {
+        flood_seed s = stack.back();
+        stack.pop_back();
+        const color_t* row = job.buf + (size_t)s.y * job.stride;
+        // Runs are always marked whole, so one visited pixel means the run is done.
+        if (flood_visited(job, s.x, s.y) || !flood_match(job, row[s.x])) {
+            continue;
+        }
+        int l = s.x, r = flood_scan(job, row, s.x, job.w, false);
+        while (l > 0 && flood_match(job, row[l - 1])) {
+            --l;
+        }
+        flood_mark(job, s.y, l, r);
+
+        for (int ny = s.y - 1; ny <= s.y + 1; ny += 2) {
+            if (ny < 0 || ny >= job.h) {
+                continue;
+            }
+            const color_t* next = job.buf + (size_t)ny * job.stride;
+            for (int nx = flood_scan(job, next, l, r, true); nx < r; nx = flood_scan(job, next, nx, r, true)) {
+                if (!flood_visited(job, nx, ny)) {
+                    flood_seed n = {nx, ny};
+                    stack.push_back(n);
+                }
+                nx = flood_scan(job, next, nx, r, false);
+            }
+        }
+    }
+}
+
+inline bool flood_begin(flood_job& job, int x, int y, color_t color, floodfill_type type, const color_t* buf, int w, int h,
+    int stride)
+{
+    if (buf == NULL || x < 0 || y < 0 || x >= w || y >= h) {
+        return false;
+    }
+    job.buf    = buf;
+    job.w      = w;
+    job.h      = h;
+    job.stride = stride;
+    job.key    = color & 0xFFFFFF;
+    job.inside = type == FLOODFILL_SURFACE;
+    return true;
+}
+
+/// Paint the region connected to (x, y) in a w x h buffer; job receives the painted bounds.
+inline int flood_paint(flood_job& job, int x, int y, color_t color, floodfill_type type, color_t fill, color_t* buf, int w,
+    int h, int stride)
+{
+    if (!flood_begin(job, x, y, color, type, buf, w, h, stride)) {
+        return buf == NULL ? grNullPointer : grParamError;
+    }
+    std::vector<uint32_t> mask((size_t)((job.w + 31) >> 5) * job.h, 0);
+    job.mask       = &mask[0];
+    job.maskStride = (job.w + 31) >> 5;
+    flood_run(job, x, y);
+
+    for (int row = job.y0; row < job.y1; ++row) {
+        color_t*        d    = buf + (size_t)row * stride;
+        const uint32_t* bits = job.mask + (size_t)row * job.maskStride;
+        for (int i = job.x0 >> 5; i < (job.x1 + 31) >> 5; ++i) {
+            uint32_t word = bits[i];
+            if (word == ~0u) {
+                for (int bit = 0; bit < 32; ++bit) {
+                    d[i * 32 + bit] = fill;
+                }
+            } else if (word != 0) {
+                for (int bit = 0; bit < 32; ++bit) {
+                    if ((word >> bit) & 1) {
+                        d[i * 32 + bit] = fill;
+                    }
+                }
+            }
+        }
+    }
+    return grOk;
+}
+
+inline int flood_paint(int x, int y, color_t color, floodfill_type type, PIMAGE pimg)
+{
+    flood_job job;
+    int       w   = getwidth(pimg);
+    int       ret = flood_paint(job, x, y, color, type, getfillcolor(pimg), getbuffer(pimg), w, getheight(pimg), w);
+    if (ret == grOk && job.count > 0) {
+        dirty_note(pimg, job.x0, job.y0, job.x1 - job.x0, job.y1 - job.y0);
+    }
+    return ret;
+}
+
+/// Search only: fill a caller supplied mask with the region connected to (x, y).
+inline int flood_select(int x, int y, color_t color, floodfill_type type, uint32_t* mask, int maskStride,
+    const color_t* buf, int w, int h, int stride)
+{
+    flood_job job;
+    if (mask == NULL || buf == NULL) {
+        return grNullPointer;
+    }
+    if (!flood_begin(job, x, y, color, type, buf, w, h, stride) || maskStride < (job.w + 31) >> 5) {
+        return grParamError;
+    }
+    memset(mask, 0, (size_t)maskStride * job.h * sizeof(uint32_t));
+    job.mask       = mask;
+    job.maskStride = maskStride;
+    flood_run(job, x, y);
+    return grOk;
+}
+
+} // namespace detail
+
+/**
+ * @brief Flood fill up to a border color, scanline based
+ * @param x Fill starting point x coordinate
+ * @param y Fill starting point y coordinate
+ * @param borderColor Boundary color
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if the target has no buffer, grParamError if (x, y) is outside it
+ */
+inline int floodfill_f(int x, int y, int borderColor, PIMAGE pimg = NULL)
+{
+    return detail::flood_paint(x, y, (color_t)borderColor, FLOODFILL_BORDER, pimg);
+}
+
+/**
+ * @brief Fill the area of one color connected to a point, scanline based
+ * @param x Fill starting point x coordinate
+ * @param y Fill starting point y coordinate
+ * @param areaColor Area color to be replaced
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if the target has no buffer, grParamError if (x, y) is outside it
+ */
+inline int floodfillsurface_f(int x, int y, color_t areaColor, PIMAGE pimg = NULL)
+{
+    return detail::flood_paint(x, y, areaColor, FLOODFILL_SURFACE, pimg);
+}
+
+/**
+ * @brief Compute the region a flood fill would paint, as a 1-bit mask
+ * @param x Fill starting point x coordinate
+ * @param y Fill starting point y coordinate
+ * @param color Border color for FLOODFILL_BORDER, area color for FLOODFILL_SURFACE
+ * @param type FLOODFILL_BORDER or FLOODFILL_SURFACE
+ * @param mask Receives one bit per pixel, least significant bit first, cleared before filling
+ * @param maskStride Words per mask row, at least (getwidth(pimg) + 31) / 32
+ * @param pimg Source image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if mask is NULL or the image has no buffer,
+ *         grParamError if (x, y) is outside the image or maskStride is too small
+ */
+inline int floodfill_mask(int x, int y, color_t color, floodfill_type type, uint32_t* mask, int maskStride, PCIMAGE pimg = NULL)
+{
+    int w = getwidth(pimg);
+    return detail::flood_select(x, y, color, type, mask, maskStride, getbuffer(pimg), w, getheight(pimg), w);
+}
+
+} // namespace ege
+
+#endif /* EGE_FLOODFILL_H */
@@ -0,0 +1,371 @@
+/**
+ * @file font_cache.h
+ * @brief Font cache that turns repeated setfont calls into lookups
+ *
+ * setfont() creates a new font object on every call, even when the target already uses the
+ * same font. setfont_cached() remembers, for each distinct set of setfont parameters, the
+ * LOGFONTW the library produced; when the target's current font (from getfont()) already
+ * matches it, the call is a lookup and no font is created.
+ *
+ * Entries are reference counted by the images currently bound to them and the cache keeps
+ * at most ege_font_cache_set_capacity() entries, evicting unreferenced entries least recently
+ * used first. The creation counter in ege_font_cache_stats shows how many calls still reached
+ * setfont().
+ */
+#ifndef EGE_FONT_CACHE_H
+#define EGE_FONT_CACHE_H
+
+#include "../ege.h"
+
+#include <stddef.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+namespace ege
+{
+
+/**
+ * @struct ege_font_cache_stats
+ * @brief Counters of the font cache
+ */
+struct ege_font_cache_stats
+{
+    unsigned long lookups;      ///< setfont_cached() calls
+    unsigned long hits;         ///< Calls answered without creating a font
+    unsigned long creations;    ///< Calls forwarded to setfont()
+    int           entries;      ///< Cached parameter sets
+    int           capacity;     ///< Maximum number of entries
+};
+
+namespace detail
+{
+
+/// Compare two LOGFONTW, ignoring whatever follows the face name terminator.
+inline bool logfont_equal(const LOGFONTW& a, const LOGFONTW& b)
+{
+    if (memcmp(&a, &b, offsetof(LOGFONTW, lfFaceName)) != 0) {
+        return false;
+    }
+    for (int i = 0; i < LF_FACESIZE; ++i) {
+        if (a.lfFaceName[i] != b.lfFaceName[i]) {
+            return false;
+        }
+        if (a.lfFaceName[i] == 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+struct font_request
+{
+    enum kind_type { SIMPLE, FULL };
+
+    kind_type    kind;
+    int          height, width, escapement, orientation, weight;
+    bool         italic, underline, strikeOut;
+    std::wstring face;
+
+    bool operator<(const font_request& o) const
+    {
+        if (kind != o.kind)               return kind < o.kind;
+        if (height != o.height)           return height < o.height;
+        if (width != o.width)             return width < o.width;
+        if (escapement != o.escapement)   return escapement < o.escapement;
+        if (orientation != o.orientation) return orientation < o.orientation;
+        if (weight != o.weight)           return weight < o.weight;
+        if (italic != o.italic)           return italic < o.italic;
+        if (underline != o.underline)     return underline < o.underline;
+        if (strikeOut != o.strikeOut)     return strikeOut < o.strikeOut;
+        return face < o.face;
+    }
+};
+
+class font_cache
+{
+public:
+    font_cache() : m_capacity(64), m_clock(0) { memset(&m_stats, 0, sizeof(m_stats)); }
+
+    void set(const font_request& request, PIMAGE pimg)
+    {
+        ++m_stats.lookups;
+        PCIMAGE target = pimg != NULL ? pimg : gettarget();
+
+        entry_map::iterator it = m_entries.find(request);
+        if (it != m_entries.end()) {
+            LOGFONTW current;
+            getfont(&current, pimg);
+            if (logfont_equal(current, it->second.font)) {
+                ++m_stats.hits;
+                it->second.lastUse = ++m_clock;
+                bind(target, it);
+                return;
+            }
+        }
+
+        apply(request, pimg);
+        ++m_stats.creations;
+
+        if (it == m_entries.end()) {
+            if ((int)m_entries.size() >= m_capacity && !evict()) {
+                unbind(target);
+                return;
+            }
+            it = m_entries.insert(std::make_pair(request, entry())).first;
+            it->second.refs = 0;
+        }
+        getfont(&it->second.font, pimg);
+        it->second.lastUse = ++m_clock;
+        bind(target, it);
+    }
+
+    /// LOGFONTW requests need no entry: the comparison with getfont() is the whole lookup.
+    void set(const LOGFONTW& font, PIMAGE pimg)
+    {
+        ++m_stats.lookups;
+        LOGFONTW current;
+        getfont(&current, pimg);
+        if (logfont_equal(current, font)) {
+            ++m_stats.hits;
+            return;
+        }
+        setfont(&font, pimg);
+        ++m_stats.creations;
+        unbind(pimg != NULL ? pimg : gettarget());
+    }
+
+    void release(PCIMAGE pimg) { unbind(pimg); }
+
+    void setCapacity(int capacity)
+    {
+        m_capacity = capacity < 1 ? 1 : capacity;
+        while ((int)m_entries.size() > m_capacity && evict()) {
+        }
+    }
+
+    void stats(ege_font_cache_stats* out) const
+    {
+        *out          = m_stats;
+        out->entries  = (int)m_entries.size();
+        out->capacity = m_capacity;
+    }
+
+    void resetStats() { m_stats.lookups = m_stats.hits = m_stats.creations = 0; }
+
+private:
+    struct entry
+    {
+        LOGFONTW      font;     ///< Font the library produced for the request
+        int           refs;     ///< Images currently using this font
+        unsigned long lastUse;
+    };
+
+    typedef std::map<font_request, entry>               entry_map;
+    typedef std::map<PCIMAGE, entry_map::iterator>      binding_map;
+
+    static void apply(const font_request& r, PIMAGE pimg)
+    {
+        if (r.kind == font_request::SIMPLE) {
+            setfont(r.height, r.width, r.face.c_str(), pimg);
+        } else {
+            setfont(r.height, r.width, r.face.c_str(), r.escapement, r.orientation, r.weight, r.italic, r.underline,
+                r.strikeOut, pimg);
+        }
+    }
+
+    void bind(PCIMAGE target, entry_map::iterator it)
+    {
+        binding_map::iterator b = m_bindings.find(target);
+        if (b != m_bindings.end()) {
+            if (b->second == it) {
+                return;
+            }
+            --b->second->second.refs;
+            b->second = it;
+        } else {
+            m_bindings.insert(std::make_pair(target, it));
+        }
+        ++it->second.refs;
+    }
+
+    void unbind(PCIMAGE target)
+    {
+        binding_map::iterator b = m_bindings.find(target);
+        if (b != m_bindings.end()) {
+            --b->second->second.refs;
+            m_bindings.erase(b);
+        }
+    }
+
+    /// Drop the least recently used entry no image refers to.
+    bool evict()
+    {
+        entry_map::iterator victim = m_entries.end();
+        for (entry_map::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+            if (it->second.refs == 0 && (victim == m_entries.end() || it->second.lastUse < victim->second.lastUse)) {
+                victim = it;
+            }
+        }
+        if (victim == m_entries.end()) {
+            return false;
+        }
+        m_entries.erase(victim);
+        return true;
+    }
+
+    font_cache(const font_cache&);
+    font_cache& operator=(const font_cache&);
+
+    entry_map            m_entries;
+    binding_map          m_bindings;
+    int                  m_capacity;
+    unsigned long        m_clock;
+    ege_font_cache_stats m_stats;
+};
+
+inline font_cache& font_cache_instance()
+{
+    static font_cache cache;
+    return cache;
+}
+
+inline std::wstring font_face(const char* typeface)
+{
+    std::wstring face;
+    int          length = MultiByteToWideChar(getcodepage(), 0, typeface, -1, NULL, 0);
+    if (length > 1) {
+        face.resize(length);
+        MultiByteToWideChar(getcodepage(), 0, typeface, -1, &face[0], length);
+        face.resize(length - 1);
+    }
+    return face;
+}
+
+inline font_request font_make_request(int height, int width, const std::wstring& face)
+{
+    font_request r;
+    r.kind        = font_request::SIMPLE;
+    r.height      = height;
+    r.width       = width;
+    r.escapement  = 0;
+    r.orientation = 0;
+    r.weight      = 0;
+    r.italic      = false;
+    r.underline   = false;
+    r.strikeOut   = false;
+    r.face        = face;
+    return r;
+}
+
+inline font_request font_make_request(int height, int width, const std::wstring& face, int escapement,
+    int orientation, int weight, bool italic, bool underline, bool strikeOut)
+{
+    font_request r = font_make_request(height, width, face);
+    r.kind         = font_request::FULL;
+    r.escapement   = escapement;
+    r.orientation  = orientation;
+    r.weight       = weight;
+    r.italic       = italic;
+    r.underline    = underline;
+    r.strikeOut    = strikeOut;
+    return r;
+}
+
+} // namespace detail
+
+/**
+ * @brief Set font through the font cache (simplified version)
+ * @param height Font height (pixels)
+ * @param width Font width (pixels), 0 means automatic
+ * @param typeface Font name
+ * @param pimg Target image pointer, NULL means current ege window
+ */
+inline void setfont_cached(int height, int width, const char* typeface, PIMAGE pimg = NULL)
+{
+    detail::font_cache_instance().set(detail::font_make_request(height, width, detail::font_face(typeface)), pimg);
+}
+
+/// @copydoc setfont_cached(int, int, const char*, PIMAGE)
+inline void setfont_cached(int height, int width, const wchar_t* typeface, PIMAGE pimg = NULL)
+{
+    detail::font_cache_instance().set(detail::font_make_request(height, width, typeface), pimg);
+}
+
+/**
+ * @brief Set font through the font cache (complete version)
+ * @param height Font height (pixels)
+ * @param width Font width (pixels), 0 means automatic
+ * @param typeface Font name
+ * @param escapement Font tilt angle (in tenths of a degree)
+ * @param orientation Character tilt angle (in tenths of a degree)
+ * @param weight Font thickness (100-900, 400 is normal, 700 is bold)
+ * @param italic Whether italic
+ * @param underline Whether underline
+ * @param strikeOut Whether strikethrough
+ * @param pimg Target image pointer, NULL means current ege window
+ */
+inline void setfont_cached(int height, int width, const char* typeface, int escapement, int orientation, int weight,
+    bool italic, bool underline, bool strikeOut, PIMAGE pimg = NULL)
+{
+    detail::font_cache_instance().set(detail::font_make_request(height, width, detail::font_face(typeface), escapement,
+        orientation, weight, italic, underline, strikeOut), pimg);
+}
+
+/// @copydoc setfont_cached(int, int, const char*, int, int, int, bool, bool, bool, PIMAGE)
+inline void setfont_cached(int height, int width, const wchar_t* typeface, int escapement, int orientation,
+    int weight, bool italic, bool underline, bool strikeOut, PIMAGE pimg = NULL)
+{
+    detail::font_cache_instance().set(detail::font_make_request(height, width, typeface, escapement, orientation,
+        weight, italic, underline, strikeOut), pimg);
+}
+
+/**
+ * @brief Set font from a LOGFONTW through the font cache
+ * @param font Pointer to LOGFONTW structure
+ * @param pimg Target image pointer, NULL means current ege window
+ */
+inline void setfont_cached(const LOGFONTW* font, PIMAGE pimg = NULL)
+{
+    detail::font_cache_instance().set(*font, pimg);
+}
+
+/**
+ * @brief Release the font cache reference held by an image
+ * @param pimg Image about to be deleted
+ * @note Optional: stale references only keep an entry from being evicted.
+ */
+inline void ege_font_cache_release(PCIMAGE pimg)
+{
+    detail::font_cache_instance().release(pimg);
+}
+
+/**
+ * @brief Set the maximum number of cached font parameter sets
+ * @param capacity Maximum entry count, default is 64
+ */
+inline void ege_font_cache_set_capacity(int capacity)
+{
+    detail::font_cache_instance().setCapacity(capacity);
+}
+
+/**
+ * @brief Get the counters of the font cache
+ * @param stats Receives lookups, hits, font creations and entry count
+ */
+inline void ege_font_cache_get_stats(ege_font_cache_stats* stats)
+{
+    if (stats != NULL) {
+        detail::font_cache_instance().stats(stats);
+    }
+}
+
+/// @brief Reset the lookup, hit and creation counters of the font cache
+inline void ege_font_cache_reset_stats()
+{
+    detail::font_cache_instance().resetStats();
+}
+
+} // namespace ege
+
+#endif /* EGE_FONT_CACHE_H */
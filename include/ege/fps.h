@@ -2,6 +2,7 @@
 #define EGE_FPS_H
 
 #include "egecontrolbase.h"
+#include "font_cache.h"
 
 namespace ege
 {
@@ -46,7 +47,7 @@ public:
         setcolor(WHITE, pimg);
         setfillcolor(BLACK, pimg);
         setbkmode(OPAQUE, pimg);
-        setfont(12, 0, "SimSun", pimg);
+        setfont_cached(12, 0, "SimSun", pimg);
         outtextxy(0, 0, str, pimg);
     }
 };
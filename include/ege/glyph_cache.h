@@ -0,0 +1,686 @@
+/**
+ * @file glyph_cache.h
+ * @brief Glyph atlas cache for drawing many short strings per frame
+ *
+ * outtextxy_cached(), xyprintf_cached() and ege_outtextxy_cached() rasterize each glyph once,
+ * keyed by the target's current font (the LOGFONTW returned by getfont()) and its code
+ * point, into a shared atlas IMAGE. Later calls blit the cached coverage in the current
+ * text color. Glyphs are evicted least recently used first once the atlas reaches its
+ * memory limit (see ege_glyph_cache_set_limit()).
+ *
+ * The cached functions always draw left/top aligned with a transparent background, like
+ * outtextxy() after settextjustify(LEFT_TEXT, TOP_TEXT) and setbkmode(TRANSPARENT). Rotated
+ * fonts (non-zero lfEscapement) are passed through to outtextxy() uncached.
+ */
+#ifndef EGE_GLYPH_CACHE_H
+#define EGE_GLYPH_CACHE_H
+
+#include "blend.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_glyph_cache_stats
+ * @brief Counters of the glyph atlas cache
+ */
+struct ege_glyph_cache_stats
+{
+    unsigned long hits;         ///< Glyphs drawn from the atlas
+    unsigned long misses;       ///< Glyphs rasterized into the atlas
+    unsigned long evictions;    ///< Glyphs evicted to make room
+    int           glyphs;       ///< Glyphs currently cached
+    size_t        atlasBytes;   ///< Current size of the atlas image
+    size_t        memoryLimit;  ///< Upper bound of atlasBytes
+};
+
+namespace detail
+{
+
+class glyph_cache
+{
+public:
+    enum
+    {
+        ATLAS_WIDTH = 1024,
+        MAX_FONTS   = 64,   ///< Distinct fonts kept before the cache starts over
+        NONE        = -1
+    };
+
+    glyph_cache() : m_atlas(NULL), m_atlasHeight(0), m_limit(4 * 1024 * 1024), m_lruHead(NONE), m_lruTail(NONE),
+        m_freeEntry(NONE), m_scratch(NULL), m_scratchFont(NONE), m_lastFont(NONE)
+    {
+        memset(&m_stats, 0, sizeof(m_stats));
+    }
+
+    void setLimit(size_t bytes)
+    {
+        m_limit = bytes < ATLAS_WIDTH * 4 * 64 ? ATLAS_WIDTH * 4 * 64 : bytes;
+        clear();
+    }
+
+    void clear()
+    {
+        if (m_atlas != NULL) {
+            delimage(m_atlas);
+            m_atlas = NULL;
+        }
+        m_atlasHeight = 0;
+        m_entries.clear();
+        m_lookup.clear();
+        m_shelves.clear();
+        m_fonts.clear();
+        m_lruHead = m_lruTail = m_freeEntry = NONE;
+        m_scratchFont = m_lastFont = NONE;
+    }
+
+    void stats(ege_glyph_cache_stats* out) const
+    {
+        *out             = m_stats;
+        out->glyphs      = (int)m_lookup.size();
+        out->atlasBytes  = (size_t)ATLAS_WIDTH * m_atlasHeight * sizeof(color_t);
+        out->memoryLimit = m_limit;
+    }
+
+    void resetStats()
+    {
+        m_stats.hits = m_stats.misses = m_stats.evictions = 0;
+    }
+
+    void draw(int x, int y, const wchar_t* text, PIMAGE pimg)
+    {
+        LOGFONTW lf;
+        getfont(&lf, pimg);
+        if (lf.lfEscapement != 0) {
+            outtextxy(x, y, text, pimg);
+            return;
+        }
+
+        int font = fontId(lf);
+
+        // Text is placed relative to the viewport origin, and clipped to the viewport only when
+        // its clipping is on; otherwise to the whole image, as outtextxy() does.
+        int left, top, right, bottom, clip;
+        getviewport(&left, &top, &right, &bottom, &clip, pimg);
+        int width = getwidth(pimg), height = getheight(pimg);
+        int clipLeft = 0, clipTop = 0, clipRight = width, clipBottom = height;
+        if (clip) {
+            clipLeft   = left < 0 ? 0 : left;
+            clipTop    = top < 0 ? 0 : top;
+            clipRight  = right > width ? width : right;
+            clipBottom = bottom > height ? height : bottom;
+        }
+
+        color_t*  dst   = getbuffer(pimg);
+        color_t   color = gettextcolor(pimg);
+        const int x0    = x + left;
+        int       penX  = x0, penY = y + top;
+        dirty_box damage = {x0, penY, x0, penY};
+
+        for (const wchar_t* p = text; *p; ++p) {
+            if (*p == L'\n') {
+                penX  = x0;
+                penY += m_fonts[font].lineHeight;
+                continue;
+            }
+
+            wchar_t      units[3] = {p[0], 0, 0};
+            unsigned int codepoint = p[0];
+            if (p[0] >= 0xD800 && p[0] < 0xDC00 && p[1] >= 0xDC00 && p[1] < 0xE000) {
+                units[1]  = p[1];
+                codepoint = 0x10000 + (((unsigned int)p[0] - 0xD800) << 10) + ((unsigned int)p[1] - 0xDC00);
+                ++p;
+            }
+
+            int index = find(font, codepoint, units);
+            if (index == NONE) {
+                // Glyph larger than the atlas: blend it from the scratch image, so the target's
+                // justification and background mode stay out of the picture here too.
+                int cellW, cellH, pad = renderScratch(font, units, cellW, cellH);
+                blit(dst, width, penX - pad, penY - pad, getbuffer(m_scratch), getwidth(m_scratch), cellW, cellH,
+                    clipLeft, clipTop, clipRight, clipBottom, color);
+                dirty_box box = {penX - pad, penY - pad, penX - pad + cellW, penY - pad + cellH};
+                damage = damage.united(box);
+                penX  += textwidth(units, m_scratch);
+                continue;
+            }
+
+            const entry& e = m_entries[index];
+            blit(dst, width, penX + e.offsetX, penY + e.offsetY, getbuffer((PCIMAGE)m_atlas) + (size_t)e.y * ATLAS_WIDTH + e.x,
+                ATLAS_WIDTH, e.w, e.h, clipLeft, clipTop, clipRight, clipBottom, color);
+            if (e.w > 0) {
+                dirty_box box = {penX + e.offsetX, penY + e.offsetY, penX + e.offsetX + e.w, penY + e.offsetY + e.h};
+                damage = damage.united(box);
+            }
+            penX += e.advance;
+        }
+        dirty_note(pimg, damage.x0, damage.y0, damage.x1 - damage.x0, damage.y1 - damage.y0);
+    }
+
+private:
+    struct entry
+    {
+        int          font;
+        unsigned int codepoint;
+        int          x, y, w, h;        ///< Rectangle in the atlas, w == 0 for blank glyphs
+        int          offsetX, offsetY;  ///< Position of the rectangle relative to the pen
+        int          advance;
+        int          shelf;
+        int          prev, next;        ///< LRU list, or free list through next
+    };
+
+    struct shelf
+    {
+        int y, height, cursor, live;
+        std::vector<std::pair<int, int> > holes;  ///< Free (x, width) ranges left by evictions
+    };
+
+    struct font_info
+    {
+        LOGFONTW font;
+        int      lineHeight;
+    };
+
+    typedef std::map<std::pair<int, unsigned int>, int> lookup_map;
+
+    glyph_cache(const glyph_cache&);
+    glyph_cache& operator=(const glyph_cache&);
+
+    int fontId(const LOGFONTW& lf)
+    {
+        // Normalize the face name so bytes after the terminator do not split identical fonts.
+        LOGFONTW key = lf;
+        memset(key.lfFaceName, 0, sizeof(key.lfFaceName));
+        for (int i = 0; i < LF_FACESIZE - 1 && lf.lfFaceName[i]; ++i) {
+            key.lfFaceName[i] = lf.lfFaceName[i];
+        }
+
+        if (m_lastFont != NONE && memcmp(&m_fonts[m_lastFont].font, &key, sizeof(key)) == 0) {
+            return m_lastFont;
+        }
+        for (size_t i = 0; i < m_fonts.size(); ++i) {
+            if (memcmp(&m_fonts[i].font, &key, sizeof(key)) == 0) {
+                return m_lastFont = (int)i;
+            }
+        }
+        if (m_fonts.size() >= MAX_FONTS) {
+            // Glyphs are keyed by font index, so the fonts can only be dropped together with them.
+            clear();
+        }
+
+        font_info info;
+        info.font       = key;
+        info.lineHeight = 0;
+        m_fonts.push_back(info);
+        m_lastFont = (int)m_fonts.size() - 1;
+        selectScratchFont(m_lastFont);
+        m_fonts[m_lastFont].lineHeight = textheight(L"A", m_scratch);
+        return m_lastFont;
+    }
+
+    void selectScratchFont(int font)
+    {
+        if (m_scratch == NULL) {
+            m_scratch = newimage(64, 64);
+            setbkcolor(BLACK, m_scratch);
+            settextcolor(WHITE, m_scratch);
+            setbkmode(TRANSPARENT, m_scratch);
+            settextjustify(LEFT_TEXT, TOP_TEXT, m_scratch);
+        }
+        if (m_scratchFont != font) {
+            setfont(&m_fonts[font].font, m_scratch);
+            m_scratchFont = font;
+        }
+    }
+
+    int find(int font, unsigned int codepoint, const wchar_t* units)
+    {
+        lookup_map::iterator it = m_lookup.find(std::make_pair(font, codepoint));
+        if (it != m_lookup.end()) {
+            ++m_stats.hits;
+            touch(it->second);
+            return it->second;
+        }
+        ++m_stats.misses;
+        return rasterize(font, codepoint, units);
+    }
+
+    /**
+     * Draw units white on black at (pad, pad) of the scratch image and turn it into atlas
+     * coverage in place; returns pad, cellW x cellH receives the drawn cell.
+     */
+    int renderScratch(int font, const wchar_t* units, int& cellW, int& cellH)
+    {
+        selectScratchFont(font);
+        int line = m_fonts[font].lineHeight;
+        int pad  = line / 4 + 2;  // room for italic overhang and accents
+        cellW    = textwidth(units, m_scratch) + 2 * pad;
+        cellH    = line + 2 * pad;
+        if (getwidth(m_scratch) < cellW || getheight(m_scratch) < cellH) {
+            resize(m_scratch, cellW > getwidth(m_scratch) ? cellW : getwidth(m_scratch),
+                cellH > getheight(m_scratch) ? cellH : getheight(m_scratch));
+            setbkcolor(BLACK, m_scratch);
+            settextcolor(WHITE, m_scratch);
+            setbkmode(TRANSPARENT, m_scratch);
+            settextjustify(LEFT_TEXT, TOP_TEXT, m_scratch);
+            setfont(&m_fonts[font].font, m_scratch);
+        }
+        cleardevice(m_scratch);
+        outtextxy(pad, pad, units, m_scratch);
+
+        // Alpha holds the strongest channel, for the alpha of the blended result.
+        const int stride = getwidth(m_scratch);
+        color_t*  cell   = getbuffer(m_scratch);
+        for (int y = 0; y < cellH; ++y) {
+            for (int x = 0; x < cellW; ++x) {
+                color_t  c = cell[y * stride + x] & 0x00FFFFFF;
+                unsigned r = c >> 16, g = (c >> 8) & 0xFF, b = c & 0xFF;
+                unsigned m = r > g ? (r > b ? r : b) : (g > b ? g : b);
+                cell[y * stride + x] = (m << 24) | c;
+            }
+        }
+        return pad;
+    }
+
+    int rasterize(int font, unsigned int codepoint, const wchar_t* units)
+    {
+        int cellW, cellH, pad = renderScratch(font, units, cellW, cellH);
+
+        // Crop to the covered pixels.
+        const int      stride = getwidth(m_scratch);
+        const color_t* cell   = getbuffer(m_scratch);
+        int minX = cellW, minY = cellH, maxX = -1, maxY = -1;
+        for (int y = 0; y < cellH; ++y) {
+            for (int x = 0; x < cellW; ++x) {
+                if (cell[y * stride + x] != 0) {
+                    if (x < minX) minX = x;
+                    if (x > maxX) maxX = x;
+                    if (y < minY) minY = y;
+                    if (y > maxY) maxY = y;
+                }
+            }
+        }
+
+        int index = allocEntry();
+        entry& e  = m_entries[index];
+        e.font      = font;
+        e.codepoint = codepoint;
+        e.advance   = cellW - 2 * pad;
+        e.w = e.h = 0;
+        e.x = e.y = e.offsetX = e.offsetY = 0;
+        e.shelf     = NONE;
+
+        if (maxX >= 0) {
+            int w = maxX - minX + 1, h = maxY - minY + 1;
+            if (!allocRect(w, h, index)) {
+                freeEntry(index);
+                return NONE;
+            }
+            entry&   slot  = m_entries[index];
+            color_t* atlas = getbuffer(m_atlas);
+            for (int y = 0; y < h; ++y) {
+                memcpy(atlas + (size_t)(slot.y + y) * ATLAS_WIDTH + slot.x, cell + (minY + y) * stride + minX,
+                    w * sizeof(color_t));
+            }
+            slot.offsetX = minX - pad;
+            slot.offsetY = minY - pad;
+        }
+
+        m_lookup[std::make_pair(font, codepoint)] = index;
+        linkFront(index);
+        return index;
+    }
+
+    /// Find atlas space for a w x h glyph owned by entry index, evicting old glyphs if needed.
+    bool allocRect(int w, int h, int index)
+    {
+        if (w > ATLAS_WIDTH) {
+            return false;
+        }
+        for (;;) {
+            if (tryAlloc(w, h, index)) {
+                return true;
+            }
+            if (growAtlas()) {
+                continue;
+            }
+            if (m_lruTail == NONE) {
+                // Nothing left to evict: start over with empty shelves, once.
+                if (m_shelves.empty()) {
+                    return false;
+                }
+                m_shelves.clear();
+                continue;
+            }
+            evict(m_lruTail);
+        }
+    }
+
+    bool tryAlloc(int w, int h, int index)
+    {
+        entry& e = m_entries[index];
+
+        int best = NONE;
+        for (size_t i = 0; i < m_shelves.size(); ++i) {
+            shelf& s = m_shelves[i];
+            if (s.height < h || (s.live > 0 && s.height > h + h / 2 + 2)) {
+                continue;
+            }
+            if (s.live == 0) {
+                s.cursor = 0;
+                s.holes.clear();
+            }
+            for (size_t k = 0; k < s.holes.size(); ++k) {
+                if (s.holes[k].second >= w) {
+                    e.x = s.holes[k].first;
+                    s.holes[k].first  += w;
+                    s.holes[k].second -= w;
+                    if (s.holes[k].second == 0) {
+                        s.holes.erase(s.holes.begin() + k);
+                    }
+                    return place(e, (int)i, w, h);
+                }
+            }
+            if (s.cursor + w <= ATLAS_WIDTH && (best == NONE || s.height < m_shelves[best].height)) {
+                best = (int)i;
+            }
+        }
+        if (best != NONE) {
+            e.x                     = m_shelves[best].cursor;
+            m_shelves[best].cursor += w;
+            return place(e, best, w, h);
+        }
+
+        int bottom = m_shelves.empty() ? 0 : m_shelves.back().y + m_shelves.back().height;
+        int height = (h + 3) & ~3;
+        if (bottom + height > m_atlasHeight) {
+            return false;
+        }
+        shelf s;
+        s.y      = bottom;
+        s.height = height;
+        s.cursor = w;
+        s.live   = 0;
+        m_shelves.push_back(s);
+        e.x = 0;
+        return place(e, (int)m_shelves.size() - 1, w, h);
+    }
+
+    bool place(entry& e, int shelfIndex, int w, int h)
+    {
+        shelf& s = m_shelves[shelfIndex];
+        e.y      = s.y;
+        e.w      = w;
+        e.h      = h;
+        e.shelf  = shelfIndex;
+        ++s.live;
+        return true;
+    }
+
+    bool growAtlas()
+    {
+        int    height = m_atlasHeight == 0 ? 256 : m_atlasHeight * 2;
+        size_t maxH   = m_limit / (ATLAS_WIDTH * sizeof(color_t));
+        if ((size_t)height > maxH) {
+            height = (int)maxH;
+        }
+        if (height <= m_atlasHeight) {
+            return false;
+        }
+
+        PIMAGE atlas = newimage(ATLAS_WIDTH, height);
+        if (m_atlas != NULL) {
+            memcpy(getbuffer(atlas), getbuffer(m_atlas), (size_t)ATLAS_WIDTH * m_atlasHeight * sizeof(color_t));
+            delimage(m_atlas);
+        }
+        m_atlas       = atlas;
+        m_atlasHeight = height;
+        return true;
+    }
+
+    void evict(int index)
+    {
+        entry& e = m_entries[index];
+        if (e.shelf != NONE && e.shelf < (int)m_shelves.size()) {
+            shelf& s = m_shelves[e.shelf];
+            s.holes.push_back(std::make_pair(e.x, e.w));
+            --s.live;
+        }
+        m_lookup.erase(std::make_pair(e.font, e.codepoint));
+        unlink(index);
+        freeEntry(index);
+        ++m_stats.evictions;
+    }
+
+    int allocEntry()
+    {
+        if (m_freeEntry != NONE) {
+            int index   = m_freeEntry;
+            m_freeEntry = m_entries[index].next;
+            return index;
+        }
+        m_entries.push_back(entry());
+        return (int)m_entries.size() - 1;
+    }
+
+    void freeEntry(int index)
+    {
+        m_entries[index].next = m_freeEntry;
+        m_freeEntry           = index;
+    }
+
+    void linkFront(int index)
+    {
+        entry& e = m_entries[index];
+        e.prev   = NONE;
+        e.next   = m_lruHead;
+        if (m_lruHead != NONE) {
+            m_entries[m_lruHead].prev = index;
+        }
+        m_lruHead = index;
+        if (m_lruTail == NONE) {
+            m_lruTail = index;
+        }
+    }
+
+    void unlink(int index)
+    {
+        entry& e = m_entries[index];
+        if (e.prev != NONE) m_entries[e.prev].next = e.next; else m_lruHead = e.next;
+        if (e.next != NONE) m_entries[e.next].prev = e.prev; else m_lruTail = e.prev;
+    }
+
+    void touch(int index)
+    {
+        if (m_lruHead != index) {
+            unlink(index);
+            linkFront(index);
+        }
+    }
+
+    /// Blend w x h coverage pixels (alpha and per-channel coverage) at (x, y) in the text color.
+    static void blit(color_t* dst, int stride, int x, int y, const color_t* coverage, int coverageStride, int w, int h,
+        int left, int top, int right, int bottom, color_t color)
+    {
+        if (w == 0) {
+            return;
+        }
+        int x0 = x < left ? left : x, y0 = y < top ? top : y;
+        int x1 = x + w > right ? right : x + w, y1 = y + h > bottom ? bottom : y + h;
+
+        const unsigned tr = (color >> 16) & 0xFF, tg = (color >> 8) & 0xFF, tb = color & 0xFF;
+        for (int py = y0; py < y1; ++py) {
+            const color_t* src = coverage + (size_t)(py - y) * coverageStride + (x0 - x);
+            color_t*       out = dst + (size_t)py * stride + x0;
+            for (int px = x0; px < x1; ++px, ++src, ++out) {
+                color_t c = *src;
+                if (c == 0) {
+                    continue;
+                }
+                // Per-channel coverage keeps ClearType rendering intact.
+                color_t  d = *out;
+                unsigned cr = (c >> 16) & 0xFF, cg = (c >> 8) & 0xFF, cb = c & 0xFF, ca = c >> 24;
+                unsigned r  = mix((d >> 16) & 0xFF, tr, cr);
+                unsigned g  = mix((d >> 8) & 0xFF, tg, cg);
+                unsigned b  = mix(d & 0xFF, tb, cb);
+                unsigned a  = ca + blend_mul255(d >> 24, 255 - ca);
+                *out        = (a << 24) | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+
+    static unsigned mix(unsigned d, unsigned t, unsigned coverage)
+    {
+        unsigned v = d * (255 - coverage) + t * coverage + 128;
+        return (v + (v >> 8)) >> 8;
+    }
+
+    PIMAGE                 m_atlas;
+    int                    m_atlasHeight;
+    size_t                 m_limit;
+    std::vector<entry>     m_entries;
+    std::vector<shelf>     m_shelves;
+    lookup_map             m_lookup;
+    int                    m_lruHead, m_lruTail, m_freeEntry;
+    std::vector<font_info> m_fonts;
+    PIMAGE                 m_scratch;
+    int                    m_scratchFont;
+    int                    m_lastFont;
+    ege_glyph_cache_stats  m_stats;
+};
+
+inline glyph_cache& glyph_cache_instance()
+{
+    static glyph_cache cache;
+    return cache;
+}
+
+inline std::wstring glyph_widen(const char* text)
+{
+    int          length = MultiByteToWideChar(getcodepage(), 0, text, -1, NULL, 0);
+    std::wstring wide(length > 0 ? length : 1, L'\0');
+    if (length > 0) {
+        MultiByteToWideChar(getcodepage(), 0, text, -1, &wide[0], length);
+    }
+    wide.resize(wcslen(wide.c_str()));
+    return wide;
+}
+
+inline int glyph_round(float v)
+{
+    return (int)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+} // namespace detail
+
+/**
+ * @brief Output text at the specified position through the glyph atlas cache
+ * @param x X coordinate of output position
+ * @param y Y coordinate of output position
+ * @param text Text to output
+ * @param pimg Target image pointer, NULL means current ege window
+ * @note Drawn left/top aligned with transparent background, see ege/glyph_cache.h
+ */
+inline void outtextxy_cached(int x, int y, const wchar_t* text, PIMAGE pimg = NULL)
+{
+    detail::glyph_cache_instance().draw(x, y, text, pimg);
+}
+
+/// @copydoc outtextxy_cached(int, int, const wchar_t*, PIMAGE)
+inline void outtextxy_cached(int x, int y, const char* text, PIMAGE pimg = NULL)
+{
+    detail::glyph_cache_instance().draw(x, y, detail::glyph_widen(text).c_str(), pimg);
+}
+
+/**
+ * @brief Output text at a floating-point position through the glyph atlas cache
+ * @param x X coordinate of output position, rounded to the nearest pixel
+ * @param y Y coordinate of output position, rounded to the nearest pixel
+ * @param text Text to output
+ * @param pimg Target image pointer, NULL means current ege window
+ * @note Glyphs are the GDI glyphs of outtextxy(), not the GDI+ rendering of ege_outtextxy()
+ */
+inline void ege_outtextxy_cached(float x, float y, const wchar_t* text, PIMAGE pimg = NULL)
+{
+    outtextxy_cached(detail::glyph_round(x), detail::glyph_round(y), text, pimg);
+}
+
+/// @copydoc ege_outtextxy_cached(float, float, const wchar_t*, PIMAGE)
+inline void ege_outtextxy_cached(float x, float y, const char* text, PIMAGE pimg = NULL)
+{
+    outtextxy_cached(detail::glyph_round(x), detail::glyph_round(y), text, pimg);
+}
+
+/**
+ * @brief Format and output text through the glyph atlas cache
+ * @param x X coordinate of output position
+ * @param y Y coordinate of output position
+ * @param format Format string (similar to printf)
+ * @param ... Variable argument list
+ */
+inline void xyprintf_cached(int x, int y, const char* format, ...)
+{
+    char    buffer[1024];
+    va_list args;
+    va_start(args, format);
+    _vsnprintf(buffer, sizeof(buffer) - 1, format, args);
+    va_end(args);
+    buffer[sizeof(buffer) - 1] = '\0';
+    outtextxy_cached(x, y, buffer);
+}
+
+/// @copydoc xyprintf_cached(int, int, const char*, ...)
+inline void xyprintf_cached(int x, int y, const wchar_t* format, ...)
+{
+    wchar_t buffer[1024];
+    va_list args;
+    va_start(args, format);
+    _vsnwprintf(buffer, sizeof(buffer) / sizeof(buffer[0]) - 1, format, args);
+    va_end(args);
+    buffer[sizeof(buffer) / sizeof(buffer[0]) - 1] = L'\0';
+    outtextxy_cached(x, y, buffer);
+}
+
+/**
+ * @brief Get the counters of the glyph atlas cache
+ * @param stats Receives hits, misses, evictions and memory use
+ */
+inline void ege_glyph_cache_get_stats(ege_glyph_cache_stats* stats)
+{
+    if (stats != NULL) {
+        detail::glyph_cache_instance().stats(stats);
+    }
+}
+
+/// @brief Reset the hit, miss and eviction counters of the glyph atlas cache
+inline void ege_glyph_cache_reset_stats()
+{
+    detail::glyph_cache_instance().resetStats();
+}
+
+/**
+ * @brief Set the memory limit of the glyph atlas
+ * @param bytes Maximum size of the atlas image in bytes, default is 4 MB; clears the cache
+ */
+inline void ege_glyph_cache_set_limit(size_t bytes)
+{
+    detail::glyph_cache_instance().setLimit(bytes);
+}
+
+/// @brief Drop every cached glyph and release the atlas
+inline void ege_glyph_cache_clear()
+{
+    detail::glyph_cache_instance().clear();
+}
+
+} // namespace ege
+
+#endif /* EGE_GLYPH_CACHE_H */
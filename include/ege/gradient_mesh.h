@@ -0,0 +1,128 @@
+/**
+ * @file gradient_mesh.h
+ * @brief Gouraud shaded triangle meshes, an indexed generalization of fillpoly_gradient
+ *
+ * fillmesh_gradient() fills a whole vertex/index buffer of colored triangles in one call, with
+ * the rasterizer and tile binning of ege/triangles.h. The four channels are interpolated as
+ * planes over each triangle and stepped in 16.16 fixed point along each span; with SSE2 the
+ * four channels of a pixel are stepped together in one register, with the same results as the
+ * scalar path.
+ */
+#ifndef EGE_GRADIENT_MESH_H
+#define EGE_GRADIENT_MESH_H
+
+#include "triangles.h"
+
+namespace ege
+{
+
+namespace detail
+{
+
+inline unsigned int gouraud_clamp(int v)
+{
+    v >>= 16;
+    return v < 0 ? 0 : (v > 255 ? 255 : (unsigned int)v);
+}
+
+/// Attributes 0-3 hold the B, G, R and A planes.
+inline void gouraud_span_scalar(const tri_job& job, const tri_setup& t, int y, int xa, int xb)
+{
+    int c[4], dc[4];
+    for (int k = 0; k < 4; ++k) {
+        c[k]  = rotate_fixed(t.attr[k][2] + t.attr[k][0] * xa + t.attr[k][1] * y) + 0x8000;
+        dc[k] = rotate_fixed(t.attr[k][0]);
+    }
+    color_t* d = job.dst + (size_t)y * job.dstStride;
+    for (int x = xa; x < xb; ++x) {
+        d[x] = gouraud_clamp(c[0]) | (gouraud_clamp(c[1]) << 8) | (gouraud_clamp(c[2]) << 16) | (gouraud_clamp(c[3]) << 24);
+        c[0] += dc[0];
+        c[1] += dc[1];
+        c[2] += dc[2];
+        c[3] += dc[3];
+    }
+}
+
+#ifdef EGE_SIMD_X86
+EGE_SIMD_TARGET("sse2")
+inline void gouraud_span_sse2(const tri_job& job, const tri_setup& t, int y, int xa, int xb)
+{
+    int c[4], dc[4];
+    for (int k = 0; k < 4; ++k) {
+        c[k]  = rotate_fixed(t.attr[k][2] + t.attr[k][0] * xa + t.attr[k][1] * y) + 0x8000;
+        dc[k] = rotate_fixed(t.attr[k][0]);
+    }
+    __m128i  v    = _mm_setr_epi32(c[0], c[1], c[2], c[3]);
+    __m128i  step = _mm_setr_epi32(dc[0], dc[1], dc[2], dc[3]);
+    color_t* d    = job.dst + (size_t)y * job.dstStride;
+    for (int x = xa; x < xb; ++x) {
+        // Arithmetic shift, then saturating packs clamp to 0-255 like gouraud_clamp().
+        __m128i p = _mm_srai_epi32(v, 16);
+        p         = _mm_packs_epi32(p, p);
+        d[x]      = (color_t)_mm_cvtsi128_si32(_mm_packus_epi16(p, p));
+        v         = _mm_add_epi32(v, step);
+    }
+}
+#endif
+
+} // namespace detail
+
+/**
+ * @brief Fill an indexed mesh of gradient (Gouraud shaded) triangles
+ * @param vertices Vertex array, position and color of each vertex
+ * @param indices Vertex indices, three per triangle; NULL fills vertices[0..3 * count) in order
+ * @param count Number of triangles
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if vertices is NULL
+ * @note Colors (alpha included) are written as they are, without blending. Like the other _f
+ *       functions the mesh is drawn in image coordinates, ignoring the viewport.
+ */
+inline int fillmesh_gradient(const ege_colpoint* vertices, const uint32_t* indices, int count, PIMAGE pimg = NULL)
+{
+    if (vertices == NULL && count > 0) {
+        return grNullPointer;
+    }
+
+    detail::tri_job job;
+    job.dst       = getbuffer(pimg);
+    job.dstW      = getwidth(pimg);
+    job.dstH      = getheight(pimg);
+    job.dstStride = job.dstW;
+    job.shader    = NULL;
+    job.span      = detail::gouraud_span_scalar;
+    if (job.dst == NULL) {
+        return grNullPointer;
+    }
+#ifdef EGE_SIMD_X86
+    if (ege_cpu_features() & CPU_FEATURE_SSE2) {
+        job.span = detail::gouraud_span_sse2;
+    }
+#endif
+
+    job.tris.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        float  xs[3], ys[3];
+        double attrs[3][detail::TRI_ATTRS];
+        for (int k = 0; k < 3; ++k) {
+            const ege_colpoint& v = vertices[indices != NULL ? indices[i * 3 + k] : (uint32_t)(i * 3 + k)];
+            xs[k] = v.x;
+            ys[k] = v.y;
+            for (int n = 0; n < 4; ++n) {
+                attrs[k][n] = (double)((v.color >> (n * 8)) & 0xFF);
+            }
+        }
+        detail::tri_setup t;
+        if (detail::tri_prepare(t, xs, ys, attrs, 4, job.dstW, job.dstH)) {
+            job.tris.push_back(t);
+        }
+    }
+
+    int x0, y0, x1, y1;
+    detail::tri_run(job, x0, y0, x1, y1);
+    detail::dirty_note(pimg, x0, y0, x1 - x0, y1 - y0);
+    return grOk;
+}
+
+} // namespace ege
+
+#endif /* EGE_GRADIENT_MESH_H */
@@ -0,0 +1,104 @@
+/**
+ * @file headless.h
+ * @brief Offscreen rendering without a window
+ *
+ * IMAGE objects can be created and drawn before initgraph() is called, so a batch renderer
+ * does not need a window at all. initgraph_headless() replaces initgraph() for such programs:
+ * it creates an offscreen IMAGE of the requested size and makes it the drawing target, so the
+ * drawing, text, path and saving functions called with a NULL image draw into it. No window,
+ * message thread or presentation thread is created.
+ *
+ * Functions that need the window (input, delay_fps(), is_run(), getHWnd()...) must not be used
+ * in a headless program.
+ *
+ * @code
+ * initgraph_headless(800, 600);
+ * setbkcolor(WHITE);
+ * cleardevice();
+ * setcolor(BLACK);
+ * outtextxy(10, 10, "chart");
+ * savepng(getheadlessimage(), "chart.png");
+ * closegraph_headless();
+ * @endcode
+ */
+#ifndef EGE_HEADLESS_H
+#define EGE_HEADLESS_H
+
+#include "../ege.h"
+
+namespace ege
+{
+
+namespace detail
+{
+
+inline PIMAGE& headless_image()
+{
+    static PIMAGE image = NULL;
+    return image;
+}
+
+} // namespace detail
+
+/**
+ * @brief Initialize offscreen rendering without creating a window
+ * @param width Width of the offscreen image (pixels)
+ * @param height Height of the offscreen image (pixels)
+ * @return grOk on success, grParamError for a non-positive size, grAllocError if the image cannot be created
+ * @note Calling it again resizes the offscreen image.
+ */
+inline int initgraph_headless(int width, int height)
+{
+    if (width <= 0 || height <= 0) {
+        return grParamError;
+    }
+    PIMAGE& image = detail::headless_image();
+    if (image == NULL) {
+        image = newimage(width, height);
+        if (image == NULL) {
+            return grAllocError;
+        }
+    } else if (resize(image, width, height) != grOk) {
+        return grAllocError;
+    }
+    settarget(image);
+    cleardevice(image);
+    return grOk;
+}
+
+/**
+ * @brief Release the offscreen image created by initgraph_headless()
+ */
+inline void closegraph_headless()
+{
+    PIMAGE& image = detail::headless_image();
+    if (image != NULL) {
+        if (gettarget() == image) {
+            settarget(NULL);
+        }
+        delimage(image);
+        image = NULL;
+    }
+}
+
+/**
+ * @brief Get the offscreen image of headless mode
+ * @return The image created by initgraph_headless(), NULL when not in headless mode
+ */
+inline PIMAGE getheadlessimage()
+{
+    return detail::headless_image();
+}
+
+/**
+ * @brief Check whether the program renders headless
+ * @return true between initgraph_headless() and closegraph_headless()
+ */
+inline bool is_headless()
+{
+    return detail::headless_image() != NULL;
+}
+
+} // namespace ege
+
+#endif /* EGE_HEADLESS_H */
@@ -0,0 +1,407 @@
+/**
+ * @file image_async.h
+ * @brief Asynchronous image loading on a bounded decode thread pool
+ *
+ * getimage_async() queues a file for decoding and returns at once. A small pool of loader
+ * threads reads and decodes the files and premultiplies the pixels (see ege/image_codec.h);
+ * the image object itself is only touched by the hand-off, which resizes it and copies the
+ * pixels in. The hand-off runs on the drawing thread, in ege_load_poll(), ege_load_wait() or
+ * ege_load_dispatch(), and calls the completion callback right after it.
+ *
+ * A typical level loader queues every texture, closes the handles it does not need, and calls
+ * ege_load_dispatch() once per frame until everything has arrived.
+ */
+#ifndef EGE_IMAGE_ASYNC_H
+#define EGE_IMAGE_ASYNC_H
+
+#include "image_codec.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+namespace ege
+{
+
+/**
+ * @brief Called on the drawing thread once a load has been handed off to its image
+ * @param pimg Image passed to getimage_async()
+ * @param result grOk, grFileNotFound, grInvalidFileFormat or grAllocError; pimg is unchanged on error
+ * @param user User pointer passed to getimage_async()
+ */
+typedef void (*ege_load_callback)(PIMAGE pimg, int result, void* user);
+
+/// Pending image load, owned by the loader; see getimage_async()
+struct ege_load_task
+{
+    PIMAGE               pimg;
+    std::wstring         file;
+    ege_load_callback    callback;
+    void*                user;
+    std::vector<color_t> pixels;
+    int                  width, height;
+    int                  result;
+    volatile LONG        state;     ///< One of detail::load_state
+    bool                 closed;    ///< Free after hand-off, the handle is gone
+    HANDLE               decoded;   ///< Signaled when the worker is done with the task
+};
+
+/// Handle returned by getimage_async()
+typedef ege_load_task* ege_load_handle;
+
+namespace detail
+{
+
+enum load_state
+{
+    LOAD_QUEUED,
+    LOAD_DECODING,
+    LOAD_DECODED,
+    LOAD_DELIVERED  ///< Handed off or cancelled
+};
+
+inline void load_decode(ege_load_task* task)
+{
+    task->result = codec_decode_file(task->file.c_str(), task->pixels, task->width, task->height);
+    InterlockedExchange(&task->state, LOAD_DECODED);
+    SetEvent(task->decoded);
+}
+
+class image_loader
+{
+public:
+    image_loader() : m_threads(0), m_quit(0)
+    {
+        InitializeCriticalSection(&m_lock);
+        m_wake = CreateSemaphoreW(NULL, 0, 0x7FFFFFFF, NULL);
+    }
+
+    ~image_loader()
+    {
+        stop(false);
+        CloseHandle(m_wake);
+        DeleteCriticalSection(&m_lock);
+    }
+
+    int threads()
+    {
+        if (m_threads == 0) {
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            int n     = (int)info.dwNumberOfProcessors - 1;
+            m_threads = n < 1 ? 1 : (n > 4 ? 4 : n);
+        }
+        return m_threads;
+    }
+
+    void setThreads(int threads)
+    {
+        stop(true);
+        m_threads = threads < 1 ? 0 : (threads > 16 ? 16 : threads);
+    }
+
+    ege_load_task* submit(PIMAGE pimg, const wchar_t* file, ege_load_callback callback, void* user)
+    {
+        ege_load_task* task = new ege_load_task;
+        task->pimg          = pimg;
+        task->file          = file;
+        task->callback      = callback;
+        task->user          = user;
+        task->width         = 0;
+        task->height        = 0;
+        task->result        = grError;
+        task->state         = LOAD_QUEUED;
+        task->closed        = false;
+        task->decoded       = CreateEventW(NULL, TRUE, FALSE, NULL);
+        m_pending.push_back(task);
+
+        start();
+        EnterCriticalSection(&m_lock);
+        m_queue.push_back(task);
+        LeaveCriticalSection(&m_lock);
+        ReleaseSemaphore(m_wake, 1, NULL);
+        return task;
+    }
+
+    /// Hand a decoded task off to its image; true once the task is delivered.
+    bool deliver(ege_load_task* task)
+    {
+        if (task->state == LOAD_DELIVERED) {
+            return true;
+        }
+        if (task->state != LOAD_DECODED) {
+            return false;
+        }
+        if (task->result == grOk) {
+            task->result = codec_store(task->pimg, task->pixels, task->width, task->height);
+        }
+        std::vector<color_t>().swap(task->pixels);
+        task->state = LOAD_DELIVERED;
+        m_pending.erase(std::find(m_pending.begin(), m_pending.end(), task));
+        if (task->callback != NULL) {
+            task->callback(task->pimg, task->result, task->user);
+        }
+        return true;
+    }
+
+    int wait(ege_load_task* task)
+    {
+        // A task nobody has picked up yet is decoded right here instead of waiting for a worker.
+        if (unqueue(task)) {
+            task->state = LOAD_DECODING;
+            load_decode(task);
+        }
+        WaitForSingleObject(task->decoded, INFINITE);
+        deliver(task);
+        return task->result;
+    }
+
+    bool cancel(ege_load_task* task)
+    {
+        if (!unqueue(task)) {
+            return false;
+        }
+        task->result = grError;
+        task->state  = LOAD_DELIVERED;
+        SetEvent(task->decoded);
+        m_pending.erase(std::find(m_pending.begin(), m_pending.end(), task));
+        return true;
+    }
+
+    void close(ege_load_task* task)
+    {
+        task->closed = true;
+        if (task->state == LOAD_DELIVERED) {
+            release(task);
+        }
+    }
+
+    int dispatch()
+    {
+        int delivered = 0;
+        // deliver() removes entries and callbacks may submit new ones, so work on a copy.
+        std::vector<ege_load_task*> pending(m_pending);
+        for (size_t i = 0; i < pending.size(); ++i) {
+            ege_load_task* task = pending[i];
+            if (task->state == LOAD_DECODED && deliver(task)) {
+                ++delivered;
+                if (task->closed) {
+                    release(task);
+                }
+            }
+        }
+        return delivered;
+    }
+
+private:
+    image_loader(const image_loader&);
+    image_loader& operator=(const image_loader&);
+
+    static void release(ege_load_task* task)
+    {
+        CloseHandle(task->decoded);
+        delete task;
+    }
+
+    bool unqueue(ege_load_task* task)
+    {
+        EnterCriticalSection(&m_lock);
+        std::deque<ege_load_task*>::iterator it    = std::find(m_queue.begin(), m_queue.end(), task);
+        bool                                 found = it != m_queue.end();
+        if (found) {
+            m_queue.erase(it);
+        }
+        LeaveCriticalSection(&m_lock);
+        return found;
+    }
+
+    static DWORD WINAPI threadProc(LPVOID param)
+    {
+        image_loader* self = (image_loader*)param;
+        for (;;) {
+            WaitForSingleObject(self->m_wake, INFINITE);
+            EnterCriticalSection(&self->m_lock);
+            if (self->m_quit) {
+                LeaveCriticalSection(&self->m_lock);
+                return 0;
+            }
+            // The queue may be empty when the task was cancelled or taken by wait().
+            ege_load_task* task = NULL;
+            if (!self->m_queue.empty()) {
+                task = self->m_queue.front();
+                self->m_queue.pop_front();
+                task->state = LOAD_DECODING;
+            }
+            LeaveCriticalSection(&self->m_lock);
+            if (task != NULL) {
+                load_decode(task);
+            }
+        }
+    }
+
+    void start()
+    {
+        if (!m_workers.empty()) {
+            return;
+        }
+        // Start GDI+ here rather than racing to do it from the workers.
+        codec_startup();
+        for (int i = 0; i < threads(); ++i) {
+            HANDLE thread = CreateThread(NULL, 0, threadProc, this, 0, NULL);
+            if (thread == NULL) {
+                break;
+            }
+            m_workers.push_back(thread);
+        }
+    }
+
+    /// End the workers, decoding the queued tasks first if finish is set.
+    void stop(bool finish)
+    {
+        if (m_workers.empty()) {
+            return;
+        }
+        EnterCriticalSection(&m_lock);
+        while (finish && !m_queue.empty()) {
+            ege_load_task* task = m_queue.front();
+            m_queue.pop_front();
+            LeaveCriticalSection(&m_lock);
+            task->state = LOAD_DECODING;
+            load_decode(task);
+            EnterCriticalSection(&m_lock);
+        }
+        m_quit = 1;
+        LeaveCriticalSection(&m_lock);
+        ReleaseSemaphore(m_wake, (LONG)m_workers.size(), NULL);
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            WaitForSingleObject(m_workers[i], INFINITE);
+            CloseHandle(m_workers[i]);
+        }
+        m_workers.clear();
+        m_quit = 0;
+    }
+
+    int                         m_threads;
+    std::vector<HANDLE>         m_workers;
+    HANDLE                      m_wake;
+    CRITICAL_SECTION            m_lock;
+    std::deque<ege_load_task*>  m_queue;
+    std::vector<ege_load_task*> m_pending;  ///< Not yet delivered; drawing thread only
+    volatile LONG               m_quit;
+};
+
+inline image_loader& image_loader_instance()
+{
+    static image_loader loader;
+    return loader;
+}
+
+} // namespace detail
+
+/**
+ * @brief Load an image file in the background
+ * @param pimg Image receiving the file; it is resized to the image size on hand-off
+ * @param file Image file name (PNG, BMP, JPG, GIF, TIFF, ICO)
+ * @param callback Called on hand-off, may be NULL
+ * @param user Passed to callback
+ * @return Handle for ege_load_poll(), ege_load_wait() and ege_load_cancel(), to be released with
+ *         ege_load_close(); NULL if pimg or file is NULL
+ * @note pimg must stay alive until the load is delivered or cancelled. Functions of this
+ *       group must be called from the drawing thread.
+ */
+inline ege_load_handle getimage_async(PIMAGE pimg, const wchar_t* file, ege_load_callback callback = NULL,
+    void* user = NULL)
+{
+    if (pimg == NULL || file == NULL) {
+        return NULL;
+    }
+    return detail::image_loader_instance().submit(pimg, file, callback, user);
+}
+
+/**
+ * @brief Check whether a load has finished, handing it off to its image if it has
+ * @param handle Handle from getimage_async()
+ * @param result Receives the result code once finished, may be NULL
+ * @return true once the image has been handed off or the load was cancelled
+ */
+inline bool ege_load_poll(ege_load_handle handle, int* result = NULL)
+{
+    if (handle == NULL || !detail::image_loader_instance().deliver(handle)) {
+        return false;
+    }
+    if (result != NULL) {
+        *result = handle->result;
+    }
+    return true;
+}
+
+/**
+ * @brief Wait for a load to finish and hand it off to its image
+ * @param handle Handle from getimage_async()
+ * @return grOk on success, grFileNotFound, grInvalidFileFormat or grAllocError on failure,
+ *         grError if the load was cancelled, grNullPointer if handle is NULL
+ * @note A load still waiting in the queue is decoded on the calling thread.
+ */
+inline int ege_load_wait(ege_load_handle handle)
+{
+    if (handle == NULL) {
+        return grNullPointer;
+    }
+    return detail::image_loader_instance().wait(handle);
+}
+
+/**
+ * @brief Cancel a load that has not started decoding yet
+ * @param handle Handle from getimage_async()
+ * @return true if the load was removed from the queue; its callback is not called
+ */
+inline bool ege_load_cancel(ege_load_handle handle)
+{
+    return handle != NULL && detail::image_loader_instance().cancel(handle);
+}
+
+/**
+ * @brief Release a load handle
+ * @param handle Handle from getimage_async(), invalid afterwards; NULL is ignored
+ * @note A load that is still running carries on and is handed off by ege_load_dispatch().
+ */
+inline void ege_load_close(ege_load_handle handle)
+{
+    if (handle != NULL) {
+        detail::image_loader_instance().close(handle);
+    }
+}
+
+/**
+ * @brief Hand off every finished load to its image and call the callbacks
+ * @return Number of loads handed off
+ * @note Call it regularly, e.g. once per frame, while loads are in flight.
+ */
+inline int ege_load_dispatch()
+{
+    return detail::image_loader_instance().dispatch();
+}
+
+/**
+ * @brief Set the number of loader threads
+ * @param threads Thread count, at most 16; 0 or a negative value picks one per processor minus one,
+ *        at most 4 (the default)
+ * @note Queued loads are finished on the calling thread before the pool is restarted.
+ */
+inline void ege_set_load_threads(int threads)
+{
+    detail::image_loader_instance().setThreads(threads);
+}
+
+/**
+ * @brief Get the number of loader threads
+ * @return Thread count of the loader pool
+ */
+inline int ege_get_load_threads()
+{
+    return detail::image_loader_instance().threads();
+}
+
+} // namespace ege
+
+#endif /* EGE_IMAGE_ASYNC_H */
@@ -0,0 +1,346 @@
+/**
+ * @file image_codec.h
+ * @brief Image decoding and encoding through GDI+, from files and memory buffers
+ *
+ * getimage() decodes straight into an IMAGE object, which must only be touched by the thread
+ * that draws with it. The helpers here decode with GDI+ into a std::vector of premultiplied
+ * COLORTYPE_PRGB32 pixels instead, so the work can run on any thread; codec_store() then hands
+ * the result to an image in a single resize and copy.
+ *
+ * getimage_frommemory() and saveimage_tomemory() connect GDI+ to memory through a small IStream
+ * over the caller's buffer: the encoded data is read in place and the encoder reads the image
+ * buffer directly. Decoded pixels go to a temporary buffer first and are copied into the image
+ * only once decoding succeeded, so a failed decode leaves the image untouched.
+ *
+ * GDI+ is started on first use and stays up until the process exits.
+ */
+#ifndef EGE_IMAGE_CODEC_H
+#define EGE_IMAGE_CODEC_H
+
+#include "blend.h"
+
+#include <objidl.h>
+#include <gdiplus.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+namespace ege
+{
+
+namespace detail
+{
+
+/// Start GDI+ once; safe to call from any thread.
+inline bool codec_startup()
+{
+    static volatile LONG state = 0;  // 0: not started, 1: starting, 2: started, 3: failed
+    if (InterlockedCompareExchange(&state, 1, 0) == 0) {
+        static ULONG_PTR             token = 0;
+        Gdiplus::GdiplusStartupInput input;
+        InterlockedExchange(&state, Gdiplus::GdiplusStartup(&token, &input, NULL) == Gdiplus::Ok ? 2 : 3);
+    }
+    while (state == 1) {
+        SwitchToThread();
+    }
+    return state == 2;
+}
+
+inline int codec_size(Gdiplus::GpBitmap* bitmap, int& width, int& height)
+{
+    UINT w = 0, h = 0;
+    Gdiplus::DllExports::GdipGetImageWidth((Gdiplus::GpImage*)bitmap, &w);
+    Gdiplus::DllExports::GdipGetImageHeight((Gdiplus::GpImage*)bitmap, &h);
+    if (w == 0 || h == 0 || w > 0x7FFF || h > 0x7FFF) {
+        return grInvalidFileFormat;
+    }
+    width  = (int)w;
+    height = (int)h;
+    return grOk;
+}
+
+/// Decode a width x height bitmap straight into packed dst and premultiply it there.
+inline int codec_read_into(Gdiplus::GpBitmap* bitmap, color_t* dst, int width, int height)
+{
+    Gdiplus::Rect       rect(0, 0, width, height);
+    Gdiplus::BitmapData data;
+    data.Width       = (UINT)width;
+    data.Height      = (UINT)height;
+    data.Stride      = width * (INT)sizeof(color_t);
+    data.PixelFormat = PixelFormat32bppARGB;
+    data.Scan0       = dst;
+    data.Reserved    = 0;
+    if (Gdiplus::DllExports::GdipBitmapLockBits(bitmap, &rect, Gdiplus::ImageLockModeRead | Gdiplus::ImageLockModeUserInputBuf,
+            PixelFormat32bppARGB, &data) != Gdiplus::Ok) {
+        return grInvalidFileFormat;
+    }
+    Gdiplus::DllExports::GdipBitmapUnlockBits(bitmap, &data);
+
+    for (size_t i = 0, n = (size_t)width * height; i < n; ++i) {
+        color_t      c = dst[i];
+        unsigned int a = c >> 24;
+        if (a != 255) {
+            dst[i] = (a << 24) | (blend_mul255((c >> 16) & 0xFF, a) << 16) | (blend_mul255((c >> 8) & 0xFF, a) << 8)
+                     | blend_mul255(c & 0xFF, a);
+        }
+    }
+    return grOk;
+}
+
+/// Copy a decoded bitmap into premultiplied pixels.
+inline int codec_read_bitmap(Gdiplus::GpBitmap* bitmap, std::vector<color_t>& pixels, int& width, int& height)
+{
+    int ret = codec_size(bitmap, width, height);
+    if (ret != grOk) {
+        return ret;
+    }
+    pixels.resize((size_t)width * height);
+    return codec_read_into(bitmap, &pixels[0], width, height);
+}
+
+/// Decode an image file (PNG, BMP, JPG, GIF, TIFF, ICO) into premultiplied pixels.
+inline int codec_decode_file(const wchar_t* file, std::vector<color_t>& pixels, int& width, int& height)
+{
+    if (GetFileAttributesW(file) == INVALID_FILE_ATTRIBUTES) {
+        return grFileNotFound;
+    }
+    if (!codec_startup()) {
+        return grError;
+    }
+    Gdiplus::GpBitmap* bitmap = NULL;
+    if (Gdiplus::DllExports::GdipCreateBitmapFromFile(file, &bitmap) != Gdiplus::Ok || bitmap == NULL) {
+        return grInvalidFileFormat;
+    }
+    int ret = codec_read_bitmap(bitmap, pixels, width, height);
+    Gdiplus::DllExports::GdipDisposeImage((Gdiplus::GpImage*)bitmap);
+    return ret;
+}
+
+/// Resize pimg to width x height and copy the decoded pixels into it.
+inline int codec_store(PIMAGE pimg, const std::vector<color_t>& pixels, int width, int height)
+{
+    if (resize_f(pimg, width, height) != 0) {
+        return grAllocError;
+    }
+    color_t* buf = getbuffer(pimg);
+    if (buf == NULL || getwidth(pimg) != width || getheight(pimg) != height) {
+        return grAllocError;
+    }
+    memcpy(buf, &pixels[0], pixels.size() * sizeof(color_t));
+    return grOk;
+}
+
+/**
+ * IStream over memory: reads from a fixed buffer, or writes to a growing vector. It lives on the
+ * stack of its user, so reference counting only keeps COM happy.
+ */
+class codec_stream : public IStream
+{
+public:
+    codec_stream(const void* data, size_t size) : m_data((const BYTE*)data), m_size(size), m_out(NULL), m_pos(0) {}
+
+    explicit codec_stream(std::vector<uint8_t>& out) : m_data(NULL), m_size(0), m_out(&out), m_pos(0) {}
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object)
+    {
+        if (object == NULL) {
+            return E_POINTER;
+        }
+        if (riid == IID_IUnknown || riid == IID_ISequentialStream || riid == IID_IStream) {
+            *object = this;
+            return S_OK;
+        }
+        *object = NULL;
+        return E_NOINTERFACE;
+    }
+
+    ULONG STDMETHODCALLTYPE AddRef() { return 1; }
+    ULONG STDMETHODCALLTYPE Release() { return 1; }
+
+    HRESULT STDMETHODCALLTYPE Read(void* buffer, ULONG count, ULONG* read)
+    {
+        size_t size = this->size(), n = m_pos < size ? size - m_pos : 0;
+        n           = n < count ? n : count;
+        if (n > 0) {
+            memcpy(buffer, (m_out != NULL ? &(*m_out)[0] : m_data) + m_pos, n);
+        }
+        m_pos += n;
+        if (read != NULL) {
+            *read = (ULONG)n;
+        }
+        return n == count ? S_OK : S_FALSE;
+    }
+
+    HRESULT STDMETHODCALLTYPE Write(const void* buffer, ULONG count, ULONG* written)
+    {
+        if (m_out == NULL) {
+            return STG_E_ACCESSDENIED;
+        }
+        if (m_pos + count > m_out->size()) {
+            m_out->resize(m_pos + count);
+        }
+        if (count > 0) {
+            memcpy(&(*m_out)[m_pos], buffer, count);
+        }
+        m_pos += count;
+        if (written != NULL) {
+            *written = count;
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Seek(LARGE_INTEGER move, DWORD origin, ULARGE_INTEGER* position)
+    {
+        LONGLONG base = origin == STREAM_SEEK_SET ? 0 : (origin == STREAM_SEEK_CUR ? (LONGLONG)m_pos : (LONGLONG)size());
+        if (origin > STREAM_SEEK_END || base + move.QuadPart < 0) {
+            return STG_E_INVALIDFUNCTION;
+        }
+        m_pos = (size_t)(base + move.QuadPart);
+        if (position != NULL) {
+            position->QuadPart = m_pos;
+        }
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetSize(ULARGE_INTEGER size)
+    {
+        if (m_out == NULL) {
+            return STG_E_ACCESSDENIED;
+        }
+        m_out->resize((size_t)size.QuadPart);
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE CopyTo(IStream*, ULARGE_INTEGER, ULARGE_INTEGER*, ULARGE_INTEGER*) { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE Commit(DWORD) { return S_OK; }
+    HRESULT STDMETHODCALLTYPE Revert() { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) { return E_NOTIMPL; }
+    HRESULT STDMETHODCALLTYPE UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) { return E_NOTIMPL; }
+
+    HRESULT STDMETHODCALLTYPE Stat(STATSTG* stat, DWORD)
+    {
+        if (stat == NULL) {
+            return E_POINTER;
+        }
+        memset(stat, 0, sizeof(*stat));
+        stat->type            = STGTY_STREAM;
+        stat->cbSize.QuadPart = size();
+        return S_OK;
+    }
+
+    HRESULT STDMETHODCALLTYPE Clone(IStream**) { return E_NOTIMPL; }
+
+private:
+    size_t size() const { return m_out != NULL ? m_out->size() : m_size; }
+
+    const BYTE*           m_data;
+    size_t                m_size;
+    std::vector<uint8_t>* m_out;
+    size_t                m_pos;
+};
+
+/// Find the GDI+ encoder for a MIME type.
+inline bool codec_encoder(const wchar_t* mime, CLSID* clsid)
+{
+    UINT count = 0, bytes = 0;
+    if (Gdiplus::DllExports::GdipGetImageEncodersSize(&count, &bytes) != Gdiplus::Ok || bytes == 0) {
+        return false;
+    }
+    std::vector<BYTE>        buffer(bytes);
+    Gdiplus::ImageCodecInfo* codecs = (Gdiplus::ImageCodecInfo*)&buffer[0];
+    if (Gdiplus::DllExports::GdipGetImageEncoders(count, bytes, codecs) != Gdiplus::Ok) {
+        return false;
+    }
+    for (UINT i = 0; i < count; ++i) {
+        if (wcscmp(codecs[i].MimeType, mime) == 0) {
+            *clsid = codecs[i].Clsid;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace detail
+
+/**
+ * @enum image_format
+ * @brief Encoded image formats for saveimage_tomemory()
+ */
+enum image_format
+{
+    IMAGEFORMAT_PNG  = 0,   ///< PNG, lossless, keeps the alpha channel if asked to
+    IMAGEFORMAT_BMP  = 1,   ///< Windows bitmap
+    IMAGEFORMAT_JPEG = 2,   ///< JPEG, lossy, no alpha channel
+    IMAGEFORMAT_GIF  = 3,   ///< GIF, 256 colors
+    IMAGEFORMAT_TIFF = 4    ///< TIFF
+};
+
+/**
+ * @brief Decode an image from a memory buffer
+ * @param pimg Image receiving the pixels, resized to the image size
+ * @param data Encoded image (PNG, BMP, JPG, GIF, TIFF, ICO), read in place
+ * @param size Size of data in bytes
+ * @return grOk on success, grNullPointer if pimg or data is NULL, grInvalidFileFormat if the data
+ *         cannot be decoded, grAllocError if pimg cannot be resized; pimg is unchanged on error
+ */
+inline int getimage_frommemory(PIMAGE pimg, const void* data, size_t size)
+{
+    if (pimg == NULL || data == NULL) {
+        return grNullPointer;
+    }
+    if (!detail::codec_startup()) {
+        return grError;
+    }
+    detail::codec_stream stream(data, size);
+    Gdiplus::GpBitmap*   bitmap = NULL;
+    if (Gdiplus::DllExports::GdipCreateBitmapFromStream(&stream, &bitmap) != Gdiplus::Ok || bitmap == NULL) {
+        return grInvalidFileFormat;
+    }
+    // Decode into a temporary buffer first, so pimg is only touched once decoding succeeded.
+    std::vector<color_t> pixels;
+    int                  width = 0, height = 0;
+    int                  ret   = detail::codec_read_bitmap(bitmap, pixels, width, height);
+    Gdiplus::DllExports::GdipDisposeImage((Gdiplus::GpImage*)bitmap);
+    return ret == grOk ? detail::codec_store(pimg, pixels, width, height) : ret;
+}
+
+/**
+ * @brief Encode an image into a memory buffer
+ * @param pimg Image to encode, NULL means current ege window
+ * @param format Encoded format
+ * @param out Receives the encoded image, replacing its previous content
+ * @param withAlphaChannel Whether to keep the alpha channel (PNG, TIFF), default is false
+ * @return grOk on success, grNullPointer if the image has no buffer, grUnsupportedFormat if the
+ *         format has no encoder, grError if encoding failed
+ */
+inline int saveimage_tomemory(PCIMAGE pimg, image_format format, std::vector<uint8_t>& out, bool withAlphaChannel = false)
+{
+    static const wchar_t* const mimes[] = {L"image/png", L"image/bmp", L"image/jpeg", L"image/gif", L"image/tiff"};
+
+    const color_t* buf = getbuffer(pimg);
+    if (buf == NULL) {
+        return grNullPointer;
+    }
+    CLSID clsid;
+    if ((unsigned)format >= sizeof(mimes) / sizeof(mimes[0]) || !detail::codec_startup()
+        || !detail::codec_encoder(mimes[format], &clsid)) {
+        return grUnsupportedFormat;
+    }
+    // The bitmap wraps the image buffer itself; encoders only read from it.
+    int                width = getwidth(pimg), height = getheight(pimg);
+    Gdiplus::GpBitmap* bitmap = NULL;
+    if (Gdiplus::DllExports::GdipCreateBitmapFromScan0(width, height, width * (INT)sizeof(color_t),
+            withAlphaChannel ? PixelFormat32bppPARGB : PixelFormat32bppRGB, (BYTE*)buf, &bitmap) != Gdiplus::Ok) {
+        return grError;
+    }
+    out.clear();
+    detail::codec_stream stream(out);
+    Gdiplus::GpStatus    status = Gdiplus::DllExports::GdipSaveImageToStream((Gdiplus::GpImage*)bitmap, &stream, &clsid, NULL);
+    Gdiplus::DllExports::GdipDisposeImage((Gdiplus::GpImage*)bitmap);
+    return status == Gdiplus::Ok ? grOk : grError;
+}
+
+} // namespace ege
+
+#endif /* EGE_IMAGE_CODEC_H */
@@ -0,0 +1,357 @@
+/**
+ * @file image_png.h
+ * @brief PNG saving with a compression level, a filter strategy and multithreaded compression
+ *
+ * savepng() filters and compresses the whole image as one stream on one thread. savepng_ex()
+ * splits the rows into bands of about 256 KiB that are filtered and compressed at the same
+ * time on the worker pool (see ege_set_worker_threads() in ege/parallel.h), using the encoder
+ * of ege/deflate.h. Every band may refer back into the rows before it, and the bands are
+ * stitched into the single zlib stream PNG requires, each in its own IDAT chunk. The file does
+ * not depend on the number of threads.
+ */
+#ifndef EGE_IMAGE_PNG_H
+#define EGE_IMAGE_PNG_H
+
+#include "deflate.h"
+#include "parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+namespace ege
+{
+
+/**
+ * @enum png_filter_type
+ * @brief Row filter applied before compression
+ */
+enum png_filter_type
+{
+    PNG_FILTER_NONE     = 0,
+    PNG_FILTER_SUB      = 1,    ///< Difference to the pixel on the left
+    PNG_FILTER_UP       = 2,    ///< Difference to the pixel above
+    PNG_FILTER_AVERAGE  = 3,    ///< Difference to the average of left and above
+    PNG_FILTER_PAETH    = 4,    ///< Difference to the Paeth predictor of left, above and upper left
+    PNG_FILTER_ADAPTIVE = 5     ///< Per row, the filter with the smallest sum of absolute differences
+};
+
+/**
+ * @struct ege_png_options
+ * @brief Options of savepng_ex()
+ */
+struct ege_png_options
+{
+    int             level;              ///< Compression level from 0 (fastest) to 8 (smallest), as for ege_compress2()
+    png_filter_type filter;             ///< Row filter
+    bool            withAlphaChannel;   ///< Save the alpha channel (RGBA) rather than RGB
+};
+
+/**
+ * @brief Get the default options of savepng_ex()
+ * @return Level 5, PNG_FILTER_ADAPTIVE, without alpha channel
+ */
+inline ege_png_options ege_png_default_options()
+{
+    ege_png_options options;
+    options.level            = detail::DEFLATE_LEVEL_DEFAULT;
+    options.filter           = PNG_FILTER_ADAPTIVE;
+    options.withAlphaChannel = false;
+    return options;
+}
+
+namespace detail
+{
+
+const size_t PNG_BAND_BYTES = 256 * 1024;
+
+struct png_job
+{
+    const color_t*                     src;
+    int                                width, height;
+    int                                channels;
+    size_t                             rowBytes;   ///< Filter type byte and pixel bytes
+    int                                bandRows, bands;
+    ege_png_options                    options;
+    std::vector<uint8_t>               filtered;
+    std::vector<std::vector<uint8_t> > parts;      ///< Compressed bands; the first one starts with the zlib header
+    std::vector<uint32_t>              adler;      ///< Adler-32 of the filtered bytes of each band
+    std::vector<uint32_t>              crc;        ///< CRC-32 of the IDAT chunk of each band, without the adler trailer
+};
+
+/// Convert a premultiplied row to straight RGB or RGBA bytes.
+inline void png_convert_row(const color_t* src, int width, int channels, uint8_t* dst)
+{
+    for (int x = 0; x < width; ++x, dst += channels) {
+        color_t      c = src[x];
+        unsigned int a = c >> 24, r = (c >> 16) & 0xFF, g = (c >> 8) & 0xFF, b = c & 0xFF;
+        if (channels == 4) {
+            if (a == 0) {
+                r = g = b = 0;
+            } else if (a != 255) {
+                r = (r * 255 + a / 2) / a;
+                g = (g * 255 + a / 2) / a;
+                b = (b * 255 + a / 2) / a;
+                r = r > 255 ? 255 : r;
+                g = g > 255 ? 255 : g;
+                b = b > 255 ? 255 : b;
+            }
+            dst[3] = (uint8_t)a;
+        }
+        dst[0] = (uint8_t)r;
+        dst[1] = (uint8_t)g;
+        dst[2] = (uint8_t)b;
+    }
+}
+
+inline int png_paeth(int a, int b, int c)
+{
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+}
+
+/// Filter n bytes of cur against the previous row.
+inline void png_filter_row(int type, const uint8_t* cur, const uint8_t* prev, int n, int bpp, uint8_t* out)
+{
+    int i = 0;
+    switch (type) {
+    case PNG_FILTER_SUB:
+        for (; i < bpp; ++i) {
+            out[i] = cur[i];
+        }
+        for (; i < n; ++i) {
+            out[i] = (uint8_t)(cur[i] - cur[i - bpp]);
+        }
+        break;
+    case PNG_FILTER_UP:
+        for (; i < n; ++i) {
+            out[i] = (uint8_t)(cur[i] - prev[i]);
+        }
+        break;
+    case PNG_FILTER_AVERAGE:
+        for (; i < bpp; ++i) {
+            out[i] = (uint8_t)(cur[i] - (prev[i] >> 1));
+        }
+        for (; i < n; ++i) {
+            out[i] = (uint8_t)(cur[i] - ((cur[i - bpp] + prev[i]) >> 1));
+        }
+        break;
+    case PNG_FILTER_PAETH:
+        for (; i < bpp; ++i) {
+            out[i] = (uint8_t)(cur[i] - prev[i]);
+        }
+        for (; i < n; ++i) {
+            out[i] = (uint8_t)(cur[i] - png_paeth(cur[i - bpp], prev[i], prev[i - bpp]));
+        }
+        break;
+    default:
+        memcpy(out, cur, n);
+        break;
+    }
+}
+
+/**
+ * Sum of the absolute values of the filtered bytes taken as signed, the usual estimate of how
+ * well a row compresses. Counting stops once the sum exceeds limit.
+ */
+inline unsigned int png_filter_cost(const uint8_t* row, int n, unsigned int limit)
+{
+    unsigned int sum = 0;
+    for (int i = 0; i < n && sum <= limit; i += 256) {
+        for (int k = i, end = i + 256 < n ? i + 256 : n; k < end; ++k) {
+            int v = (signed char)row[k];
+            sum  += v < 0 ? -v : v;
+        }
+    }
+    return sum;
+}
+
+inline void png_filter_band(void* context, int band)
+{
+    png_job&             job = *(png_job*)context;
+    int                  n = (int)job.rowBytes - 1, y0 = band * job.bandRows;
+    int                  y1 = y0 + job.bandRows < job.height ? y0 + job.bandRows : job.height;
+    std::vector<uint8_t> rows(2 * (size_t)n), trial(job.options.filter == PNG_FILTER_ADAPTIVE ? (size_t)n : 0);
+    uint8_t *            cur = &rows[0], *prev = &rows[n];
+    if (y0 > 0) {
+        png_convert_row(job.src + (size_t)(y0 - 1) * job.width, job.width, job.channels, prev);
+    }
+    for (int y = y0; y < y1; ++y) {
+        png_convert_row(job.src + (size_t)y * job.width, job.width, job.channels, cur);
+        uint8_t* out  = &job.filtered[(size_t)y * job.rowBytes];
+        int      type = job.options.filter;
+        if (type == PNG_FILTER_ADAPTIVE) {
+            png_filter_row(PNG_FILTER_NONE, cur, prev, n, job.channels, out + 1);
+            unsigned int best = png_filter_cost(out + 1, n, ~0u);
+            type              = PNG_FILTER_NONE;
+            for (int t = PNG_FILTER_SUB; t <= PNG_FILTER_PAETH; ++t) {
+                png_filter_row(t, cur, prev, n, job.channels, &trial[0]);
+                unsigned int sum = png_filter_cost(&trial[0], n, best);
+                if (sum < best) {
+                    best = sum;
+                    type = t;
+                    memcpy(out + 1, &trial[0], n);
+                }
+            }
+        } else {
+            png_filter_row(type, cur, prev, n, job.channels, out + 1);
+        }
+        out[0] = (uint8_t)type;
+        std::swap(cur, prev);
+    }
+}
+
+inline void png_compress_band(void* context, int band)
+{
+    png_job&             job   = *(png_job*)context;
+    std::vector<uint8_t>& part = job.parts[band];
+    size_t               begin = (size_t)band * job.bandRows * job.rowBytes;
+    size_t               end   = band == job.bands - 1 ? job.filtered.size() : begin + job.bandRows * job.rowBytes;
+    if (band == 0) {
+        part.push_back(0x78);
+        part.push_back(job.options.level < 2 ? 0x01 : (job.options.level < 6 ? 0x9C : 0xDA));
+    }
+    deflate_encoder encoder(job.options.level);
+    deflate_bits    bits(part);
+    encoder.compress(bits, &job.filtered[0], begin, end, band == job.bands - 1);
+    job.adler[band] = deflate_adler32(1, &job.filtered[begin], end - begin);
+    job.crc[band]   = deflate_crc32(deflate_crc32(0, "IDAT", 4), &part[0], part.size());
+}
+
+inline void png_put32(std::vector<uint8_t>& out, uint32_t v)
+{
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+inline void png_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+{
+    png_put32(out, (uint32_t)size);
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    png_put32(out, deflate_crc32(deflate_crc32(0, type, 4), data, size));
+}
+
+/// Encode pimg as a PNG file image into out.
+inline int png_encode(PCIMAGE pimg, const ege_png_options& options, std::vector<uint8_t>& out)
+{
+    png_job job;
+    job.src = getbuffer(pimg);
+    if (job.src == NULL) {
+        return grNullPointer;
+    }
+    job.width    = getwidth(pimg);
+    job.height   = getheight(pimg);
+    job.options  = options;
+    job.channels = options.withAlphaChannel ? 4 : 3;
+    job.rowBytes = 1 + (size_t)job.width * job.channels;
+    job.bandRows = (int)(PNG_BAND_BYTES / job.rowBytes);
+    job.bandRows = job.bandRows < 1 ? 1 : job.bandRows;
+    job.bands    = (job.height + job.bandRows - 1) / job.bandRows;
+    if (job.options.filter < PNG_FILTER_NONE || job.options.filter > PNG_FILTER_ADAPTIVE) {
+        job.options.filter = PNG_FILTER_ADAPTIVE;
+    }
+    job.options.level = options.level < DEFLATE_LEVEL_MIN ? DEFLATE_LEVEL_MIN
+                                                         : (options.level > DEFLATE_LEVEL_MAX ? DEFLATE_LEVEL_MAX : options.level);
+    job.filtered.resize(job.rowBytes * job.height);
+    job.parts.resize(job.bands);
+    job.adler.resize(job.bands);
+    job.crc.resize(job.bands);
+
+    // Every band reads the filtered bytes before it, so all bands are filtered first.
+    parallel_for(job.bands, png_filter_band, &job);
+    parallel_for(job.bands, png_compress_band, &job);
+
+    uint32_t adler = 1;
+    for (int i = 0; i < job.bands; ++i) {
+        size_t size = (i == job.bands - 1 ? job.height - i * job.bandRows : job.bandRows) * job.rowBytes;
+        adler       = deflate_adler32_combine(adler, job.adler[i], size);
+    }
+    uint8_t trailer[4] = {(uint8_t)(adler >> 24), (uint8_t)(adler >> 16), (uint8_t)(adler >> 8), (uint8_t)adler};
+    std::vector<uint8_t>& last = job.parts[job.bands - 1];
+    job.crc[job.bands - 1]     = deflate_crc32(job.crc[job.bands - 1], trailer, 4);
+    last.insert(last.end(), trailer, trailer + 4);
+
+    size_t total = 8 + 25 + 12;
+    for (int i = 0; i < job.bands; ++i) {
+        total += job.parts[i].size() + 12;
+    }
+    out.clear();
+    out.reserve(total);
+    const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    out.insert(out.end(), signature, signature + 8);
+    uint8_t header[13] = {0};
+    for (int i = 0; i < 4; ++i) {
+        header[i]     = (uint8_t)(job.width >> (24 - 8 * i));
+        header[4 + i] = (uint8_t)(job.height >> (24 - 8 * i));
+    }
+    header[8] = 8;                              // Bit depth
+    header[9] = job.channels == 4 ? 6 : 2;      // Color type: RGBA or RGB
+    png_chunk(out, "IHDR", header, 13);
+    for (int i = 0; i < job.bands; ++i) {
+        // The CRC of each IDAT chunk was computed along with its band.
+        png_put32(out, (uint32_t)job.parts[i].size());
+        out.insert(out.end(), "IDAT", "IDAT" + 4);
+        out.insert(out.end(), job.parts[i].begin(), job.parts[i].end());
+        png_put32(out, job.crc[i]);
+        std::vector<uint8_t>().swap(job.parts[i]);
+    }
+    png_chunk(out, "IEND", NULL, 0);
+    return grOk;
+}
+
+inline int png_save(FILE* fp, const std::vector<uint8_t>& data)
+{
+    if (fp == NULL) {
+        return grIOerror;
+    }
+    bool written = fwrite(&data[0], 1, data.size(), fp) == data.size();
+    return fclose(fp) == 0 && written ? grOk : grIOerror;
+}
+
+} // namespace detail
+
+/**
+ * @brief Save image as PNG format to file, with compression options (char* version)
+ * @param pimg Image object pointer to save, NULL means current ege window
+ * @param filename Save image file name
+ * @param options Compression level, filter and alpha channel; NULL uses ege_png_default_options()
+ * @return grOk on success, grNullPointer if the image has no buffer, grIOerror if the file cannot be written
+ * @note Rows are compressed in bands on the worker pool, see ege_set_worker_threads()
+ * @note If file already exists, it will overwrite the original file
+ * @see savepng(PCIMAGE, const char*, bool)
+ */
+inline int savepng_ex(PCIMAGE pimg, const char* filename, const ege_png_options* options = NULL)
+{
+    if (filename == NULL) {
+        return grNullPointer;
+    }
+    std::vector<uint8_t> data;
+    int ret = detail::png_encode(pimg, options != NULL ? *options : ege_png_default_options(), data);
+    return ret != grOk ? ret : detail::png_save(fopen(filename, "wb"), data);
+}
+
+/**
+ * @brief Save image as PNG format to file, with compression options (wchar_t* version)
+ * @param pimg Image object pointer to save, NULL means current ege window
+ * @param filename Save image file name (wide character version)
+ * @param options Compression level, filter and alpha channel; NULL uses ege_png_default_options()
+ * @return grOk on success, grNullPointer if the image has no buffer, grIOerror if the file cannot be written
+ * @note Rows are compressed in bands on the worker pool, see ege_set_worker_threads()
+ * @note If file already exists, it will overwrite the original file
+ * @see savepng(PCIMAGE, const wchar_t*, bool)
+ */
+inline int savepng_ex(PCIMAGE pimg, const wchar_t* filename, const ege_png_options* options = NULL)
+{
+    if (filename == NULL) {
+        return grNullPointer;
+    }
+    std::vector<uint8_t> data;
+    int ret = detail::png_encode(pimg, options != NULL ? *options : ege_png_default_options(), data);
+    return ret != grOk ? ret : detail::png_save(_wfopen(filename, L"wb"), data);
+}
+
+} // namespace ege
+
+#endif /* EGE_IMAGE_PNG_H */
@@ -0,0 +1,291 @@
+/**
+ * @file image_pool.h
+ * @brief Reuse of image objects for per-frame scratch layers
+ *
+ * Every newimage() allocates a DIB section, and delimage() frees it again. Code that creates
+ * temporary layers every frame can use newimage_pooled() and delimage_pooled() instead: released
+ * images are kept in a pool, grouped by size, and handed out again for the next request of the
+ * same size. resize_pooled() does the same for images that change size, e.g. with the window,
+ * by swapping in a pooled image of the new size when there is one and resizing in place
+ * otherwise.
+ *
+ * The pool holds at most ege_image_pool_set_capacity() bytes of pixels and drops the least
+ * recently released images beyond that. A pooled image keeps its pixels and drawing settings,
+ * so clear it or set it up again after taking it from the pool.
+ */
+#ifndef EGE_IMAGE_POOL_H
+#define EGE_IMAGE_POOL_H
+
+#include "../ege.h"
+
+#include <map>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_image_pool_stats
+ * @brief Counters of the image pool
+ */
+struct ege_image_pool_stats
+{
+    unsigned long hits;             ///< Requests served from the pool
+    unsigned long misses;           ///< Requests that created or resized an image
+    unsigned long evictions;        ///< Pooled images deleted to respect the capacity
+    unsigned long liveBytes;        ///< Pixel bytes of images handed out and not yet released
+    unsigned long pooledBytes;      ///< Pixel bytes of images waiting in the pool
+    unsigned long capacity;         ///< Maximum pooled bytes
+    int           liveImages;       ///< Images handed out and not yet released
+    int           pooledImages;     ///< Images waiting in the pool
+    float         hitRate;          ///< hits / (hits + misses), 0 before the first request
+};
+
+namespace detail
+{
+
+struct image_pool_entry
+{
+    PIMAGE img;
+    int    w, h;
+};
+
+class image_pool
+{
+public:
+    image_pool() : m_capacity(64ul << 20), m_pooledBytes(0), m_liveBytes(0) { resetStats(); }
+
+    PIMAGE acquire(int w, int h)
+    {
+        w = w < 1 ? 1 : w;
+        h = h < 1 ? 1 : h;
+        PIMAGE img = take(w, h);
+        if (img == NULL) {
+            ++m_misses;
+            img = newimage(w, h);
+            if (img == NULL) {
+                return NULL;
+            }
+        } else {
+            ++m_hits;
+        }
+        track(img, w, h);
+        return img;
+    }
+
+    void release(PIMAGE img)
+    {
+        if (img == NULL || pooled(img)) {
+            return;
+        }
+        untrack(img);
+        image_pool_entry e = {img, getwidth(img), getheight(img)};
+        m_free.push_back(e);
+        m_pooledBytes += bytes(e.w, e.h);
+        evict(m_capacity);
+    }
+
+    int resize(PIMAGE& img, int w, int h)
+    {
+        if (img == NULL) {
+            img = acquire(w, h);
+            return img == NULL ? grAllocError : grOk;
+        }
+        w = w < 1 ? 1 : w;
+        h = h < 1 ? 1 : h;
+        if (getwidth(img) == w && getheight(img) == h) {
+            return grOk;
+        }
+        // Swap only for a size that is already pooled. Any other size is resized in place, so a
+        // window drag does not fill the pool with sizes that never come back.
+        if (hasSize(w, h)) {
+            PIMAGE next = acquire(w, h);
+            release(img);
+            img = next;
+            return grOk;
+        }
+        ++m_misses;
+        untrack(img);
+        int ret = resize_f(img, w, h);
+        track(img, getwidth(img), getheight(img));
+        return ret == 0 ? grOk : grAllocError;
+    }
+
+    void setCapacity(unsigned long capacity)
+    {
+        m_capacity = capacity;
+        evict(m_capacity);
+    }
+
+    void clear() { evict(0); }
+
+    void stats(ege_image_pool_stats* s) const
+    {
+        s->hits         = m_hits;
+        s->misses       = m_misses;
+        s->evictions    = m_evictions;
+        s->liveBytes    = m_liveBytes;
+        s->pooledBytes  = m_pooledBytes;
+        s->capacity     = m_capacity;
+        s->liveImages   = (int)m_live.size();
+        s->pooledImages = (int)m_free.size();
+        s->hitRate      = m_hits + m_misses > 0 ? (float)m_hits / (float)(m_hits + m_misses) : 0.0f;
+    }
+
+    void resetStats() { m_hits = m_misses = m_evictions = 0; }
+
+private:
+    static unsigned long bytes(int w, int h) { return (unsigned long)w * (unsigned long)h * sizeof(color_t); }
+
+    bool hasSize(int w, int h) const
+    {
+        for (size_t i = 0; i < m_free.size(); ++i) {
+            if (m_free[i].w == w && m_free[i].h == h) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool pooled(PIMAGE img) const
+    {
+        for (size_t i = 0; i < m_free.size(); ++i) {
+            if (m_free[i].img == img) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Remove the most recently released image of the given size from the pool.
+    PIMAGE take(int w, int h)
+    {
+        for (size_t i = m_free.size(); i-- > 0;) {
+            if (m_free[i].w == w && m_free[i].h == h) {
+                PIMAGE img = m_free[i].img;
+                m_free.erase(m_free.begin() + i);
+                m_pooledBytes -= bytes(w, h);
+                return img;
+            }
+        }
+        return NULL;
+    }
+
+    void track(PIMAGE img, int w, int h)
+    {
+        m_live[img] = bytes(w, h);
+        m_liveBytes += bytes(w, h);
+    }
+
+    void untrack(PIMAGE img)
+    {
+        std::map<PIMAGE, unsigned long>::iterator it = m_live.find(img);
+        if (it != m_live.end()) {
+            m_liveBytes -= it->second;
+            m_live.erase(it);
+        }
+    }
+
+    /// Delete least recently released images until at most limit bytes remain pooled.
+    void evict(unsigned long limit)
+    {
+        // m_free is in release order, so the oldest entries are at the front.
+        size_t n = 0;
+        while (n < m_free.size() && m_pooledBytes > limit) {
+            m_pooledBytes -= bytes(m_free[n].w, m_free[n].h);
+            delimage(m_free[n].img);
+            ++m_evictions;
+            ++n;
+        }
+        m_free.erase(m_free.begin(), m_free.begin() + n);
+    }
+
+    std::vector<image_pool_entry>   m_free;
+    std::map<PIMAGE, unsigned long> m_live;
+    unsigned long                   m_capacity, m_pooledBytes, m_liveBytes;
+    unsigned long                   m_hits, m_misses, m_evictions;
+};
+
+inline image_pool& image_pool_instance()
+{
+    static image_pool pool;
+    return pool;
+}
+
+} // namespace detail
+
+/**
+ * @brief Get an image of the given size, from the pool when possible
+ * @param width Image width, at least 1
+ * @param height Image height, at least 1
+ * @return Image pointer, NULL if it could not be created
+ * @note A new image is cleared like newimage() does; a pooled one keeps the pixels and drawing
+ *       settings of its last use. Release it with delimage_pooled().
+ */
+inline PIMAGE newimage_pooled(int width, int height)
+{
+    return detail::image_pool_instance().acquire(width, height);
+}
+
+/**
+ * @brief Return an image to the pool instead of deleting it
+ * @param pimg Image pointer, from newimage_pooled() or newimage(); NULL is ignored
+ * @note The image must not be used afterwards; releasing it twice has no effect. Images beyond
+ *       the pool capacity are deleted.
+ */
+inline void delimage_pooled(PIMAGE pimg)
+{
+    detail::image_pool_instance().release(pimg);
+}
+
+/**
+ * @brief Change the size of an image, swapping in a pooled image of that size when there is one
+ * @param pimg Image pointer, replaced by the pooled image in that case; NULL gets a new image
+ * @param width New width, at least 1
+ * @param height New height, at least 1
+ * @return grOk on success, grAllocError if the image could not be resized
+ * @note Like resize_f(), the content of the image is undefined afterwards. When the pool holds an
+ *       image of the new size, the two are swapped and the previous image goes to the pool, so
+ *       switching back and forth between sizes released earlier does not allocate. Any other size
+ *       is resized in place with resize_f() and pools nothing.
+ */
+inline int resize_pooled(PIMAGE& pimg, int width, int height)
+{
+    return detail::image_pool_instance().resize(pimg, width, height);
+}
+
+/**
+ * @brief Set the maximum amount of pixel memory kept in the pool
+ * @param bytes Maximum pooled bytes, default is 64 MiB; 0 deletes every released image at once
+ */
+inline void ege_image_pool_set_capacity(unsigned long bytes)
+{
+    detail::image_pool_instance().setCapacity(bytes);
+}
+
+/**
+ * @brief Get the counters of the image pool
+ * @param stats Receives live and pooled bytes, hit rate and the other counters
+ */
+inline void ege_image_pool_get_stats(ege_image_pool_stats* stats)
+{
+    if (stats != NULL) {
+        detail::image_pool_instance().stats(stats);
+    }
+}
+
+/// @brief Reset the hit, miss and eviction counters of the image pool
+inline void ege_image_pool_reset_stats()
+{
+    detail::image_pool_instance().resetStats();
+}
+
+/// @brief Delete all pooled images
+inline void ege_image_pool_clear()
+{
+    detail::image_pool_instance().clear();
+}
+
+} // namespace ege
+
+#endif /* EGE_IMAGE_POOL_H */
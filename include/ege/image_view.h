@@ -0,0 +1,545 @@
+/**
+ * @file image_view.h
+ * @brief Sub-image views that share the pixels of their parent image
+ *
+ * newimage_view() describes a rectangle of an existing image without copying it: the view keeps
+ * a pointer to its first pixel and the row stride of the parent, so tiles of a large canvas or
+ * cells of a sprite atlas can be blended into, blurred, drawn on and flood filled in place.
+ *
+ * A view does not own its pixels. It stays valid as long as its parent is neither deleted nor
+ * resized. Drawing into a view of the window marks the touched area dirty (see ege/dirty_rect.h)
+ * in window coordinates.
+ *
+ * getstride() gives the distance between rows in pixels, so code walking getbuffer() works for
+ * images and views alike. For images it is always getwidth(), as EGE images are packed.
+ *
+ * newimage_aligned() allocates a standalone buffer for SIMD code instead: every row starts on a
+ * 64-byte boundary and the stride is a multiple of 16 pixels, so a row can be processed with
+ * aligned 128/256/512-bit loads up to its padded end without a scalar tail. It is used through
+ * the same view functions and released with delimage_aligned().
+ */
+#ifndef EGE_IMAGE_VIEW_H
+#define EGE_IMAGE_VIEW_H
+
+#include "blur.h"
+#include "floodfill.h"
+#include "shapes.h"
+
+#include <stdlib.h>
+
+namespace ege
+{
+
+/**
+ * @struct ege_image_view
+ * @brief Rectangle of an image, sharing its pixels
+ */
+struct ege_image_view
+{
+    color_t* pixels;    ///< First pixel of the view, NULL for an empty view
+    int      width;     ///< Width in pixels
+    int      height;    ///< Height in pixels
+    int      stride;    ///< Pixels from the start of one row to the next
+    PIMAGE   parent;    ///< Image the pixels belong to, NULL for the window
+    int      x, y;      ///< Position of the view in parent
+    bool     owned;     ///< Pixels come from newimage_aligned() rather than from parent
+};
+
+/**
+ * @brief Get the row stride of an image
+ * @param pimg Image pointer, NULL means current ege window
+ * @return Pixels from the start of one row of getbuffer(pimg) to the next
+ */
+inline int getstride(PCIMAGE pimg = NULL)
+{
+    return getwidth(pimg);
+}
+
+/**
+ * @brief Create a view of a rectangle of an image
+ * @param parent Image pointer, NULL means current ege window
+ * @param x X coordinate of the top-left corner in parent
+ * @param y Y coordinate of the top-left corner in parent
+ * @param width Width of the view, 0 means to the right edge
+ * @param height Height of the view, 0 means to the bottom edge
+ * @return View of the rectangle clipped to parent; pixels is NULL if nothing is left
+ */
+inline ege_image_view newimage_view(PIMAGE parent, int x = 0, int y = 0, int width = 0, int height = 0)
+{
+    ege_image_view view = {NULL, 0, 0, 0, parent, 0, 0, false};
+    color_t*       buf  = getbuffer(parent);
+    int            w = getwidth(parent), h = getheight(parent);
+    if (width <= 0)  width  = w - x;
+    if (height <= 0) height = h - y;
+    if (x < 0) { width  += x; x = 0; }
+    if (y < 0) { height += y; y = 0; }
+    if (x + width > w)  width  = w - x;
+    if (y + height > h) height = h - y;
+    if (buf == NULL || width <= 0 || height <= 0) {
+        return view;
+    }
+    view.pixels = buf + (size_t)y * w + x;
+    view.width  = width;
+    view.height = height;
+    view.stride = w;
+    view.x      = x;
+    view.y      = y;
+    return view;
+}
+
+/**
+ * @brief Create a view of a rectangle of another view
+ * @param parent View to take the rectangle from
+ * @param x X coordinate of the top-left corner in parent
+ * @param y Y coordinate of the top-left corner in parent
+ * @param width Width of the view, 0 means to the right edge
+ * @param height Height of the view, 0 means to the bottom edge
+ * @return View of the rectangle clipped to parent, sharing the image of parent
+ */
+inline ege_image_view newimage_view(const ege_image_view& parent, int x, int y, int width = 0, int height = 0)
+{
+    ege_image_view view = {NULL, 0, 0, 0, parent.parent, 0, 0, parent.owned};
+    if (width <= 0)  width  = parent.width - x;
+    if (height <= 0) height = parent.height - y;
+    if (x < 0) { width  += x; x = 0; }
+    if (y < 0) { height += y; y = 0; }
+    if (x + width > parent.width)   width  = parent.width - x;
+    if (y + height > parent.height) height = parent.height - y;
+    if (parent.pixels == NULL || width <= 0 || height <= 0) {
+        return view;
+    }
+    view.pixels = parent.pixels + (size_t)y * parent.stride + x;
+    view.width  = width;
+    view.height = height;
+    view.stride = parent.stride;
+    view.x      = parent.x + x;
+    view.y      = parent.y + y;
+    return view;
+}
+
+/// @brief Get the first pixel of a view; rows are getstride(view) pixels apart
+inline color_t* getbuffer(const ege_image_view& view) { return view.pixels; }
+
+/// @brief Get the width of a view
+inline int getwidth(const ege_image_view& view) { return view.width; }
+
+/// @brief Get the height of a view
+inline int getheight(const ege_image_view& view) { return view.height; }
+
+/// @brief Get the row stride of a view, in pixels
+inline int getstride(const ege_image_view& view) { return view.stride; }
+
+/**
+ * @brief Allocate an image buffer with 64-byte aligned rows
+ * @param width Width in pixels
+ * @param height Height in pixels
+ * @return View of the new buffer, cleared to 0; its stride is width rounded up to 16 pixels.
+ *         pixels is NULL if the size is invalid or the allocation failed.
+ * @note The padding pixels at the end of each row belong to the buffer and may be freely
+ *       written, but are not drawn by any function. Functions that default to the fill or line
+ *       color take it from the current target. Use putimage_f() to copy the buffer to an image.
+ */
+inline ege_image_view newimage_aligned(int width, int height)
+{
+    ege_image_view view = {NULL, 0, 0, 0, NULL, 0, 0, true};
+    if (width <= 0 || height <= 0) {
+        return view;
+    }
+    int    stride = (width + 15) & ~15;
+    size_t bytes  = (size_t)stride * height * sizeof(color_t);
+    // The block starts with the pointer returned by malloc, just below the aligned pixels.
+    char* raw = (char*)malloc(bytes + 64 + sizeof(void*));
+    if (raw == NULL) {
+        return view;
+    }
+    char* aligned = (char*)(((size_t)raw + sizeof(void*) + 63) & ~(size_t)63);
+    ((void**)aligned)[-1] = raw;
+    memset(aligned, 0, bytes);
+
+    view.pixels = (color_t*)aligned;
+    view.width  = width;
+    view.height = height;
+    view.stride = stride;
+    return view;
+}
+
+/**
+ * @brief Free a buffer allocated by newimage_aligned()
+ * @param view View returned by newimage_aligned(), cleared on return; views of it become invalid
+ * @return grOk on success, grParamError if view is not a whole buffer from newimage_aligned()
+ */
+inline int delimage_aligned(ege_image_view& view)
+{
+    if (!view.owned || view.x != 0 || view.y != 0 || view.pixels == NULL || ((size_t)view.pixels & 63) != 0) {
+        return grParamError;
+    }
+    free(((void**)view.pixels)[-1]);
+    ege_image_view empty = {NULL, 0, 0, 0, NULL, 0, 0, true};
+    view                 = empty;
+    return grOk;
+}
+
+namespace detail
+{
+
+inline ege_image_view view_whole(PCIMAGE pimg)
+{
+    return newimage_view((PIMAGE)pimg);
+}
+
+/// Record damage of a view in the coordinates of its parent.
+inline void view_note(const ege_image_view& view, int x, int y, int w, int h)
+{
+    if (!view.owned) {
+        dirty_note(view.parent, view.x + x, view.y + y, w, h);
+    }
+}
+
+/// Run a blend or color key kernel over the clipped rectangle; key_kernel is used when not NULL.
+inline int view_blit(const ege_image_view& dst, const ege_image_view& src, int xDest, int yDest, int xSrc, int ySrc,
+    int width, int height, span_blend_fn blend_kernel, span_key_fn key_kernel, color_t key, unsigned int alpha)
+{
+    if (src.pixels == NULL) {
+        return grNullPointer;
+    }
+    if (dst.pixels == NULL
+        || !blit_clip(dst.width, dst.height, src.width, src.height, xDest, yDest, xSrc, ySrc, width, height)) {
+        return grInvalidRegion;
+    }
+    color_t*       d = dst.pixels + (size_t)yDest * dst.stride + xDest;
+    const color_t* s = src.pixels + (size_t)ySrc * src.stride + xSrc;
+    for (int y = 0; y < height; ++y, d += dst.stride, s += src.stride) {
+        if (key_kernel != NULL) {
+            key_kernel(d, s, width, key, alpha);
+        } else {
+            blend_kernel(d, s, width, alpha);
+        }
+    }
+    view_note(dst, xDest, yDest, width, height);
+    return grOk;
+}
+
+inline void view_shapes_finish(shape_job& job, const ege_image_view& view)
+{
+    int x0, y0, x1, y1;
+    if (shape_draw(job, x0, y0, x1, y1)) {
+        view_note(view, x0, y0, x1 - x0, y1 - y0);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Copy the pixels of a view into a view
+ * @param imgDest Target view, e.g. newimage_view(pimg) for a whole image
+ * @param xDest X coordinate of drawing position in imgDest
+ * @param yDest Y coordinate of drawing position in imgDest
+ * @param imgSrc Source view, must not overlap imgDest
+ * @param xSrc X coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param widthSrc Width of drawing content, default is 0 (to the right edge of imgSrc)
+ * @param heightSrc Height of drawing content, default is 0 (to the bottom edge of imgSrc)
+ * @return grOk on success, grInvalidRegion if nothing is visible, grNullPointer if imgSrc is empty
+ */
+inline int putimage_f(const ege_image_view& imgDest, int xDest, int yDest, const ege_image_view& imgSrc, int xSrc = 0,
+    int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    if (imgSrc.pixels == NULL) {
+        return grNullPointer;
+    }
+    if (imgDest.pixels == NULL || !detail::blit_clip(imgDest.width, imgDest.height, imgSrc.width, imgSrc.height, xDest,
+                                      yDest, xSrc, ySrc, widthSrc, heightSrc)) {
+        return grInvalidRegion;
+    }
+    color_t*       d = imgDest.pixels + (size_t)yDest * imgDest.stride + xDest;
+    const color_t* s = imgSrc.pixels + (size_t)ySrc * imgSrc.stride + xSrc;
+    for (int y = 0; y < heightSrc; ++y, d += imgDest.stride, s += imgSrc.stride) {
+        memcpy(d, s, widthSrc * sizeof(color_t));
+    }
+    detail::view_note(imgDest, xDest, yDest, widthSrc, heightSrc);
+    return grOk;
+}
+
+/**
+ * @brief Alpha blend a view into a view using the SIMD span kernels
+ * @param imgDest Target view
+ * @param imgSrc Source view, must not overlap imgDest
+ * @param xDest X coordinate of drawing position in imgDest
+ * @param yDest Y coordinate of drawing position in imgDest
+ * @param alpha Overall image transparency (0-255)
+ * @param xSrc X coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param widthSrc Width of drawing content, default is 0 (to the right edge of imgSrc)
+ * @param heightSrc Height of drawing content, default is 0 (to the bottom edge of imgSrc)
+ * @param colorType Color type of source image pixels, default is COLORTYPE_PRGB32
+ * @return grOk on success, grInvalidRegion if nothing is visible, grNullPointer if imgSrc is empty
+ */
+inline int putimage_alphablend_f(const ege_image_view& imgDest, const ege_image_view& imgSrc, int xDest, int yDest,
+    unsigned char alpha, int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0,
+    color_type colorType = COLORTYPE_PRGB32)
+{
+    return detail::view_blit(imgDest, imgSrc, xDest, yDest, xSrc, ySrc, widthSrc, heightSrc,
+        detail::span_kernels_current().blend[detail::blend_mode(colorType)], NULL, 0, alpha);
+}
+
+/// @brief Alpha blend an image into a view using the SIMD span kernels
+inline int putimage_alphablend_f(const ege_image_view& imgDest, PCIMAGE imgSrc, int xDest, int yDest, unsigned char alpha,
+    int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0, color_type colorType = COLORTYPE_PRGB32)
+{
+    return putimage_alphablend_f(imgDest, detail::view_whole(imgSrc), xDest, yDest, alpha, xSrc, ySrc, widthSrc,
+        heightSrc, colorType);
+}
+
+/**
+ * @brief Draw a premultiplied ARGB view into a view using its per-pixel alpha
+ * @param imgDest Target view
+ * @param imgSrc Source view, must not overlap imgDest
+ * @param xDest X coordinate of drawing position in imgDest
+ * @param yDest Y coordinate of drawing position in imgDest
+ * @param xSrc X coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param widthSrc Width of drawing content, default is 0 (to the right edge of imgSrc)
+ * @param heightSrc Height of drawing content, default is 0 (to the bottom edge of imgSrc)
+ * @return grOk on success, corresponding error code on failure
+ */
+inline int putimage_withalpha_f(const ege_image_view& imgDest, const ege_image_view& imgSrc, int xDest, int yDest,
+    int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    return putimage_alphablend_f(imgDest, imgSrc, xDest, yDest, 255, xSrc, ySrc, widthSrc, heightSrc, COLORTYPE_PRGB32);
+}
+
+/// @brief Draw a premultiplied ARGB image into a view using its per-pixel alpha
+inline int putimage_withalpha_f(const ege_image_view& imgDest, PCIMAGE imgSrc, int xDest, int yDest, int xSrc = 0,
+    int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    return putimage_withalpha_f(imgDest, detail::view_whole(imgSrc), xDest, yDest, xSrc, ySrc, widthSrc, heightSrc);
+}
+
+/**
+ * @brief Draw a view into a view, skipping pixels of the transparent color
+ * @param imgDest Target view
+ * @param imgSrc Source view, must not overlap imgDest
+ * @param xDest X coordinate of drawing position in imgDest
+ * @param yDest Y coordinate of drawing position in imgDest
+ * @param transparentColor Pixel color to become transparent
+ * @param xSrc X coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param widthSrc Width of drawing content, default is 0 (to the right edge of imgSrc)
+ * @param heightSrc Height of drawing content, default is 0 (to the bottom edge of imgSrc)
+ * @return grOk on success, corresponding error code on failure
+ */
+inline int putimage_transparent_f(const ege_image_view& imgDest, const ege_image_view& imgSrc, int xDest, int yDest,
+    color_t transparentColor, int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    return detail::view_blit(imgDest, imgSrc, xDest, yDest, xSrc, ySrc, widthSrc, heightSrc, NULL,
+        detail::span_kernels_current().transparent, transparentColor, 255);
+}
+
+/// @brief Draw an image into a view, skipping pixels of the transparent color
+inline int putimage_transparent_f(const ege_image_view& imgDest, PCIMAGE imgSrc, int xDest, int yDest,
+    color_t transparentColor, int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    return putimage_transparent_f(imgDest, detail::view_whole(imgSrc), xDest, yDest, transparentColor, xSrc, ySrc,
+        widthSrc, heightSrc);
+}
+
+/**
+ * @brief Alpha blend a view into a view, skipping pixels of the transparent color
+ * @param imgDest Target view
+ * @param imgSrc Source view, must not overlap imgDest
+ * @param xDest X coordinate of drawing position in imgDest
+ * @param yDest Y coordinate of drawing position in imgDest
+ * @param transparentColor Pixel color to become transparent
+ * @param alpha Overall image transparency (0-255)
+ * @param xSrc X coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param ySrc Y coordinate of top-left corner of drawing content in imgSrc, default is 0
+ * @param widthSrc Width of drawing content, default is 0 (to the right edge of imgSrc)
+ * @param heightSrc Height of drawing content, default is 0 (to the bottom edge of imgSrc)
+ * @return grOk on success, corresponding error code on failure
+ */
+inline int putimage_alphatransparent_f(const ege_image_view& imgDest, const ege_image_view& imgSrc, int xDest, int yDest,
+    color_t transparentColor, unsigned char alpha, int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    return detail::view_blit(imgDest, imgSrc, xDest, yDest, xSrc, ySrc, widthSrc, heightSrc, NULL,
+        detail::span_kernels_current().alphatransparent, transparentColor, alpha);
+}
+
+/// @brief Alpha blend an image into a view, skipping pixels of the transparent color
+inline int putimage_alphatransparent_f(const ege_image_view& imgDest, PCIMAGE imgSrc, int xDest, int yDest,
+    color_t transparentColor, unsigned char alpha, int xSrc = 0, int ySrc = 0, int widthSrc = 0, int heightSrc = 0)
+{
+    return putimage_alphatransparent_f(imgDest, detail::view_whole(imgSrc), xDest, yDest, transparentColor, alpha, xSrc,
+        ySrc, widthSrc, heightSrc);
+}
+
+/**
+ * @brief Box blur a rectangle of a view in place
+ * @param view Target view
+ * @param radius Blur radius in pixels
+ * @param passes Number of box passes, 3 approximates a Gaussian
+ * @param xDest X coordinate of the region in view, default is 0
+ * @param yDest Y coordinate of the region in view, default is 0
+ * @param widthDest Width of the region, default is 0 (to the right edge)
+ * @param heightDest Height of the region, default is 0 (to the bottom edge)
+ * @return grOk on success, grNullPointer if the view is empty
+ * @note Pixels outside the view are never read, so neighbouring tiles do not bleed into each other.
+ */
+inline int imagefilter_boxblur(const ege_image_view& view, int radius, int passes = 1, int xDest = 0, int yDest = 0,
+    int widthDest = 0, int heightDest = 0)
+{
+    detail::blur_job job;
+    if (!detail::blur_setup(job, view.pixels, view.width, view.height, view.stride, xDest, yDest, widthDest, heightDest)) {
+        return grNullPointer;
+    }
+    for (int i = 0; i < passes; ++i) {
+        detail::blur_box_pass(job, radius);
+    }
+    detail::view_note(view, job.x, job.y, job.w, job.h);
+    return grOk;
+}
+
+/**
+ * @brief Gaussian blur a rectangle of a view in place, approximated by three box passes
+ * @param view Target view
+ * @param radius Standard deviation of the blur in pixels
+ * @param xDest X coordinate of the region in view, default is 0
+ * @param yDest Y coordinate of the region in view, default is 0
+ * @param widthDest Width of the region, default is 0 (to the right edge)
+ * @param heightDest Height of the region, default is 0 (to the bottom edge)
+ * @return grOk on success, grNullPointer if the view is empty
+ */
+inline int imagefilter_gaussian(const ege_image_view& view, float radius, int xDest = 0, int yDest = 0, int widthDest = 0,
+    int heightDest = 0)
+{
+    detail::blur_job job;
+    if (!detail::blur_setup(job, view.pixels, view.width, view.height, view.stride, xDest, yDest, widthDest, heightDest)) {
+        return grNullPointer;
+    }
+    if (!(radius > 0.0f)) {
+        return grOk;
+    }
+    detail::blur_gaussian(job, radius);
+    detail::view_note(view, job.x, job.y, job.w, job.h);
+    return grOk;
+}
+
+/**
+ * @brief Fill an array of anti-aliased circles in a view
+ * @param n Number of circles
+ * @param xyr Center x, center y and radius of each circle (3 * n floats), in view coordinates
+ * @param colors ARGB color of each circle, NULL to use the fill color of the parent image
+ * @param view Target view
+ * @return grOk on success, grNullPointer if xyr is NULL or the view is empty
+ */
+inline int ege_fillcircles(int n, const float* xyr, const color_t* colors, const ege_image_view& view)
+{
+    detail::shape_job job;
+    if ((xyr == NULL && n > 0) || !detail::shape_begin(job, view.pixels, view.width, view.height, view.stride, n)) {
+        return grNullPointer;
+    }
+    detail::shape_add_circles(job, n, detail::shape_interleaved(xyr, 3), colors,
+        colors == NULL ? getfillcolor(view.parent) : 0);
+    detail::view_shapes_finish(job, view);
+    return grOk;
+}
+
+/**
+ * @brief Fill an array of anti-aliased rectangles in a view
+ * @param n Number of rectangles
+ * @param xywh Left, top, width and height of each rectangle (4 * n floats), in view coordinates
+ * @param colors ARGB color of each rectangle, NULL to use the fill color of the parent image
+ * @param view Target view
+ * @return grOk on success, grNullPointer if xywh is NULL or the view is empty
+ */
+inline int ege_fillrects(int n, const float* xywh, const color_t* colors, const ege_image_view& view)
+{
+    detail::shape_job job;
+    if ((xywh == NULL && n > 0) || !detail::shape_begin(job, view.pixels, view.width, view.height, view.stride, n)) {
+        return grNullPointer;
+    }
+    detail::shape_add_rects(job, n, detail::shape_interleaved(xywh, 4), colors,
+        colors == NULL ? getfillcolor(view.parent) : 0);
+    detail::view_shapes_finish(job, view);
+    return grOk;
+}
+
+/**
+ * @brief Draw an array of anti-aliased line segments with round ends in a view
+ * @param n Number of segments
+ * @param xyxy Start x, start y, end x and end y of each segment (4 * n floats), in view coordinates
+ * @param colors ARGB color of each segment, NULL to use the line color of the parent image
+ * @param thickness Line width in pixels
+ * @param view Target view
+ * @return grOk on success, grNullPointer if xyxy is NULL or the view is empty
+ */
+inline int ege_lines(int n, const float* xyxy, const color_t* colors, float thickness, const ege_image_view& view)
+{
+    detail::shape_job job;
+    if ((xyxy == NULL && n > 0) || !detail::shape_begin(job, view.pixels, view.width, view.height, view.stride, n)) {
+        return grNullPointer;
+    }
+    detail::shape_add_lines(job, n, detail::shape_interleaved(xyxy, 4), colors,
+        colors == NULL ? getlinecolor(view.parent) : 0, thickness);
+    detail::view_shapes_finish(job, view);
+    return grOk;
+}
+
+/**
+ * @brief Flood fill up to a border color inside a view, with the fill color of the parent image
+ * @param x Fill starting point x coordinate, in view coordinates
+ * @param y Fill starting point y coordinate, in view coordinates
+ * @param borderColor Boundary color
+ * @param view Target view; the fill stops at its edges
+ * @return grOk on success, grNullPointer if the view is empty, grParamError if (x, y) is outside it
+ */
+inline int floodfill_f(int x, int y, int borderColor, const ege_image_view& view)
+{
+    detail::flood_job job;
+    int ret = detail::flood_paint(job, x, y, (color_t)borderColor, FLOODFILL_BORDER, getfillcolor(view.parent),
+        view.pixels, view.width, view.height, view.stride);
+    if (ret == grOk && job.count > 0) {
+        detail::view_note(view, job.x0, job.y0, job.x1 - job.x0, job.y1 - job.y0);
+    }
+    return ret;
+}
+
+/**
+ * @brief Fill the area of one color connected to a point inside a view
+ * @param x Fill starting point x coordinate, in view coordinates
+ * @param y Fill starting point y coordinate, in view coordinates
+ * @param areaColor Area color to be replaced
+ * @param view Target view; the fill stops at its edges
+ * @return grOk on success, grNullPointer if the view is empty, grParamError if (x, y) is outside it
+ */
+inline int floodfillsurface_f(int x, int y, color_t areaColor, const ege_image_view& view)
+{
+    detail::flood_job job;
+    int ret = detail::flood_paint(job, x, y, areaColor, FLOODFILL_SURFACE, getfillcolor(view.parent), view.pixels,
+        view.width, view.height, view.stride);
+    if (ret == grOk && job.count > 0) {
+        detail::view_note(view, job.x0, job.y0, job.x1 - job.x0, job.y1 - job.y0);
+    }
+    return ret;
+}
+
+/**
+ * @brief Compute the region a flood fill inside a view would paint, as a 1-bit mask
+ * @param x Fill starting point x coordinate, in view coordinates
+ * @param y Fill starting point y coordinate, in view coordinates
+ * @param color Border color for FLOODFILL_BORDER, area color for FLOODFILL_SURFACE
+ * @param type FLOODFILL_BORDER or FLOODFILL_SURFACE
+ * @param mask Receives one bit per view pixel, least significant bit first, cleared before filling
+ * @param maskStride Words per mask row, at least (getwidth(view) + 31) / 32
+ * @param view Source view
+ * @return grOk on success, grNullPointer if mask is NULL or the view is empty,
+ *         grParamError if (x, y) is outside the view or maskStride is too small
+ */
+inline int floodfill_mask(int x, int y, color_t color, floodfill_type type, uint32_t* mask, int maskStride,
+    const ege_image_view& view)
+{
+    return detail::flood_select(x, y, color, type, mask, maskStride, view.pixels, view.width, view.height, view.stride);
+}
+
+} // namespace ege
+
+#endif /* EGE_IMAGE_VIEW_H */
@@ -2,6 +2,7 @@
 #define EGE_LABEL_H
 
 #include "egecontrolbase.h"
+#include "font_cache.h"
 
 namespace ege
 {
@@ -117,7 +118,7 @@ public:
         setcolor(m_color);
         cleardevice();
         setbkmode(TRANSPARENT);
-        setfont(m_fontheight, 0, m_face);
+        setfont_cached(m_fontheight, 0, m_face);
         outtextrect(0, 0, getw(), geth(), m_caption);
 
         if (m_transparent) {
@@ -129,7 +130,7 @@ public:
                 setcolor(0xFFFFFF, filter());
             }
             setbkmode(TRANSPARENT, filter());
-            setfont(m_fontheight, 0, m_face, filter());
+            setfont_cached(m_fontheight, 0, m_face, filter());
             outtextrect(0, 0, getw(), geth(), m_caption, filter());
         } else {
             if (m_alpha < 0xff) {
@@ -0,0 +1,219 @@
+/**
+ * @file parallel.h
+ * @brief Worker thread pool shared by the multithreaded EGE helpers
+ *
+ * The pool is opt-in: by default every helper runs on the calling thread. Call
+ * ege_set_worker_threads() to let tiled operations (rotation, filters, rasterization...)
+ * spread their work over several cores. The calling thread always takes part in the work,
+ * so n threads means n - 1 extra worker threads.
+ */
+#ifndef EGE_PARALLEL_H
+#define EGE_PARALLEL_H
+
+#include "../ege.h"
+
+#include <vector>
+
+namespace ege
+{
+
+namespace detail
+{
+
+/// Work item callback: index runs from 0 to count - 1.
+typedef void (*parallel_task)(void* context, int index);
+
+class worker_pool
+{
+public:
+    worker_pool() : m_threads(1), m_task(NULL), m_context(NULL), m_count(0), m_next(0), m_active(0), m_busy(0),
+        m_quit(0)
+    {
+        m_done = CreateEventW(NULL, FALSE, FALSE, NULL);
+    }
+
+    ~worker_pool()
+    {
+        stop();
+        CloseHandle(m_done);
+    }
+
+    int threads() const { return m_threads; }
+
+    void setThreads(int threads)
+    {
+        if (threads <= 0) {
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            threads = (int)info.dwNumberOfProcessors;
+        }
+        if (threads < 1)  threads = 1;
+        if (threads > 64) threads = 64;
+
+        // Wait for a running parallel_for() to finish before touching the workers.
+        while (InterlockedCompareExchange(&m_busy, 1, 0) != 0) {
+            SwitchToThread();
+        }
+        if (threads != m_threads) {
+            stop();
+            m_threads = threads;
+        }
+        InterlockedExchange(&m_busy, 0);
+    }
+
+    /// Run task(context, i) for i in [0, count); returns when every item is done.
+    void run(int count, parallel_task task, void* context)
+    {
+        if (count <= 0) {
+            return;
+        }
+
+        // Nested or concurrent calls run on the calling thread instead of waiting for the pool.
+        if (count == 1 || m_threads <= 1 || InterlockedCompareExchange(&m_busy, 1, 0) != 0) {
+            for (int i = 0; i < count; ++i) {
+                task(context, i);
+            }
+            return;
+        }
+
+        start();
+        int workers = (int)m_workers.size();
+        if (workers > count - 1) {
+            workers = count - 1;
+        }
+
+        m_task    = task;
+        m_context = context;
+        m_count   = count;
+        m_next    = 0;
+        m_active  = workers;
+        for (int i = 0; i < workers; ++i) {
+            SetEvent(m_workers[i].wake);
+        }
+
+        work();
+        if (workers > 0) {
+            WaitForSingleObject(m_done, INFINITE);
+        }
+        InterlockedExchange(&m_busy, 0);
+    }
+
+private:
+    struct worker
+    {
+        worker_pool* pool;
+        HANDLE       thread;
+        HANDLE       wake;
+    };
+
+    worker_pool(const worker_pool&);
+    worker_pool& operator=(const worker_pool&);
+
+    void work()
+    {
+        for (LONG i; (i = InterlockedIncrement(&m_next) - 1) < m_count;) {
+            m_task(m_context, (int)i);
+        }
+    }
+
+    static DWORD WINAPI threadProc(LPVOID param)
+    {
+        worker*      self = (worker*)param;
+        worker_pool* pool = self->pool;
+        for (;;) {
+            WaitForSingleObject(self->wake, INFINITE);
+            if (pool->m_quit) {
+                return 0;
+            }
+            pool->work();
+            if (InterlockedDecrement(&pool->m_active) == 0) {
+                SetEvent(pool->m_done);
+            }
+        }
+    }
+
+    void start()
+    {
+        if (!m_workers.empty()) {
+            return;
+        }
+        // Reserve first: the threads keep pointers to their entries.
+        m_workers.reserve(m_threads - 1);
+        for (int i = 0; i < m_threads - 1; ++i) {
+            worker w;
+            w.pool = this;
+            w.wake = CreateEventW(NULL, FALSE, FALSE, NULL);
+            m_workers.push_back(w);
+            m_workers.back().thread = CreateThread(NULL, 0, threadProc, &m_workers.back(), 0, NULL);
+            if (m_workers.back().thread == NULL) {
+                CloseHandle(w.wake);
+                m_workers.pop_back();
+                break;
+            }
+        }
+    }
+
+    void stop()
+    {
+        InterlockedExchange(&m_quit, 1);
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            SetEvent(m_workers[i].wake);
+        }
+        for (size_t i = 0; i < m_workers.size(); ++i) {
+            WaitForSingleObject(m_workers[i].thread, INFINITE);
+            CloseHandle(m_workers[i].thread);
+            CloseHandle(m_workers[i].wake);
+        }
+        m_workers.clear();
+        InterlockedExchange(&m_quit, 0);
+    }
+
+    int                 m_threads;
+    std::vector<worker> m_workers;
+    HANDLE              m_done;
+
+    parallel_task       m_task;
+    void*               m_context;
+    volatile LONG       m_count;
+    volatile LONG       m_next;
+    volatile LONG       m_active;
+    volatile LONG       m_busy;
+    volatile LONG       m_quit;
+};
+
+inline worker_pool& worker_pool_instance()
+{
+    static worker_pool pool;
+    return pool;
+}
+
+/// Run task(context, i) for every i in [0, count) on the worker pool.
+inline void parallel_for(int count, parallel_task task, void* context)
+{
+    worker_pool_instance().run(count, task, context);
+}
+
+} // namespace detail
+
+/**
+ * @brief Set the number of threads used by the multithreaded EGE helpers
+ * @param threads Thread count including the calling thread; 1 disables multithreading (the
+ *        default), 0 or a negative value uses one thread per logical processor
+ */
+inline void ege_set_worker_threads(int threads)
+{
+    detail::worker_pool_instance().setThreads(threads);
+}
+
+/**
+ * @brief Get the number of threads used by the multithreaded EGE helpers
+ * @return Thread count including the calling thread
+ */
+inline int ege_get_worker_threads()
+{
+    return detail::worker_pool_instance().threads();
+}
+
+} // namespace ege
+
+#endif /* EGE_PARALLEL_H */
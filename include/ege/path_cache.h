@@ -0,0 +1,370 @@
+/**
+ * @file path_cache.h
+ * @brief Flattened geometry cache for static ege_path objects
+ *
+ * Icons, glyph outlines from ege_path_addtext() and map outlines rarely change, yet every
+ * ege_fillpath()/ege_drawpath() call flattens their curves again. ege_fillpath_cached() and
+ * ege_drawpath_cached() keep the flattened polyline of each path, and for strokes its outline,
+ * in path coordinates. Entries are keyed by the flattening tolerance that the scale of the image
+ * transform calls for, so translating or rotating a path reuses its cached geometry as it is;
+ * only scaling it up by more than the slack re-flattens it.
+ *
+ * Both functions go through the backend chosen with ege_set_render_backend(): the native
+ * rasterizer consumes the cached polylines directly, GDI+ gets a flattened copy of the path.
+ *
+ * Every call checks the point data of the path against a checksum, so any ege_path_add*,
+ * ege_path_transform() or other mutation invalidates the entry automatically. Call
+ * ege_path_cache_invalidate() before destroying a cached path to release its entry early.
+ */
+#ifndef EGE_PATH_CACHE_H
+#define EGE_PATH_CACHE_H
+
+#include "raster.h"
+
+#include <map>
+
+namespace ege
+{
+
+/**
+ * @struct ege_path_cache_stats
+ * @brief Counters of the flattened geometry cache
+ */
+struct ege_path_cache_stats
+{
+    unsigned long hits;             ///< Draws that reused cached geometry
+    unsigned long misses;           ///< Draws that flattened the path
+    unsigned long invalidations;    ///< Misses caused by a modified path
+    unsigned long evictions;        ///< Entries dropped to respect the capacity
+    int           entries;          ///< Cached paths
+    int           capacity;         ///< Maximum number of entries
+};
+
+namespace detail
+{
+
+struct path_cache_entry
+{
+    unsigned int                signature;
+    int                         count;
+    float                       tol;            ///< Flattening tolerance in path units
+    std::vector<raster_contour> contours;
+    bool                        stroked;
+    raster_stroke_style         style;          ///< Style the outline was built for
+    std::vector<raster_contour> outline;
+    ege_path*                   flat;           ///< Flattened copy for the GDI+ backend, built on demand
+    fill_mode                   flatMode;       ///< Mode set on flat, FILLMODE_DEFAULT if it kept the path's own
+    unsigned long               lastUse;
+};
+
+inline bool raster_style_equal(const raster_stroke_style& a, const raster_stroke_style& b)
+{
+    return a.halfWidth == b.halfWidth && a.startCap == b.startCap && a.endCap == b.endCap && a.join == b.join &&
+           a.miterLimit == b.miterLimit && a.tol == b.tol;
+}
+
+class path_cache
+{
+public:
+    path_cache() : m_capacity(256), m_tick(0) { resetStats(); }
+
+    /**
+     * Entry holding path flattened to at most tol and to no less than half of it, or NULL when
+     * caching is disabled. The checksum covers the point data of the path.
+     */
+    path_cache_entry* lookup(const ege_path* path, float tol)
+    {
+        if (m_capacity <= 0) {
+            return NULL;
+        }
+        int count = ege_path_pointcount(path);
+        m_points.resize(count > 0 ? count : 1);
+        m_types.resize(count > 0 ? count : 1);
+        if (count > 0) {
+            ege_path_getpathpoints(path, &m_points[0]);
+            ege_path_getpathtypes(path, &m_types[0]);
+        }
+        unsigned int h = 2166136261u;   // FNV-1a
+        h              = hash(h, &m_points[0], count * sizeof(ege_point));
+        h              = hash(h, &m_types[0], count);
+
+        std::map<const ege_path*, path_cache_entry>::iterator it = m_entries.find(path);
+        if (it != m_entries.end()) {
+            path_cache_entry& e = it->second;
+            if (e.signature == h && e.count == count && e.tol <= tol && e.tol * 2.0f > tol) {
+                e.lastUse = ++m_tick;
+                ++m_hits;
+                return &e;
+            }
+            if (e.signature != h || e.count != count) {
+                ++m_invalidations;
+            }
+        } else {
+            evict(m_capacity - 1);
+            path_cache_entry blank;
+            blank.signature = 0;
+            blank.count     = -1;
+            blank.tol       = 0.0f;
+            blank.stroked   = false;
+            blank.flat      = NULL;
+            blank.flatMode  = FILLMODE_DEFAULT;
+            blank.lastUse   = 0;
+            it              = m_entries.insert(std::make_pair(path, blank)).first;
+        }
+
+        ++m_misses;
+        path_cache_entry& e = it->second;
+        e.signature         = h;
+        e.count             = count;
+        e.tol               = tol;
+        e.stroked           = false;
+        e.lastUse           = ++m_tick;
+        e.contours.clear();
+        e.outline.clear();
+        release(e);
+        if (count > 0) {
+            raster_flatten(&m_points[0], &m_types[0], count, tol, e.contours);
+        }
+        return &e;
+    }
+
+    /// Stroke outline of an entry for the given style.
+    const std::vector<raster_contour>& outline(path_cache_entry& e, const raster_stroke_style& style)
+    {
+        if (!e.stroked || !raster_style_equal(e.style, style)) {
+            e.outline.clear();
+            for (size_t i = 0; i < e.contours.size(); ++i) {
+                raster_stroke(e.contours[i], style, e.outline);
+            }
+            e.style   = style;
+            e.stroked = true;
+        }
+        return e.outline;
+    }
+
+    /**
+     * Flattened copy of the path for GDI+, filled with the given mode, or NULL if the path could
+     * not be copied. The mode is only ever set on the copy; FILLMODE_DEFAULT keeps the mode the
+     * copy took over from the path, re-cloning it if an explicit mode was set before.
+     */
+    const ege_path* flattened(path_cache_entry& e, const ege_path* path, fill_mode mode)
+    {
+        if (e.flat != NULL && mode == FILLMODE_DEFAULT && e.flatMode != FILLMODE_DEFAULT) {
+            release(e);
+        }
+        if (e.flat == NULL) {
+            e.flat = ege_path_clone(path);
+            if (e.flat == NULL) {
+                return NULL;
+            }
+            ege_path_flatten(e.flat, NULL, e.tol);
+            e.flatMode = FILLMODE_DEFAULT;
+        }
+        if (mode != FILLMODE_DEFAULT && mode != e.flatMode) {
+            ege_path_setfillmode(e.flat, mode);
+            e.flatMode = mode;
+        }
+        return e.flat;
+    }
+
+    void invalidate(const ege_path* path)
+    {
+        std::map<const ege_path*, path_cache_entry>::iterator it = m_entries.find(path);
+        if (it != m_entries.end()) {
+            release(it->second);
+            m_entries.erase(it);
+        }
+    }
+
+    void setCapacity(int capacity)
+    {
+        m_capacity = capacity > 0 ? capacity : 0;
+        evict(m_capacity);
+    }
+
+    void clear()
+    {
+        for (std::map<const ege_path*, path_cache_entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+            release(it->second);
+        }
+        m_entries.clear();
+    }
+
+    void stats(ege_path_cache_stats* s) const
+    {
+        s->hits          = m_hits;
+        s->misses        = m_misses;
+        s->invalidations = m_invalidations;
+        s->evictions     = m_evictions;
+        s->entries       = (int)m_entries.size();
+        s->capacity      = m_capacity;
+    }
+
+    void resetStats() { m_hits = m_misses = m_invalidations = m_evictions = 0; }
+
+private:
+    static unsigned int hash(unsigned int h, const void* data, size_t size)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        for (size_t i = 0; i < size; ++i) {
+            h = (h ^ p[i]) * 16777619u;
+        }
+        return h;
+    }
+
+    static void release(path_cache_entry& e)
+    {
+        if (e.flat != NULL) {
+            ege_path_destroy(e.flat);
+            e.flat = NULL;
+        }
+    }
+
+    /// Drop least recently used entries until at most limit remain.
+    void evict(int limit)
+    {
+        while ((int)m_entries.size() > limit && !m_entries.empty()) {
+            std::map<const ege_path*, path_cache_entry>::iterator oldest = m_entries.begin();
+            for (std::map<const ege_path*, path_cache_entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+                if (it->second.lastUse < oldest->second.lastUse) {
+                    oldest = it;
+                }
+            }
+            release(oldest->second);
+            m_entries.erase(oldest);
+            ++m_evictions;
+        }
+    }
+
+    std::map<const ege_path*, path_cache_entry> m_entries;
+    std::vector<ege_point>                      m_points;
+    std::vector<unsigned char>                  m_types;
+    int                                         m_capacity;
+    unsigned long                               m_tick;
+    unsigned long                               m_hits, m_misses, m_invalidations, m_evictions;
+};
+
+inline path_cache& path_cache_instance()
+{
+    static path_cache cache;
+    return cache;
+}
+
+} // namespace detail
+
+/**
+ * @brief Fill a path, reusing its flattened geometry from earlier calls
+ * @param path Path object pointer
+ * @param mode Fill mode, FILLMODE_DEFAULT uses the mode set with ege_path_setfillmode() on GDI+
+ *        and FILLMODE_ALTERNATE on the native backend
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if path or the target is NULL, grAllocError if the
+ *         path could not be copied
+ * @note Same output as ege_render_fillpath() with the same mode. The checksum does not cover
+ *       the fill mode stored in the path, so call ege_path_cache_invalidate() after changing it
+ *       with ege_path_setfillmode() on a cached path.
+ */
+inline int ege_fillpath_cached(const ege_path* path, fill_mode mode = FILLMODE_DEFAULT, PIMAGE pimg = NULL)
+{
+    if (path == NULL) {
+        return grNullPointer;
+    }
+    ege_transform_matrix m;
+    ege_get_transform(&m, pimg);
+    float                     scale = detail::raster_scale(m);
+    detail::path_cache&       cache = detail::path_cache_instance();
+    detail::path_cache_entry* e     = cache.lookup(path, detail::RASTER_TOLERANCE / (scale > 0.0f ? scale : 1.0f));
+    if (e == NULL) {
+        return ege_render_fillpath(path, mode, pimg);
+    }
+    if (ege_get_render_backend() == RENDER_BACKEND_GDIPLUS) {
+        const ege_path* flat = cache.flattened(*e, path, mode);
+        if (flat == NULL) {
+            return grAllocError;
+        }
+        ege_fillpath(flat, pimg);
+        return grOk;
+    }
+    return detail::native_fill(e->contours, &m, detail::raster_evenodd(mode), pimg);
+}
+
+/**
+ * @brief Stroke a path, reusing its flattened geometry and outline from earlier calls
+ * @param path Path object pointer
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if path or the target is NULL, grAllocError if the
+ *         path could not be copied
+ * @note Same output as ege_render_drawpath(). The outline is rebuilt when the line width, caps
+ *       or joins change.
+ */
+inline int ege_drawpath_cached(const ege_path* path, PIMAGE pimg = NULL)
+{
+    if (path == NULL) {
+        return grNullPointer;
+    }
+    ege_transform_matrix m;
+    ege_get_transform(&m, pimg);
+    detail::raster_stroke_style st;
+    detail::raster_get_style(st, detail::raster_scale(m), pimg);
+    detail::path_cache&       cache = detail::path_cache_instance();
+    detail::path_cache_entry* e     = cache.lookup(path, st.tol);
+    if (e == NULL) {
+        return ege_render_drawpath(path, pimg);
+    }
+    if (ege_get_render_backend() == RENDER_BACKEND_GDIPLUS || detail::raster_dashed(pimg)) {
+        // Strokes ignore the fill mode; keep whichever the copy has.
+        const ege_path* flat = cache.flattened(*e, path, e->flatMode);
+        if (flat == NULL) {
+            return grAllocError;
+        }
+        ege_drawpath(flat, pimg);
+        return grOk;
+    }
+    st.tol = e->tol;
+    return detail::native_outline(cache.outline(*e, st), m, pimg);
+}
+
+/**
+ * @brief Drop the cached geometry of a path, e.g. before destroying it
+ * @param path Path object pointer
+ */
+inline void ege_path_cache_invalidate(const ege_path* path)
+{
+    detail::path_cache_instance().invalidate(path);
+}
+
+/**
+ * @brief Set the maximum number of cached paths
+ * @param capacity Maximum entry count, default is 256; 0 disables the cache
+ */
+inline void ege_path_cache_set_capacity(int capacity)
+{
+    detail::path_cache_instance().setCapacity(capacity);
+}
+
+/**
+ * @brief Get the counters of the flattened geometry cache
+ * @param stats Receives hits, misses, invalidations, evictions and entry count
+ */
+inline void ege_path_cache_get_stats(ege_path_cache_stats* stats)
+{
+    if (stats != NULL) {
+        detail::path_cache_instance().stats(stats);
+    }
+}
+
+/// @brief Reset the hit, miss, invalidation and eviction counters of the geometry cache
+inline void ege_path_cache_reset_stats()
+{
+    detail::path_cache_instance().resetStats();
+}
+
+/// @brief Drop all cached geometry
+inline void ege_path_cache_clear()
+{
+    detail::path_cache_instance().clear();
+}
+
+} // namespace ege
+
+#endif /* EGE_PATH_CACHE_H */
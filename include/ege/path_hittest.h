@@ -0,0 +1,284 @@
+/**
+ * @file path_hittest.h
+ * @brief Point-in-path and point-in-stroke tests for many points at once
+ *
+ * ege_path_inpath() and ege_path_instroke() go through GDI+ for every single point. The batch
+ * versions here flatten the path once, sort its edges into horizontal bins, and classify the
+ * points bin by bin with a crossing count along +x. With SSE2 four points are tested against
+ * an edge at a time; the bins are spread over the worker pool.
+ */
+#ifndef EGE_PATH_HITTEST_H
+#define EGE_PATH_HITTEST_H
+
+#include "raster.h"
+
+#include <string.h>
+
+namespace ege
+{
+
+namespace detail
+{
+
+struct hit_edge
+{
+    float x0, y0, y1;   ///< Upper end and y range [y0, y1)
+    float slope;        ///< dx/dy
+    int   dir;          ///< +1 if the edge went down, -1 if it went up
+};
+
+struct hit_job
+{
+    float                 minX, minY, maxX, maxY;
+    float                 binScale;
+    int                   bins, binsPerTask;
+    bool                  evenOdd;
+    std::vector<int>      edgeStart;    ///< Edges of bin b: binEdges[edgeStart[b], edgeStart[b + 1])
+    std::vector<hit_edge> binEdges;
+    std::vector<int>      pointStart;   ///< Points of bin b: order[pointStart[b], pointStart[b + 1])
+    std::vector<int>      order;
+    const ege_point*      points;
+    uint8_t*              out;
+};
+
+inline int hit_bin(const hit_job& job, float y)
+{
+    int b = (int)((y - job.minY) * job.binScale);
+    return b < 0 ? 0 : (b >= job.bins ? job.bins - 1 : b);
+}
+
+/// Build the binned edge table; false if the contours enclose nothing.
+inline bool hit_build(hit_job& job, const std::vector<raster_contour>& contours)
+{
+    std::vector<hit_edge> edges;
+    bool                  bounded = false;
+    for (size_t i = 0; i < contours.size(); ++i) {
+        const std::vector<ege_point>& pts = contours[i].pts;
+        for (size_t k = 0; k < pts.size(); ++k) {
+            const ege_point& a = pts[k];
+            const ege_point& b = pts[(k + 1) % pts.size()];
+            // The x bounds take every vertex, horizontal edges included.
+            if (!bounded) {
+                job.minX = job.maxX = a.x;
+                bounded             = true;
+            }
+            job.minX = std::min(job.minX, std::min(a.x, b.x));
+            job.maxX = std::max(job.maxX, std::max(a.x, b.x));
+            if (!(a.y != b.y)) {
+                continue;
+            }
+            hit_edge e;
+            e.dir   = a.y < b.y ? 1 : -1;
+            e.x0    = a.y < b.y ? a.x : b.x;
+            e.y0    = a.y < b.y ? a.y : b.y;
+            e.y1    = a.y < b.y ? b.y : a.y;
+            e.slope = (b.x - a.x) / (b.y - a.y);
+            if (edges.empty()) {
+                job.minY = e.y0;
+                job.maxY = e.y1;
+            }
+            job.minY = e.y0 < job.minY ? e.y0 : job.minY;
+            job.maxY = e.y1 > job.maxY ? e.y1 : job.maxY;
+            edges.push_back(e);
+        }
+    }
+    if (edges.empty()) {
+        return false;
+    }
+
+    int count    = (int)edges.size();
+    job.bins     = count < 16 ? 16 : (count > 4096 ? 4096 : count);
+    job.binScale = job.bins / (job.maxY - job.minY);
+    job.edgeStart.assign(job.bins + 1, 0);
+    for (int i = 0; i < count; ++i) {
+        for (int b = hit_bin(job, edges[i].y0), last = hit_bin(job, edges[i].y1); b <= last; ++b) {
+            ++job.edgeStart[b + 1];
+        }
+    }
+    for (int b = 0; b < job.bins; ++b) {
+        job.edgeStart[b + 1] += job.edgeStart[b];
+    }
+    job.binEdges.resize(job.edgeStart[job.bins]);
+    std::vector<int> fill(job.edgeStart.begin(), job.edgeStart.end() - 1);
+    for (int i = 0; i < count; ++i) {
+        for (int b = hit_bin(job, edges[i].y0), last = hit_bin(job, edges[i].y1); b <= last; ++b) {
+            job.binEdges[fill[b]++] = edges[i];
+        }
+    }
+    return true;
+}
+
+inline bool hit_inside(const hit_job& job, int winding)
+{
+    return job.evenOdd ? (winding & 1) != 0 : winding != 0;
+}
+
+inline void hit_points_scalar(const hit_job& job, const hit_edge* edges, int edgeCount, const int* idx, int n)
+{
+    for (int i = 0; i < n; ++i) {
+        const ege_point& p = job.points[idx[i]];
+        int              w = 0;
+        for (int k = 0; k < edgeCount; ++k) {
+            const hit_edge& e = edges[k];
+            if (p.y >= e.y0 && p.y < e.y1 && p.x < e.x0 + (p.y - e.y0) * e.slope) {
+                w += e.dir;
+            }
+        }
+        job.out[idx[i]] = hit_inside(job, w) ? 1 : 0;
+    }
+}
+
+#ifdef EGE_SIMD_X86
+EGE_SIMD_TARGET("sse2")
+inline void hit_points_sse2(const hit_job& job, const hit_edge* edges, int edgeCount, const int* idx, int n)
+{
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const ege_point *p0 = &job.points[idx[i]], *p1 = &job.points[idx[i + 1]];
+        const ege_point *p2 = &job.points[idx[i + 2]], *p3 = &job.points[idx[i + 3]];
+        __m128  px = _mm_setr_ps(p0->x, p1->x, p2->x, p3->x);
+        __m128  py = _mm_setr_ps(p0->y, p1->y, p2->y, p3->y);
+        __m128i w  = _mm_setzero_si128();
+        for (int k = 0; k < edgeCount; ++k) {
+            const hit_edge& e  = edges[k];
+            __m128          in = _mm_and_ps(_mm_cmpge_ps(py, _mm_set1_ps(e.y0)), _mm_cmplt_ps(py, _mm_set1_ps(e.y1)));
+            __m128          x  = _mm_add_ps(_mm_set1_ps(e.x0), _mm_mul_ps(_mm_sub_ps(py, _mm_set1_ps(e.y0)), _mm_set1_ps(e.slope)));
+            in                 = _mm_and_ps(in, _mm_cmplt_ps(px, x));
+            w                  = _mm_add_epi32(w, _mm_and_si128(_mm_castps_si128(in), _mm_set1_epi32(e.dir)));
+        }
+        int winding[4];
+        _mm_storeu_si128((__m128i*)winding, w);
+        for (int k = 0; k < 4; ++k) {
+            job.out[idx[i + k]] = hit_inside(job, winding[k]) ? 1 : 0;
+        }
+    }
+    hit_points_scalar(job, edges, edgeCount, idx + i, n - i);
+}
+#endif
+
+inline void hit_task(void* context, int index)
+{
+    const hit_job& job = *(const hit_job*)context;
+
+    bool sse2 = false;
+#ifdef EGE_SIMD_X86
+    sse2 = (ege_cpu_features() & CPU_FEATURE_SSE2) != 0;
+#endif
+    int first = index * job.binsPerTask, last = first + job.binsPerTask < job.bins ? first + job.binsPerTask : job.bins;
+    for (int b = first; b < last; ++b) {
+        int n = job.pointStart[b + 1] - job.pointStart[b];
+        if (n == 0) {
+            continue;
+        }
+        const hit_edge* edges     = job.binEdges.empty() ? NULL : &job.binEdges[job.edgeStart[b]];
+        int             edgeCount = job.edgeStart[b + 1] - job.edgeStart[b];
+        const int*      idx       = &job.order[job.pointStart[b]];
+#ifdef EGE_SIMD_X86
+        if (sse2) {
+            hit_points_sse2(job, edges, edgeCount, idx, n);
+            continue;
+        }
+#endif
+        (void)sse2;
+        hit_points_scalar(job, edges, edgeCount, idx, n);
+    }
+}
+
+/// Classify points against the contours, writing 1 (inside) or 0 to out.
+inline void hit_run(const std::vector<raster_contour>& contours, bool evenOdd, const ege_point* points, int n, uint8_t* out)
+{
+    hit_job job;
+    job.evenOdd = evenOdd;
+    job.points  = points;
+    job.out     = out;
+    if (!hit_build(job, contours)) {
+        memset(out, 0, n);
+        return;
+    }
+
+    // Counting sort of the points by bin; points outside the bounds are answered right away.
+    std::vector<int> bin(n);
+    job.pointStart.assign(job.bins + 1, 0);
+    for (int i = 0; i < n; ++i) {
+        const ege_point& p = points[i];
+        if (p.y >= job.minY && p.y < job.maxY && p.x >= job.minX && p.x < job.maxX) {
+            bin[i] = hit_bin(job, p.y);
+            ++job.pointStart[bin[i] + 1];
+        } else {
+            bin[i] = -1;
+            out[i] = 0;
+        }
+    }
+    for (int b = 0; b < job.bins; ++b) {
+        job.pointStart[b + 1] += job.pointStart[b];
+    }
+    job.order.resize(job.pointStart[job.bins] > 0 ? job.pointStart[job.bins] : 1);
+    std::vector<int> fill(job.pointStart.begin(), job.pointStart.end() - 1);
+    for (int i = 0; i < n; ++i) {
+        if (bin[i] >= 0) {
+            job.order[fill[bin[i]]++] = i;
+        }
+    }
+
+    int tasks       = job.bins < 64 ? job.bins : 64;
+    job.binsPerTask = (job.bins + tasks - 1) / tasks;
+    parallel_for((job.bins + job.binsPerTask - 1) / job.binsPerTask, hit_task, &job);
+}
+
+} // namespace detail
+
+/**
+ * @brief Test many points against the interior of a path
+ * @param path Path object pointer
+ * @param points Points to test, in path coordinates
+ * @param n Number of points
+ * @param out Receives 1 for each point inside the path and 0 otherwise
+ * @param mode Fill mode, FILLMODE_DEFAULT is the same as FILLMODE_ALTERNATE
+ * @return grOk on success, grNullPointer if path, points or out is NULL
+ */
+inline int ege_path_inpath_batch(const ege_path* path, const ege_point* points, int n, uint8_t* out,
+    fill_mode mode = FILLMODE_DEFAULT)
+{
+    if (path == NULL || ((points == NULL || out == NULL) && n > 0)) {
+        return grNullPointer;
+    }
+    if (n <= 0) {
+        return grOk;
+    }
+    std::vector<detail::raster_contour> contours;
+    detail::raster_read_path(path, NULL, detail::RASTER_TOLERANCE, contours);
+    detail::hit_run(contours, detail::raster_evenodd(mode), points, n, out);
+    return grOk;
+}
+
+/**
+ * @brief Test many points against the stroke of a path
+ * @param path Path object pointer
+ * @param points Points to test, in path coordinates
+ * @param n Number of points
+ * @param out Receives 1 for each point on the stroke and 0 otherwise
+ * @param pimg Image whose line width, caps and joins define the stroke, NULL means current ege window
+ * @return grOk on success, grNullPointer if path, points or out is NULL
+ */
+inline int ege_path_instroke_batch(const ege_path* path, const ege_point* points, int n, uint8_t* out, PCIMAGE pimg = NULL)
+{
+    if (path == NULL || ((points == NULL || out == NULL) && n > 0)) {
+        return grNullPointer;
+    }
+    if (n <= 0) {
+        return grOk;
+    }
+    detail::raster_stroke_style st;
+    detail::raster_get_style(st, 1.0f, pimg);
+    std::vector<detail::raster_contour> contours, outline;
+    detail::raster_read_path(path, NULL, st.tol, contours);
+    for (size_t i = 0; i < contours.size(); ++i) {
+        detail::raster_stroke(contours[i], st, outline);
+    }
+    detail::hit_run(outline, false, points, n, out);
+    return grOk;
+}
+
+} // namespace ege
+
+#endif /* EGE_PATH_HITTEST_H */
@@ -0,0 +1,689 @@
+/**
+ * @file raster.h
+ * @brief Native anti-aliased rasterizer for ege_ paths, polygons and lines
+ *
+ * The ege_ path functions render through GDI+, one call at a time on the calling thread. This
+ * header adds a scanline rasterizer that needs nothing but the image buffer, and a render
+ * backend switch that routes ege_render_fillpath(), ege_render_drawpath(), ege_render_fillpoly()
+ * and ege_render_line() either to GDI+ (the default) or to it.
+ *
+ * Coverage is computed exactly, the way font rasterizers do: each edge adds the signed area it
+ * covers to the cells it crosses, and a prefix sum along the scanline turns the accumulated
+ * values into winding coverage, to which the non-zero or even-odd rule is then applied. The
+ * target is split into horizontal bands that are accumulated and composited on the worker pool.
+ *
+ * Strokes are turned into an outline first (start/end caps from setlinecap(), joins and miter
+ * limit from setlinejoin()) and the outline is filled with the non-zero rule. Paths, polygons
+ * and strokes go through the image transform (ege_set_transform()); curves are flattened to
+ * within a tenth of a pixel.
+ *
+ * As with the other _f functions the native backend draws in image coordinates, ignoring the
+ * viewport, and it always anti-aliases. Dashed line styles are left to GDI+. The line width is
+ * read back with getlinestyle(), so fractional widths from setlinewidth() are rounded.
+ */
+#ifndef EGE_RASTER_H
+#define EGE_RASTER_H
+
+#include "shapes.h"
+
+#include <algorithm>
+
+namespace ege
+{
+
+/**
+ * @enum render_backend
+ * @brief Renderers for the ege_render_ functions
+ */
+enum render_backend
+{
+    RENDER_BACKEND_GDIPLUS = 0,     ///< GDI+, same as calling the ege_ functions directly
+    RENDER_BACKEND_NATIVE  = 1      ///< Built-in analytic coverage rasterizer
+};
+
+namespace detail
+{
+
+const float RASTER_TOLERANCE = 0.1f;   ///< Flattening tolerance in pixels
+
+struct raster_edge
+{
+    float x0, y0, x1, y1;   ///< y0 < y1
+    float dir;              ///< +1 if the edge went down, -1 if it went up
+};
+
+struct raster_contour
+{
+    std::vector<ege_point> pts;
+    bool                   closed;
+};
+
+struct raster_job
+{
+    shape_job                target;
+    std::vector<raster_edge> edges;     ///< Sorted by y0
+    int                      x0, y0, x1, y1;
+    bool                     evenOdd;
+    color_t                  color;
+};
+
+struct raster_state
+{
+    render_backend backend;
+};
+
+inline raster_state& raster_instance()
+{
+    static raster_state state = {RENDER_BACKEND_GDIPLUS};
+    return state;
+}
+
+/// Whether a fill mode selects the even-odd rule; FILLMODE_DEFAULT is alternate, as in GDI+.
+inline bool raster_evenodd(fill_mode mode)
+{
+    return mode != FILLMODE_WINDING;
+}
+
+/**
+ * Fill a path with GDI+, which reads the fill mode from the path object. FILLMODE_DEFAULT keeps
+ * the mode stored in the path; any other mode is applied to a copy, never to the caller's path.
+ */
+inline int raster_gdiplus_fill(const ege_path* path, fill_mode mode, PIMAGE pimg)
+{
+    if (mode == FILLMODE_DEFAULT) {
+        ege_fillpath(path, pimg);
+        return grOk;
+    }
+    ege_path* copy = ege_path_clone(path);
+    if (copy == NULL) {
+        return grAllocError;
+    }
+    ege_path_setfillmode(copy, mode);
+    ege_fillpath(copy, pimg);
+    ege_path_destroy(copy);
+    return grOk;
+}
+
+inline ege_point raster_point(float x, float y)
+{
+    ege_point p = {x, y};
+    return p;
+}
+
+inline ege_point raster_apply(const ege_transform_matrix& m, const ege_point& p)
+{
+    return raster_point(m.m11 * p.x + m.m21 * p.y + m.m31, m.m12 * p.x + m.m22 * p.y + m.m32);
+}
+
+/// Largest factor by which the matrix stretches a length.
+inline float raster_scale(const ege_transform_matrix& m)
+{
+    float sx = m.m11 * m.m11 + m.m12 * m.m12, sy = m.m21 * m.m21 + m.m22 * m.m22;
+    return sqrtf(sx > sy ? sx : sy);
+}
+
+inline void raster_cubic(std::vector<ege_point>& out, ege_point p0, ege_point p1, ege_point p2, ege_point p3, float tol)
+{
+    // A polyline of n segments stays within 3/4 * max|second difference| / n^2 of the curve.
+    float ax = p0.x - 2 * p1.x + p2.x, ay = p0.y - 2 * p1.y + p2.y;
+    float bx = p1.x - 2 * p2.x + p3.x, by = p1.y - 2 * p2.y + p3.y;
+    float dd = sqrtf(ax * ax + ay * ay > bx * bx + by * by ? ax * ax + ay * ay : bx * bx + by * by);
+    int   n  = (int)ceilf(sqrtf(0.75f * dd / tol));
+    n        = n < 1 ? 1 : (n > 1000 ? 1000 : n);
+    for (int i = 1; i <= n; ++i) {
+        float t = (float)i / n, u = 1.0f - t;
+        float a = u * u * u, b = 3 * u * u * t, c = 3 * u * t * t, d = t * t * t;
+        out.push_back(raster_point(a * p0.x + b * p1.x + c * p2.x + d * p3.x, a * p0.y + b * p1.y + c * p2.y + d * p3.y));
+    }
+}
+
+/// Split GDI+ path data into flattened contours.
+inline void raster_flatten(const ege_point* points, const unsigned char* types, int count, float tol, std::vector<raster_contour>& out)
+{
+    for (int i = 0; i < count; ++i) {
+        int type = types[i] & 0x07;
+        if (type == 0 || out.empty() || out.back().closed) {
+            out.push_back(raster_contour());
+            out.back().closed = false;
+            out.back().pts.push_back(points[i]);
+        } else if (type == 3 && i + 2 < count) {
+            raster_cubic(out.back().pts, out.back().pts.back(), points[i], points[i + 1], points[i + 2], tol);
+            i += 2;
+        } else {
+            out.back().pts.push_back(points[i]);
+        }
+        if (types[i] & 0x80) {
+            out.back().closed = true;
+        }
+    }
+}
+
+/// Read a path, flattened to tol, optionally mapped through m first.
+inline void raster_read_path(const ege_path* path, const ege_transform_matrix* m, float tol, std::vector<raster_contour>& out)
+{
+    int count = ege_path_pointcount(path);
+    if (count <= 0) {
+        return;
+    }
+    std::vector<ege_point>     points(count);
+    std::vector<unsigned char> types(count);
+    ege_path_getpathpoints(path, &points[0]);
+    ege_path_getpathtypes(path, &types[0]);
+    if (m != NULL) {
+        for (int i = 0; i < count; ++i) {
+            points[i] = raster_apply(*m, points[i]);
+        }
+    }
+    raster_flatten(&points[0], &types[0], count, tol, out);
+}
+
+inline void raster_arc(std::vector<ege_point>& out, ege_point c, float r, float start, float sweep, float tol)
+{
+    float step = r > tol ? 2.0f * acosf(1.0f - tol / r) : 1.0f;
+    int   n    = (int)ceilf(fabsf(sweep) / step);
+    n          = n < 1 ? 1 : (n > 1000 ? 1000 : n);
+    for (int i = 1; i <= n; ++i) {
+        float a = start + sweep * i / n;
+        out.push_back(raster_point(c.x + r * cosf(a), c.y + r * sinf(a)));
+    }
+}
+
+struct raster_stroke_style
+{
+    float          halfWidth;
+    line_cap_type  startCap, endCap;
+    line_join_type join;
+    float          miterLimit;
+    float          tol;
+};
+
+/// Append the left side of a polyline (consecutive points distinct) with its joins.
+inline void raster_offset_side(const std::vector<ege_point>& pts, bool closed, const raster_stroke_style& st, std::vector<ege_point>& out)
+{
+    const int   n  = (int)pts.size();
+    const float hw = st.halfWidth;
+    const int   segments = closed ? n : n - 1;
+    if (!closed) {
+        float dx = pts[1].x - pts[0].x, dy = pts[1].y - pts[0].y, len = sqrtf(dx * dx + dy * dy);
+        out.push_back(raster_point(pts[0].x - dy / len * hw, pts[0].y + dx / len * hw));
+    }
+    for (int i = closed ? 0 : 1; i < (closed ? n : n - 1); ++i) {
+        const ege_point& p = pts[i];
+        const ege_point& a = pts[(i + n - 1) % n];
+        const ege_point& b = pts[(i + 1) % n];
+        float d1x = p.x - a.x, d1y = p.y - a.y, l1 = sqrtf(d1x * d1x + d1y * d1y);
+        float d2x = b.x - p.x, d2y = b.y - p.y, l2 = sqrtf(d2x * d2x + d2y * d2y);
+        d1x /= l1, d1y /= l1, d2x /= l2, d2y /= l2;
+        float     cross = d1x * d2y - d1y * d2x, dot = d1x * d2x + d1y * d2y;
+        ege_point n1 = raster_point(-d1y, d1x), n2 = raster_point(-d2y, d2x);
+        ege_point q1 = raster_point(p.x + n1.x * hw, p.y + n1.y * hw), q2 = raster_point(p.x + n2.x * hw, p.y + n2.y * hw);
+
+        if (fabsf(cross) < 1e-6f && dot > 0.0f) {
+            out.push_back(q1);
+        } else if (cross > 0.0f) {
+            // Inner side: going through the vertex keeps the corner covered under the non-zero rule.
+            out.push_back(q1);
+            out.push_back(p);
+            out.push_back(q2);
+        } else if (st.join == LINEJOIN_ROUND) {
+            out.push_back(q1);
+            raster_arc(out, p, hw, atan2f(n1.y, n1.x), atan2f(cross, dot), st.tol);
+        } else {
+            out.push_back(q1);
+            float k = 1.0f + n1.x * n2.x + n1.y * n2.y;     // 2 cos^2(half the turn)
+            if (st.join == LINEJOIN_MITER && k > 1e-6f && 2.0f / k <= st.miterLimit * st.miterLimit) {
+                out.push_back(raster_point(p.x + (n1.x + n2.x) / k * hw, p.y + (n1.y + n2.y) / k * hw));
+            }
+            out.push_back(q2);
+        }
+    }
+    if (!closed) {
+        const ege_point& a = pts[segments - 1];
+        const ege_point& p = pts[segments];
+        float dx = p.x - a.x, dy = p.y - a.y, len = sqrtf(dx * dx + dy * dy);
+        out.push_back(raster_point(p.x - dy / len * hw, p.y + dx / len * hw));
+    }
+}
+
+/// Cap at p heading along unit d, from p + n to p - n where n is d turned left.
+inline void raster_cap(std::vector<ege_point>& out, ege_point p, float dx, float dy, line_cap_type cap, const raster_stroke_style& st)
+{
+    float hw = st.halfWidth;
+    if (cap == LINECAP_SQUARE) {
+        out.push_back(raster_point(p.x - dy * hw + dx * hw, p.y + dx * hw + dy * hw));
+        out.push_back(raster_point(p.x + dy * hw + dx * hw, p.y - dx * hw + dy * hw));
+    } else if (cap == LINECAP_ROUND) {
+        raster_arc(out, p, hw, atan2f(dx, -dy), -3.14159265f, st.tol);
+    }
+}
+
+/// Outline a flattened contour; the result is meant to be filled with the non-zero rule.
+inline void raster_stroke(const raster_contour& c, const raster_stroke_style& st, std::vector<raster_contour>& out)
+{
+    std::vector<ege_point> pts;
+    for (size_t i = 0; i < c.pts.size(); ++i) {
+        const ege_point& p = c.pts[i];
+        if (pts.empty() || fabsf(p.x - pts.back().x) > 1e-5f || fabsf(p.y - pts.back().y) > 1e-5f) {
+            pts.push_back(p);
+        }
+    }
+    bool closed = c.closed;
+    while (closed && pts.size() > 1 && fabsf(pts[0].x - pts.back().x) <= 1e-5f && fabsf(pts[0].y - pts.back().y) <= 1e-5f) {
+        pts.pop_back();
+    }
+    if (pts.empty()) {
+        return;
+    }
+
+    raster_contour outline;
+    outline.closed = true;
+    if (pts.size() == 1) {
+        // A lone point only shows with round or square caps.
+        raster_cap(outline.pts, pts[0], 1.0f, 0.0f, st.endCap, st);
+        raster_cap(outline.pts, pts[0], -1.0f, 0.0f, st.startCap, st);
+        if (outline.pts.size() > 2) {
+            out.push_back(outline);
+        }
+        return;
+    }
+
+    std::vector<ege_point> reversed(pts.rbegin(), pts.rend());
+    if (closed) {
+        raster_offset_side(pts, true, st, outline.pts);
+        out.push_back(outline);
+        outline.pts.clear();
+        raster_offset_side(reversed, true, st, outline.pts);
+        out.push_back(outline);
+        return;
+    }
+
+    size_t n  = pts.size();
+    float  ex = pts[n - 1].x - pts[n - 2].x, ey = pts[n - 1].y - pts[n - 2].y, el = sqrtf(ex * ex + ey * ey);
+    float  sx = pts[0].x - pts[1].x, sy = pts[0].y - pts[1].y, sl = sqrtf(sx * sx + sy * sy);
+    raster_offset_side(pts, false, st, outline.pts);
+    raster_cap(outline.pts, pts[n - 1], ex / el, ey / el, st.endCap, st);
+    raster_offset_side(reversed, false, st, outline.pts);
+    raster_cap(outline.pts, pts[0], sx / sl, sy / sl, st.startCap, st);
+    out.push_back(outline);
+}
+
+inline void raster_push_edge(raster_job& job, float x0, float y0, float x1, float y1)
+{
+    if (y0 == y1) {
+        return;
+    }
+    raster_edge e;
+    e.dir = y0 < y1 ? 1.0f : -1.0f;
+    if (y0 < y1) {
+        e.x0 = x0, e.y0 = y0, e.x1 = x1, e.y1 = y1;
+    } else {
+        e.x0 = x1, e.y0 = y1, e.x1 = x0, e.y1 = y0;
+    }
+    job.edges.push_back(e);
+}
+
+/**
+ * Add a line, clipped horizontally to the target. Parts left of it move onto x = 0, where they
+ * still cover the whole row; parts right of it cannot affect any pixel and are dropped.
+ */
+inline void raster_add_line(raster_job& job, ege_point a, ege_point b)
+{
+    if (!(a.y == a.y && b.y == b.y && a.x == a.x && b.x == b.x) || a.y == b.y) {
+        return;
+    }
+    const float w = (float)job.target.w;
+    float       t[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+    int         nt   = 1;
+    if (a.x != b.x) {
+        float t0 = (0.0f - a.x) / (b.x - a.x), tw = (w - a.x) / (b.x - a.x);
+        if (t0 > 0.0f && t0 < 1.0f) t[nt++] = t0;
+        if (tw > 0.0f && tw < 1.0f) t[nt++] = tw;
+        if (nt == 3 && t[1] > t[2]) {
+            float s = t[1];
+            t[1] = t[2], t[2] = s;
+        }
+    }
+    t[nt] = 1.0f;
+    for (int i = 0; i < nt; ++i) {
+        float ya = a.y + (b.y - a.y) * t[i], yb = a.y + (b.y - a.y) * t[i + 1];
+        float xa = a.x + (b.x - a.x) * t[i], xb = a.x + (b.x - a.x) * t[i + 1];
+        float xm = (xa + xb) * 0.5f;
+        if (xm >= w) {
+            continue;
+        }
+        if (xm <= 0.0f) {
+            xa = xb = 0.0f;
+        }
+        xa = xa < 0.0f ? 0.0f : (xa > w ? w : xa);
+        xb = xb < 0.0f ? 0.0f : (xb > w ? w : xb);
+        raster_push_edge(job, xa, ya, xb, yb);
+    }
+}
+
+inline void raster_add_contours(raster_job& job, const std::vector<raster_contour>& contours, const ege_transform_matrix* m)
+{
+    for (size_t i = 0; i < contours.size(); ++i) {
+        const std::vector<ege_point>& pts = contours[i].pts;
+        for (size_t k = 0; k < pts.size(); ++k) {
+            ege_point a = pts[k], b = pts[(k + 1) % pts.size()];
+            if (m != NULL) {
+                a = raster_apply(*m, a);
+                b = raster_apply(*m, b);
+            }
+            raster_add_line(job, a, b);
+        }
+    }
+}
+
+inline bool raster_edge_less(const raster_edge& a, const raster_edge& b)
+{
+    return a.y0 < b.y0;
+}
+
+/// Accumulate the signed area of the part of an edge inside rows [ya, yb) into acc.
+inline void raster_accumulate(const raster_edge& e, int ya, int yb, int xoff, int stride, float* acc)
+{
+    const float dxdy = (e.x1 - e.x0) / (e.y1 - e.y0);
+    int         y0   = (int)floorf(e.y0), y1 = (int)ceilf(e.y1);
+    y0               = y0 < ya ? ya : y0;
+    y1               = y1 > yb ? yb : y1;
+    for (int y = y0; y < y1; ++y) {
+        float top = e.y0 > y ? e.y0 : (float)y, bottom = e.y1 < y + 1 ? e.y1 : (float)(y + 1);
+        float dy  = bottom - top;
+        if (dy <= 0.0f) {
+            continue;
+        }
+        float  x     = e.x0 + (top - e.y0) * dxdy - xoff;
+        float  xnext = e.x0 + (bottom - e.y0) * dxdy - xoff;
+        float  d     = dy * e.dir;
+        float  xl    = x < xnext ? x : xnext, xr = x < xnext ? xnext : x;
+        float* a     = acc + (size_t)(y - ya) * stride;
+        float  xlf   = floorf(xl);
+        int    il    = (int)xlf;
+        float  xrc   = ceilf(xr);
+        int    ir    = (int)xrc;
+        if (ir <= il + 1) {
+            // Within one cell: the part right of the edge's mean x goes to the cell, the rest further.
+            float xm = 0.5f * (x + xnext) - xlf;
+            a[il] += d - d * xm;
+            a[il + 1] += d * xm;
+        } else {
+            float s   = 1.0f / (xr - xl);
+            float xf0 = xl - xlf;
+            float a0  = 0.5f * s * (1.0f - xf0) * (1.0f - xf0);
+            float xf1 = xr - xrc + 1.0f;
+            float am  = 0.5f * s * xf1 * xf1;
+            a[il] += d * a0;
+            if (ir == il + 2) {
+                a[il + 1] += d * (1.0f - a0 - am);
+            } else {
+                float a1 = s * (1.5f - xf0);
+                a[il + 1] += d * (a1 - a0);
+                for (int i = il + 2; i < ir - 1; ++i) {
+                    a[i] += d * s;
+                }
+                float a2 = a1 + (ir - il - 3) * s;
+                a[ir - 1] += d * (1.0f - a2 - am);
+            }
+            a[ir] += d * am;
+        }
+    }
+}
+
+inline void raster_band_task(void* context, int index)
+{
+    const raster_job& job = *(const raster_job*)context;
+
+    int ya = job.y0 + index * SHAPE_BAND, yb = ya + SHAPE_BAND < job.y1 ? ya + SHAPE_BAND : job.y1;
+    int width = job.x1 - job.x0, stride = width + 2;
+
+    std::vector<float> acc((size_t)stride * (yb - ya), 0.0f);
+    for (size_t i = 0; i < job.edges.size(); ++i) {
+        const raster_edge& e = job.edges[i];
+        if (e.y0 >= yb) {
+            break;
+        }
+        if (e.y1 > ya) {
+            raster_accumulate(e, ya, yb, job.x0, stride, &acc[0]);
+        }
+    }
+
+    std::vector<color_t> line;
+    for (int y = ya; y < yb; ++y) {
+        const float* a   = &acc[(size_t)(y - ya) * stride];
+        color_t*     row = job.target.dst + (size_t)y * job.target.stride;
+        float        sum = 0.0f;
+        int          run = -1;      // start of a run of fully covered pixels
+        for (int i = 0; i < width; ++i) {
+            sum += a[i];
+            float v = fabsf(sum);
+            if (job.evenOdd) {
+                v = fmodf(v, 2.0f);
+                v = v > 1.0f ? 2.0f - v : v;
+            }
+            if (v >= 0.998f) {
+                run = run < 0 ? i : run;
+                continue;
+            }
+            if (run >= 0) {
+                shape_run(job.target, row, job.x0 + run, job.x0 + i, job.color, line);
+                run = -1;
+            }
+            shape_plot(row[job.x0 + i], job.color, v);
+        }
+        if (run >= 0) {
+            shape_run(job.target, row, job.x0 + run, job.x0 + width, job.color, line);
+        }
+    }
+}
+
+inline bool raster_begin(raster_job& job, PIMAGE pimg, color_t color, bool evenOdd)
+{
+    job.color   = color;
+    job.evenOdd = evenOdd;
+    return shape_begin(job.target, pimg, 0);
+}
+
+/// Rasterize the collected edges and composite them onto the target.
+inline void raster_finish(raster_job& job, PIMAGE pimg)
+{
+    if (job.edges.empty() || (job.color >> 24) == 0) {
+        return;
+    }
+    float minX = job.edges[0].x0, maxX = minX, minY = job.edges[0].y0, maxY = job.edges[0].y1;
+    for (size_t i = 0; i < job.edges.size(); ++i) {
+        const raster_edge& e = job.edges[i];
+        minX = std::min(minX, std::min(e.x0, e.x1));
+        maxX = std::max(maxX, std::max(e.x0, e.x1));
+        minY = e.y0 < minY ? e.y0 : minY;
+        maxY = e.y1 > maxY ? e.y1 : maxY;
+    }
+    job.x0 = (int)floorf(minX);
+    job.x1 = (int)ceilf(maxX) + 1;
+    job.y0 = minY < 0.0f ? 0 : (int)floorf(minY);
+    job.y1 = maxY > job.target.h ? job.target.h : (int)ceilf(maxY);
+    job.x0 = job.x0 < 0 ? 0 : job.x0;
+    job.x1 = job.x1 > job.target.w ? job.target.w : job.x1;
+    if (job.x0 >= job.x1 || job.y0 >= job.y1) {
+        return;
+    }
+    std::sort(job.edges.begin(), job.edges.end(), raster_edge_less);
+    parallel_for((job.y1 - job.y0 + SHAPE_BAND - 1) / SHAPE_BAND, raster_band_task, &job);
+    dirty_note(pimg, job.x0, job.y0, job.x1 - job.x0, job.y1 - job.y0);
+}
+
+inline void raster_get_style(raster_stroke_style& st, float scale, PCIMAGE pimg)
+{
+    int thickness = 1;
+    getlinestyle(NULL, NULL, &thickness, pimg);
+    getlinecap(&st.startCap, &st.endCap, pimg);
+    getlinejoin(&st.join, &st.miterLimit, pimg);
+    st.halfWidth = (thickness > 0 ? thickness : 1) * 0.5f;
+    st.tol       = RASTER_TOLERANCE / (scale > 0.0f ? scale : 1.0f);
+}
+
+inline bool raster_dashed(PIMAGE pimg)
+{
+    int style = SOLID_LINE;
+    getlinestyle(&style, NULL, NULL, pimg);
+    return (style & 0x0F) != SOLID_LINE;
+}
+
+inline int native_fill(const std::vector<raster_contour>& contours, const ege_transform_matrix* m, bool evenOdd, PIMAGE pimg)
+{
+    raster_job job;
+    if (!raster_begin(job, pimg, getfillcolor(pimg), evenOdd)) {
+        return grNullPointer;
+    }
+    raster_add_contours(job, contours, m);
+    raster_finish(job, pimg);
+    return grOk;
+}
+
+/// Fill a stroke outline built by raster_stroke() with the line color.
+inline int native_outline(const std::vector<raster_contour>& outline, const ege_transform_matrix& m, PIMAGE pimg)
+{
+    raster_job job;
+    if (!raster_begin(job, pimg, getlinecolor(pimg), false)) {
+        return grNullPointer;
+    }
+    raster_add_contours(job, outline, &m);
+    raster_finish(job, pimg);
+    return grOk;
+}
+
+inline int native_stroke(const std::vector<raster_contour>& contours, const ege_transform_matrix& m, const raster_stroke_style& st, PIMAGE pimg)
+{
+    std::vector<raster_contour> outline;
+    for (size_t i = 0; i < contours.size(); ++i) {
+        raster_stroke(contours[i], st, outline);
+    }
+    return native_outline(outline, m, pimg);
+}
+
+} // namespace detail
+
+/**
+ * @brief Select the renderer used by the ege_render_ functions
+ * @param backend RENDER_BACKEND_GDIPLUS (default) or RENDER_BACKEND_NATIVE
+ */
+inline void ege_set_render_backend(render_backend backend)
+{
+    detail::raster_instance().backend = backend;
+}
+
+/**
+ * @brief Get the renderer used by the ege_render_ functions
+ * @return Current render backend
+ */
+inline render_backend ege_get_render_backend()
+{
+    return detail::raster_instance().backend;
+}
+
+/**
+ * @brief Fill a path with the current fill color
+ * @param path Path object pointer
+ * @param mode Fill mode, FILLMODE_DEFAULT uses the mode set with ege_path_setfillmode() on GDI+
+ *        and FILLMODE_ALTERNATE on the native backend
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if path or the target is NULL, grAllocError if the
+ *         path could not be copied
+ * @note The native backend cannot read the fill mode back from the path, so pass
+ *       FILLMODE_ALTERNATE or FILLMODE_WINDING for the same result on both backends. With GDI+
+ *       an explicit mode is applied to a temporary copy; the path itself is never modified.
+ */
+inline int ege_render_fillpath(const ege_path* path, fill_mode mode = FILLMODE_DEFAULT, PIMAGE pimg = NULL)
+{
+    if (path == NULL) {
+        return grNullPointer;
+    }
+    if (ege_get_render_backend() == RENDER_BACKEND_GDIPLUS) {
+        return detail::raster_gdiplus_fill(path, mode, pimg);
+    }
+    ege_transform_matrix m;
+    ege_get_transform(&m, pimg);
+    std::vector<detail::raster_contour> contours;
+    detail::raster_read_path(path, &m, detail::RASTER_TOLERANCE, contours);
+    return detail::native_fill(contours, NULL, detail::raster_evenodd(mode), pimg);
+}
+
+/**
+ * @brief Stroke a path with the current line color, width, caps and joins
+ * @param path Path object pointer
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if path or the target is NULL
+ */
+inline int ege_render_drawpath(const ege_path* path, PIMAGE pimg = NULL)
+{
+    if (path == NULL) {
+        return grNullPointer;
+    }
+    if (ege_get_render_backend() == RENDER_BACKEND_GDIPLUS || detail::raster_dashed(pimg)) {
+        ege_drawpath(path, pimg);
+        return grOk;
+    }
+    ege_transform_matrix m;
+    ege_get_transform(&m, pimg);
+    detail::raster_stroke_style st;
+    detail::raster_get_style(st, detail::raster_scale(m), pimg);
+    std::vector<detail::raster_contour> contours;
+    detail::raster_read_path(path, NULL, st.tol, contours);
+    return detail::native_stroke(contours, m, st, pimg);
+}
+
+/**
+ * @brief Fill a polygon with the current fill color (alternate fill mode)
+ * @param numOfPoints Number of points
+ * @param points Polygon vertices
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if points or the target is NULL
+ */
+inline int ege_render_fillpoly(int numOfPoints, const ege_point* points, PIMAGE pimg = NULL)
+{
+    if (points == NULL && numOfPoints > 0) {
+        return grNullPointer;
+    }
+    if (ege_get_render_backend() == RENDER_BACKEND_GDIPLUS) {
+        ege_fillpoly(numOfPoints, points, pimg);
+        return grOk;
+    }
+    ege_transform_matrix m;
+    ege_get_transform(&m, pimg);
+    std::vector<detail::raster_contour> contours(1);
+    contours[0].closed = true;
+    for (int i = 0; i < numOfPoints; ++i) {
+        contours[0].pts.push_back(detail::raster_apply(m, points[i]));
+    }
+    return detail::native_fill(contours, NULL, true, pimg);
+}
+
+/**
+ * @brief Draw a line with the current line color, width and caps
+ * @param x1 Start point x coordinate
+ * @param y1 Start point y coordinate
+ * @param x2 End point x coordinate
+ * @param y2 End point y coordinate
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if the target is NULL
+ */
+inline int ege_render_line(float x1, float y1, float x2, float y2, PIMAGE pimg = NULL)
+{
+    if (ege_get_render_backend() == RENDER_BACKEND_GDIPLUS || detail::raster_dashed(pimg)) {
+        ege_line(x1, y1, x2, y2, pimg);
+        return grOk;
+    }
+    ege_transform_matrix m;
+    ege_get_transform(&m, pimg);
+    detail::raster_stroke_style st;
+    detail::raster_get_style(st, detail::raster_scale(m), pimg);
+    std::vector<detail::raster_contour> contours(1);
+    contours[0].closed = false;
+    contours[0].pts.push_back(detail::raster_point(x1, y1));
+    contours[0].pts.push_back(detail::raster_point(x2, y2));
+    return detail::native_stroke(contours, m, st, pimg);
+}
+
+} // namespace ege
+
+#endif /* EGE_RASTER_H */
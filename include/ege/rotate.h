@@ -0,0 +1,432 @@
+/**
+ * @file rotate.h
+ * @brief Tiled, multithreaded versions of putimage_rotate, putimage_rotatezoom and putimage_rotatetransparent
+ *
+ * The destination area covered by the rotated image is split into 64x64 tiles that are
+ * processed on the worker pool (see ege_set_worker_threads() in ege/parallel.h). Source
+ * coordinates are stepped incrementally in 16.16 fixed point along each row, and only the
+ * part of the row that maps inside the source rectangle is visited. Bilinear sampling
+ * (smooth = true) uses SSE2 when available, with the same result as the scalar path.
+ *
+ * The functions take the same parameters as their library counterparts. Like the other
+ * _f functions of EGE they work in image coordinates and ignore the viewport.
+ */
+#ifndef EGE_ROTATE_H
+#define EGE_ROTATE_H
+
+#include "blend.h"
+#include "parallel.h"
+
+#include <math.h>
+
+namespace ege
+{
+
+namespace detail
+{
+
+enum rotate_mode
+{
+    ROTATE_OPAQUE,  ///< Source alpha ignored
+    ROTATE_ALPHA,   ///< Source alpha channel used (premultiplied)
+    ROTATE_KEY      ///< Pixels of the transparent color skipped
+};
+
+struct rotate_job;
+typedef void (*rotate_row_fn)(const rotate_job& job, int y, int xa, int xb);
+
+struct rotate_job
+{
+    const color_t* src;
+    int            srcStride;
+    int            sx0, sy0, sx1, sy1;    ///< Source rectangle
+    color_t*       dst;
+    int            dstStride;
+    int            x0, y0, x1, y1;        ///< Destination bounding box, clipped
+    int            tilesX;
+    double         u0, v0;                ///< Source position of the center of destination pixel (0, 0)
+    double         dudx, dvdx, dudy, dvdy;
+    int            du, dv;                ///< 16.16 steps along a row
+    color_t        key;
+    unsigned int   alpha;                 ///< Overall alpha, 0-255
+    rotate_row_fn  row;
+};
+
+const int ROTATE_TILE = 64;
+
+/// Smallest zoom whose source steps (up to 1 / zoom per pixel) still fit the 16.16 fixed point.
+const double ROTATE_MIN_ZOOM = 1.0 / 16384;
+
+inline int rotate_fixed(double x)
+{
+    return (int)floor(x * 65536.0 + 0.5);
+}
+
+/// Narrow [xa, xb) to the x for which start + x * step lies in [lo, hi), with a one pixel margin.
+inline void rotate_span(double start, double step, double lo, double hi, int& xa, int& xb)
+{
+    if (fabs(step) < 1e-12) {
+        if (start < lo - 1.0 || start > hi + 1.0) {
+            xb = xa;
+        }
+        return;
+    }
+    double ta = (lo - start) / step, tb = (hi - start) / step;
+    if (ta > tb) {
+        double t = ta;
+        ta       = tb;
+        tb       = t;
+    }
+    if (ta - 1.0 > xa) xa = ta - 1.0 > xb ? xb : (int)(ta - 1.0);
+    if (tb + 2.0 < xb) xb = tb + 2.0 < xa ? xa : (int)(tb + 2.0);
+}
+
+inline void rotate_put(color_t& d, color_t s, unsigned int alpha)
+{
+    if (alpha != 255) {
+        s = (blend_mul255(s >> 24, alpha) << 24) | (blend_mul255((s >> 16) & 0xFF, alpha) << 16) |
+            (blend_mul255((s >> 8) & 0xFF, alpha) << 8) | blend_mul255(s & 0xFF, alpha);
+    }
+    if ((s >> 24) == 255) {
+        d = s;
+    } else if (s != 0) {
+        d = blend_pixel(d, s, 255, 0);
+    }
+}
+
+/// Bilinear interpolation of four texels with 8-bit weights, shared by all sampling paths.
+inline color_t rotate_lerp(color_t p00, color_t p01, color_t p10, color_t p11, unsigned int fx, unsigned int fy)
+{
+    color_t r = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        unsigned int top = (((p00 >> shift) & 0xFF) * (256 - fx) + ((p01 >> shift) & 0xFF) * fx) >> 8;
+        unsigned int bot = (((p10 >> shift) & 0xFF) * (256 - fx) + ((p11 >> shift) & 0xFF) * fx) >> 8;
+        r |= ((top * (256 - fy) + bot * fy) >> 8) << shift;
+    }
+    return r;
+}
+
+struct rotate_sampler_scalar
+{
+    static color_t sample(const color_t* p, int stride, unsigned int fx, unsigned int fy, color_t orMask)
+    {
+        return rotate_lerp(p[0] | orMask, p[1] | orMask, p[stride] | orMask, p[stride + 1] | orMask, fx, fy);
+    }
+};
+
+#ifdef EGE_SIMD_X86
+struct rotate_sampler_sse2
+{
+    EGE_SIMD_TARGET("sse2")
+    static color_t sample(const color_t* p, int stride, unsigned int fx, unsigned int fy, color_t orMask)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i mask = _mm_set1_epi32((int)orMask);
+        const __m128i wx   = _mm_set_epi16((short)fx, (short)fx, (short)fx, (short)fx, (short)(256 - fx),
+            (short)(256 - fx), (short)(256 - fx), (short)(256 - fx));
+
+        __m128i top = _mm_or_si128(_mm_loadl_epi64((const __m128i*)p), mask);
+        __m128i bot = _mm_or_si128(_mm_loadl_epi64((const __m128i*)(p + stride)), mask);
+        top = _mm_mullo_epi16(_mm_unpacklo_epi8(top, zero), wx);
+        bot = _mm_mullo_epi16(_mm_unpacklo_epi8(bot, zero), wx);
+        top = _mm_srli_epi16(_mm_add_epi16(top, _mm_srli_si128(top, 8)), 8);
+        bot = _mm_srli_epi16(_mm_add_epi16(bot, _mm_srli_si128(bot, 8)), 8);
+
+        __m128i r = _mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16((short)(256 - fy))),
+            _mm_mullo_epi16(bot, _mm_set1_epi16((short)fy)));
+        r = _mm_srli_epi16(r, 8);
+        return (color_t)_mm_cvtsi128_si32(_mm_packus_epi16(r, r));
+    }
+};
+#endif
+
+/// Bilinear sample touching the source border: texels outside the rectangle are transparent.
+inline color_t rotate_sample_edge(const rotate_job& job, int ix, int iy, unsigned int fx, unsigned int fy,
+    color_t orMask)
+{
+    color_t p[4];
+    for (int i = 0; i < 4; ++i) {
+        int x = ix + (i & 1), y = iy + (i >> 1);
+        p[i]  = (x >= job.sx0 && x < job.sx1 && y >= job.sy0 && y < job.sy1)
+                    ? (job.src[(size_t)y * job.srcStride + x] | orMask) : 0;
+    }
+    return rotate_lerp(p[0], p[1], p[2], p[3], fx, fy);
+}
+
+template <int Mode, bool Smooth, class Sampler>
+inline void rotate_row(const rotate_job& job, int y, int xa, int xb)
+{
+    double fu = job.u0 + y * job.dudy, fv = job.v0 + y * job.dvdy;
+    if (Smooth) {
+        // Sample positions relative to texel centers; the one texel apron fades the edges.
+        fu -= 0.5;
+        fv -= 0.5;
+        rotate_span(fu, job.dudx, job.sx0 - 1.0, (double)job.sx1, xa, xb);
+        rotate_span(fv, job.dvdx, job.sy0 - 1.0, (double)job.sy1, xa, xb);
+    } else {
+        rotate_span(fu, job.dudx, job.sx0, job.sx1, xa, xb);
+        rotate_span(fv, job.dvdx, job.sy0, job.sy1, xa, xb);
+    }
+    if (xa >= xb) {
+        return;
+    }
+
+    const color_t  orMask = Mode == ROTATE_OPAQUE ? 0xFF000000 : 0;
+    const color_t  key    = job.key & 0x00FFFFFF;
+    const int      stride = job.srcStride;
+    color_t*       d      = job.dst + (size_t)y * job.dstStride;
+    int            u      = rotate_fixed(fu + xa * job.dudx);
+    int            v      = rotate_fixed(fv + xa * job.dvdx);
+
+    for (int x = xa; x < xb; ++x, u += job.du, v += job.dv) {
+        int ix = u >> 16, iy = v >> 16;
+        if (!Smooth) {
+            if (ix < job.sx0 || ix >= job.sx1 || iy < job.sy0 || iy >= job.sy1) {
+                continue;
+            }
+            color_t s = job.src[(size_t)iy * stride + ix];
+            if (Mode == ROTATE_KEY) {
+                if ((s & 0x00FFFFFF) != key) {
+                    d[x] = s;
+                }
+                continue;
+            }
+            rotate_put(d[x], s | orMask, job.alpha);
+        } else {
+            if (ix < job.sx0 - 1 || ix >= job.sx1 || iy < job.sy0 - 1 || iy >= job.sy1) {
+                continue;
+            }
+            unsigned int fx = (u >> 8) & 0xFF, fy = (v >> 8) & 0xFF;
+            color_t      s;
+            if (ix >= job.sx0 && ix + 1 < job.sx1 && iy >= job.sy0 && iy + 1 < job.sy1) {
+                s = Sampler::sample(job.src + (size_t)iy * stride + ix, stride, fx, fy, orMask);
+            } else {
+                s = rotate_sample_edge(job, ix, iy, fx, fy, orMask);
+            }
+            rotate_put(d[x], s, job.alpha);
+        }
+    }
+}
+
+inline void rotate_tile(void* context, int index)
+{
+    const rotate_job& job = *(const rotate_job*)context;
+
+    int xa = job.x0 + (index % job.tilesX) * ROTATE_TILE;
+    int ya = job.y0 + (index / job.tilesX) * ROTATE_TILE;
+    int xb = xa + ROTATE_TILE < job.x1 ? xa + ROTATE_TILE : job.x1;
+    int yb = ya + ROTATE_TILE < job.y1 ? ya + ROTATE_TILE : job.y1;
+    for (int y = ya; y < yb; ++y) {
+        job.row(job, y, xa, xb);
+    }
+}
+
+template <int Mode, bool Smooth>
+inline rotate_row_fn rotate_select_row()
+{
+#ifdef EGE_SIMD_X86
+    if (Smooth && (ege_cpu_features() & CPU_FEATURE_SSE2)) {
+        return rotate_row<Mode, Smooth, rotate_sampler_sse2>;
+    }
+#endif
+    return rotate_row<Mode, Smooth, rotate_sampler_scalar>;
+}
+
+/**
+ * Draw the source rectangle [sx, sx + sw) x [sy, sy + sh) of imgSrc rotated by radian
+ * (clockwise) and scaled by zoom, with source point (xCenterSrc, yCenterSrc) landing on
+ * destination point (xCenterDest, yCenterDest).
+ */
+inline int rotate_draw(PIMAGE imgDest, PCIMAGE imgSrc, int sx, int sy, int sw, int sh, double xCenterDest,
+    double yCenterDest, double xCenterSrc, double yCenterSrc, double radian, double zoom, int mode, bool smooth,
+    unsigned int alpha, color_t key)
+{
+    if (imgSrc == NULL) {
+        return grNullPointer;
+    }
+    if (!(zoom >= ROTATE_MIN_ZOOM)) {
+        return grParamError;
+    }
+
+    int srcW = getwidth(imgSrc), srcH = getheight(imgSrc);
+    int dstW = getwidth(imgDest), dstH = getheight(imgDest);
+    if (sx < 0) { sw += sx; sx = 0; }
+    if (sy < 0) { sh += sy; sy = 0; }
+    if (sx + sw > srcW) sw = srcW - sx;
+    if (sy + sh > srcH) sh = srcH - sy;
+    if (sw <= 0 || sh <= 0 || alpha == 0) {
+        return grInvalidRegion;
+    }
+
+    rotate_job job;
+    double     c = cos(radian), s = sin(radian);
+
+    // Destination bounding box of the transformed source rectangle.
+    double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+    for (int i = 0; i < 4; ++i) {
+        double px = ((i & 1) ? sx + sw : sx) - xCenterSrc, py = ((i >> 1) ? sy + sh : sy) - yCenterSrc;
+        double qx = (px * c - py * s) * zoom + xCenterDest, qy = (px * s + py * c) * zoom + yCenterDest;
+        if (qx < minX) minX = qx;
+        if (qx > maxX) maxX = qx;
+        if (qy < minY) minY = qy;
+        if (qy > maxY) maxY = qy;
+    }
+    // Also rejects boxes that are NaN or too far away to convert to int.
+    if (!(maxX > 0.0 && maxY > 0.0 && minX < dstW && minY < dstH)) {
+        return grInvalidRegion;
+    }
+    job.x0 = minX < 0.0 ? 0 : (int)floor(minX) - 1;
+    job.y0 = minY < 0.0 ? 0 : (int)floor(minY) - 1;
+    job.x1 = maxX >= dstW ? dstW : (int)ceil(maxX) + 1;
+    job.y1 = maxY >= dstH ? dstH : (int)ceil(maxY) + 1;
+    if (job.x0 < 0) job.x0 = 0;
+    if (job.y0 < 0) job.y0 = 0;
+    if (job.x1 > dstW) job.x1 = dstW;
+    if (job.y1 > dstH) job.y1 = dstH;
+    if (job.x0 >= job.x1 || job.y0 >= job.y1) {
+        return grInvalidRegion;
+    }
+
+    job.src       = getbuffer(imgSrc);
+    job.srcStride = srcW;
+    job.sx0       = sx;
+    job.sy0       = sy;
+    job.sx1       = sx + sw;
+    job.sy1       = sy + sh;
+    job.dst       = getbuffer(imgDest);
+    job.dstStride = dstW;
+    job.dudx      = c / zoom;
+    job.dvdx      = -s / zoom;
+    job.dudy      = s / zoom;
+    job.dvdy      = c / zoom;
+    job.u0        = (0.5 - xCenterDest) * job.dudx + (0.5 - yCenterDest) * job.dudy + xCenterSrc;
+    job.v0        = (0.5 - xCenterDest) * job.dvdx + (0.5 - yCenterDest) * job.dvdy + yCenterSrc;
+    job.du        = rotate_fixed(job.dudx);
+    job.dv        = rotate_fixed(job.dvdx);
+    job.key       = key;
+    job.alpha     = alpha;
+
+    if (mode == ROTATE_KEY) {
+        job.row = rotate_select_row<ROTATE_KEY, false>();
+    } else if (mode == ROTATE_ALPHA) {
+        job.row = smooth ? rotate_select_row<ROTATE_ALPHA, true>() : rotate_select_row<ROTATE_ALPHA, false>();
+    } else {
+        job.row = smooth ? rotate_select_row<ROTATE_OPAQUE, true>() : rotate_select_row<ROTATE_OPAQUE, false>();
+    }
+
+    job.tilesX    = (job.x1 - job.x0 + ROTATE_TILE - 1) / ROTATE_TILE;
+    int    tilesY = (job.y1 - job.y0 + ROTATE_TILE - 1) / ROTATE_TILE;
+    parallel_for(job.tilesX * tilesY, rotate_tile, &job);
+    dirty_note(imgDest, job.x0, job.y0, job.x1 - job.x0, job.y1 - job.y0);
+    return grOk;
+}
+
+/// Convert the 0-256 alpha of the putimage_rotate family (-1 = none) to 0-255.
+inline unsigned int rotate_alpha(int alpha)
+{
+    if (alpha < 0 || alpha >= 256) {
+        return 255;
+    }
+    return ((unsigned int)alpha * 255 + 128) >> 8;
+}
+
+} // namespace detail
+
+/**
+ * @brief Rotation and zoom drawing function, tiled and multithreaded
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgTexture Source texture IMAGE object pointer
+ * @param xDest X coordinate of drawing position
+ * @param yDest Y coordinate of drawing position
+ * @param xCenter X coordinate of rotation center point (relative to source image, 0.0-1.0)
+ * @param yCenter Y coordinate of rotation center point (relative to source image, 0.0-1.0)
+ * @param radian Rotation angle (in radians, clockwise direction)
+ * @param zoom Scaling ratio, 1.0 is original size, at least 1/16384
+ * @param transparent Whether to use image's transparent channel, default is false
+ * @param alpha Overall image transparency (0-256), -1 means no alpha, default is -1
+ * @param smooth Whether to use bilinear sampling (anti-aliasing), default is false
+ * @return Returns grOk on success, corresponding error code on failure
+ */
+inline int putimage_rotatezoom_f(PIMAGE imgDest, PCIMAGE imgTexture, int xDest, int yDest, float xCenter,
+    float yCenter, float radian, float zoom, bool transparent = false, int alpha = -1, bool smooth = false)
+{
+    if (imgTexture == NULL) {
+        return grNullPointer;
+    }
+    int w = getwidth(imgTexture), h = getheight(imgTexture);
+    return detail::rotate_draw(imgDest, imgTexture, 0, 0, w, h, xDest, yDest, xCenter * w, yCenter * h, radian, zoom,
+        transparent ? detail::ROTATE_ALPHA : detail::ROTATE_OPAQUE, smooth, detail::rotate_alpha(alpha), 0);
+}
+
+/**
+ * @brief Rotation drawing function, tiled and multithreaded
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgTexture Source texture IMAGE object pointer
+ * @param xDest X coordinate of drawing position
+ * @param yDest Y coordinate of drawing position
+ * @param xCenter X coordinate of rotation center point (relative to source image, 0.0-1.0)
+ * @param yCenter Y coordinate of rotation center point (relative to source image, 0.0-1.0)
+ * @param radian Rotation angle (in radians, clockwise direction)
+ * @param transparent Whether to use image's transparent channel, default is false
+ * @param alpha Overall image transparency (0-256), -1 means no alpha, default is -1
+ * @param smooth Whether to use bilinear sampling (anti-aliasing), default is false
+ * @return Returns grOk on success, corresponding error code on failure
+ */
+inline int putimage_rotate_f(PIMAGE imgDest, PCIMAGE imgTexture, int xDest, int yDest, float xCenter, float yCenter,
+    float radian, bool transparent = false, int alpha = -1, bool smooth = false)
+{
+    return putimage_rotatezoom_f(imgDest, imgTexture, xDest, yDest, xCenter, yCenter, radian, 1.0f, transparent, alpha,
+        smooth);
+}
+
+/**
+ * @brief Rotation transparent drawing function, tiled and multithreaded, complete version
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgSrc Source IMAGE object pointer
+ * @param xCenterDest X coordinate of rotation center point in target image
+ * @param yCenterDest Y coordinate of rotation center point in target image
+ * @param xSrc X coordinate of top-left corner of drawing content in source IMAGE object
+ * @param ySrc Y coordinate of top-left corner of drawing content in source IMAGE object
+ * @param widthSrc Width of drawing content in source IMAGE object
+ * @param heightSrc Height of drawing content in source IMAGE object
+ * @param xCenterSrc X coordinate of rotation center point in source image
+ * @param yCenterSrc Y coordinate of rotation center point in source image
+ * @param transparentColor Pixel color to become transparent
+ * @param radian Rotation angle (in radians, clockwise direction)
+ * @param zoom Scaling ratio, 1.0 is original size, at least 1/16384, default is 1.0f
+ * @return Returns grOk on success, corresponding error code on failure
+ */
+inline int putimage_rotatetransparent_f(PIMAGE imgDest, PCIMAGE imgSrc, int xCenterDest, int yCenterDest, int xSrc,
+    int ySrc, int widthSrc, int heightSrc, int xCenterSrc, int yCenterSrc, color_t transparentColor, float radian,
+    float zoom = 1.0f)
+{
+    return detail::rotate_draw(imgDest, imgSrc, xSrc, ySrc, widthSrc, heightSrc, xCenterDest, yCenterDest, xCenterSrc,
+        yCenterSrc, radian, zoom, detail::ROTATE_KEY, false, 255, transparentColor);
+}
+
+/**
+ * @brief Rotation transparent drawing function, tiled and multithreaded, basic version
+ * @param imgDest Target IMAGE object pointer, if NULL then draw to screen
+ * @param imgSrc Source IMAGE object pointer
+ * @param xCenterDest X coordinate of rotation center point in target image
+ * @param yCenterDest Y coordinate of rotation center point in target image
+ * @param xCenterSrc X coordinate of rotation center point in source image
+ * @param yCenterSrc Y coordinate of rotation center point in source image
+ * @param transparentColor Pixel color to become transparent
+ * @param radian Rotation angle (in radians, clockwise direction)
+ * @param zoom Scaling ratio, 1.0 is original size, at least 1/16384, default is 1.0f
+ * @return Returns grOk on success, corresponding error code on failure
+ */
+inline int putimage_rotatetransparent_f(PIMAGE imgDest, PCIMAGE imgSrc, int xCenterDest, int yCenterDest,
+    int xCenterSrc, int yCenterSrc, color_t transparentColor, float radian, float zoom = 1.0f)
+{
+    if (imgSrc == NULL) {
+        return grNullPointer;
+    }
+    return putimage_rotatetransparent_f(imgDest, imgSrc, xCenterDest, yCenterDest, 0, 0, getwidth(imgSrc),
+        getheight(imgSrc), xCenterSrc, yCenterSrc, transparentColor, radian, zoom);
+}
+
+} // namespace ege
+
+#endif /* EGE_ROTATE_H */
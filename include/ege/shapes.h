@@ -0,0 +1,489 @@
+/**
+ * @file shapes.h
+ * @brief Batched anti-aliased circles, rectangles and lines
+ *
+ * ege_fillcircles(), ege_fillrects() and ege_lines() draw a whole array of shapes per call. The
+ * coordinates are passed either interleaved in one array (x, y, r, x, y, r, ...) or as one
+ * array per component (struct of arrays), whichever layout the caller already keeps.
+ * Instead of building a path for every shape they use dedicated coverage kernels: rectangles
+ * get their exact area coverage, circles and lines a one pixel wide ramp at the edge computed
+ * from the distance of the pixel center. Fully covered runs are filled, or blended with the
+ * SIMD span kernels of ege/blend.h when the color is translucent, and only edge pixels are
+ * blended one by one.
+ *
+ * The target is processed in horizontal bands on the worker pool (see ege_set_worker_threads());
+ * each band draws the shapes touching it in array order.
+ *
+ * Pixel (x, y) covers the square [x, x + 1) x [y, y + 1). Like the other _f functions the shapes
+ * are drawn in image coordinates, ignoring the viewport.
+ */
+#ifndef EGE_SHAPES_H
+#define EGE_SHAPES_H
+
+#include "blend.h"
+#include "parallel.h"
+
+#include <math.h>
+#include <vector>
+
+namespace ege
+{
+
+namespace detail
+{
+
+enum shape_kind
+{
+    SHAPE_CIRCLE,   ///< p = cx, cy, r
+    SHAPE_RECT,     ///< p = left, top, right, bottom
+    SHAPE_LINE      ///< p = x1, y1, x2, y2, half thickness
+};
+
+struct shape_item
+{
+    int     kind;
+    color_t color;
+    int     x0, y0, x1, y1;     ///< Pixel bounding box, clipped to the target
+    float   p[5];
+};
+
+struct shape_job
+{
+    color_t*                dst;
+    int                     stride, w, h;
+    int                     firstBand;
+    span_blend_fn           blend;      ///< ARGB span kernel for translucent runs
+    std::vector<shape_item> items;
+};
+
+const int SHAPE_BAND = 32;
+
+/// Fill or blend [xa, xb) of a row with one color at full coverage.
+inline void shape_run(const shape_job& job, color_t* row, int xa, int xb, color_t color, std::vector<color_t>& line)
+{
+    if (xa >= xb) {
+        return;
+    }
+    if ((color >> 24) == 255) {
+        for (int x = xa; x < xb; ++x) {
+            row[x] = color;
+        }
+        return;
+    }
+    if ((int)line.size() < xb - xa || line.empty() || line[0] != color) {
+        line.assign(job.w, color);
+    }
+    job.blend(row + xa, &line[0], xb - xa, 255);
+}
+
+inline void shape_plot(color_t& d, color_t color, float coverage)
+{
+    if (coverage >= 1.0f) {
+        d = (color >> 24) == 255 ? color : blend_pixel(d, color, 255, 1);
+    } else if (coverage > 0.0f) {
+        d = blend_pixel(d, color, (unsigned int)(coverage * 255.0f + 0.5f), 1);
+    }
+}
+
+inline float shape_clamp01(float v)
+{
+    return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+inline void shape_circle_row(const shape_job& job, const shape_item& it, int y, std::vector<color_t>& line)
+{
+    const float cx = it.p[0], cy = it.p[1], r = it.p[2];
+    const float dy = y + 0.5f - cy;
+    if (fabsf(dy) >= r + 0.5f) {
+        return;
+    }
+    color_t* row = job.dst + (size_t)y * job.stride;
+
+    // Pixels whose centers are within r - 0.5 are fully covered.
+    int ia = it.x1, ib = it.x1;
+    float inner = r - 0.5f;
+    if (inner > fabsf(dy)) {
+        float xi = sqrtf(inner * inner - dy * dy);
+        ia       = (int)ceilf(cx - xi - 0.5f);
+        ib       = (int)floorf(cx + xi - 0.5f) + 1;
+        if (ia < it.x0) ia = it.x0;
+        if (ib > it.x1) ib = it.x1;
+        if (ia >= ib) ia = ib = it.x1;
+    }
+    for (int x = it.x0; x < it.x1; ++x) {
+        if (x == ia) {
+            shape_run(job, row, ia, ib, it.color, line);
+            x = ib - 1;
+            continue;
+        }
+        float dx = x + 0.5f - cx;
+        shape_plot(row[x], it.color, shape_clamp01(r + 0.5f - sqrtf(dx * dx + dy * dy)));
+    }
+}
+
+inline void shape_rect_row(const shape_job& job, const shape_item& it, int y, std::vector<color_t>& line)
+{
+    const float l = it.p[0], t = it.p[1], r = it.p[2], b = it.p[3];
+    float       cy = shape_clamp01((y + 1 < b ? y + 1 : b) - (y > t ? y : t));
+    if (cy <= 0.0f) {
+        return;
+    }
+    color_t* row = job.dst + (size_t)y * job.stride;
+
+    int ia = (int)ceilf(l), ib = (int)floorf(r);    // columns fully inside horizontally
+    if (ia < it.x0) ia = it.x0;
+    if (ib > it.x1) ib = it.x1;
+    for (int x = it.x0; x < it.x1; ++x) {
+        if (x >= ia && x < ib) {
+            if (cy >= 1.0f) {
+                shape_run(job, row, ia, ib, it.color, line);
+                x = ib - 1;
+                continue;
+            }
+            shape_plot(row[x], it.color, cy);
+            continue;
+        }
+        float cx = shape_clamp01((x + 1 < r ? x + 1 : r) - (x > l ? x : l));
+        shape_plot(row[x], it.color, cx * cy);
+    }
+}
+
+inline void shape_line_row(const shape_job& job, const shape_item& it, int y, std::vector<color_t>&)
+{
+    const float ax = it.p[0], ay = it.p[1], bx = it.p[2], by = it.p[3], hw = it.p[4];
+    const float ex = bx - ax, ey = by - ay, len2 = ex * ex + ey * ey;
+    const float py = y + 0.5f, reach = hw + 0.5f;
+    color_t*    row = job.dst + (size_t)y * job.stride;
+
+    // Narrow the row to the band around the infinite line, then measure to the segment.
+    int xa = it.x0, xb = it.x1;
+    if (len2 > 0.0f && fabsf(ey) > 1e-6f) {
+        float len = sqrtf(len2);
+        float xc  = ax + (py - ay) * ex / ey;              // line crosses the row center here
+        float w   = reach * len / fabsf(ey) + 1.0f;
+        int   lo  = (int)floorf(xc - w - 0.5f), hi = (int)ceilf(xc + w + 0.5f);
+        if (lo > xa) xa = lo;
+        if (hi < xb) xb = hi;
+    }
+    for (int x = xa; x < xb; ++x) {
+        float qx = x + 0.5f - ax, qy = py - ay;
+        float s  = len2 > 0.0f ? shape_clamp01((qx * ex + qy * ey) / len2) : 0.0f;
+        float dx = qx - s * ex, dy = qy - s * ey;
+        shape_plot(row[x], it.color, shape_clamp01(reach - sqrtf(dx * dx + dy * dy)));
+    }
+}
+
+inline void shape_band_task(void* context, int index)
+{
+    const shape_job& job = *(const shape_job*)context;
+
+    int ya = (job.firstBand + index) * SHAPE_BAND, yb = ya + SHAPE_BAND < job.h ? ya + SHAPE_BAND : job.h;
+
+    std::vector<color_t> line;
+    for (size_t i = 0; i < job.items.size(); ++i) {
+        const shape_item& it = job.items[i];
+        if (it.y1 <= ya || it.y0 >= yb) {
+            continue;
+        }
+        int y0 = it.y0 > ya ? it.y0 : ya, y1 = it.y1 < yb ? it.y1 : yb;
+        for (int y = y0; y < y1; ++y) {
+            if (it.kind == SHAPE_CIRCLE) {
+                shape_circle_row(job, it, y, line);
+            } else if (it.kind == SHAPE_RECT) {
+                shape_rect_row(job, it, y, line);
+            } else {
+                shape_line_row(job, it, y, line);
+            }
+        }
+    }
+}
+
+/// Prepare a job drawing into a w x h buffer with the given row stride.
+inline bool shape_begin(shape_job& job, color_t* dst, int w, int h, int stride, int n)
+{
+    job.dst       = dst;
+    job.w         = w;
+    job.h         = h;
+    job.stride    = stride;
+    job.firstBand = 0;
+    job.blend     = span_kernels_current().blend[1];
+    job.items.reserve(n > 0 ? n : 0);
+    return job.dst != NULL;
+}
+
+inline bool shape_begin(shape_job& job, PIMAGE pimg, int n)
+{
+    int w = getwidth(pimg);
+    return shape_begin(job, getbuffer(pimg), w, getheight(pimg), w, n);
+}
+
+/// Clip the float bounding box [l, r) x [t, b) to the target; false when nothing is visible.
+inline bool shape_add(shape_job& job, shape_item& it, float l, float t, float r, float b)
+{
+    if (!(l < r) || !(t < b) || r <= 0.0f || b <= 0.0f || l >= job.w || t >= job.h || (it.color >> 24) == 0) {
+        return false;
+    }
+    it.x0 = l < 0.0f ? 0 : (int)floorf(l);
+    it.y0 = t < 0.0f ? 0 : (int)floorf(t);
+    it.x1 = r > job.w ? job.w : (int)ceilf(r);
+    it.y1 = b > job.h ? job.h : (int)ceilf(b);
+    job.items.push_back(it);
+    return true;
+}
+
+/// Shape coordinates, either interleaved in one array or in one array per component.
+struct shape_coords
+{
+    const float* c[4];      ///< First value of each component
+    int          stride;    ///< Distance in floats between the values of consecutive shapes
+
+    float get(int component, int i) const { return c[component][(size_t)i * stride]; }
+};
+
+/// Coordinates stored as components consecutive floats per shape, e.g. x, y, r, x, y, r, ...
+inline shape_coords shape_interleaved(const float* data, int components)
+{
+    shape_coords s;
+    for (int k = 0; k < 4; ++k) {
+        s.c[k] = k < components ? data + k : NULL;
+    }
+    s.stride = components;
+    return s;
+}
+
+/// Coordinates stored in a separate array per component.
+inline shape_coords shape_separate(const float* a, const float* b, const float* c, const float* d = NULL)
+{
+    shape_coords s;
+    s.c[0]   = a;
+    s.c[1]   = b;
+    s.c[2]   = c;
+    s.c[3]   = d;
+    s.stride = 1;
+    return s;
+}
+
+inline void shape_add_circles(shape_job& job, int n, const shape_coords& xyr, const color_t* colors, color_t fill)
+{
+    for (int i = 0; i < n; ++i) {
+        float x = xyr.get(0, i), y = xyr.get(1, i), r = xyr.get(2, i);
+        if (!(r > 0.0f)) {
+            continue;
+        }
+        shape_item it;
+        it.kind  = SHAPE_CIRCLE;
+        it.color = colors != NULL ? colors[i] : fill;
+        it.p[0]  = x;
+        it.p[1]  = y;
+        it.p[2]  = r;
+        shape_add(job, it, x - r - 0.5f, y - r - 0.5f, x + r + 0.5f, y + r + 0.5f);
+    }
+}
+
+inline void shape_add_rects(shape_job& job, int n, const shape_coords& xywh, const color_t* colors, color_t fill)
+{
+    for (int i = 0; i < n; ++i) {
+        shape_item it;
+        it.kind  = SHAPE_RECT;
+        it.color = colors != NULL ? colors[i] : fill;
+        it.p[0]  = xywh.get(0, i);
+        it.p[1]  = xywh.get(1, i);
+        it.p[2]  = it.p[0] + xywh.get(2, i);
+        it.p[3]  = it.p[1] + xywh.get(3, i);
+        shape_add(job, it, it.p[0], it.p[1], it.p[2], it.p[3]);
+    }
+}
+
+inline void shape_add_lines(shape_job& job, int n, const shape_coords& xyxy, const color_t* colors, color_t stroke,
+    float thickness)
+{
+    float hw = thickness > 0.0f ? thickness * 0.5f : 0.5f;
+    for (int i = 0; i < n; ++i) {
+        shape_item it;
+        it.kind  = SHAPE_LINE;
+        it.color = colors != NULL ? colors[i] : stroke;
+        for (int k = 0; k < 4; ++k) {
+            it.p[k] = xyxy.get(k, i);
+        }
+        const float* s = it.p;
+        it.p[4]        = hw;
+        float reach    = hw + 0.5f;
+        shape_add(job, it, (s[0] < s[2] ? s[0] : s[2]) - reach, (s[1] < s[3] ? s[1] : s[3]) - reach,
+            (s[0] > s[2] ? s[0] : s[2]) + reach, (s[1] > s[3] ? s[1] : s[3]) + reach);
+    }
+}
+
+/// Draw the queued shapes; false if there were none, otherwise [x0, x1) x [y0, y1) receives their bounds.
+inline bool shape_draw(shape_job& job, int& x0, int& y0, int& x1, int& y1)
+{
+    if (job.items.empty()) {
+        return false;
+    }
+    x0 = job.w, y0 = job.h, x1 = 0, y1 = 0;
+    for (size_t i = 0; i < job.items.size(); ++i) {
+        const shape_item& it = job.items[i];
+        if (it.x0 < x0) x0 = it.x0;
+        if (it.y0 < y0) y0 = it.y0;
+        if (it.x1 > x1) x1 = it.x1;
+        if (it.y1 > y1) y1 = it.y1;
+    }
+    job.firstBand = y0 / SHAPE_BAND;
+    int lastBand  = (y1 + SHAPE_BAND - 1) / SHAPE_BAND;
+    parallel_for(lastBand - job.firstBand, shape_band_task, &job);
+    return true;
+}
+
+inline void shape_finish(shape_job& job, PIMAGE pimg)
+{
+    int x0, y0, x1, y1;
+    if (shape_draw(job, x0, y0, x1, y1)) {
+        dirty_note(pimg, x0, y0, x1 - x0, y1 - y0);
+    }
+}
+
+inline int shape_fill_circles(int n, const shape_coords& xyr, const color_t* colors, PIMAGE pimg)
+{
+    shape_job job;
+    if (!shape_begin(job, pimg, n)) {
+        return grNullPointer;
+    }
+    shape_add_circles(job, n, xyr, colors, colors == NULL ? getfillcolor(pimg) : 0);
+    shape_finish(job, pimg);
+    return grOk;
+}
+
+inline int shape_fill_rects(int n, const shape_coords& xywh, const color_t* colors, PIMAGE pimg)
+{
+    shape_job job;
+    if (!shape_begin(job, pimg, n)) {
+        return grNullPointer;
+    }
+    shape_add_rects(job, n, xywh, colors, colors == NULL ? getfillcolor(pimg) : 0);
+    shape_finish(job, pimg);
+    return grOk;
+}
+
+inline int shape_draw_lines(int n, const shape_coords& xyxy, const color_t* colors, float thickness, PIMAGE pimg)
+{
+    shape_job job;
+    if (!shape_begin(job, pimg, n)) {
+        return grNullPointer;
+    }
+    shape_add_lines(job, n, xyxy, colors, colors == NULL ? getlinecolor(pimg) : 0, thickness);
+    shape_finish(job, pimg);
+    return grOk;
+}
+
+} // namespace detail
+
+/**
+ * @brief Fill an array of anti-aliased circles
+ * @param n Number of circles
+ * @param xyr Interleaved center x, center y and radius of each circle (3 * n floats)
+ * @param colors ARGB color of each circle, NULL to use the fill color of pimg for all
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if xyr is NULL
+ */
+inline int ege_fillcircles(int n, const float* xyr, const color_t* colors, PIMAGE pimg = NULL)
+{
+    if (xyr == NULL && n > 0) {
+        return grNullPointer;
+    }
+    return detail::shape_fill_circles(n, detail::shape_interleaved(xyr, 3), colors, pimg);
+}
+
+/**
+ * @brief Fill an array of anti-aliased circles given as separate arrays (struct of arrays)
+ * @param n Number of circles
+ * @param x Center x of each circle (n floats)
+ * @param y Center y of each circle (n floats)
+ * @param r Radius of each circle (n floats)
+ * @param colors ARGB color of each circle, NULL to use the fill color of pimg for all
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if x, y or r is NULL
+ */
+inline int ege_fillcircles(int n, const float* x, const float* y, const float* r, const color_t* colors, PIMAGE pimg = NULL)
+{
+    if ((x == NULL || y == NULL || r == NULL) && n > 0) {
+        return grNullPointer;
+    }
+    return detail::shape_fill_circles(n, detail::shape_separate(x, y, r), colors, pimg);
+}
+
+/**
+ * @brief Fill an array of anti-aliased rectangles
+ * @param n Number of rectangles
+ * @param xywh Interleaved left, top, width and height of each rectangle (4 * n floats)
+ * @param colors ARGB color of each rectangle, NULL to use the fill color of pimg for all
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if xywh is NULL
+ */
+inline int ege_fillrects(int n, const float* xywh, const color_t* colors, PIMAGE pimg = NULL)
+{
+    if (xywh == NULL && n > 0) {
+        return grNullPointer;
+    }
+    return detail::shape_fill_rects(n, detail::shape_interleaved(xywh, 4), colors, pimg);
+}
+
+/**
+ * @brief Fill an array of anti-aliased rectangles given as separate arrays (struct of arrays)
+ * @param n Number of rectangles
+ * @param x Left of each rectangle (n floats)
+ * @param y Top of each rectangle (n floats)
+ * @param w Width of each rectangle (n floats)
+ * @param h Height of each rectangle (n floats)
+ * @param colors ARGB color of each rectangle, NULL to use the fill color of pimg for all
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if x, y, w or h is NULL
+ */
+inline int ege_fillrects(int n, const float* x, const float* y, const float* w, const float* h, const color_t* colors,
+    PIMAGE pimg = NULL)
+{
+    if ((x == NULL || y == NULL || w == NULL || h == NULL) && n > 0) {
+        return grNullPointer;
+    }
+    return detail::shape_fill_rects(n, detail::shape_separate(x, y, w, h), colors, pimg);
+}
+
+/**
+ * @brief Draw an array of anti-aliased line segments with round ends
+ * @param n Number of segments
+ * @param xyxy Interleaved start x, start y, end x and end y of each segment (4 * n floats)
+ * @param colors ARGB color of each segment, NULL to use the line color of pimg for all
+ * @param thickness Line width in pixels, default is 1
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if xyxy is NULL
+ */
+inline int ege_lines(int n, const float* xyxy, const color_t* colors, float thickness = 1.0f, PIMAGE pimg = NULL)
+{
+    if (xyxy == NULL && n > 0) {
+        return grNullPointer;
+    }
+    return detail::shape_draw_lines(n, detail::shape_interleaved(xyxy, 4), colors, thickness, pimg);
+}
+
+/**
+ * @brief Draw an array of anti-aliased line segments given as separate arrays (struct of arrays)
+ * @param n Number of segments
+ * @param x1 Start x of each segment (n floats)
+ * @param y1 Start y of each segment (n floats)
+ * @param x2 End x of each segment (n floats)
+ * @param y2 End y of each segment (n floats)
+ * @param colors ARGB color of each segment, NULL to use the line color of pimg for all
+ * @param thickness Line width in pixels, default is 1
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return grOk on success, grNullPointer if x1, y1, x2 or y2 is NULL
+ */
+inline int ege_lines(int n, const float* x1, const float* y1, const float* x2, const float* y2, const color_t* colors,
+    float thickness = 1.0f, PIMAGE pimg = NULL)
+{
+    if ((x1 == NULL || y1 == NULL || x2 == NULL || y2 == NULL) && n > 0) {
+        return grNullPointer;
+    }
+    return detail::shape_draw_lines(n, detail::shape_separate(x1, y1, x2, y2), colors, thickness, pimg);
+}
+
+} // namespace ege
+
+#endif /* EGE_SHAPES_H */
@@ -0,0 +1,296 @@
+/**
+ * @file sprites.h
+ * @brief Sprite batches: many sub-rectangles of one atlas image drawn in one call
+ *
+ * ege_drawsprites() validates the atlas and the target once, computes the clipped destination
+ * box of every sprite, then walks the target in horizontal bands on the worker pool (see
+ * ege_set_worker_threads()). Each band draws the sprites that touch it, in array order, so
+ * overlapping sprites still stack as they would with one putimage call each.
+ *
+ * Unscaled, unrotated sprites blend their atlas rows directly with the SIMD span kernels of
+ * ege/blend.h. Scaled or rotated sprites are sampled (nearest texel) into a row buffer that is
+ * then blended with the same kernels. Tinting multiplies every channel of the atlas pixel.
+ *
+ * Like the other _f functions the batch works in image coordinates and ignores the viewport.
+ */
+#ifndef EGE_SPRITES_H
+#define EGE_SPRITES_H
+
+#include "rotate.h"
+
+#include <math.h>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_sprite
+ * @brief One sprite of a batch drawn by ege_drawsprites()
+ */
+struct ege_sprite
+{
+    int           srcX, srcY;       ///< Top-left corner of the sprite in the atlas
+    int           srcW, srcH;       ///< Size of the sprite in the atlas
+    float         x, y;             ///< Destination of the top-left corner before rotation
+    float         scaleX, scaleY;   ///< Scale factors, 1 for none
+    float         angle;            ///< Clockwise rotation around the sprite center in radians, 0 for none
+    unsigned char alpha;            ///< Overall opacity, 255 for opaque
+    color_t       tint;             ///< Multiplied into each atlas pixel (ARGB), 0xFFFFFFFF for none
+};
+
+/**
+ * @brief Make a sprite with no scale, rotation, transparency or tint
+ * @param srcX X coordinate of the sprite in the atlas
+ * @param srcY Y coordinate of the sprite in the atlas
+ * @param srcW Width of the sprite
+ * @param srcH Height of the sprite
+ * @param x Destination x coordinate
+ * @param y Destination y coordinate
+ * @return The sprite
+ */
+inline ege_sprite ege_make_sprite(int srcX, int srcY, int srcW, int srcH, float x, float y)
+{
+    ege_sprite s;
+    s.srcX   = srcX;
+    s.srcY   = srcY;
+    s.srcW   = srcW;
+    s.srcH   = srcH;
+    s.x      = x;
+    s.y      = y;
+    s.scaleX = 1.0f;
+    s.scaleY = 1.0f;
+    s.angle  = 0.0f;
+    s.alpha  = 255;
+    s.tint   = 0xFFFFFFFF;
+    return s;
+}
+
+namespace detail
+{
+
+struct sprite_item
+{
+    const ege_sprite* sprite;
+    int               x0, y0, x1, y1;       ///< Destination box, clipped to the target
+    int               sx0, sy0, sx1, sy1;   ///< Source rectangle, clipped to the atlas
+    bool              simple;               ///< Unscaled and unrotated: row copies at (dx, dy)
+    int               dx, dy;
+    double            u0, v0;               ///< Source position of the center of destination pixel (0, 0)
+    double            dudx, dvdx, dudy, dvdy;
+};
+
+struct sprite_job
+{
+    const color_t*           atlas;
+    int                      atlasStride;
+    color_t*                 dst;
+    int                      dstStride, dstH;
+    int                      firstBand;             ///< Band of task 0, bands above hold no sprite
+    span_blend_fn            blend;
+    std::vector<sprite_item> items;
+};
+
+const int SPRITE_BAND = 32;
+
+inline void sprite_tint(color_t* out, const color_t* in, int count, color_t tint)
+{
+    unsigned int ta = tint >> 24, tr = (tint >> 16) & 0xFF, tg = (tint >> 8) & 0xFF, tb = tint & 0xFF;
+    for (int i = 0; i < count; ++i) {
+        color_t p = in[i];
+        out[i]    = (blend_mul255(p >> 24, ta) << 24) | (blend_mul255((p >> 16) & 0xFF, tr) << 16) |
+                 (blend_mul255((p >> 8) & 0xFF, tg) << 8) | blend_mul255(p & 0xFF, tb);
+    }
+}
+
+inline bool sprite_prepare(sprite_item& it, const ege_sprite& s, int atlasW, int atlasH, int dstW, int dstH)
+{
+    it.sprite = &s;
+    it.sx0    = s.srcX < 0 ? 0 : s.srcX;
+    it.sy0    = s.srcY < 0 ? 0 : s.srcY;
+    it.sx1    = s.srcX + s.srcW > atlasW ? atlasW : s.srcX + s.srcW;
+    it.sy1    = s.srcY + s.srcH > atlasH ? atlasH : s.srcY + s.srcH;
+    if (it.sx0 >= it.sx1 || it.sy0 >= it.sy1 || s.alpha == 0 || (s.tint >> 24) == 0) {
+        return false;
+    }
+
+    it.simple = s.angle == 0.0f && s.scaleX == 1.0f && s.scaleY == 1.0f;
+    if (it.simple) {
+        it.dx = (int)floor(s.x + 0.5f) - s.srcX;    // destination of atlas pixel (0, 0)
+        it.dy = (int)floor(s.y + 0.5f) - s.srcY;
+        it.x0 = it.sx0 + it.dx;
+        it.y0 = it.sy0 + it.dy;
+        it.x1 = it.sx1 + it.dx;
+        it.y1 = it.sy1 + it.dy;
+    } else {
+        // Smaller scales would overflow the 16.16 source steps, and draw under a pixel anyway.
+        if (!(s.scaleX >= ROTATE_MIN_ZOOM) || !(s.scaleY >= ROTATE_MIN_ZOOM)) {
+            return false;
+        }
+        double c = cos(s.angle), n = sin(s.angle);
+        double hw = s.srcW * 0.5, hh = s.srcH * 0.5;
+        double cx = s.x + hw * s.scaleX, cy = s.y + hh * s.scaleY;
+
+        double minX = 1e300, minY = 1e300, maxX = -1e300, maxY = -1e300;
+        for (int k = 0; k < 4; ++k) {
+            double lx = ((k & 1) ? hw : -hw) * s.scaleX, ly = ((k & 2) ? hh : -hh) * s.scaleY;
+            double qx = cx + c * lx - n * ly, qy = cy + n * lx + c * ly;
+            if (qx < minX) minX = qx;
+            if (qx > maxX) maxX = qx;
+            if (qy < minY) minY = qy;
+            if (qy > maxY) maxY = qy;
+        }
+        if (!(maxX >= 0.0 && maxY >= 0.0 && minX < dstW && minY < dstH)) {
+            return false;
+        }
+        it.x0 = minX < 0.0 ? 0 : (int)floor(minX);
+        it.y0 = minY < 0.0 ? 0 : (int)floor(minY);
+        it.x1 = maxX > dstW ? dstW : (int)ceil(maxX);
+        it.y1 = maxY > dstH ? dstH : (int)ceil(maxY);
+
+        it.dudx = c / s.scaleX;
+        it.dudy = n / s.scaleX;
+        it.dvdx = -n / s.scaleY;
+        it.dvdy = c / s.scaleY;
+        it.u0   = (0.5 - cx) * it.dudx + (0.5 - cy) * it.dudy + hw + s.srcX;
+        it.v0   = (0.5 - cx) * it.dvdx + (0.5 - cy) * it.dvdy + hh + s.srcY;
+    }
+
+    if (it.x0 < 0)    it.x0 = 0;
+    if (it.y0 < 0)    it.y0 = 0;
+    if (it.x1 > dstW) it.x1 = dstW;
+    if (it.y1 > dstH) it.y1 = dstH;
+    return it.x0 < it.x1 && it.y0 < it.y1;
+}
+
+inline void sprite_rows(const sprite_job& job, const sprite_item& it, int ya, int yb, std::vector<color_t>& line)
+{
+    const ege_sprite& s     = *it.sprite;
+    const bool        tint  = s.tint != 0xFFFFFFFF;
+    const int         width = it.x1 - it.x0;
+    if ((int)line.size() < width) {
+        line.resize(width);
+    }
+
+    for (int y = ya; y < yb; ++y) {
+        color_t* dst = job.dst + (size_t)y * job.dstStride;
+        if (it.simple) {
+            const color_t* src = job.atlas + (size_t)(y - it.dy) * job.atlasStride + (it.x0 - it.dx);
+            if (tint) {
+                sprite_tint(&line[0], src, width, s.tint);
+                src = &line[0];
+            }
+            job.blend(dst + it.x0, src, width, s.alpha);
+            continue;
+        }
+
+        double uRow = it.u0 + it.dudy * y, vRow = it.v0 + it.dvdy * y;
+        int    xa = it.x0, xb = it.x1;
+        rotate_span(uRow, it.dudx, it.sx0, it.sx1, xa, xb);
+        rotate_span(vRow, it.dvdx, it.sy0, it.sy1, xa, xb);
+
+        // 16.16 stepping; trim the one pixel margin of rotate_span() with the same arithmetic.
+        const int du = rotate_fixed(it.dudx), dv = rotate_fixed(it.dvdx);
+        const int ulo = it.sx0 << 16, uhi = it.sx1 << 16, vlo = it.sy0 << 16, vhi = it.sy1 << 16;
+        int       u = rotate_fixed(uRow + it.dudx * xa), v = rotate_fixed(vRow + it.dvdx * xa);
+        while (xa < xb && (u < ulo || u >= uhi || v < vlo || v >= vhi)) {
+            ++xa;
+            u += du;
+            v += dv;
+        }
+        int ue = u + du * (xb - 1 - xa), ve = v + dv * (xb - 1 - xa);
+        while (xb > xa && (ue < ulo || ue >= uhi || ve < vlo || ve >= vhi)) {
+            --xb;
+            ue -= du;
+            ve -= dv;
+        }
+        if (xa >= xb) {
+            continue;
+        }
+
+        int n = xb - xa;
+        for (int i = 0; i < n; ++i, u += du, v += dv) {
+            line[i] = job.atlas[(size_t)(v >> 16) * job.atlasStride + (u >> 16)];
+        }
+        if (tint) {
+            sprite_tint(&line[0], &line[0], n, s.tint);
+        }
+        job.blend(dst + xa, &line[0], n, s.alpha);
+    }
+}
+
+inline void sprite_band_task(void* context, int index)
+{
+    const sprite_job& job = *(const sprite_job*)context;
+
+    int ya = (job.firstBand + index) * SPRITE_BAND, yb = ya + SPRITE_BAND < job.dstH ? ya + SPRITE_BAND : job.dstH;
+
+    std::vector<color_t> line;
+    for (size_t i = 0; i < job.items.size(); ++i) {
+        const sprite_item& it = job.items[i];
+        if (it.y1 <= ya || it.y0 >= yb) {
+            continue;
+        }
+        sprite_rows(job, it, it.y0 > ya ? it.y0 : ya, it.y1 < yb ? it.y1 : yb, line);
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Draw a batch of sprites from one atlas image
+ * @param atlas Atlas IMAGE object holding all sprite images
+ * @param sprites Array of sprites, drawn in order
+ * @param count Number of sprites
+ * @param dst Target IMAGE object pointer, if NULL then draw to screen
+ * @param colorType Color type of atlas pixels, default is COLORTYPE_PRGB32 (premultiplied alpha)
+ * @return grOk on success, grNullPointer if atlas or sprites is NULL
+ * @note Sprites are clipped against the atlas and the target; invisible ones are skipped.
+ */
+inline int ege_drawsprites(PCIMAGE atlas, const ege_sprite* sprites, int count, PIMAGE dst = NULL,
+    color_type colorType = COLORTYPE_PRGB32)
+{
+    if (atlas == NULL || (sprites == NULL && count > 0)) {
+        return grNullPointer;
+    }
+
+    int atlasW = getwidth(atlas), atlasH = getheight(atlas);
+    int dstW = getwidth(dst), dstH = getheight(dst);
+
+    detail::sprite_job job;
+    job.atlas       = getbuffer(atlas);
+    job.atlasStride = atlasW;
+    job.dst         = getbuffer(dst);
+    job.dstStride   = dstW;
+    job.dstH        = dstH;
+    job.blend       = detail::span_kernels_current().blend[detail::blend_mode(colorType)];
+    if (job.atlas == NULL || job.dst == NULL) {
+        return grNullPointer;
+    }
+
+    job.items.reserve(count);
+    int x0 = dstW, y0 = dstH, x1 = 0, y1 = 0;
+    for (int i = 0; i < count; ++i) {
+        detail::sprite_item it;
+        if (detail::sprite_prepare(it, sprites[i], atlasW, atlasH, dstW, dstH)) {
+            job.items.push_back(it);
+            if (it.x0 < x0) x0 = it.x0;
+            if (it.y0 < y0) y0 = it.y0;
+            if (it.x1 > x1) x1 = it.x1;
+            if (it.y1 > y1) y1 = it.y1;
+        }
+    }
+    if (job.items.empty()) {
+        return grOk;
+    }
+
+    job.firstBand = y0 / detail::SPRITE_BAND;
+    int lastBand  = (y1 + detail::SPRITE_BAND - 1) / detail::SPRITE_BAND;
+    detail::parallel_for(lastBand - job.firstBand, detail::sprite_band_task, &job);
+    detail::dirty_note(dst, x0, y0, x1 - x0, y1 - y0);
+    return grOk;
+}
+
+} // namespace ege
+
+#endif /* EGE_SPRITES_H */
@@ -0,0 +1,326 @@
+/**
+ * @file text_measure.h
+ * @brief Memoized textwidth / textheight / measuretext
+ *
+ * Layout code measures the same strings over and over with the same font. The functions here
+ * remember the result per (font, string) pair: the font is identified by the LOGFONTW that
+ * getfont() reports for the target, the string by its hash and contents. Only misses reach the
+ * library's measuring functions.
+ *
+ * measuretext_batch() reads the font state once for a whole array of strings, which is the
+ * cheapest way to measure the cells of a table.
+ */
+#ifndef EGE_TEXT_MEASURE_H
+#define EGE_TEXT_MEASURE_H
+
+#include "font_cache.h"
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_text_measure_stats
+ * @brief Counters of the text measurement cache
+ */
+struct ege_text_measure_stats
+{
+    unsigned long hits;         ///< Measurements answered from the cache
+    unsigned long misses;       ///< Measurements forwarded to the library
+    unsigned long evictions;    ///< Entries dropped to respect the capacity
+    int           entries;      ///< Cached (font, string) pairs
+    int           capacity;     ///< Maximum number of entries
+};
+
+namespace detail
+{
+
+inline unsigned int text_hash(const wchar_t* text, size_t length)
+{
+    unsigned int h = 2166136261u;   // FNV-1a
+    for (size_t i = 0; i < length; ++i) {
+        h = (h ^ (unsigned int)text[i]) * 16777619u;
+    }
+    return h;
+}
+
+inline std::wstring text_widen(const char* text)
+{
+    std::wstring wide;
+    int          length = MultiByteToWideChar(getcodepage(), 0, text, -1, NULL, 0);
+    if (length > 1) {
+        wide.resize(length);
+        MultiByteToWideChar(getcodepage(), 0, text, -1, &wide[0], length);
+        wide.resize(length - 1);
+    }
+    return wide;
+}
+
+class text_measure_cache
+{
+public:
+    enum { MEASURE_INT = 1, MEASURE_FLOAT = 2 };
+
+    struct result
+    {
+        int   width, height;        ///< textwidth() / textheight()
+        float fwidth, fheight;      ///< measuretext()
+        int   valid;                ///< MEASURE_INT and/or MEASURE_FLOAT
+    };
+
+    text_measure_cache() : m_capacity(4096) { resetStats(); }
+
+    /// Font id of the target's current font; ids stay valid until the cache is cleared.
+    int fontId(PCIMAGE pimg)
+    {
+        LOGFONTW font;
+        getfont(&font, pimg);
+        for (size_t i = 0; i < m_fonts.size(); ++i) {
+            if (logfont_equal(m_fonts[i], font)) {
+                return (int)i;
+            }
+        }
+        if (m_fonts.size() >= 256) {
+            clear();
+        }
+        m_fonts.push_back(font);
+        return (int)m_fonts.size() - 1;
+    }
+
+    const result& measure(int font, const wchar_t* text, size_t length, int what, PCIMAGE pimg)
+    {
+        key k;
+        k.font = font;
+        k.hash = text_hash(text, length);
+        k.text.assign(text, length);
+
+        entry_map::iterator it = m_entries.find(k);
+        if (it == m_entries.end()) {
+            if ((int)m_entries.size() >= m_capacity) {
+                m_entries.erase(m_order.back());
+                m_order.pop_back();
+                ++m_evictions;
+            }
+            it = m_entries.insert(std::make_pair(k, entry())).first;
+            it->second.value.valid = 0;
+            m_order.push_front(it);
+            it->second.order = m_order.begin();
+        } else if (it->second.order != m_order.begin()) {
+            m_order.splice(m_order.begin(), m_order, it->second.order);
+        }
+
+        result& r = it->second.value;
+        if ((r.valid & what) == what) {
+            ++m_hits;
+            return r;
+        }
+        ++m_misses;
+        const wchar_t* s = it->first.text.c_str();
+        if ((what & MEASURE_INT) && !(r.valid & MEASURE_INT)) {
+            r.width  = textwidth(s, pimg);
+            r.height = textheight(s, pimg);
+        }
+        if ((what & MEASURE_FLOAT) && !(r.valid & MEASURE_FLOAT)) {
+            measuretext(s, &r.fwidth, &r.fheight, pimg);
+        }
+        r.valid |= what;
+        return r;
+    }
+
+    void setCapacity(int capacity)
+    {
+        m_capacity = capacity < 1 ? 1 : capacity;
+        while ((int)m_entries.size() > m_capacity) {
+            m_entries.erase(m_order.back());
+            m_order.pop_back();
+            ++m_evictions;
+        }
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+        m_order.clear();
+        m_fonts.clear();
+    }
+
+    void stats(ege_text_measure_stats* out) const
+    {
+        out->hits      = m_hits;
+        out->misses    = m_misses;
+        out->evictions = m_evictions;
+        out->entries   = (int)m_entries.size();
+        out->capacity  = m_capacity;
+    }
+
+    void resetStats() { m_hits = m_misses = m_evictions = 0; }
+
+private:
+    struct key
+    {
+        int          font;
+        unsigned int hash;
+        std::wstring text;
+
+        bool operator<(const key& o) const
+        {
+            if (hash != o.hash) return hash < o.hash;
+            if (font != o.font) return font < o.font;
+            return text < o.text;
+        }
+    };
+
+    struct entry;
+    typedef std::map<key, entry>               entry_map;
+    typedef std::list<entry_map::iterator>     order_list;
+
+    struct entry
+    {
+        result               value;
+        order_list::iterator order;     ///< Position in the LRU list, most recent first
+    };
+
+    text_measure_cache(const text_measure_cache&);
+    text_measure_cache& operator=(const text_measure_cache&);
+
+    entry_map             m_entries;
+    order_list            m_order;
+    std::vector<LOGFONTW> m_fonts;
+    int                   m_capacity;
+    unsigned long         m_hits, m_misses, m_evictions;
+};
+
+inline text_measure_cache& text_measure_instance()
+{
+    static text_measure_cache cache;
+    return cache;
+}
+
+inline const text_measure_cache::result& text_measure(const wchar_t* text, int what, PCIMAGE pimg)
+{
+    text_measure_cache& cache = text_measure_instance();
+    return cache.measure(cache.fontId(pimg), text, wcslen(text), what, pimg);
+}
+
+} // namespace detail
+
+/**
+ * @brief Get string width in pixels, memoized per font and string
+ * @param text Text string
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return Same value as textwidth()
+ */
+inline int textwidth_cached(const wchar_t* text, PCIMAGE pimg = NULL)
+{
+    return detail::text_measure(text, detail::text_measure_cache::MEASURE_INT, pimg).width;
+}
+
+/// @copydoc textwidth_cached(const wchar_t*, PCIMAGE)
+inline int textwidth_cached(const char* text, PCIMAGE pimg = NULL)
+{
+    return textwidth_cached(detail::text_widen(text).c_str(), pimg);
+}
+
+/**
+ * @brief Get string height in pixels, memoized per font and string
+ * @param text Text string
+ * @param pimg Target image pointer, NULL means current ege window
+ * @return Same value as textheight()
+ */
+inline int textheight_cached(const wchar_t* text, PCIMAGE pimg = NULL)
+{
+    return detail::text_measure(text, detail::text_measure_cache::MEASURE_INT, pimg).height;
+}
+
+/// @copydoc textheight_cached(const wchar_t*, PCIMAGE)
+inline int textheight_cached(const char* text, PCIMAGE pimg = NULL)
+{
+    return textheight_cached(detail::text_widen(text).c_str(), pimg);
+}
+
+/**
+ * @brief Measure text size, memoized per font and string
+ * @param text Text string
+ * @param width Pointer to receive width, may be NULL
+ * @param height Pointer to receive height, may be NULL
+ * @param pimg Target image pointer, NULL means current ege window
+ */
+inline void measuretext_cached(const wchar_t* text, float* width, float* height, PCIMAGE pimg = NULL)
+{
+    const detail::text_measure_cache::result& r =
+        detail::text_measure(text, detail::text_measure_cache::MEASURE_FLOAT, pimg);
+    if (width != NULL)  *width  = r.fwidth;
+    if (height != NULL) *height = r.fheight;
+}
+
+/// @copydoc measuretext_cached(const wchar_t*, float*, float*, PCIMAGE)
+inline void measuretext_cached(const char* text, float* width, float* height, PCIMAGE pimg = NULL)
+{
+    measuretext_cached(detail::text_widen(text).c_str(), width, height, pimg);
+}
+
+/**
+ * @brief Measure many strings with the current font at once
+ * @param texts Array of n strings, NULL entries measure as 0 x 0
+ * @param n Number of strings
+ * @param width Array receiving n widths, may be NULL
+ * @param height Array receiving n heights, may be NULL
+ * @param pimg Target image pointer, NULL means current ege window
+ * @note The font state is read once for the whole batch, so the font must not change meanwhile.
+ */
+inline void measuretext_batch(const wchar_t** texts, int n, float* width, float* height, PCIMAGE pimg = NULL)
+{
+    detail::text_measure_cache& cache = detail::text_measure_instance();
+    int                         font  = cache.fontId(pimg);
+    for (int i = 0; i < n; ++i) {
+        float w = 0.0f, h = 0.0f;
+        if (texts[i] != NULL) {
+            const detail::text_measure_cache::result& r =
+                cache.measure(font, texts[i], wcslen(texts[i]), detail::text_measure_cache::MEASURE_FLOAT, pimg);
+            w = r.fwidth;
+            h = r.fheight;
+        }
+        if (width != NULL)  width[i]  = w;
+        if (height != NULL) height[i] = h;
+    }
+}
+
+/**
+ * @brief Set the maximum number of memoized (font, string) pairs
+ * @param capacity Maximum entry count, default is 4096
+ */
+inline void ege_text_measure_set_capacity(int capacity)
+{
+    detail::text_measure_instance().setCapacity(capacity);
+}
+
+/**
+ * @brief Get the counters of the text measurement cache
+ * @param stats Receives hits, misses, evictions and entry count
+ */
+inline void ege_text_measure_get_stats(ege_text_measure_stats* stats)
+{
+    if (stats != NULL) {
+        detail::text_measure_instance().stats(stats);
+    }
+}
+
+/// @brief Reset the hit, miss and eviction counters of the text measurement cache
+inline void ege_text_measure_reset_stats()
+{
+    detail::text_measure_instance().resetStats();
+}
+
+/// @brief Drop all memoized measurements, e.g. after installing a font file
+inline void ege_text_measure_clear()
+{
+    detail::text_measure_instance().clear();
+}
+
+} // namespace ege
+
+#endif /* EGE_TEXT_MEASURE_H */
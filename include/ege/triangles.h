@@ -0,0 +1,354 @@
+/**
+ * @file triangles.h
+ * @brief Textured triangle meshes drawn by a tile-binned software rasterizer
+ *
+ * ege_drawtriangles() draws an indexed triangle list with texture coordinates. Vertices are
+ * snapped to 1/16 pixel and every triangle is described by three integer edge functions; each
+ * row of a triangle is turned into a span directly from them, with a top-left fill rule so
+ * triangles sharing an edge neither overlap nor leave gaps. Texture coordinates are
+ * interpolated linearly in screen space (no perspective correction) and stepped in 16.16 fixed
+ * point along each span, with nearest or bilinear sampling. Spans that reach more than 16383
+ * texels from the origin are clamped to the texture edge per pixel instead.
+ *
+ * The target is split into 64x64 tiles. Triangles are binned to the tiles their bounding box
+ * touches, keeping their order, and the tiles are rasterized on the worker pool (see
+ * ege_set_worker_threads()).
+ *
+ * Like the other _f functions the triangles are drawn in image coordinates, ignoring the viewport.
+ */
+#ifndef EGE_TRIANGLES_H
+#define EGE_TRIANGLES_H
+
+#include "rotate.h"
+
+#include <math.h>
+#include <vector>
+
+namespace ege
+{
+
+/**
+ * @struct ege_vertex
+ * @brief Vertex of a textured triangle mesh
+ */
+struct ege_vertex
+{
+    float x, y;     ///< Position in the target image (pixels)
+    float u, v;     ///< Texture coordinates, 0 to 1 spans the whole texture
+};
+
+namespace detail
+{
+
+const int TRI_TILE  = 64;
+const int TRI_ATTRS = 4;    ///< Interpolated attributes per vertex
+
+struct tri_setup
+{
+    long long a[3], b[3], c[3];     ///< Edge functions in 1/16 pixel units, >= bias inside
+    int       bias[3];              ///< 0 on top-left edges, 1 elsewhere
+    int       x0, y0, x1, y1;       ///< Pixel bounding box, clipped to the target
+    double    attr[TRI_ATTRS][3];   ///< d/dx, d/dy and value at the center of pixel (0, 0)
+};
+
+struct tri_job;
+typedef void (*tri_span_fn)(const tri_job& job, const tri_setup& t, int y, int xa, int xb);
+
+struct tri_job
+{
+    color_t*                       dst;
+    int                            dstStride, dstW, dstH;
+    tri_span_fn                    span;
+    const void*                    shader;    ///< Data of the span function
+    std::vector<tri_setup>         tris;
+    int                            tilesX;
+    std::vector<std::vector<int> > bins;      ///< Triangle indices per tile, in drawing order
+    std::vector<int>               tiles;     ///< Tiles with at least one triangle
+};
+
+inline long long tri_floor_div(long long n, long long d)
+{
+    return n >= 0 ? n / d : -((-n + d - 1) / d);
+}
+
+/// Set up the edge functions, bounding box and attribute planes of one triangle.
+inline bool tri_prepare(tri_setup& t, const float* xs, const float* ys, const double attrs[3][TRI_ATTRS], int nAttrs,
+    int dstW, int dstH)
+{
+    long long X[3], Y[3];
+    for (int k = 0; k < 3; ++k) {
+        if (!(fabs(xs[k]) < 1e6f) || !(fabs(ys[k]) < 1e6f)) {
+            return false;
+        }
+        X[k] = (long long)floor(xs[k] * 16.0 + 0.5);
+        Y[k] = (long long)floor(ys[k] * 16.0 + 0.5);
+    }
+
+    long long area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+    if (area == 0) {
+        return false;
+    }
+    for (int k = 0; k < 3; ++k) {
+        int i = k, j = (k + 1) % 3;
+        t.a[k] = Y[i] - Y[j];
+        t.b[k] = X[j] - X[i];
+        if (area < 0) {
+            t.a[k] = -t.a[k];
+            t.b[k] = -t.b[k];
+        }
+        t.c[k]    = -(t.a[k] * X[i] + t.b[k] * Y[i]);
+        t.bias[k] = (t.a[k] > 0 || (t.a[k] == 0 && t.b[k] > 0)) ? 0 : 1;
+    }
+
+    long long minX = X[0], maxX = X[0], minY = Y[0], maxY = Y[0];
+    for (int k = 1; k < 3; ++k) {
+        if (X[k] < minX) minX = X[k];
+        if (X[k] > maxX) maxX = X[k];
+        if (Y[k] < minY) minY = Y[k];
+        if (Y[k] > maxY) maxY = Y[k];
+    }
+    // Pixels whose centers (16 * x + 8) can lie inside.
+    t.x0 = (int)tri_floor_div(minX + 7, 16);
+    t.y0 = (int)tri_floor_div(minY + 7, 16);
+    t.x1 = (int)tri_floor_div(maxX - 8, 16) + 1;
+    t.y1 = (int)tri_floor_div(maxY - 8, 16) + 1;
+    if (t.x0 < 0)    t.x0 = 0;
+    if (t.y0 < 0)    t.y0 = 0;
+    if (t.x1 > dstW) t.x1 = dstW;
+    if (t.y1 > dstH) t.y1 = dstH;
+    if (t.x0 >= t.x1 || t.y0 >= t.y1) {
+        return false;
+    }
+
+    // Attribute planes from the snapped positions, evaluated at pixel centers.
+    double x0 = X[0] / 16.0, y0 = Y[0] / 16.0;
+    double dx1 = X[1] / 16.0 - x0, dy1 = Y[1] / 16.0 - y0;
+    double dx2 = X[2] / 16.0 - x0, dy2 = Y[2] / 16.0 - y0;
+    double inv = 1.0 / (dx1 * dy2 - dx2 * dy1);
+    for (int n = 0; n < nAttrs; ++n) {
+        double d1 = attrs[1][n] - attrs[0][n], d2 = attrs[2][n] - attrs[0][n];
+        double gx = (d1 * dy2 - d2 * dy1) * inv;
+        double gy = (d2 * dx1 - d1 * dx2) * inv;
+        t.attr[n][0] = gx;
+        t.attr[n][1] = gy;
+        t.attr[n][2] = attrs[0][n] + gx * (0.5 - x0) + gy * (0.5 - y0);
+    }
+    return true;
+}
+
+/// Columns [xa, xb) of row y covered by the triangle, narrowed from the range passed in.
+inline void tri_row_span(const tri_setup& t, int y, int& xa, int& xb)
+{
+    long long py = 16LL * y + 8;
+    for (int k = 0; k < 3 && xa < xb; ++k) {
+        long long a = t.a[k];
+        long long r = t.bias[k] - (t.b[k] * py + t.c[k]) - 8 * a;   // need 16 * a * x >= r
+        if (a > 0) {
+            long long lo = -tri_floor_div(-r, 16 * a);
+            if (lo > xa) xa = lo > xb ? xb : (int)lo;
+        } else if (a < 0) {
+            long long hi = tri_floor_div(-r, -16 * a) + 1;
+            if (hi < xb) xb = hi < xa ? xa : (int)hi;
+        } else if (r > 0) {
+            xb = xa;
+        }
+    }
+}
+
+inline void tri_tile_task(void* context, int index)
+{
+    const tri_job& job  = *(const tri_job*)context;
+    const int      tile = job.tiles[index];
+
+    int tx0 = (tile % job.tilesX) * TRI_TILE, ty0 = (tile / job.tilesX) * TRI_TILE;
+    int tx1 = tx0 + TRI_TILE < job.dstW ? tx0 + TRI_TILE : job.dstW;
+    int ty1 = ty0 + TRI_TILE < job.dstH ? ty0 + TRI_TILE : job.dstH;
+
+    const std::vector<int>& bin = job.bins[tile];
+    for (size_t i = 0; i < bin.size(); ++i) {
+        const tri_setup& t  = job.tris[bin[i]];
+        int              ya = t.y0 > ty0 ? t.y0 : ty0, yb = t.y1 < ty1 ? t.y1 : ty1;
+        for (int y = ya; y < yb; ++y) {
+            int xa = t.x0 > tx0 ? t.x0 : tx0, xb = t.x1 < tx1 ? t.x1 : tx1;
+            tri_row_span(t, y, xa, xb);
+            if (xa < xb) {
+                job.span(job, t, y, xa, xb);
+            }
+        }
+    }
+}
+
+/// Bin the prepared triangles and rasterize the tiles; returns the union of their boxes.
+inline void tri_run(tri_job& job, int& x0, int& y0, int& x1, int& y1)
+{
+    x0 = job.dstW;
+    y0 = job.dstH;
+    x1 = y1 = 0;
+
+    job.tilesX = (job.dstW + TRI_TILE - 1) / TRI_TILE;
+    int tilesY = (job.dstH + TRI_TILE - 1) / TRI_TILE;
+    job.bins.assign((size_t)job.tilesX * tilesY, std::vector<int>());
+    job.tiles.clear();
+
+    for (size_t i = 0; i < job.tris.size(); ++i) {
+        const tri_setup& t = job.tris[i];
+        for (int ty = t.y0 / TRI_TILE; ty <= (t.y1 - 1) / TRI_TILE; ++ty) {
+            for (int tx = t.x0 / TRI_TILE; tx <= (t.x1 - 1) / TRI_TILE; ++tx) {
+                std::vector<int>& bin = job.bins[(size_t)ty * job.tilesX + tx];
+                if (bin.empty()) {
+                    job.tiles.push_back(ty * job.tilesX + tx);
+                }
+                bin.push_back((int)i);
+            }
+        }
+        if (t.x0 < x0) x0 = t.x0;
+        if (t.y0 < y0) y0 = t.y0;
+        if (t.x1 > x1) x1 = t.x1;
+        if (t.y1 > y1) y1 = t.y1;
+    }
+    parallel_for((int)job.tiles.size(), tri_tile_task, &job);
+}
+
+struct tri_texture
+{
+    const color_t* texels;
+    int            w, h;
+};
+
+/// Bilinear sample with texel coordinates clamped to the texture.
+inline color_t tri_sample_clamped(const tri_texture& tex, int ix, int iy, unsigned int fx, unsigned int fy)
+{
+    int x0 = ix < 0 ? 0 : (ix >= tex.w ? tex.w - 1 : ix);
+    int x1 = ix + 1 < 0 ? 0 : (ix + 1 >= tex.w ? tex.w - 1 : ix + 1);
+    int y0 = iy < 0 ? 0 : (iy >= tex.h ? tex.h - 1 : iy);
+    int y1 = iy + 1 < 0 ? 0 : (iy + 1 >= tex.h ? tex.h - 1 : iy + 1);
+    const color_t* p = tex.texels;
+    return rotate_lerp(p[(size_t)y0 * tex.w + x0], p[(size_t)y0 * tex.w + x1], p[(size_t)y1 * tex.w + x0],
+        p[(size_t)y1 * tex.w + x1], fx, fy);
+}
+
+/// Texel at 16.16 texture position (u, v), edges clamped.
+template <bool Smooth, class Sampler>
+inline color_t tri_texel(const tri_texture& tex, int u, int v)
+{
+    int ix = u >> 16, iy = v >> 16;
+    if (!Smooth) {
+        ix = ix < 0 ? 0 : (ix >= tex.w ? tex.w - 1 : ix);
+        iy = iy < 0 ? 0 : (iy >= tex.h ? tex.h - 1 : iy);
+        return tex.texels[(size_t)iy * tex.w + ix];
+    }
+    unsigned int fx = (u >> 8) & 0xFF, fy = (v >> 8) & 0xFF;
+    if (ix >= 0 && ix + 1 < tex.w && iy >= 0 && iy + 1 < tex.h) {
+        return Sampler::sample(tex.texels + (size_t)iy * tex.w + ix, tex.w, fx, fy, 0);
+    }
+    return tri_sample_clamped(tex, ix, iy, fx, fy);
+}
+
+/// Texel coordinates the 16.16 steps of a span stay within, steps included.
+const double TRI_FIXED_LIMIT = 16383.0;
+
+template <bool Smooth, class Sampler>
+inline void tri_texture_span(const tri_job& job, const tri_setup& t, int y, int xa, int xb)
+{
+    const tri_texture& tex = *(const tri_texture*)job.shader;
+
+    double   fu = t.attr[0][2] + t.attr[0][0] * xa + t.attr[0][1] * y;
+    double   fv = t.attr[1][2] + t.attr[1][0] * xa + t.attr[1][1] * y;
+    color_t* d  = job.dst + (size_t)y * job.dstStride;
+    if (Smooth) {
+        fu -= 0.5;
+        fv -= 0.5;
+    }
+
+    double eu = fu + t.attr[0][0] * (xb - xa), ev = fv + t.attr[1][0] * (xb - xa);
+    if (fabs(fu) < TRI_FIXED_LIMIT && fabs(fv) < TRI_FIXED_LIMIT && fabs(eu) < TRI_FIXED_LIMIT
+        && fabs(ev) < TRI_FIXED_LIMIT) {
+        int u = rotate_fixed(fu), v = rotate_fixed(fv);
+        int du = rotate_fixed(t.attr[0][0]), dv = rotate_fixed(t.attr[1][0]);
+        for (int x = xa; x < xb; ++x, u += du, v += dv) {
+            d[x] = tri_texel<Smooth, Sampler>(tex, u, v);
+        }
+        return;
+    }
+
+    // Coordinates far outside the texture: clamp each one to just past the edge before it is
+    // converted, which samples the same edge texels.
+    const double maxU = tex.w + 1.0, maxV = tex.h + 1.0;
+    for (int x = xa; x < xb; ++x) {
+        double pu = fu + t.attr[0][0] * (x - xa), pv = fv + t.attr[1][0] * (x - xa);
+        pu        = pu < -2.0 ? -2.0 : (pu > maxU ? maxU : pu);
+        pv        = pv < -2.0 ? -2.0 : (pv > maxV ? maxV : pv);
+        d[x]      = tri_texel<Smooth, Sampler>(tex, rotate_fixed(pu), rotate_fixed(pv));
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Draw a textured triangle mesh
+ * @param texture Texture IMAGE object
+ * @param vertices Vertex array
+ * @param indices Vertex indices, three per triangle; NULL draws vertices[0..3 * count) in order
+ * @param count Number of triangles
+ * @param dst Target IMAGE object pointer, if NULL then draw to screen
+ * @param smooth Whether to use bilinear filtering, default is false (nearest texel)
+ * @return grOk on success, grNullPointer if texture or vertices is NULL
+ * @note Texels are copied as they are, alpha included. Texture coordinates outside 0 to 1 are
+ *       clamped to the texture edge.
+ */
+inline int ege_drawtriangles(PCIMAGE texture, const ege_vertex* vertices, const uint32_t* indices, int count,
+    PIMAGE dst = NULL, bool smooth = false)
+{
+    if (texture == NULL || (vertices == NULL && count > 0)) {
+        return grNullPointer;
+    }
+
+    detail::tri_texture tex;
+    tex.texels = getbuffer(texture);
+    tex.w      = getwidth(texture);
+    tex.h      = getheight(texture);
+
+    detail::tri_job job;
+    job.dst       = getbuffer(dst);
+    job.dstW      = getwidth(dst);
+    job.dstH      = getheight(dst);
+    job.dstStride = job.dstW;
+    job.shader    = &tex;
+    if (tex.texels == NULL || job.dst == NULL) {
+        return grNullPointer;
+    }
+
+    job.span = smooth ? detail::tri_texture_span<true, detail::rotate_sampler_scalar>
+                      : detail::tri_texture_span<false, detail::rotate_sampler_scalar>;
+#ifdef EGE_SIMD_X86
+    if (smooth && (ege_cpu_features() & CPU_FEATURE_SSE2)) {
+        job.span = detail::tri_texture_span<true, detail::rotate_sampler_sse2>;
+    }
+#endif
+
+    job.tris.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        float  xs[3], ys[3];
+        double attrs[3][detail::TRI_ATTRS];
+        for (int k = 0; k < 3; ++k) {
+            const ege_vertex& v = vertices[indices != NULL ? indices[i * 3 + k] : (uint32_t)(i * 3 + k)];
+            xs[k]       = v.x;
+            ys[k]       = v.y;
+            attrs[k][0] = (double)v.u * tex.w;
+            attrs[k][1] = (double)v.v * tex.h;
+        }
+        detail::tri_setup t;
+        if (detail::tri_prepare(t, xs, ys, attrs, 2, job.dstW, job.dstH)) {
+            job.tris.push_back(t);
+        }
+    }
+
+    int x0, y0, x1, y1;
+    detail::tri_run(job, x0, y0, x1, y1);
+    detail::dirty_note(dst, x0, y0, x1 - x0, y1 - y0);
+    return grOk;
+}
+
+} // namespace ege
+
+#endif /* EGE_TRIANGLES_H */